@@ -0,0 +1,349 @@
+#include "animation_clip.h"
+#include "trasform.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+// The SIMD blend only runs if the quaternion is stored the way it reads it (see `TRANSFORM_QUAT_XYZW`)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define ANIMATION_SIMD_SSE
+#endif
+
+#if defined(ANIMATION_SIMD_SSE)
+constexpr bool BLEND_SIMD = TRANSFORM_QUAT_XYZW;
+#else
+constexpr bool BLEND_SIMD = false;
+#endif
+
+// Every SIMD load reads 16 bytes, so the scale still needs 4 bytes of room after it
+static_assert(sizeof(Transform) >= offsetof(Transform, scale) + 16, "Unexpected Transform layout");
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Tracks that never move more than this are stored once
+const nikol::f32 CONSTANT_EPSILON = 1e-5f;
+
+// The 3 smallest components of a unit quaternion are all within [-1/sqrt(2), 1/sqrt(2)]
+const nikol::f32 SMALLEST_THREE_RANGE = 0.70710678f;
+const nikol::f32 SMALLEST_THREE_MAX   = 32767.0f;
+
+const nikol::u32 KEY_ROTATION_SIZE = 3;
+const nikol::u32 KEY_VEC3_SIZE     = 3;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void encode_rotation(const glm::quat& rotation, nikol::u16* out) {
+  glm::quat q = glm::normalize(rotation);
+  nikol::f32 comps[4] = {q.x, q.y, q.z, q.w};
+
+  nikol::u32 largest = 0;
+  for(nikol::u32 i = 1; i < 4; i++) {
+    if(std::abs(comps[i]) > std::abs(comps[largest])) {
+      largest = i;
+    }
+  }
+
+  // `q` and `-q` are the same rotation, so the dropped component can always be positive
+  nikol::f32 sign = (comps[largest] < 0.0f) ? -1.0f : 1.0f;
+
+  nikol::u16 quantized[3];
+  for(nikol::u32 i = 0, j = 0; i < 4; i++) {
+    if(i == largest) {
+      continue;
+    }
+
+    nikol::f32 normalized = glm::clamp((comps[i] * sign) / SMALLEST_THREE_RANGE * 0.5f + 0.5f, 0.0f, 1.0f);
+    quantized[j++]        = (nikol::u16)std::round(normalized * SMALLEST_THREE_MAX);
+  }
+
+  out[0] = quantized[0] | (nikol::u16)((largest & 1) << 15);
+  out[1] = quantized[1] | (nikol::u16)((largest >> 1) << 15);
+  out[2] = quantized[2];
+}
+
+static glm::quat decode_rotation(const nikol::u16* in) {
+  nikol::u32 largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+
+  nikol::f32 small[3];
+  for(nikol::u32 i = 0; i < 3; i++) {
+    small[i] = (((in[i] & 0x7fff) / SMALLEST_THREE_MAX) * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+  }
+
+  nikol::f32 comps[4];
+  for(nikol::u32 i = 0, j = 0; i < 4; i++) {
+    if(i != largest) {
+      comps[i] = small[j++];
+    }
+  }
+  comps[largest] = std::sqrt(glm::max(0.0f, 1.0f - small[0] * small[0] - small[1] * small[1] - small[2] * small[2]));
+
+  return glm::quat(comps[3], comps[0], comps[1], comps[2]);
+}
+
+static void encode_vec3(const glm::vec3& value, const glm::vec3& min, const glm::vec3& extent, nikol::u16* out) {
+  for(int i = 0; i < 3; i++) {
+    nikol::f32 normalized = (extent[i] > 0.0f) ? (value[i] - min[i]) / extent[i] : 0.0f;
+    out[i]                = (nikol::u16)std::round(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+  }
+}
+
+static glm::vec3 decode_vec3(const nikol::u16* in, const glm::vec3& min, const glm::vec3& extent) {
+  return min + extent * (glm::vec3(in[0], in[1], in[2]) / 65535.0f);
+}
+
+static void decode_key(const AnimationClip& clip, const nikol::u32 frame, const nikol::u32 joint, Transform& out) {
+  const AnimationSegment& segment = clip.segments[frame / ANIMATION_SEGMENT_FRAMES];
+  const AnimationTrack& track     = clip.tracks[joint];
+
+  const nikol::u16* key   = &clip.data[segment.data_offset + (frame - segment.first_frame) * clip.frame_stride + track.key_offset];
+  const glm::vec3* ranges = &clip.ranges[segment.range_offset];
+
+  out.rotation = decode_rotation(key);
+  key         += KEY_ROTATION_SIZE;
+
+  out.position = track.constant_translation;
+  if(track.translation_range != ANIMATION_RANGE_NONE) {
+    out.position = decode_vec3(key, ranges[track.translation_range * 2], ranges[track.translation_range * 2 + 1]);
+    key         += KEY_VEC3_SIZE;
+  }
+
+  out.scale = track.constant_scale;
+  if(track.scale_range != ANIMATION_RANGE_NONE) {
+    out.scale = decode_vec3(key, ranges[track.scale_range * 2], ranges[track.scale_range * 2 + 1]);
+  }
+
+  out.is_dirty = true;
+}
+
+static inline void blend_transform(const Transform& a, const Transform& b, const nikol::f32 weight, Transform& out) {
+  if constexpr(BLEND_SIMD) {
+#if defined(ANIMATION_SIMD_SSE)
+    __m128 w = _mm_set1_ps(weight);
+
+    // Position and scale (the 4th lane is whatever follows them and gets thrown away)
+    __m128 pos_a   = _mm_loadu_ps(&a.position.x);
+    __m128 pos_b   = _mm_loadu_ps(&b.position.x);
+    __m128 scale_a = _mm_loadu_ps(&a.scale.x);
+    __m128 scale_b = _mm_loadu_ps(&b.scale.x);
+    __m128 rot_a   = _mm_loadu_ps(&a.rotation.x);
+    __m128 rot_b   = _mm_loadu_ps(&b.rotation.x);
+
+    __m128 pos   = _mm_add_ps(pos_a, _mm_mul_ps(_mm_sub_ps(pos_b, pos_a), w));
+    __m128 scale = _mm_add_ps(scale_a, _mm_mul_ps(_mm_sub_ps(scale_b, scale_a), w));
+
+    // Taking the shortest path: flip `b` if the two are in opposite hemispheres
+    __m128 dot = _mm_mul_ps(rot_a, rot_b);
+    dot        = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+    dot        = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+    rot_b       = _mm_xor_ps(rot_b, flip);
+
+    __m128 rot = _mm_add_ps(rot_a, _mm_mul_ps(_mm_sub_ps(rot_b, rot_a), w));
+
+    __m128 len2 = _mm_mul_ps(rot, rot);
+    len2        = _mm_add_ps(len2, _mm_shuffle_ps(len2, len2, _MM_SHUFFLE(2, 3, 0, 1)));
+    len2        = _mm_add_ps(len2, _mm_shuffle_ps(len2, len2, _MM_SHUFFLE(1, 0, 3, 2)));
+    rot         = _mm_div_ps(rot, _mm_sqrt_ps(len2));
+
+    // Everything was loaded already, so `out` can be `a` or `b`
+    alignas(16) nikol::f32 pos_out[4], scale_out[4];
+    _mm_store_ps(pos_out, pos);
+    _mm_store_ps(scale_out, scale);
+    _mm_storeu_ps(&out.rotation.x, rot);
+
+    out.position = glm::vec3(pos_out[0], pos_out[1], pos_out[2]);
+    out.scale    = glm::vec3(scale_out[0], scale_out[1], scale_out[2]);
+#endif
+  }
+  else {
+    glm::quat rot_b = (glm::dot(a.rotation, b.rotation) < 0.0f) ? -b.rotation : b.rotation;
+
+    out.position = glm::mix(a.position, b.position, weight);
+    out.scale    = glm::mix(a.scale, b.scale, weight);
+    out.rotation = glm::normalize(a.rotation * (1.0f - weight) + rot_b * weight);
+  }
+
+  out.is_dirty = true;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// AnimationClip functions
+void animation_clip_compress(AnimationClip& clip,
+                             const Transform* keys,
+                             const nikol::u32 joints_count,
+                             const nikol::u32 frames_count,
+                             const nikol::f32 sample_rate) {
+  NIKOL_ASSERT(frames_count > 0, "An animation clip needs at least one frame");
+
+  clip.joints_count = joints_count;
+  clip.frames_count = frames_count;
+  clip.sample_rate  = sample_rate;
+  clip.duration     = (frames_count - 1) / sample_rate;
+  clip.stats        = {};
+
+  // Finding the constant tracks and where every joint's keys go in a frame
+  clip.tracks.resize(joints_count);
+  clip.frame_stride = 0;
+  clip.ranges_count = 0;
+
+  for(nikol::u32 joint = 0; joint < joints_count; joint++) {
+    glm::vec3 min_pos   = keys[joint].position, max_pos   = min_pos;
+    glm::vec3 min_scale = keys[joint].scale,    max_scale = min_scale;
+
+    for(nikol::u32 frame = 1; frame < frames_count; frame++) {
+      const Transform& key = keys[frame * joints_count + joint];
+
+      min_pos   = glm::min(min_pos, key.position);
+      max_pos   = glm::max(max_pos, key.position);
+      min_scale = glm::min(min_scale, key.scale);
+      max_scale = glm::max(max_scale, key.scale);
+    }
+
+    glm::vec3 pos_extent   = max_pos - min_pos;
+    glm::vec3 scale_extent = max_scale - min_scale;
+
+    AnimationTrack& track      = clip.tracks[joint];
+    track.key_offset           = clip.frame_stride;
+    track.constant_translation = (min_pos + max_pos) * 0.5f;
+    track.constant_scale       = (min_scale + max_scale) * 0.5f;
+    track.translation_range    = ANIMATION_RANGE_NONE;
+    track.scale_range          = ANIMATION_RANGE_NONE;
+
+    clip.frame_stride += KEY_ROTATION_SIZE;
+
+    if(glm::max(pos_extent.x, glm::max(pos_extent.y, pos_extent.z)) > CONSTANT_EPSILON) {
+      track.translation_range = clip.ranges_count++;
+      clip.frame_stride      += KEY_VEC3_SIZE;
+    }
+    else {
+      clip.stats.constant_tracks++;
+    }
+
+    if(glm::max(scale_extent.x, glm::max(scale_extent.y, scale_extent.z)) > CONSTANT_EPSILON) {
+      track.scale_range  = clip.ranges_count++;
+      clip.frame_stride += KEY_VEC3_SIZE;
+    }
+    else {
+      clip.stats.constant_tracks++;
+    }
+  }
+
+  // Every segment gets its own ranges, which are much tighter than the clip's
+  nikol::u32 segments_count = (frames_count + ANIMATION_SEGMENT_FRAMES - 1) / ANIMATION_SEGMENT_FRAMES;
+
+  clip.segments.resize(segments_count);
+  clip.ranges.assign(segments_count * clip.ranges_count * 2, glm::vec3(0.0f));
+  clip.data.resize(frames_count * clip.frame_stride);
+
+  for(nikol::u32 s = 0; s < segments_count; s++) {
+    AnimationSegment& segment = clip.segments[s];
+    segment.first_frame       = s * ANIMATION_SEGMENT_FRAMES;
+    segment.frames_count      = glm::min(ANIMATION_SEGMENT_FRAMES, frames_count - segment.first_frame);
+    segment.data_offset       = segment.first_frame * clip.frame_stride;
+    segment.range_offset      = s * clip.ranges_count * 2;
+
+    glm::vec3* ranges = &clip.ranges[segment.range_offset];
+
+    for(nikol::u32 joint = 0; joint < joints_count; joint++) {
+      const AnimationTrack& track = clip.tracks[joint];
+
+      glm::vec3 min_pos   = glm::vec3( 1e30f), min_scale = glm::vec3( 1e30f);
+      glm::vec3 max_pos   = glm::vec3(-1e30f), max_scale = glm::vec3(-1e30f);
+
+      for(nikol::u32 frame = segment.first_frame; frame < segment.first_frame + segment.frames_count; frame++) {
+        const Transform& key = keys[frame * joints_count + joint];
+
+        min_pos   = glm::min(min_pos, key.position);
+        max_pos   = glm::max(max_pos, key.position);
+        min_scale = glm::min(min_scale, key.scale);
+        max_scale = glm::max(max_scale, key.scale);
+      }
+
+      if(track.translation_range != ANIMATION_RANGE_NONE) {
+        ranges[track.translation_range * 2]     = min_pos;
+        ranges[track.translation_range * 2 + 1] = max_pos - min_pos;
+      }
+
+      if(track.scale_range != ANIMATION_RANGE_NONE) {
+        ranges[track.scale_range * 2]     = min_scale;
+        ranges[track.scale_range * 2 + 1] = max_scale - min_scale;
+      }
+
+      for(nikol::u32 frame = segment.first_frame; frame < segment.first_frame + segment.frames_count; frame++) {
+        const Transform& key = keys[frame * joints_count + joint];
+        nikol::u16* out      = &clip.data[frame * clip.frame_stride + track.key_offset];
+
+        encode_rotation(key.rotation, out);
+        out += KEY_ROTATION_SIZE;
+
+        if(track.translation_range != ANIMATION_RANGE_NONE) {
+          encode_vec3(key.position, ranges[track.translation_range * 2], ranges[track.translation_range * 2 + 1], out);
+          out += KEY_VEC3_SIZE;
+        }
+
+        if(track.scale_range != ANIMATION_RANGE_NONE) {
+          encode_vec3(key.scale, ranges[track.scale_range * 2], ranges[track.scale_range * 2 + 1], out);
+        }
+      }
+    }
+  }
+
+  // Measuring what the compression cost us against the source keys
+  for(nikol::u32 frame = 0; frame < frames_count; frame++) {
+    for(nikol::u32 joint = 0; joint < joints_count; joint++) {
+      const Transform& key = keys[frame * joints_count + joint];
+
+      Transform decoded;
+      decode_key(clip, frame, joint, decoded);
+
+      nikol::f32 dot   = glm::min(std::abs(glm::dot(glm::normalize(key.rotation), decoded.rotation)), 1.0f);
+      nikol::f32 angle = 2.0f * std::acos(dot);
+
+      clip.stats.max_rotation_error    = glm::max(clip.stats.max_rotation_error, angle);
+      clip.stats.max_translation_error = glm::max(clip.stats.max_translation_error, glm::length(key.position - decoded.position));
+      clip.stats.max_scale_error       = glm::max(clip.stats.max_scale_error, glm::length(key.scale - decoded.scale));
+    }
+  }
+
+  clip.stats.raw_bytes        = (nikol::sizei)frames_count * joints_count * sizeof(Transform);
+  clip.stats.compressed_bytes = clip.data.size() * sizeof(nikol::u16) +
+                                clip.ranges.size() * sizeof(glm::vec3) +
+                                clip.segments.size() * sizeof(AnimationSegment) +
+                                clip.tracks.size() * sizeof(AnimationTrack);
+}
+
+void animation_clip_sample(const AnimationClip& clip, const nikol::f32 time, Transform* out) {
+  nikol::f32 frame = glm::clamp(time, 0.0f, clip.duration) * clip.sample_rate;
+
+  nikol::u32 frame0  = glm::min((nikol::u32)frame, clip.frames_count - 1);
+  nikol::u32 frame1  = glm::min(frame0 + 1, clip.frames_count - 1);
+  nikol::f32 alpha   = frame - (nikol::f32)frame0;
+
+  for(nikol::u32 joint = 0; joint < clip.joints_count; joint++) {
+    Transform key0, key1;
+    decode_key(clip, frame0, joint, key0);
+    decode_key(clip, frame1, joint, key1);
+
+    blend_transform(key0, key1, alpha, out[joint]);
+  }
+}
+
+void animation_blend_poses(const Transform* a, const Transform* b, const nikol::f32 weight, Transform* out, const nikol::u32 count) {
+  for(nikol::u32 i = 0; i < count; i++) {
+    blend_transform(a[i], b[i], weight, out[i]);
+  }
+}
+// AnimationClip functions
+// ----------------------------------------------------------------------------
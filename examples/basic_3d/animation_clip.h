@@ -0,0 +1,109 @@
+#pragma once
+
+#include "trasform.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Frames per segment. Sampling any time reads one segment, or two right at the edge of one.
+const nikol::u32 ANIMATION_SEGMENT_FRAMES = 16;
+
+const nikol::u32 ANIMATION_RANGE_NONE = 0xffffffff;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// AnimationTrack
+// Where one joint's keys live in every frame. Translations and scales that never
+// move are stored once here instead of in every frame.
+struct AnimationTrack {
+  nikol::u32 key_offset; // In `u16`s from the start of a frame
+
+  nikol::u32 translation_range; // Index into each segment's ranges or `ANIMATION_RANGE_NONE` if constant
+  nikol::u32 scale_range;
+
+  glm::vec3 constant_translation;
+  glm::vec3 constant_scale;
+};
+// AnimationTrack
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// AnimationSegment
+struct AnimationSegment {
+  nikol::u32 first_frame;
+  nikol::u32 frames_count;
+
+  nikol::u32 data_offset;  // Into `AnimationClip::data`
+  nikol::u32 range_offset; // Into `AnimationClip::ranges`
+};
+// AnimationSegment
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// AnimationClipStats
+struct AnimationClipStats {
+  nikol::sizei raw_bytes        = 0; // One `Transform` per joint per frame
+  nikol::sizei compressed_bytes = 0;
+
+  nikol::u32 constant_tracks = 0; // Translations and scales that got stored once
+
+  nikol::f32 max_rotation_error    = 0.0f; // In radians
+  nikol::f32 max_translation_error = 0.0f;
+  nikol::f32 max_scale_error       = 0.0f;
+};
+// AnimationClipStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// AnimationClip
+// Every key is 16-bit:
+//  - Rotations are stored as their 3 smallest components (15 bits each), with the index of
+//    the largest one in the spare bits. The largest one is rebuilt from the unit length.
+//  - Translations and scales are normalized into the range they span in their segment.
+//
+// The keys are laid out frame after frame, every joint of a frame next to each other, so sampling
+// a time reads two neighbouring rows of a single segment.
+struct AnimationClip {
+  nikol::u32 joints_count = 0;
+  nikol::u32 frames_count = 0;
+  nikol::f32 sample_rate  = 30.0f;
+  nikol::f32 duration     = 0.0f;
+
+  std::vector<AnimationTrack> tracks;
+  nikol::u32 frame_stride = 0; // In `u16`s
+  nikol::u32 ranges_count = 0; // Per segment (one for every animated translation or scale)
+
+  std::vector<AnimationSegment> segments;
+  std::vector<glm::vec3> ranges; // (min, extent) pairs, segment after segment
+  std::vector<nikol::u16> data;
+
+  AnimationClipStats stats;
+};
+// AnimationClip
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// AnimationClip functions
+
+// `keys` holds `frames_count` rows of `joints_count` local transforms each (`keys[frame * joints_count + joint]`).
+// The errors in `stats` get measured against them.
+void animation_clip_compress(AnimationClip& clip,
+                             const Transform* keys,
+                             const nikol::u32 joints_count,
+                             const nikol::u32 frames_count,
+                             const nikol::f32 sample_rate);
+
+// Write the pose at `time` (clamped to the clip) into `out` (`joints_count` transforms)
+void animation_clip_sample(const AnimationClip& clip, const nikol::f32 time, Transform* out);
+
+// `out = a * (1 - weight) + b * weight`. Linear for the translations and scales, normalized linear for the rotations.
+// `out` can be either `a` or `b`.
+void animation_blend_poses(const Transform* a, const Transform* b, const nikol::f32 weight, Transform* out, const nikol::u32 count);
+// AnimationClip functions
+// ----------------------------------------------------------------------------
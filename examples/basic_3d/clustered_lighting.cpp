@@ -0,0 +1,401 @@
+#include "clustered_lighting.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define CLUSTER_SIMD_SSE
+#endif
+
+// Rows get tested 4 clusters at a time
+static_assert((CLUSTER_GRID_X % 4) == 0, "CLUSTER_GRID_X has to be a multiple of 4");
+
+// Every block has to fit in `CLUSTER_UNIFORM_BLOCK_SIZE` (the ranges go in four to a uvec4)
+static_assert(sizeof(PointLight) * CLUSTER_GPU_LIGHTS_MAX <= CLUSTER_UNIFORM_BLOCK_SIZE, "The lights do not fit in a uniform block");
+static_assert(sizeof(nikol::u16) * CLUSTER_GPU_INDICES_MAX <= CLUSTER_UNIFORM_BLOCK_SIZE, "The light indices do not fit in a uniform block");
+static_assert(sizeof(nikol::u32) * CLUSTERS_COUNT <= CLUSTER_UNIFORM_BLOCK_SIZE && (CLUSTERS_COUNT % 4) == 0, "The cluster ranges do not fit in a uniform block");
+static_assert(CLUSTER_GPU_INDICES_MAX <= CLUSTER_RANGE_OFFSET_MAX + 1 && CLUSTER_LIGHTS_MAX <= 0xffff, "The cluster ranges do not fit in 32 bits");
+static_assert(CLUSTER_GPU_LIGHTS_MAX <= CLUSTER_BIN_LIGHTS_MAX, "The uploaded lights do not fit in 16-bit indices");
+
+// ----------------------------------------------------------------------------
+// Consts
+const nikol::u32 TRANSFORM_BATCH_SIZE = 1024;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u32 depth_to_slice(const ClusteredLighting& cl, const nikol::f32 depth) {
+  nikol::f32 slice = std::log(glm::max(depth, cl.near)) * cl.params.slicing.x + cl.params.slicing.y;
+  return (nikol::u32)glm::clamp(slice, 0.0f, (nikol::f32)(CLUSTER_GRID_Z - 1));
+}
+
+static void push_light(ClusteredLighting& cl, const nikol::u32 cluster, const nikol::u32 light) {
+  nikol::u32 count = cl.cluster_counts[cluster]++;
+  if(count < CLUSTER_LIGHTS_MAX) {
+    cl.cluster_scratch[cluster * CLUSTER_LIGHTS_MAX + count] = (nikol::u16)light;
+  }
+}
+
+// The longest every list can be for all of them to fit in `CLUSTER_GPU_INDICES_MAX`
+static nikol::u32 find_cluster_lights_cap(const ClusteredLighting& cl) {
+  nikol::u32 low  = 0;
+  nikol::u32 high = CLUSTER_LIGHTS_MAX;
+
+  while(low < high) {
+    nikol::u32 cap   = (low + high + 1) / 2;
+    nikol::u32 total = 0;
+
+    for(auto count : cl.cluster_counts) {
+      total += glm::min(count, cap);
+    }
+
+    if(total <= CLUSTER_GPU_INDICES_MAX) {
+      low = cap;
+    }
+    else {
+      high = cap - 1;
+    }
+  }
+
+  return low;
+}
+
+// Sphere against the 4 clusters starting at `first`. Returns one bit per overlapping cluster.
+static nikol::u32 test_clusters4(const ClusteredLighting& cl, const nikol::u32 first, const PointLight& light) {
+#if defined(CLUSTER_SIMD_SSE)
+  __m128 zero = _mm_setzero_ps();
+
+  __m128 px = _mm_set1_ps(light.position.x);
+  __m128 py = _mm_set1_ps(light.position.y);
+  __m128 pz = _mm_set1_ps(light.position.z);
+  __m128 r2 = _mm_set1_ps(light.radius * light.radius);
+
+  // The distance from the center to each box on every axis (0 when inside)
+  __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&cl.min_x[first]), px), zero), _mm_sub_ps(px, _mm_loadu_ps(&cl.max_x[first])));
+  __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&cl.min_y[first]), py), zero), _mm_sub_ps(py, _mm_loadu_ps(&cl.max_y[first])));
+  __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&cl.min_z[first]), pz), zero), _mm_sub_ps(pz, _mm_loadu_ps(&cl.max_z[first])));
+
+  __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+  return (nikol::u32)_mm_movemask_ps(_mm_cmple_ps(dist2, r2));
+#else
+  nikol::u32 mask = 0;
+
+  for(nikol::u32 i = 0; i < 4; i++) {
+    nikol::u32 c = first + i;
+
+    nikol::f32 dx = glm::max(glm::max(cl.min_x[c] - light.position.x, 0.0f), light.position.x - cl.max_x[c]);
+    nikol::f32 dy = glm::max(glm::max(cl.min_y[c] - light.position.y, 0.0f), light.position.y - cl.max_y[c]);
+    nikol::f32 dz = glm::max(glm::max(cl.min_z[c] - light.position.z, 0.0f), light.position.z - cl.max_z[c]);
+
+    mask |= ((dx * dx + dy * dy + dz * dz) <= (light.radius * light.radius)) << i;
+  }
+
+  return mask;
+#endif
+}
+
+static void bin_slice(ClusteredLighting& cl, const nikol::u32 slice) {
+  nikol::u32 slice_start = slice * CLUSTERS_PER_SLICE;
+  std::memset(&cl.cluster_counts[slice_start], 0, CLUSTERS_PER_SLICE * sizeof(nikol::u32));
+
+  for(nikol::u32 i = 0; i < cl.view_lights.size(); i++) {
+    const glm::uvec2& slices = cl.light_slices[i];
+    if(slice < slices.x || slice > slices.y) {
+      continue;
+    }
+
+    const PointLight& light = cl.view_lights[i];
+
+    for(nikol::u32 y = 0; y < CLUSTER_GRID_Y; y++) {
+      const glm::vec2& row = cl.row_bounds[slice * CLUSTER_GRID_Y + y];
+      if((light.position.y + light.radius) < row.x || (light.position.y - light.radius) > row.y) {
+        continue;
+      }
+
+      nikol::u32 row_start = slice_start + y * CLUSTER_GRID_X;
+      for(nikol::u32 x = 0; x < CLUSTER_GRID_X; x += 4) {
+        nikol::u32 mask = test_clusters4(cl, row_start + x, light);
+        if(!mask) {
+          continue;
+        }
+
+        for(nikol::u32 bit = 0; bit < 4; bit++) {
+          if(mask & (1 << bit)) {
+            push_light(cl, row_start + x + bit, i);
+          }
+        }
+      }
+    }
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ClusteredLighting functions
+void clustered_lighting_init(ClusteredLighting& cl, nikol::GfxContext* gfx) {
+  cl.gfx        = gfx;
+  cl.projection = glm::mat4(0.0f);
+  cl.width      = 0;
+  cl.height     = 0;
+  cl.params     = {};
+  cl.stats      = {};
+
+  cl.min_x.assign(CLUSTERS_COUNT, 0.0f);
+  cl.min_y.assign(CLUSTERS_COUNT, 0.0f);
+  cl.min_z.assign(CLUSTERS_COUNT, 0.0f);
+  cl.max_x.assign(CLUSTERS_COUNT, 0.0f);
+  cl.max_y.assign(CLUSTERS_COUNT, 0.0f);
+  cl.max_z.assign(CLUSTERS_COUNT, 0.0f);
+  cl.row_bounds.assign(CLUSTER_GRID_Y * CLUSTER_GRID_Z, glm::vec2(0.0f));
+
+  cl.cluster_counts.assign(CLUSTERS_COUNT, 0);
+  cl.cluster_scratch.assign(CLUSTERS_COUNT * CLUSTER_LIGHTS_MAX, 0);
+  cl.cluster_ranges.assign(CLUSTERS_COUNT, glm::uvec2(0));
+  cl.packed_ranges.assign(CLUSTERS_COUNT, 0);
+
+  if(!gfx) {
+    return;
+  }
+
+  // Uniform buffers init
+  nikol::GfxBufferDesc buff_desc = {
+    .data  = nullptr,
+    .size  = sizeof(ClusterParams),
+    .type  = nikol::GFX_BUFFER_UNIFORM,
+    .usage = nikol::GFX_BUFFER_USAGE_DYNAMIC_DRAW,
+  };
+  cl.params_buffer = nikol::gfx_buffer_create(gfx, buff_desc);
+
+  buff_desc.size   = sizeof(PointLight) * CLUSTER_GPU_LIGHTS_MAX;
+  cl.lights_buffer = nikol::gfx_buffer_create(gfx, buff_desc);
+
+  buff_desc.size   = sizeof(nikol::u32) * CLUSTERS_COUNT;
+  cl.ranges_buffer = nikol::gfx_buffer_create(gfx, buff_desc);
+
+  buff_desc.size    = sizeof(nikol::u16) * CLUSTER_GPU_INDICES_MAX;
+  cl.indices_buffer = nikol::gfx_buffer_create(gfx, buff_desc);
+}
+
+void clustered_lighting_shutdown(ClusteredLighting& cl) {
+  if(cl.gfx) {
+    nikol::gfx_buffer_destroy(cl.params_buffer);
+    nikol::gfx_buffer_destroy(cl.lights_buffer);
+    nikol::gfx_buffer_destroy(cl.ranges_buffer);
+    nikol::gfx_buffer_destroy(cl.indices_buffer);
+  }
+
+  cl.params_buffer  = nullptr;
+  cl.lights_buffer  = nullptr;
+  cl.ranges_buffer  = nullptr;
+  cl.indices_buffer = nullptr;
+}
+
+void clustered_lighting_update_grid(ClusteredLighting& cl, const glm::mat4& projection, const nikol::u32 width, const nikol::u32 height) {
+  if(cl.width == width && cl.height == height && std::memcmp(&cl.projection, &projection, sizeof(glm::mat4)) == 0) {
+    return;
+  }
+
+  cl.projection = projection;
+  cl.width      = width;
+  cl.height     = height;
+
+  // Everything the grid needs can be read back from the projection
+  nikol::f32 tan_x = 1.0f / projection[0][0];
+  nikol::f32 tan_y = 1.0f / projection[1][1];
+  cl.near          = projection[3][2] / (projection[2][2] - 1.0f);
+  cl.far           = projection[3][2] / (projection[2][2] + 1.0f);
+
+  nikol::f32 log_ratio = std::log(cl.far / cl.near);
+
+  cl.params.grid_size = glm::uvec4(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, 0);
+  cl.params.tile_size = glm::vec4((nikol::f32)width / CLUSTER_GRID_X, (nikol::f32)height / CLUSTER_GRID_Y, 0.0f, 0.0f);
+  cl.params.slicing   = glm::vec4(CLUSTER_GRID_Z / log_ratio, -(CLUSTER_GRID_Z * std::log(cl.near)) / log_ratio, 0.0f, 0.0f);
+
+  for(nikol::u32 z = 0; z < CLUSTER_GRID_Z; z++) {
+    // Exponential slices, so the clusters stay roughly cubic all the way back
+    nikol::f32 near_depth = cl.near * std::pow(cl.far / cl.near, (nikol::f32)z / CLUSTER_GRID_Z);
+    nikol::f32 far_depth  = cl.near * std::pow(cl.far / cl.near, (nikol::f32)(z + 1) / CLUSTER_GRID_Z);
+
+    for(nikol::u32 y = 0; y < CLUSTER_GRID_Y; y++) {
+      nikol::f32 ndc_y0 = -1.0f + (2.0f * y) / CLUSTER_GRID_Y;
+      nikol::f32 ndc_y1 = -1.0f + (2.0f * (y + 1)) / CLUSTER_GRID_Y;
+
+      nikol::f32 min_y = glm::min(ndc_y0 * near_depth, ndc_y0 * far_depth) * tan_y;
+      nikol::f32 max_y = glm::max(ndc_y1 * near_depth, ndc_y1 * far_depth) * tan_y;
+      cl.row_bounds[z * CLUSTER_GRID_Y + y] = glm::vec2(min_y, max_y);
+
+      for(nikol::u32 x = 0; x < CLUSTER_GRID_X; x++) {
+        nikol::f32 ndc_x0 = -1.0f + (2.0f * x) / CLUSTER_GRID_X;
+        nikol::f32 ndc_x1 = -1.0f + (2.0f * (x + 1)) / CLUSTER_GRID_X;
+
+        // The frustum looks down -Z
+        nikol::u32 c = z * CLUSTERS_PER_SLICE + y * CLUSTER_GRID_X + x;
+        cl.min_x[c]  = glm::min(ndc_x0 * near_depth, ndc_x0 * far_depth) * tan_x;
+        cl.max_x[c]  = glm::max(ndc_x1 * near_depth, ndc_x1 * far_depth) * tan_x;
+        cl.min_y[c]  = min_y;
+        cl.max_y[c]  = max_y;
+        cl.min_z[c]  = -far_depth;
+        cl.max_z[c]  = -near_depth;
+      }
+    }
+  }
+}
+
+void clustered_lighting_bin(ClusteredLighting& cl, const PointLight* lights, const nikol::u32 count, const glm::mat4& view) {
+  cl.stats              = {};
+  cl.stats.lights_total = count;
+
+  cl.is_visible.resize(count);
+  cl.transformed.resize(count);
+  cl.transformed_slices.resize(count);
+
+  nikol::f32 tan_x = 1.0f / cl.projection[0][0];
+  nikol::f32 tan_y = 1.0f / cl.projection[1][1];
+
+  // The side planes of the frustum (through the origin)
+  glm::vec3 side_planes[4] = {
+    glm::normalize(glm::vec3( 1.0f,  0.0f, tan_x)),
+    glm::normalize(glm::vec3(-1.0f,  0.0f, tan_x)),
+    glm::normalize(glm::vec3( 0.0f,  1.0f, tan_y)),
+    glm::normalize(glm::vec3( 0.0f, -1.0f, tan_y)),
+  };
+
+  // Into view space, dropping whatever is outside the frustum
+  job_system_parallel_for(count, TRANSFORM_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      PointLight light = lights[i];
+      light.position   = glm::vec3(view * glm::vec4(light.position, 1.0f));
+
+      nikol::f32 depth = -light.position.z;
+      bool visible     = (depth + light.radius) > cl.near && (depth - light.radius) < cl.far;
+
+      for(auto& plane : side_planes) {
+        visible = visible && (glm::dot(plane, light.position) <= light.radius);
+      }
+
+      cl.is_visible[i]         = visible;
+      cl.transformed[i]        = light;
+      cl.transformed_slices[i] = glm::uvec2(depth_to_slice(cl, depth - light.radius), depth_to_slice(cl, depth + light.radius));
+    }
+  });
+
+  cl.visible_indices.clear();
+  cl.visible_distances.clear();
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    if(cl.is_visible[i]) {
+      cl.visible_indices.push_back(i);
+      cl.visible_distances.push_back(glm::max(glm::length(cl.transformed[i].position) - cl.transformed[i].radius, 0.0f));
+    }
+  }
+
+  // Only as many as the uniform buffer holds, nearest first. The lists of every cluster come out in the same order.
+  nikol::u32 visible_count = (nikol::u32)cl.visible_indices.size();
+  nikol::u32 kept_count    = glm::min(visible_count, CLUSTER_GPU_LIGHTS_MAX);
+  radix_sort_floats(cl.light_sort, cl.visible_distances.data(), visible_count);
+
+  cl.view_lights.clear();
+  cl.light_slices.clear();
+
+  for(nikol::u32 i = 0; i < kept_count; i++) {
+    nikol::u32 light = cl.visible_indices[cl.light_sort.order[i]];
+
+    cl.view_lights.push_back(cl.transformed[light]);
+    cl.light_slices.push_back(cl.transformed_slices[light]);
+  }
+
+  cl.stats.lights_visible = visible_count;
+  cl.stats.lights_dropped = visible_count - kept_count;
+
+  // Every slice is its own job. No two jobs ever touch the same cluster.
+  job_system_parallel_for(CLUSTER_GRID_Z, 1, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 slice = start; slice < end; slice++) {
+      bin_slice(cl, slice);
+    }
+  });
+
+  // Too many indices for the uniform buffer cuts every list to the same length instead of dropping 
+  // the clusters packed last. Each of them then still has its nearest lights.
+  nikol::u32 indices_total = 0;
+  for(auto total : cl.cluster_counts) {
+    indices_total += glm::min(total, CLUSTER_LIGHTS_MAX);
+  }
+
+  cl.stats.cluster_lights_cap = indices_total > CLUSTER_GPU_INDICES_MAX ? find_cluster_lights_cap(cl) : CLUSTER_LIGHTS_MAX;
+
+  // Packing every list one after the other
+  cl.light_indices.clear();
+
+  for(nikol::u32 c = 0; c < CLUSTERS_COUNT; c++) {
+    nikol::u32 total  = cl.cluster_counts[c];
+    nikol::u32 stored = glm::min(total, cl.stats.cluster_lights_cap);
+
+    nikol::u32 offset    = (nikol::u32)cl.light_indices.size();
+    cl.cluster_ranges[c] = glm::uvec2(offset, stored);
+    cl.packed_ranges[c]  = glm::min(offset, CLUSTER_RANGE_OFFSET_MAX) | (stored << 16);
+
+    const nikol::u16* list = &cl.cluster_scratch[c * CLUSTER_LIGHTS_MAX];
+    cl.light_indices.insert(cl.light_indices.end(), list, list + stored);
+
+    cl.stats.clusters_lit        += (stored > 0);
+    cl.stats.clusters_overflowed += (total > CLUSTER_LIGHTS_MAX);
+    cl.stats.max_per_cluster      = glm::max(cl.stats.max_per_cluster, total);
+  }
+
+  cl.stats.light_indices   = (nikol::u32)cl.light_indices.size();
+  cl.stats.indices_dropped = indices_total - cl.stats.light_indices;
+}
+
+void clustered_lighting_upload(ClusteredLighting& cl, const glm::vec3& ambient) {
+  if(!cl.gfx) {
+    return;
+  }
+
+  // The binning already left out whatever does not fit (see `ClusterStats::lights_dropped`)
+  nikol::u32 lights_count  = (nikol::u32)cl.view_lights.size();
+  nikol::u32 indices_count = (nikol::u32)cl.light_indices.size();
+
+  cl.params.grid_size.w = lights_count;
+  cl.params.ambient     = glm::vec4(ambient, 1.0f);
+
+  nikol::gfx_buffer_update(cl.gfx, cl.params_buffer, 0, sizeof(ClusterParams), &cl.params);
+  nikol::gfx_buffer_update(cl.gfx, cl.ranges_buffer, 0, sizeof(nikol::u32) * CLUSTERS_COUNT, cl.packed_ranges.data());
+
+  if(lights_count > 0) {
+    nikol::gfx_buffer_update(cl.gfx, cl.lights_buffer, 0, sizeof(PointLight) * lights_count, cl.view_lights.data());
+  }
+
+  if(indices_count > 0) {
+    nikol::gfx_buffer_update(cl.gfx, cl.indices_buffer, 0, sizeof(nikol::u16) * indices_count, cl.light_indices.data());
+  }
+}
+
+nikol::u32 clustered_lighting_find_cluster(const ClusteredLighting& cl, const glm::vec3& view_pos) {
+  nikol::f32 depth = -view_pos.z;
+  if(depth < cl.near || depth > cl.far) {
+    return CLUSTERS_COUNT;
+  }
+
+  // Same as the shader, only from the view space position instead of the pixel
+  glm::vec4 clip = cl.projection * glm::vec4(view_pos, 1.0f);
+  glm::vec2 ndc  = glm::vec2(clip) / clip.w;
+  if(glm::abs(ndc.x) > 1.0f || glm::abs(ndc.y) > 1.0f) {
+    return CLUSTERS_COUNT;
+  }
+
+  nikol::u32 x = glm::min((nikol::u32)((ndc.x * 0.5f + 0.5f) * CLUSTER_GRID_X), CLUSTER_GRID_X - 1);
+  nikol::u32 y = glm::min((nikol::u32)((ndc.y * 0.5f + 0.5f) * CLUSTER_GRID_Y), CLUSTER_GRID_Y - 1);
+  nikol::u32 z = depth_to_slice(cl, depth);
+
+  return z * CLUSTERS_PER_SLICE + y * CLUSTER_GRID_X + x;
+}
+// ClusteredLighting functions
+// ----------------------------------------------------------------------------
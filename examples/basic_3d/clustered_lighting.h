@@ -0,0 +1,167 @@
+#pragma once
+
+#include "radix_sort.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The grid in view space: screen tiles on X and Y and exponential depth slices on Z
+const nikol::u32 CLUSTER_GRID_X     = 16;
+const nikol::u32 CLUSTER_GRID_Y     = 9;
+const nikol::u32 CLUSTER_GRID_Z     = 24;
+const nikol::u32 CLUSTERS_PER_SLICE = CLUSTER_GRID_X * CLUSTER_GRID_Y;
+const nikol::u32 CLUSTERS_COUNT     = CLUSTERS_PER_SLICE * CLUSTER_GRID_Z;
+
+// Anything past this in a single cluster is dropped
+const nikol::u32 CLUSTER_LIGHTS_MAX = 256;
+
+// Light indices are 16-bit
+const nikol::u32 CLUSTER_BIN_LIGHTS_MAX = 0xffff;
+
+// Every uniform block stays within 16 KiB, the smallest `GL_MAX_UNIFORM_BLOCK_SIZE` GL allows
+// (D3D11 always has 64 KiB). nikol has no way to ask for the actual limit, so this is all the 
+// lights and indices that are guaranteed to work everywhere. Its textures are 8-bit only and 
+// cannot be updated, so they offer no way around it either.
+const nikol::u32 CLUSTER_UNIFORM_BLOCK_SIZE = 16 * 1024;
+
+// How much of the result fits in the uniform buffers
+const nikol::u32 CLUSTER_GPU_LIGHTS_MAX  = CLUSTER_UNIFORM_BLOCK_SIZE / 32;                // Two vec4s each
+const nikol::u32 CLUSTER_GPU_INDICES_MAX = CLUSTER_UNIFORM_BLOCK_SIZE / sizeof(nikol::u16);
+
+// Cluster ranges are uploaded as (offset | count << 16), so the offsets past 0xffff get clamped
+// (they are past `CLUSTER_GPU_INDICES_MAX` anyway) and the counts have to fit in 16 bits
+const nikol::u32 CLUSTER_RANGE_OFFSET_MAX = 0xffff;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// PointLight
+// Also the layout of a light in the shader (two vec4s), but with the position in view space there
+struct PointLight {
+  glm::vec3 position;
+  nikol::f32 radius;
+
+  glm::vec3 color;
+  nikol::f32 intensity;
+};
+static_assert(sizeof(PointLight) == 32, "PointLight has to be two vec4s for std140");
+// PointLight
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ClusterParams
+// The `ClusterParams` block in the shader
+struct ClusterParams {
+  glm::uvec4 grid_size;   // x, y, z and the uploaded lights count
+  glm::vec4 tile_size;    // In pixels (x, y)
+  glm::vec4 slicing;      // Slice = log(depth) * x + y
+  glm::vec4 ambient;
+};
+// ClusterParams
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ClusterStats
+struct ClusterStats {
+  nikol::u32 lights_total    = 0;
+  nikol::u32 lights_visible  = 0; // Touching at least the frustum's bounds
+  nikol::u32 light_indices   = 0; // Summed over every cluster
+  nikol::u32 clusters_lit    = 0; // Clusters with at least one light
+  nikol::u32 max_per_cluster = 0;
+
+  nikol::u32 clusters_overflowed = 0; // Clusters that hit `CLUSTER_LIGHTS_MAX`
+  nikol::u32 lights_dropped      = 0; // The furthest visible lights, past `CLUSTER_GPU_LIGHTS_MAX`
+  nikol::u32 indices_dropped     = 0; // Cut off the end of the lists to fit `CLUSTER_GPU_INDICES_MAX`
+  nikol::u32 cluster_lights_cap  = 0; // What every list got cut to (`CLUSTER_LIGHTS_MAX` when nothing was)
+};
+// ClusterStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ClusteredLighting
+// Lights get binned into a grid of view space clusters on the CPU every frame. The shader then
+// finds its cluster from the fragment's position and only loops over the lights in there.
+//
+// Every cluster gets an (offset, count) range into one compact list of 16-bit light indices.
+// The lights are binned nearest first, so whenever the uniform buffers run out, the lights 
+// left out are the furthest ones (rather than the last ones submitted).
+struct ClusteredLighting {
+  nikol::GfxContext* gfx = nullptr;
+
+  // What the grid was last built for
+  glm::mat4 projection = glm::mat4(0.0f);
+  nikol::u32 width     = 0;
+  nikol::u32 height    = 0;
+  nikol::f32 near      = 0.1f;
+  nikol::f32 far       = 100.0f;
+
+  // The view space bounds of every cluster as structure-of-arrays, slice after slice
+  std::vector<nikol::f32> min_x, min_y, min_z;
+  std::vector<nikol::f32> max_x, max_y, max_z;
+
+  // The Y bounds of every row of tiles in every slice, to skip whole rows at once
+  std::vector<glm::vec2> row_bounds;
+
+  // The visible lights (in view space) and the first and last slice each one spans
+  std::vector<PointLight> view_lights;
+  std::vector<glm::uvec2> light_slices;
+
+  // Per input light, before the invisible ones get dropped
+  std::vector<nikol::u8> is_visible;
+  std::vector<PointLight> transformed;
+  std::vector<glm::uvec2> transformed_slices;
+
+  // The visible lights and how far their spheres are from the eye, sorted nearest first
+  std::vector<nikol::u32> visible_indices;
+  std::vector<nikol::f32> visible_distances;
+  RadixSort light_sort;
+
+  // Per cluster, before the compaction (`CLUSTER_LIGHTS_MAX` indices each)
+  std::vector<nikol::u32> cluster_counts;
+  std::vector<nikol::u16> cluster_scratch;
+
+  // The results
+  std::vector<glm::uvec2> cluster_ranges; // (offset, count)
+  std::vector<nikol::u16> light_indices;
+
+  // `cluster_ranges` as uploaded (see `CLUSTER_RANGE_OFFSET_MAX`)
+  std::vector<nikol::u32> packed_ranges;
+
+  ClusterParams params;
+  ClusterStats stats;
+
+  // Uniform buffers
+  nikol::GfxBuffer* params_buffer  = nullptr;
+  nikol::GfxBuffer* lights_buffer  = nullptr;
+  nikol::GfxBuffer* ranges_buffer  = nullptr;
+  nikol::GfxBuffer* indices_buffer = nullptr;
+};
+// ClusteredLighting
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ClusteredLighting functions
+
+// `gfx` can be `nullptr` to only do the CPU side (no uploads)
+void clustered_lighting_init(ClusteredLighting& cl, nikol::GfxContext* gfx);
+void clustered_lighting_shutdown(ClusteredLighting& cl);
+
+// Rebuild the cluster bounds if the projection or the screen size changed.
+// `projection` has to be a (right handed, OpenGL style) perspective projection.
+void clustered_lighting_update_grid(ClusteredLighting& cl, const glm::mat4& projection, const nikol::u32 width, const nikol::u32 height);
+
+// Bin `lights` (in world space) into the clusters, using the job system
+void clustered_lighting_bin(ClusteredLighting& cl, const PointLight* lights, const nikol::u32 count, const glm::mat4& view);
+
+// Upload the last binning for the shader
+void clustered_lighting_upload(ClusteredLighting& cl, const glm::vec3& ambient);
+
+// The cluster a view space position ends up in (or `CLUSTERS_COUNT` if it is outside the grid)
+nikol::u32 clustered_lighting_find_cluster(const ClusteredLighting& cl, const glm::vec3& view_pos);
+// ClusteredLighting functions
+// ----------------------------------------------------------------------------
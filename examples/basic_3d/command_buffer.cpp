@@ -0,0 +1,246 @@
+#include "command_buffer.h"
+#include "linear_allocator.h"
+#include "state_cache.h"
+#include "indirect_draw.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+// Private functions
+template<typename T>
+static T* push_command(CommandBuffer& cmd, const CommandType type, const nikol::sizei extra_size = 0) {
+  nikol::sizei size = sizeof(T) + extra_size;
+
+  T* command = (T*)linear_allocator_alloc(*cmd.memory, size, alignof(T));
+  command->header.type = type;
+  command->header.size = (nikol::u32)size;
+  command->header.next = nullptr;
+
+  if(cmd.tail) {
+    cmd.tail->next = &command->header;
+  }
+  else {
+    cmd.head = &command->header;
+  }
+
+  cmd.tail = &command->header;
+  cmd.commands_count++;
+  cmd.bytes += size;
+
+  return command;
+}
+
+static bool is_same_update(const CommandUpdateBuffer* a, const CommandUpdateBuffer* b) {
+  return a && b &&
+         a->buffer == b->buffer &&
+         a->offset == b->offset &&
+         a->size == b->size &&
+         a->data == b->data;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// CommandBuffer functions
+void command_buffer_begin(CommandBuffer& cmd, LinearAllocator& memory, const nikol::u32 sort_key) {
+  cmd.memory         = &memory;
+  cmd.head           = nullptr;
+  cmd.tail           = nullptr;
+  cmd.sort_key       = sort_key;
+  cmd.commands_count = 0;
+  cmd.bytes          = 0;
+}
+
+void command_buffer_apply_pipeline(CommandBuffer& cmd,
+                                   nikol::GfxPipeline* pipe,
+                                   const nikol::GfxPipelineDesc* desc,
+                                   nikol::GfxShader* shader,
+                                   nikol::GfxTexture* texture,
+                                   nikol::GfxBuffer* index_buffer,
+                                   const nikol::u32 indices_count) {
+  CommandApplyPipeline* command = push_command<CommandApplyPipeline>(cmd, COMMAND_APPLY_PIPELINE);
+
+  command->pipe          = pipe;
+  command->desc          = desc;
+  command->shader        = shader;
+  command->texture       = texture;
+  command->index_buffer  = index_buffer;
+  command->indices_count = indices_count;
+}
+
+void command_buffer_update_buffer(CommandBuffer& cmd, nikol::GfxBuffer* buffer, const nikol::sizei offset, const nikol::sizei size, const void* data) {
+  CommandUpdateBuffer* command = push_command<CommandUpdateBuffer>(cmd, COMMAND_UPDATE_BUFFER, size);
+
+  // The data goes right after the command
+  void* copy = (void*)(command + 1);
+  std::memcpy(copy, data, size);
+
+  command->buffer    = buffer;
+  command->offset    = offset;
+  command->size      = size;
+  command->data      = copy;
+  command->is_inline = true;
+}
+
+void command_buffer_update_buffer_ref(CommandBuffer& cmd, nikol::GfxBuffer* buffer, const nikol::sizei offset, const nikol::sizei size, const void* data) {
+  CommandUpdateBuffer* command = push_command<CommandUpdateBuffer>(cmd, COMMAND_UPDATE_BUFFER);
+
+  command->buffer    = buffer;
+  command->offset    = offset;
+  command->size      = size;
+  command->data      = data;
+  command->is_inline = false;
+}
+
+void command_buffer_draw_index(CommandBuffer& cmd, nikol::GfxPipeline* pipe) {
+  CommandDrawIndex* command = push_command<CommandDrawIndex>(cmd, COMMAND_DRAW_INDEX);
+  command->pipe = pipe;
+}
+
+void command_buffer_draw_indirect(CommandBuffer& cmd, 
+                                  const IndirectDrawState& state,
+                                  const DrawIndirectArgs* args, 
+                                  const nikol::u32 args_count, 
+                                  nikol::GfxBuffer* draw_buffer, 
+                                  const void* draw_data, 
+                                  const nikol::sizei draw_data_size, 
+                                  nikol::GfxBuffer* block_buffer, 
+                                  const DrawBlock* blocks) {
+  CommandDrawIndirect* command = push_command<CommandDrawIndirect>(cmd, COMMAND_DRAW_INDIRECT);
+
+  command->pipe           = state.pipe;
+  command->args           = args;
+  command->args_count     = args_count;
+  command->draw_buffer    = draw_buffer;
+  command->draw_data      = draw_data;
+  command->draw_data_size = draw_data_size;
+  command->index_buffer   = state.index_buffer;
+  command->index_source   = state.index_source;
+  command->index_buffers  = state.index_buffers;
+  command->block_buffer   = block_buffer;
+  command->blocks         = blocks;
+}
+
+CommandStats command_buffers_submit(CommandBuffer* buffers, const nikol::u32 count, nikol::GfxContext* gfx, StateCache& cache) {
+  CommandStats stats;
+
+  std::stable_sort(buffers, buffers + count, [](const CommandBuffer& a, const CommandBuffer& b) {
+    return a.sort_key < b.sort_key;
+  });
+
+  // Scratch space to patch the pipeline descs in
+  nikol::GfxPipelineDesc desc;
+  const CommandUpdateBuffer* last_ref_update = nullptr;
+  const void* last_block                      = nullptr;
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    const CommandBuffer& cmd = buffers[i];
+
+    stats.buffers++;
+    stats.bytes += cmd.bytes;
+
+    for(const CommandHeader* header = cmd.head; header; header = header->next) {
+      stats.commands++;
+
+      switch(header->type) {
+        case COMMAND_APPLY_PIPELINE: {
+          const CommandApplyPipeline* command = (const CommandApplyPipeline*)header;
+
+          desc                = *command->desc;
+          desc.shader         = command->shader;
+          desc.textures[0]    = command->texture;
+          desc.textures_count = 1;
+          desc.index_buffer   = command->index_buffer;
+          desc.indices_count  = command->indices_count;
+
+          state_cache_apply(cache, command->pipe, desc);
+        } break;
+        case COMMAND_UPDATE_BUFFER: {
+          const CommandUpdateBuffer* command = (const CommandUpdateBuffer*)header;
+
+          // Streaming the same range again in a row would not change a thing
+          if(!command->is_inline && is_same_update(command, last_ref_update)) {
+            stats.updates_skipped++;
+            break;
+          }
+
+          nikol::gfx_buffer_update(gfx, command->buffer, command->offset, command->size, (void*)command->data);
+
+          if(!command->is_inline) {
+            last_ref_update = command;
+          }
+          else if(last_ref_update && last_ref_update->buffer == command->buffer) {
+            last_ref_update = nullptr;
+          }
+        } break;
+        case COMMAND_DRAW_INDEX: {
+          const CommandDrawIndex* command = (const CommandDrawIndex*)header;
+          nikol::gfx_pipeline_draw_index(gfx, command->pipe);
+        } break;
+        case COMMAND_DRAW_INDIRECT: {
+          const CommandDrawIndirect* command = (const CommandDrawIndirect*)header;
+          const nikol::u8* draw_data         = (const nikol::u8*)command->draw_data;
+
+          // The backend has no (multi) indirect draw to hand the arguments to, so they 
+          // get walked one by one. Only what differs between two draws is touched. The index buffers 
+          // of pooled meshes are already rebased onto their vertices, so `base_vertex` is always 0.
+          const DrawIndirectArgs* last_streamed = nullptr;
+
+          for(nikol::u32 j = 0; j < command->args_count; j++) {
+            const DrawIndirectArgs& args = command->args[j];
+            if(args.instances_count == 0) {
+              continue;
+            }
+
+            nikol::gfx_buffer_update(gfx, command->draw_buffer, 0, command->draw_data_size, (void*)(draw_data + args.base_instance * command->draw_data_size));
+
+            // Draws of the same pose next to each other only need it uploaded once
+            const DrawBlock* block = command->blocks ? &command->blocks[args.base_instance] : nullptr;
+            if(block && block->data && block->data != last_block) {
+              nikol::gfx_buffer_update(gfx, command->block_buffer, 0, block->size, (void*)block->data);
+              last_block = block->data;
+            }
+            else if(block && block->data) {
+              stats.updates_skipped++;
+            }
+
+            bool is_same_range = last_streamed && 
+                                 last_streamed->first_index == args.first_index && 
+                                 last_streamed->indices_count == args.indices_count;
+
+            if(command->index_source && !is_same_range) {
+              nikol::gfx_buffer_update(gfx, command->index_buffer, 0, args.indices_count * sizeof(nikol::u32), (void*)(command->index_source + args.first_index));
+              last_streamed = &args;
+            }
+            else if(command->index_source) {
+              stats.updates_skipped++;
+            }
+
+            if(command->index_buffers) {
+              desc.index_buffer = command->index_buffers[args.base_instance];
+            }
+
+            desc.indices_count = args.indices_count;
+            state_cache_apply(cache, command->pipe, desc);
+
+            nikol::gfx_pipeline_draw_index(gfx, command->pipe);
+            stats.indirect_draws++;
+          }
+
+          // The index buffer might not hold what the last reference update put there anymore
+          last_ref_update = nullptr;
+        } break;
+        default:
+          NIKOL_ASSERT(false, "Invalid command type");
+          break;
+      }
+    }
+  }
+
+  return stats;
+}
+// CommandBuffer functions
+// ----------------------------------------------------------------------------
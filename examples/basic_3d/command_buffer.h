@@ -0,0 +1,165 @@
+#pragma once
+
+#include "linear_allocator.h"
+#include "state_cache.h"
+#include "indirect_draw.h"
+
+#include <nikol/nikol_core.hpp>
+
+// ----------------------------------------------------------------------------
+// CommandType
+enum CommandType : nikol::u32 {
+  COMMAND_APPLY_PIPELINE = 0,
+  COMMAND_UPDATE_BUFFER,
+  COMMAND_DRAW_INDEX,
+  COMMAND_DRAW_INDIRECT,
+
+  COMMAND_TYPES_MAX,
+};
+// CommandType
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// DrawBlock
+// Per-draw data too big for the draw data itself (a joint palette, say), only pointed at. Empty (`nullptr`) for most draws.
+struct DrawBlock {
+  const void* data;
+  nikol::sizei size;
+};
+// DrawBlock
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Commands
+// Plain old data, chained together in the memory of whoever recorded them
+struct CommandHeader {
+  CommandType type;
+  nikol::u32 size; // Including the header and any inline data
+  CommandHeader* next;
+};
+
+// Apply `pipe` with `desc`, patched with the per-draw bindings. `desc` itself is
+// never written to, so recording threads can share it.
+struct CommandApplyPipeline {
+  CommandHeader header;
+
+  nikol::GfxPipeline* pipe;
+  const nikol::GfxPipelineDesc* desc;
+
+  nikol::GfxShader* shader;
+  nikol::GfxTexture* texture;
+  nikol::GfxBuffer* index_buffer;
+  nikol::u32 indices_count;
+};
+
+// Upload `size` bytes into `buffer` at `offset`. Small blocks (uniforms) are copied right
+// after the command, while big ones are only pointed at and have to outlive the submission.
+struct CommandUpdateBuffer {
+  CommandHeader header;
+
+  nikol::GfxBuffer* buffer;
+  nikol::sizei offset;
+  nikol::sizei size;
+  const void* data;
+  bool is_inline;
+};
+
+struct CommandDrawIndex {
+  CommandHeader header;
+
+  nikol::GfxPipeline* pipe;
+};
+
+// Draw `args_count` argument blocks of `state` (applied right before). Before every draw, the
+// `draw_data_size` bytes at `draw_data[base_instance]` are uploaded into `draw_buffer`, and so is 
+// `blocks[base_instance]` into `block_buffer` (if there are blocks and it is not the one uploaded last).
+// None of the arrays are copied, so they have to outlive the submission.
+struct CommandDrawIndirect {
+  CommandHeader header;
+
+  nikol::GfxPipeline* pipe;
+  const DrawIndirectArgs* args;
+  nikol::u32 args_count;
+
+  nikol::GfxBuffer* draw_buffer;
+  const void* draw_data;
+  nikol::sizei draw_data_size;
+
+  // See `IndirectDrawState::index_source` and `IndirectDrawState::index_buffers`
+  nikol::GfxBuffer* index_buffer;
+  const nikol::u32* index_source;
+  nikol::GfxBuffer* const* index_buffers;
+
+  nikol::GfxBuffer* block_buffer;
+  const DrawBlock* blocks;
+};
+// Commands
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// CommandBuffer
+// A list of commands recorded by one thread. Buffers carry a sort key, so however the
+// recording got split between threads, they are always executed in the same order.
+struct CommandBuffer {
+  LinearAllocator* memory = nullptr;
+
+  CommandHeader* head = nullptr;
+  CommandHeader* tail = nullptr;
+
+  nikol::u32 sort_key       = 0;
+  nikol::u32 commands_count = 0;
+  nikol::sizei bytes        = 0;
+};
+// CommandBuffer
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// CommandStats
+struct CommandStats {
+  nikol::u32 buffers  = 0;
+  nikol::u32 commands = 0;
+  nikol::sizei bytes  = 0;
+
+  nikol::u32 updates_skipped = 0; // Non-inline uploads of exactly what was uploaded last
+  nikol::u32 indirect_draws  = 0; // Argument blocks drawn by the indirect commands
+};
+// CommandStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// CommandBuffer functions
+
+// Start recording into `memory`, which has to belong to the recording thread
+void command_buffer_begin(CommandBuffer& cmd, LinearAllocator& memory, const nikol::u32 sort_key);
+
+void command_buffer_apply_pipeline(CommandBuffer& cmd,
+                                   nikol::GfxPipeline* pipe,
+                                   const nikol::GfxPipelineDesc* desc,
+                                   nikol::GfxShader* shader,
+                                   nikol::GfxTexture* texture,
+                                   nikol::GfxBuffer* index_buffer,
+                                   const nikol::u32 indices_count);
+
+// Copies `data` into the command buffer
+void command_buffer_update_buffer(CommandBuffer& cmd, nikol::GfxBuffer* buffer, const nikol::sizei offset, const nikol::sizei size, const void* data);
+
+// Only keeps `data` around, so it has to stay alive (and unchanged) until the buffer gets executed
+void command_buffer_update_buffer_ref(CommandBuffer& cmd, nikol::GfxBuffer* buffer, const nikol::sizei offset, const nikol::sizei size, const void* data);
+
+void command_buffer_draw_index(CommandBuffer& cmd, nikol::GfxPipeline* pipe);
+
+void command_buffer_draw_indirect(CommandBuffer& cmd, 
+                                  const IndirectDrawState& state,
+                                  const DrawIndirectArgs* args, 
+                                  const nikol::u32 args_count, 
+                                  nikol::GfxBuffer* draw_buffer, 
+                                  const void* draw_data, 
+                                  const nikol::sizei draw_data_size, 
+                                  nikol::GfxBuffer* block_buffer = nullptr, 
+                                  const DrawBlock* blocks        = nullptr);
+
+// Sort `buffers` by their key (keeping the order of equal keys) and execute them one after the other.
+// Has to be called from the thread that owns `gfx`.
+CommandStats command_buffers_submit(CommandBuffer* buffers, const nikol::u32 count, nikol::GfxContext* gfx, StateCache& cache);
+// CommandBuffer functions
+// ----------------------------------------------------------------------------
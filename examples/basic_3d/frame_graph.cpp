@@ -0,0 +1,493 @@
+#include "frame_graph.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+static const nikol::u32 s_format_sizes[RENDER_TARGET_FORMATS_MAX] = {
+  4,  // RGBA8
+  8,  // RGBA16F
+  4,  // R32F
+  4,  // DEPTH24_STENCIL8
+  4,  // DEPTH32F
+};
+
+static const char* s_format_names[RENDER_TARGET_FORMATS_MAX] = {
+  "RGBA8",
+  "RGBA16F",
+  "R32F",
+  "DEPTH24_STENCIL8",
+  "DEPTH32F",
+};
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// FNV-1a
+static void hash_bytes(nikol::u64& hash, const void* data, const nikol::sizei size) {
+  const nikol::u8* bytes = (const nikol::u8*)data;
+
+  for(nikol::sizei i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+}
+
+static void hash_string(nikol::u64& hash, const char* str) {
+  hash_bytes(hash, str, str ? std::strlen(str) + 1 : 0);
+}
+
+static nikol::u64 hash_topology(const FrameGraph& graph) {
+  nikol::u64 hash = 14695981039346656037ull;
+
+  // Only what can change the schedule. The callbacks and their data can change freely.
+  nikol::u32 counts[2] = {(nikol::u32)graph.passes.size(), (nikol::u32)graph.resources.size()};
+  hash_bytes(hash, counts, sizeof(counts));
+
+  for(auto& res : graph.resources) {
+    hash_string(hash, res.name);
+    hash_bytes(hash, &res.desc, sizeof(RenderTargetDesc));
+    hash_bytes(hash, &res.is_imported, sizeof(bool));
+  }
+
+  for(auto& pass : graph.passes) {
+    nikol::u32 sizes[2] = {(nikol::u32)pass.reads.size(), (nikol::u32)pass.writes.size()};
+
+    hash_string(hash, pass.name);
+    hash_bytes(hash, sizes, sizeof(sizes));
+    hash_bytes(hash, pass.reads.data(), pass.reads.size() * sizeof(FrameGraphResource));
+    hash_bytes(hash, pass.writes.data(), pass.writes.size() * sizeof(FrameGraphResource));
+    hash_bytes(hash, &pass.has_side_effects, sizeof(bool));
+  }
+
+  return hash;
+}
+
+static bool pass_writes(const FrameGraphPassNode& pass, const FrameGraphResource res) {
+  return std::find(pass.writes.begin(), pass.writes.end(), res) != pass.writes.end();
+}
+
+static bool pass_reads(const FrameGraphPassNode& pass, const FrameGraphResource res) {
+  return std::find(pass.reads.begin(), pass.reads.end(), res) != pass.reads.end();
+}
+
+static void add_dependency(std::vector<std::vector<FrameGraphPass>>& deps, const FrameGraphPass before, const FrameGraphPass after) {
+  if(before == after) {
+    return;
+  }
+
+  auto& list = deps[after];
+  if(std::find(list.begin(), list.end(), before) == list.end()) {
+    list.push_back(before);
+  }
+}
+
+// `deps[i]` ends up with every pass that has to run before pass `i`
+static void build_dependencies(const FrameGraph& graph, std::vector<std::vector<FrameGraphPass>>& deps) {
+  nikol::u32 passes_count = (nikol::u32)graph.passes.size();
+  deps.assign(passes_count, {});
+
+  for(FrameGraphResource res = 0; res < graph.resources.size(); res++) {
+    bool is_imported = graph.resources[res].is_imported;
+
+    for(FrameGraphPass i = 0; i < passes_count; i++) {
+      const FrameGraphPassNode& pass = graph.passes[i];
+
+      bool reads  = pass_reads(pass, res);
+      bool writes = pass_writes(pass, res);
+      if(!reads && !writes) {
+        continue;
+      }
+
+      for(FrameGraphPass j = 0; j < passes_count; j++) {
+        const FrameGraphPassNode& other = graph.passes[j];
+
+        // A transient has one producer, no matter where it was added
+        if(!is_imported) {
+          if(reads && pass_writes(other, res)) {
+            add_dependency(deps, j, i);
+          }
+
+          continue;
+        }
+
+        // Imported resources go in the order the passes were added:
+        // reads after writes, writes after writes and writes after reads
+        if(j >= i) {
+          break;
+        }
+
+        bool other_writes = pass_writes(other, res);
+        bool other_reads  = pass_reads(other, res);
+
+        if(other_writes || (writes && other_reads)) {
+          add_dependency(deps, j, i);
+        }
+      }
+    }
+  }
+}
+
+static void cull_passes(const FrameGraph& graph, const std::vector<std::vector<FrameGraphPass>>& deps, std::vector<nikol::u8>& is_culled) {
+  nikol::u32 passes_count = (nikol::u32)graph.passes.size();
+  is_culled.assign(passes_count, 1);
+
+  // Whatever ends up outside the graph keeps its pass alive...
+  std::vector<FrameGraphPass> stack;
+  for(FrameGraphPass i = 0; i < passes_count; i++) {
+    const FrameGraphPassNode& pass = graph.passes[i];
+
+    bool is_root = pass.has_side_effects;
+    for(auto res : pass.writes) {
+      is_root |= graph.resources[res].is_imported;
+    }
+
+    if(is_root) {
+      is_culled[i] = 0;
+      stack.push_back(i);
+    }
+  }
+
+  // ...along with everything it depends on
+  while(!stack.empty()) {
+    FrameGraphPass pass = stack.back();
+    stack.pop_back();
+
+    for(auto dep : deps[pass]) {
+      if(is_culled[dep]) {
+        is_culled[dep] = 0;
+        stack.push_back(dep);
+      }
+    }
+  }
+}
+
+static void order_passes(const FrameGraph& graph, const std::vector<std::vector<FrameGraphPass>>& deps, FrameGraphSchedule& schedule) {
+  nikol::u32 passes_count = (nikol::u32)graph.passes.size();
+
+  std::vector<nikol::u32> waiting_on(passes_count, 0);
+  std::vector<std::vector<FrameGraphPass>> dependents(passes_count);
+
+  for(FrameGraphPass i = 0; i < passes_count; i++) {
+    if(schedule.is_culled[i]) {
+      continue;
+    }
+
+    for(auto dep : deps[i]) {
+      waiting_on[i]++;
+      dependents[dep].push_back(i);
+    }
+  }
+
+  // Kahn's algorithm. Ties go to the pass that was added first, so independent
+  // passes keep the order they were declared in.
+  std::vector<FrameGraphPass> ready;
+  for(FrameGraphPass i = 0; i < passes_count; i++) {
+    if(!schedule.is_culled[i] && waiting_on[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+
+  schedule.order.clear();
+  while(!ready.empty()) {
+    auto next = std::min_element(ready.begin(), ready.end());
+
+    FrameGraphPass pass = *next;
+    ready.erase(next);
+    schedule.order.push_back(pass);
+
+    for(auto dependent : dependents[pass]) {
+      if(--waiting_on[dependent] == 0) {
+        ready.push_back(dependent);
+      }
+    }
+  }
+
+  NIKOL_ASSERT(schedule.order.size() == (passes_count - (nikol::sizei)std::count(schedule.is_culled.begin(), schedule.is_culled.end(), 1)),
+               "Cycle in the frame graph");
+}
+
+static void compute_lifetimes(const FrameGraph& graph, FrameGraphSchedule& schedule) {
+  nikol::u32 resources_count = (nikol::u32)graph.resources.size();
+
+  schedule.first_uses.assign(resources_count, FRAME_GRAPH_INVALID);
+  schedule.last_uses.assign(resources_count, FRAME_GRAPH_INVALID);
+
+  for(nikol::u32 pos = 0; pos < schedule.order.size(); pos++) {
+    const FrameGraphPassNode& pass = graph.passes[schedule.order[pos]];
+
+    auto touch = [&](const FrameGraphResource res) {
+      if(schedule.first_uses[res] == FRAME_GRAPH_INVALID) {
+        schedule.first_uses[res] = pos;
+      }
+
+      schedule.last_uses[res] = pos;
+    };
+
+    for(auto res : pass.reads) {
+      touch(res);
+    }
+
+    for(auto res : pass.writes) {
+      touch(res);
+    }
+  }
+}
+
+static void alias_transients(const FrameGraph& graph, FrameGraphSchedule& schedule, FrameGraphStats& stats) {
+  nikol::u32 resources_count = (nikol::u32)graph.resources.size();
+
+  schedule.physicals.clear();
+  schedule.resource_physicals.assign(resources_count, FRAME_GRAPH_INVALID);
+
+  // Every used transient, from the first to be needed to the last (the biggest first on ties)
+  std::vector<FrameGraphResource> transients;
+  for(FrameGraphResource res = 0; res < resources_count; res++) {
+    if(!graph.resources[res].is_imported && schedule.first_uses[res] != FRAME_GRAPH_INVALID) {
+      transients.push_back(res);
+    }
+  }
+
+  std::sort(transients.begin(), transients.end(), [&](const FrameGraphResource a, const FrameGraphResource b) {
+    if(schedule.first_uses[a] != schedule.first_uses[b]) {
+      return schedule.first_uses[a] < schedule.first_uses[b];
+    }
+
+    return render_target_get_size(graph.resources[a].desc) > render_target_get_size(graph.resources[b].desc);
+  });
+
+  nikol::sizei heap_end = 0;
+  stats.memory_unaliased = 0;
+
+  for(auto res : transients) {
+    nikol::sizei size     = render_target_get_size(graph.resources[res].desc);
+    nikol::u32 first      = schedule.first_uses[res];
+    nikol::u32 best       = FRAME_GRAPH_INVALID;
+    nikol::u32 last_block = FRAME_GRAPH_INVALID;
+
+    stats.memory_unaliased += size;
+
+    // The smallest block that is free by now and big enough
+    for(nikol::u32 i = 0; i < schedule.physicals.size(); i++) {
+      const PhysicalResource& block = schedule.physicals[i];
+      if(block.free_after >= first) {
+        continue;
+      }
+
+      if((block.offset + block.size) == heap_end) {
+        last_block = i;
+      }
+
+      if(block.size >= size && (best == FRAME_GRAPH_INVALID || block.size < schedule.physicals[best].size)) {
+        best = i;
+      }
+    }
+
+    // A free block at the end of the heap can just grow instead
+    if(best == FRAME_GRAPH_INVALID && last_block != FRAME_GRAPH_INVALID) {
+      best = last_block;
+
+      PhysicalResource& block = schedule.physicals[best];
+      block.size = size;
+      heap_end   = block.offset + size;
+    }
+
+    if(best == FRAME_GRAPH_INVALID) {
+      best = (nikol::u32)schedule.physicals.size();
+      schedule.physicals.push_back(PhysicalResource{.offset = heap_end, .size = size});
+
+      heap_end += size;
+    }
+
+    schedule.physicals[best].free_after = schedule.last_uses[res];
+    schedule.resource_physicals[res]    = best;
+  }
+
+  stats.transients         = (nikol::u32)transients.size();
+  stats.physical_resources = (nikol::u32)schedule.physicals.size();
+  stats.memory_aliased     = heap_end;
+}
+
+static void print_list(FILE* file, const FrameGraph& graph, const char* label, const std::vector<FrameGraphResource>& list) {
+  if(list.empty()) {
+    return;
+  }
+
+  fprintf(file, " %s:", label);
+  for(auto res : list) {
+    fprintf(file, " %s", graph.resources[res].name);
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrameGraph functions
+nikol::sizei render_target_get_size(const RenderTargetDesc& desc) {
+  return (nikol::sizei)desc.width * desc.height * s_format_sizes[desc.format];
+}
+
+void frame_graph_reset(FrameGraph& graph) {
+  graph.passes.clear();
+  graph.resources.clear();
+}
+
+FrameGraphResource frame_graph_create_target(FrameGraph& graph, const char* name, const RenderTargetDesc& desc) {
+  graph.resources.push_back(FrameGraphResourceNode{.name = name, .desc = desc, .is_imported = false});
+  return (FrameGraphResource)(graph.resources.size() - 1);
+}
+
+FrameGraphResource frame_graph_import_target(FrameGraph& graph, const char* name, const RenderTargetDesc& desc) {
+  graph.resources.push_back(FrameGraphResourceNode{.name = name, .desc = desc, .is_imported = true});
+  return (FrameGraphResource)(graph.resources.size() - 1);
+}
+
+FrameGraphPass frame_graph_add_pass(FrameGraph& graph, const char* name, FrameGraphExecuteFn execute, void* user_data) {
+  FrameGraphPassNode pass;
+  pass.name      = name;
+  pass.execute   = execute;
+  pass.user_data = user_data;
+
+  graph.passes.push_back(pass);
+  return (FrameGraphPass)(graph.passes.size() - 1);
+}
+
+void frame_graph_read(FrameGraph& graph, const FrameGraphPass pass, const FrameGraphResource res) {
+  NIKOL_ASSERT(res < graph.resources.size(), "Reading an invalid frame graph resource");
+
+  auto& reads = graph.passes[pass].reads;
+  if(std::find(reads.begin(), reads.end(), res) == reads.end()) {
+    reads.push_back(res);
+  }
+}
+
+void frame_graph_write(FrameGraph& graph, const FrameGraphPass pass, const FrameGraphResource res) {
+  NIKOL_ASSERT(res < graph.resources.size(), "Writing an invalid frame graph resource");
+
+  if(!graph.resources[res].is_imported) {
+    for(FrameGraphPass i = 0; i < graph.passes.size(); i++) {
+      NIKOL_ASSERT(i == pass || !pass_writes(graph.passes[i], res), "A transient can only have one pass writing it");
+    }
+  }
+
+  auto& writes = graph.passes[pass].writes;
+  if(std::find(writes.begin(), writes.end(), res) == writes.end()) {
+    writes.push_back(res);
+  }
+}
+
+void frame_graph_set_side_effects(FrameGraph& graph, const FrameGraphPass pass) {
+  graph.passes[pass].has_side_effects = true;
+}
+
+bool frame_graph_compile(FrameGraph& graph) {
+  nikol::u64 hash = hash_topology(graph);
+
+  if(graph.is_compiled && hash == graph.compiled_hash) {
+    graph.stats.cache_hits++;
+    return false;
+  }
+
+  FrameGraphSchedule& schedule = graph.schedule;
+
+  std::vector<std::vector<FrameGraphPass>> deps;
+  build_dependencies(graph, deps);
+  cull_passes(graph, deps, schedule.is_culled);
+  order_passes(graph, deps, schedule);
+  compute_lifetimes(graph, schedule);
+  alias_transients(graph, schedule, graph.stats);
+
+  graph.stats.compiles++;
+  graph.stats.passes_total  = (nikol::u32)graph.passes.size();
+  graph.stats.passes_culled = graph.stats.passes_total - (nikol::u32)schedule.order.size();
+
+  graph.compiled_hash = hash;
+  graph.is_compiled   = true;
+
+  return true;
+}
+
+void frame_graph_execute(FrameGraph& graph) {
+  NIKOL_ASSERT(graph.is_compiled, "Executing a frame graph that was never compiled");
+
+  for(auto index : graph.schedule.order) {
+    FrameGraphPassNode& pass = graph.passes[index];
+
+    if(pass.execute) {
+      pass.execute(pass.user_data);
+    }
+  }
+}
+
+const PhysicalResource* frame_graph_get_physical(const FrameGraph& graph, const FrameGraphResource res) {
+  if(res >= graph.schedule.resource_physicals.size()) {
+    return nullptr;
+  }
+
+  nikol::u32 physical = graph.schedule.resource_physicals[res];
+  return (physical == FRAME_GRAPH_INVALID) ? nullptr : &graph.schedule.physicals[physical];
+}
+
+void frame_graph_dump(const FrameGraph& graph, FILE* file) {
+  const FrameGraphSchedule& schedule = graph.schedule;
+  const FrameGraphStats& stats       = graph.stats;
+
+  if(!graph.is_compiled) {
+    fprintf(file, "Frame graph: not compiled\n");
+    return;
+  }
+
+  fprintf(file, "Frame graph: %u passes (%u culled), %u transients in %u physical blocks\n",
+          stats.passes_total, stats.passes_culled, stats.transients, stats.physical_resources);
+
+  fprintf(file, "  Schedule:\n");
+  for(nikol::u32 pos = 0; pos < schedule.order.size(); pos++) {
+    const FrameGraphPassNode& pass = graph.passes[schedule.order[pos]];
+
+    fprintf(file, "    [%u] %-24s", pos, pass.name);
+    print_list(file, graph, "reads", pass.reads);
+    print_list(file, graph, "writes", pass.writes);
+    fprintf(file, "\n");
+  }
+
+  fprintf(file, "  Culled:\n");
+  for(FrameGraphPass i = 0; i < schedule.is_culled.size(); i++) {
+    if(schedule.is_culled[i]) {
+      fprintf(file, "    %s\n", graph.passes[i].name);
+    }
+  }
+
+  fprintf(file, "  Resources:\n");
+  for(FrameGraphResource res = 0; res < graph.resources.size(); res++) {
+    const FrameGraphResourceNode& node = graph.resources[res];
+
+    fprintf(file, "    %-24s %5ux%-5u %-16s %8.2f MiB ",
+            node.name, node.desc.width, node.desc.height, s_format_names[node.desc.format],
+            render_target_get_size(node.desc) / (1024.0 * 1024.0));
+
+    if(schedule.first_uses[res] == FRAME_GRAPH_INVALID) {
+      fprintf(file, "unused\n");
+    }
+    else if(node.is_imported) {
+      fprintf(file, "[%u, %u] imported\n", schedule.first_uses[res], schedule.last_uses[res]);
+    }
+    else {
+      const PhysicalResource& block = schedule.physicals[schedule.resource_physicals[res]];
+      fprintf(file, "[%u, %u] block %u @ %zu\n",
+              schedule.first_uses[res], schedule.last_uses[res], schedule.resource_physicals[res], (size_t)block.offset);
+    }
+  }
+
+  nikol::f64 saved = (stats.memory_unaliased > 0) ? 100.0 * (1.0 - (nikol::f64)stats.memory_aliased / stats.memory_unaliased) : 0.0;
+  fprintf(file, "  Memory: %.2f MiB unaliased, %.2f MiB aliased (%.1f%% saved)\n",
+          stats.memory_unaliased / (1024.0 * 1024.0), stats.memory_aliased / (1024.0 * 1024.0), saved);
+}
+// FrameGraph functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Handles
+// Indices into the graph's passes and resources. Only valid for the frame they were declared in.
+using FrameGraphPass     = nikol::u32;
+using FrameGraphResource = nikol::u32;
+
+const nikol::u32 FRAME_GRAPH_INVALID = (nikol::u32)-1;
+// Handles
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RenderTargetFormat
+enum RenderTargetFormat {
+  RENDER_TARGET_FORMAT_RGBA8 = 0,
+  RENDER_TARGET_FORMAT_RGBA16F,
+  RENDER_TARGET_FORMAT_R32F,
+  RENDER_TARGET_FORMAT_DEPTH24_STENCIL8,
+  RENDER_TARGET_FORMAT_DEPTH32F,
+
+  RENDER_TARGET_FORMATS_MAX,
+};
+// RenderTargetFormat
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RenderTargetDesc
+struct RenderTargetDesc {
+  nikol::u32 width  = 0;
+  nikol::u32 height = 0;
+
+  RenderTargetFormat format = RENDER_TARGET_FORMAT_RGBA8;
+};
+// RenderTargetDesc
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrameGraphStats
+struct FrameGraphStats {
+  nikol::u32 compiles   = 0;
+  nikol::u32 cache_hits = 0; // Frames that reused the last compiled schedule
+
+  nikol::u32 passes_total  = 0;
+  nikol::u32 passes_culled = 0;
+
+  nikol::u32 transients         = 0;
+  nikol::u32 physical_resources = 0;
+
+  nikol::sizei memory_unaliased = 0; // Every transient with its own memory
+  nikol::sizei memory_aliased   = 0; // The size of the transient heap
+};
+// FrameGraphStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrameGraphResourceNode
+struct FrameGraphResourceNode {
+  const char* name = nullptr;
+  RenderTargetDesc desc;
+
+  // Imported resources (like the back buffer) live outside the graph. They are never
+  // aliased and writing to one keeps the pass alive.
+  bool is_imported = false;
+};
+// FrameGraphResourceNode
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrameGraphPassNode
+using FrameGraphExecuteFn = void(*)(void* user_data);
+
+struct FrameGraphPassNode {
+  const char* name = nullptr;
+
+  FrameGraphExecuteFn execute = nullptr;
+  void* user_data             = nullptr;
+
+  std::vector<FrameGraphResource> reads;
+  std::vector<FrameGraphResource> writes;
+
+  // Never culled, even if nothing reads what it writes
+  bool has_side_effects = false;
+};
+// FrameGraphPassNode
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// PhysicalResource
+// A block of the transient heap that one or more transients (with disjoint lifetimes) share
+struct PhysicalResource {
+  nikol::sizei offset = 0;
+  nikol::sizei size   = 0;
+
+  nikol::u32 free_after = 0; // The last position in the schedule that uses it
+};
+// PhysicalResource
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrameGraphSchedule
+// Everything the compile produces. It only depends on the topology of the graph, so it is
+// kept around for as long as the frames keep declaring the same passes and resources.
+struct FrameGraphSchedule {
+  std::vector<FrameGraphPass> order;       // The passes that survived the culling, in execution order
+  std::vector<nikol::u8> is_culled;        // Per pass
+  std::vector<PhysicalResource> physicals;
+
+  // Per resource. The uses are positions in `order` and the physicals index into `physicals`
+  // (`FRAME_GRAPH_INVALID` for imported or unused resources).
+  std::vector<nikol::u32> first_uses;
+  std::vector<nikol::u32> last_uses;
+  std::vector<nikol::u32> resource_physicals;
+};
+// FrameGraphSchedule
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrameGraph
+// Passes declare the render targets they read and write every frame. Compiling the graph then:
+//  1. Culls every pass that does not (eventually) contribute to an imported resource or a side effect.
+//  2. Orders the rest so every pass comes after the producers of what it reads.
+//  3. Packs the transients into one heap, letting the ones whose lifetimes do not overlap share memory.
+//
+// The backend has no render target objects yet, so the heap is only laid out here (offsets and sizes)
+// for whoever ends up creating the actual memory.
+struct FrameGraph {
+  std::vector<FrameGraphPassNode> passes;
+  std::vector<FrameGraphResourceNode> resources;
+
+  FrameGraphSchedule schedule;
+  nikol::u64 compiled_hash = 0;
+  bool is_compiled         = false;
+
+  FrameGraphStats stats;
+};
+// FrameGraph
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrameGraph functions
+
+// The size of a render target of `desc` in bytes
+nikol::sizei render_target_get_size(const RenderTargetDesc& desc);
+
+// Forget every pass and resource for a new frame. The compiled schedule is kept.
+void frame_graph_reset(FrameGraph& graph);
+
+FrameGraphResource frame_graph_create_target(FrameGraph& graph, const char* name, const RenderTargetDesc& desc);
+FrameGraphResource frame_graph_import_target(FrameGraph& graph, const char* name, const RenderTargetDesc& desc);
+
+FrameGraphPass frame_graph_add_pass(FrameGraph& graph, const char* name, FrameGraphExecuteFn execute, void* user_data);
+
+// A transient can only have one pass writing it. Imported resources can have many,
+// which then run in the order they were added.
+void frame_graph_read(FrameGraph& graph, const FrameGraphPass pass, const FrameGraphResource res);
+void frame_graph_write(FrameGraph& graph, const FrameGraphPass pass, const FrameGraphResource res);
+void frame_graph_set_side_effects(FrameGraph& graph, const FrameGraphPass pass);
+
+// Cull, order and alias. Returns `false` if the topology did not change and the last schedule was reused.
+bool frame_graph_compile(FrameGraph& graph);
+
+// Run every surviving pass in order
+void frame_graph_execute(FrameGraph& graph);
+
+// Where a transient lives in the heap (imported resources return `nullptr`)
+const PhysicalResource* frame_graph_get_physical(const FrameGraph& graph, const FrameGraphResource res);
+
+// Print the schedule, the lifetimes and the memory savings
+void frame_graph_dump(const FrameGraph& graph, FILE* file);
+// FrameGraph functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,219 @@
+#include "geometry_pool.h"
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <map>
+#include <set>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void insert_free_block(RangeAllocator& alloc, const nikol::u32 offset, const nikol::u32 size) {
+  alloc.free_by_offset[offset] = size;
+  alloc.free_by_size.emplace(size, offset);
+}
+
+static void erase_free_block(RangeAllocator& alloc, const nikol::u32 offset, const nikol::u32 size) {
+  alloc.free_by_offset.erase(offset);
+  alloc.free_by_size.erase({size, offset});
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RangeAllocator functions
+void range_allocator_init(RangeAllocator& alloc, const nikol::u32 capacity) {
+  alloc.capacity = capacity;
+  alloc.used     = 0;
+
+  alloc.free_by_offset.clear();
+  alloc.free_by_size.clear();
+
+  if(capacity > 0) {
+    insert_free_block(alloc, 0, capacity);
+  }
+}
+
+nikol::u32 range_allocator_alloc(RangeAllocator& alloc, const nikol::u32 count) {
+  if(count == 0) {
+    return RANGE_INVALID;
+  }
+
+  // The smallest block that still fits (the lowest offset on ties)
+  auto best = alloc.free_by_size.lower_bound({count, 0});
+  if(best == alloc.free_by_size.end()) {
+    return RANGE_INVALID;
+  }
+
+  nikol::u32 size   = best->first;
+  nikol::u32 offset = best->second;
+  erase_free_block(alloc, offset, size);
+
+  // Give back whatever is left over
+  if(size > count) {
+    insert_free_block(alloc, offset + count, size - count);
+  }
+
+  alloc.used += count;
+  return offset;
+}
+
+void range_allocator_free(RangeAllocator& alloc, const nikol::u32 offset, const nikol::u32 count) {
+  if(count == 0 || offset == RANGE_INVALID) {
+    return;
+  }
+
+  NIKOL_ASSERT((offset + count) <= alloc.capacity, "Freeing a range outside of the allocator");
+
+  nikol::u32 start = offset;
+  nikol::u32 size  = count;
+
+  // Merge with the block right after...
+  auto next = alloc.free_by_offset.lower_bound(offset);
+  if(next != alloc.free_by_offset.end() && next->first == (offset + count)) {
+    nikol::u32 next_offset = next->first, next_size = next->second;
+
+    erase_free_block(alloc, next_offset, next_size);
+    size += next_size;
+  }
+
+  // ...and the one right before
+  auto prev = alloc.free_by_offset.lower_bound(offset);
+  if(prev != alloc.free_by_offset.begin()) {
+    prev--;
+
+    if((prev->first + prev->second) == offset) {
+      nikol::u32 prev_offset = prev->first, prev_size = prev->second;
+
+      erase_free_block(alloc, prev_offset, prev_size);
+      start  = prev_offset;
+      size  += prev_size;
+    }
+  }
+
+  insert_free_block(alloc, start, size);
+  alloc.used -= count;
+}
+
+nikol::u32 range_allocator_largest_free(const RangeAllocator& alloc) {
+  return alloc.free_by_size.empty() ? 0 : alloc.free_by_size.rbegin()->first;
+}
+
+nikol::f32 range_allocator_fragmentation(const RangeAllocator& alloc) {
+  nikol::u32 total_free = alloc.capacity - alloc.used;
+  if(total_free == 0) {
+    return 0.0f;
+  }
+
+  return 1.0f - ((nikol::f32)range_allocator_largest_free(alloc) / (nikol::f32)total_free);
+}
+// RangeAllocator functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// GeometryPool functions
+void geometry_pool_init(GeometryPool& pool, nikol::GfxContext* gfx, const nikol::u32 vertices_capacity) {
+  pool.gfx = gfx;
+
+  range_allocator_init(pool.vertex_alloc, vertices_capacity);
+  pool.indices_used  = 0;
+  pool.index_buffers = 0;
+
+  // Vertex buffer init (filled range by range)
+  nikol::GfxBufferDesc vert_desc = {
+    .data  = nullptr,
+    .size  = sizeof(Vertex) * vertices_capacity,
+    .type  = nikol::GFX_BUFFER_VERTEX,
+    .usage = nikol::GFX_BUFFER_USAGE_DYNAMIC_DRAW,
+  };
+  pool.pipe_desc.vertex_buffer  = nikol::gfx_buffer_create(gfx, vert_desc);
+  pool.pipe_desc.vertices_count = vertices_capacity;
+
+  // Every draw brings its own index buffer
+  pool.pipe_desc.index_buffer  = nullptr;
+  pool.pipe_desc.indices_count = 0;
+
+  // Shader init (will later be filled with the appropriate material)
+  pool.pipe_desc.shader = nullptr;
+
+  // Layout init (the default `Vertex` layout)
+  pool.pipe_desc.layout[0]    = nikol::GfxLayoutDesc{"POS", nikol::GFX_LAYOUT_FLOAT3, 0};
+  pool.pipe_desc.layout[1]    = nikol::GfxLayoutDesc{"NORMAL", nikol::GFX_LAYOUT_FLOAT3, 0};
+  pool.pipe_desc.layout[2]    = nikol::GfxLayoutDesc{"TEXCOORDS0", nikol::GFX_LAYOUT_FLOAT2, 0};
+  pool.pipe_desc.layout_count = 3;
+
+  // Draw mode init
+  pool.pipe_desc.draw_mode = nikol::GFX_DRAW_MODE_TRIANGLE;
+
+  // Pipeline init
+  pool.pipe = nikol::gfx_pipeline_create(gfx, pool.pipe_desc);
+}
+
+void geometry_pool_shutdown(GeometryPool& pool) {
+  if(!pool.pipe) {
+    return;
+  }
+
+  NIKOL_ASSERT(pool.index_buffers == 0, "Shutting down a geometry pool with meshes still in it");
+
+  nikol::gfx_pipeline_destroy(pool.pipe);
+  pool.pipe = nullptr;
+}
+
+nikol::u32 geometry_pool_alloc_vertices(GeometryPool& pool, const Vertex* vertices, const nikol::u32 count) {
+  nikol::u32 offset = range_allocator_alloc(pool.vertex_alloc, count);
+  if(offset == RANGE_INVALID) {
+    return RANGE_INVALID;
+  }
+
+  nikol::gfx_buffer_update(pool.gfx, pool.pipe_desc.vertex_buffer, offset * sizeof(Vertex), count * sizeof(Vertex), (void*)vertices);
+  return offset;
+}
+
+nikol::GfxBuffer* geometry_pool_create_index_buffer(GeometryPool& pool, const nikol::u32* indices, const nikol::u32 count, const nikol::u32 vertex_offset) {
+  std::vector<nikol::u32> rebased(count);
+  for(nikol::u32 i = 0; i < count; i++) {
+    rebased[i] = indices[i] + vertex_offset;
+  }
+
+  nikol::GfxBufferDesc index_desc = {
+    .data  = rebased.data(),
+    .size  = sizeof(nikol::u32) * count,
+    .type  = nikol::GFX_BUFFER_INDEX,
+    .usage = nikol::GFX_BUFFER_USAGE_STATIC_DRAW,
+  };
+
+  pool.indices_used += count;
+  pool.index_buffers++;
+
+  return nikol::gfx_buffer_create(pool.gfx, index_desc);
+}
+
+void geometry_pool_free_vertices(GeometryPool& pool, const nikol::u32 offset, const nikol::u32 count) {
+  range_allocator_free(pool.vertex_alloc, offset, count);
+}
+
+void geometry_pool_destroy_index_buffer(GeometryPool& pool, nikol::GfxBuffer* buffer, const nikol::u32 count) {
+  nikol::gfx_buffer_destroy(buffer);
+
+  pool.indices_used -= count;
+  pool.index_buffers--;
+}
+
+GeometryPoolStats geometry_pool_get_stats(const GeometryPool& pool) {
+  GeometryPoolStats stats;
+
+  stats.vertices_used        = pool.vertex_alloc.used;
+  stats.vertices_capacity    = pool.vertex_alloc.capacity;
+  stats.vertex_free_blocks   = (nikol::u32)pool.vertex_alloc.free_by_offset.size();
+  stats.vertex_fragmentation = range_allocator_fragmentation(pool.vertex_alloc);
+
+  stats.indices_used  = pool.indices_used;
+  stats.index_buffers = pool.index_buffers;
+
+  return stats;
+}
+// GeometryPool functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <map>
+#include <set>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// Consts
+const nikol::u32 RANGE_INVALID = 0xffffffff;
+
+// Default pool size (in vertices): 32 MiB of vertices
+const nikol::u32 GEOMETRY_POOL_DEFAULT_VERTICES = 1 << 20;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RangeAllocator
+// A best-fit free list over `[0, capacity)`. Neighbouring free blocks are merged on free.
+// It only hands out offsets, so it works for any (GPU or CPU) storage.
+struct RangeAllocator {
+  nikol::u32 capacity = 0;
+  nikol::u32 used     = 0;
+
+  std::map<nikol::u32, nikol::u32> free_by_offset;          // offset -> size
+  std::set<std::pair<nikol::u32, nikol::u32>> free_by_size; // (size, offset)
+};
+// RangeAllocator
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// GeometryPoolStats
+struct GeometryPoolStats {
+  nikol::u32 vertices_used     = 0;
+  nikol::u32 vertices_capacity = 0;
+
+  nikol::u32 vertex_free_blocks = 0;
+
+  // 1 - (largest free block / total free space). 0 means all the free space is in one piece.
+  nikol::f32 vertex_fragmentation = 0.0f;
+
+  // Across every index buffer of the pool
+  nikol::u32 indices_used  = 0;
+  nikol::u32 index_buffers = 0;
+};
+// GeometryPoolStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// GeometryPool
+// Every mesh in the pool is a range of one big vertex buffer (with the default `Vertex` layout),
+// so they all share the same pipeline and bindings.
+//
+// The backend can only draw an index buffer from its first index (there is no first index or base 
+// vertex to draw with), so the indices cannot share one buffer. Every range of them gets its own static 
+// index buffer instead, rebased onto its vertex range once when it is created. Nothing gets uploaded 
+// when drawing, a draw only swaps its index buffer in (like the LODs of any other mesh).
+struct GeometryPool {
+  nikol::GfxContext* gfx = nullptr;
+
+  nikol::GfxPipelineDesc pipe_desc;
+  nikol::GfxPipeline* pipe = nullptr;
+
+  RangeAllocator vertex_alloc;
+
+  nikol::u32 indices_used  = 0;
+  nikol::u32 index_buffers = 0;
+};
+// GeometryPool
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RangeAllocator functions
+void range_allocator_init(RangeAllocator& alloc, const nikol::u32 capacity);
+
+// Returns the offset of the new range or `RANGE_INVALID` if no free block is big enough
+nikol::u32 range_allocator_alloc(RangeAllocator& alloc, const nikol::u32 count);
+void range_allocator_free(RangeAllocator& alloc, const nikol::u32 offset, const nikol::u32 count);
+
+nikol::u32 range_allocator_largest_free(const RangeAllocator& alloc);
+nikol::f32 range_allocator_fragmentation(const RangeAllocator& alloc);
+// RangeAllocator functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// GeometryPool functions
+void geometry_pool_init(GeometryPool& pool, nikol::GfxContext* gfx, const nikol::u32 vertices_capacity = GEOMETRY_POOL_DEFAULT_VERTICES);
+void geometry_pool_shutdown(GeometryPool& pool);
+
+// Upload `vertices` into the pool. Returns the vertex offset or `RANGE_INVALID` if the pool is full.
+nikol::u32 geometry_pool_alloc_vertices(GeometryPool& pool, const Vertex* vertices, const nikol::u32 count);
+
+// Create a static index buffer out of `indices`, adding `vertex_offset` to every one of them 
+// (the offset `geometry_pool_alloc_vertices` returned), so it can be drawn as is.
+nikol::GfxBuffer* geometry_pool_create_index_buffer(GeometryPool& pool, const nikol::u32* indices, const nikol::u32 count, const nikol::u32 vertex_offset);
+
+void geometry_pool_free_vertices(GeometryPool& pool, const nikol::u32 offset, const nikol::u32 count);
+void geometry_pool_destroy_index_buffer(GeometryPool& pool, nikol::GfxBuffer* buffer, const nikol::u32 count);
+
+GeometryPoolStats geometry_pool_get_stats(const GeometryPool& pool);
+// GeometryPool functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+#include "indirect_draw.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <tuple>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Arguments written by one job
+const nikol::u32 ARGS_BATCH_SIZE = 1024;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static auto state_tuple(const IndirectDrawState& state) {
+  return std::make_tuple(state.pipe, state.desc, state.shader, state.texture, state.index_buffer, state.index_source, state.index_buffers);
+}
+
+static bool is_same_state(const IndirectDrawState& a, const IndirectDrawState& b) {
+  return state_tuple(a) == state_tuple(b);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// IndirectDrawList functions
+void indirect_draw_list_build(IndirectDrawList& list, const IndirectDraw* draws, const nikol::u32 count, const nikol::u32 grouped_count) {
+  list.args.resize(count);
+  list.order.resize(count);
+  list.stats = {};
+
+  list.stats.draws = count;
+  if(count == 0) {
+    list.batches.clear();
+    return;
+  }
+
+  // Every distinct state gets an ID, in the order they first show up. Neighbouring draws
+  // often share their state, so the map is only searched when it changes.
+  list.state_ids.resize(count);
+  list.state_lookup.clear();
+  list.batches.clear();
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    const IndirectDrawState& state = draws[i].state;
+
+    // The first ordered draw can't join the last grouped batch, which might not be the last one
+    if(i > 0 && i != grouped_count && is_same_state(state, draws[i - 1].state)) {
+      list.state_ids[i] = list.state_ids[i - 1];
+      continue;
+    }
+
+    // Past the grouped draws, every change of state starts a new batch
+    if(i >= grouped_count) {
+      list.state_ids[i] = (nikol::u32)list.batches.size();
+      list.batches.push_back(IndirectBatch{state, 0, 0});
+      continue;
+    }
+
+    auto [it, is_new] = list.state_lookup.try_emplace(state_tuple(state), (nikol::u32)list.batches.size());
+    if(is_new) {
+      list.batches.push_back(IndirectBatch{state, 0, 0});
+    }
+
+    list.state_ids[i] = it->second;
+  }
+
+  // A counting sort on the state IDs, which keeps the order of the draws within each state
+  for(nikol::u32 i = 0; i < count; i++) {
+    list.batches[list.state_ids[i]].args_count++;
+  }
+
+  nikol::u32 offset = 0;
+  for(auto& batch : list.batches) {
+    batch.first_args = offset;
+    offset          += batch.args_count;
+
+    list.stats.largest_batch = std::max(list.stats.largest_batch, batch.args_count);
+  }
+
+  list.cursors.resize(list.batches.size());
+  for(nikol::sizei i = 0; i < list.batches.size(); i++) {
+    list.cursors[i] = list.batches[i].first_args;
+  }
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    list.order[list.cursors[list.state_ids[i]]++] = i;
+  }
+
+  list.stats.batches = (nikol::u32)list.batches.size();
+
+  // Gathering the arguments in batch order, each job writing a contiguous block of them
+  job_system_parallel_for(count, ARGS_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      nikol::u32 draw_id = list.order[i];
+
+      list.args[i]               = draws[draw_id].args;
+      list.args[i].base_instance = draw_id;
+    }
+  });
+}
+// IndirectDrawList functions
+// ----------------------------------------------------------------------------
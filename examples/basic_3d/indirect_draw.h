@@ -0,0 +1,122 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <map>
+#include <tuple>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Group every draw of the list by state (see `indirect_draw_list_build`)
+const nikol::u32 INDIRECT_GROUP_ALL = 0xffffffff;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// DrawIndirectArgs
+// Laid out like the indexed indirect arguments of GL (`DrawElementsIndirectCommand`) and
+// D3D (`DrawIndexedInstancedIndirect`), so an array of them can be handed over as is.
+struct DrawIndirectArgs {
+  nikol::u32 indices_count;
+  nikol::u32 instances_count;
+  nikol::u32 first_index;
+  nikol::i32 base_vertex;
+  nikol::u32 base_instance; // The draw ID the per-draw data is looked up with
+};
+// DrawIndirectArgs
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// IndirectDrawState
+// Everything that has to be bound before a draw. Draws with the same state end up in the same batch.
+struct IndirectDrawState {
+  nikol::GfxPipeline* pipe;
+  const nikol::GfxPipelineDesc* desc;
+
+  nikol::GfxShader* shader;
+  nikol::GfxTexture* texture;
+  nikol::GfxBuffer* index_buffer;
+
+  // Set for draws with their own indices (see `DrawCall::indices`): `first_index` points into here 
+  // and the range gets streamed into `index_buffer`
+  const nikol::u32* index_source;
+
+  // Set (with `index_buffer` left `nullptr`) for draws whose index buffer is the only thing that differs, like the 
+  // meshes of a geometry pool. Each draw binds `index_buffers[base_instance]`, so they can all share one batch.
+  nikol::GfxBuffer* const* index_buffers;
+};
+// IndirectDrawState
+// ----------------------------------------------------------------------------
+
+// What the draws get grouped by (every field of `IndirectDrawState`)
+using IndirectStateKey = std::tuple<nikol::GfxPipeline*, 
+                                    const nikol::GfxPipelineDesc*, 
+                                    nikol::GfxShader*, 
+                                    nikol::GfxTexture*, 
+                                    nikol::GfxBuffer*, 
+                                    const nikol::u32*, 
+                                    nikol::GfxBuffer* const*>;
+
+// ----------------------------------------------------------------------------
+// IndirectDraw
+// One draw as written by the renderer. Its index in the input array is its draw ID.
+struct IndirectDraw {
+  IndirectDrawState state;
+  DrawIndirectArgs args;
+};
+// IndirectDraw
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// IndirectBatch
+struct IndirectBatch {
+  IndirectDrawState state;
+
+  nikol::u32 first_args; // Into `IndirectDrawList::args`
+  nikol::u32 args_count;
+};
+// IndirectBatch
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// IndirectStats
+struct IndirectStats {
+  nikol::u32 draws   = 0;
+  nikol::u32 batches = 0; // One state change and one (multi) draw each
+
+  nikol::u32 largest_batch = 0;
+};
+// IndirectStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// IndirectDrawList
+// The draws of a frame grouped by state, with the arguments of every batch next to each other
+struct IndirectDrawList {
+  std::vector<DrawIndirectArgs> args;
+  std::vector<IndirectBatch> batches;
+
+  // Scratch space
+  std::vector<nikol::u32> order; // Draw IDs in batch order
+  std::vector<nikol::u32> state_ids;
+  std::vector<nikol::u32> cursors;
+  std::map<IndirectStateKey, nikol::u32> state_lookup;
+
+  IndirectStats stats;
+};
+// IndirectDrawList
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// IndirectDrawList functions
+
+// Group `draws` by state (keeping the order of the draws within a state) and write out the batches
+// and their arguments (using the job system). `base_instance` gets overwritten with the draw ID.
+//
+// Only the first `grouped_count` draws get grouped. The ones after them keep their order (translucent
+// draws, say), so they only share a batch with the draws right next to them, after every grouped batch.
+void indirect_draw_list_build(IndirectDrawList& list, const IndirectDraw* draws, const nikol::u32 count, const nikol::u32 grouped_count = INDIRECT_GROUP_ALL);
+// IndirectDrawList functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,161 @@
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// ----------------------------------------------------------------------------
+// JobSystem
+struct JobSystem {
+  std::vector<std::thread> workers;
+  
+  std::mutex mutex; 
+  std::condition_variable wake_cond, done_cond;
+
+  // The current job 
+  const JobFunc* func = nullptr;
+  nikol::u32 count    = 0; 
+  nikol::u32 batch    = 1;
+  std::atomic<nikol::u32> next_item;
+
+  nikol::u64 generation = 0;
+  nikol::u32 active     = 0;
+  bool is_running       = false;
+};
+
+static JobSystem s_jobs;
+// JobSystem
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void run_batches(const nikol::u32 thread_index) {
+  while(true) {
+    nikol::u32 start = s_jobs.next_item.fetch_add(s_jobs.batch);
+    if(start >= s_jobs.count) {
+      break;
+    }
+
+    nikol::u32 end = start + s_jobs.batch; 
+    if(end > s_jobs.count) {
+      end = s_jobs.count;
+    }
+
+    (*s_jobs.func)(start, end, thread_index);
+  }
+}
+
+static void worker_loop(const nikol::u32 thread_index, const nikol::u64 start_generation) {
+  // Anything from before a re-init is long gone
+  nikol::u64 seen_generation = start_generation;
+
+  while(true) {
+    std::unique_lock<std::mutex> lock(s_jobs.mutex);
+    s_jobs.wake_cond.wait(lock, [&]() {
+      return !s_jobs.is_running || s_jobs.generation != seen_generation;
+    });
+
+    if(!s_jobs.is_running) {
+      return;
+    }
+
+    seen_generation = s_jobs.generation;
+    s_jobs.active++;
+    lock.unlock();
+
+    run_batches(thread_index);
+
+    lock.lock();
+    s_jobs.active--;
+    if(s_jobs.active == 0) {
+      s_jobs.done_cond.notify_all();
+    }
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Job system functions
+void job_system_init(const nikol::u32 threads_count) {
+  if(s_jobs.is_running) {
+    return;
+  }
+
+  nikol::u32 total = threads_count; 
+  if(total == 0) {
+    total = std::thread::hardware_concurrency();
+  }
+  
+  // At least the calling thread
+  if(total == 0) {
+    total = 1;
+  }
+
+  s_jobs.is_running = true;
+  s_jobs.next_item  = 0;
+
+  // The calling thread counts as the first worker
+  s_jobs.workers.reserve(total - 1);
+  for(nikol::u32 i = 1; i < total; i++) {
+    s_jobs.workers.emplace_back(worker_loop, i, s_jobs.generation);
+  }
+}
+
+void job_system_shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(s_jobs.mutex);
+    s_jobs.is_running = false;
+  }
+  s_jobs.wake_cond.notify_all();
+
+  for(auto& worker : s_jobs.workers) {
+    worker.join();
+  }
+  s_jobs.workers.clear();
+}
+
+void job_system_parallel_for(const nikol::u32 count, const nikol::u32 batch_size, const JobFunc& func) {
+  if(count == 0) {
+    return;
+  }
+
+  nikol::u32 batch = batch_size > 0 ? batch_size : 1;
+
+  // Not worth waking anyone up for a single batch
+  if(s_jobs.workers.empty() || count <= batch) {
+    func(0, count, 0);
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(s_jobs.mutex);
+    
+    // A straggler from the previous job might still be on its way out
+    s_jobs.done_cond.wait(lock, []() { return s_jobs.active == 0; });
+
+    s_jobs.func      = &func;
+    s_jobs.count     = count;
+    s_jobs.batch     = batch;
+    s_jobs.next_item = 0;
+    s_jobs.generation++;
+  }
+  s_jobs.wake_cond.notify_all();
+
+  // Help out while waiting
+  run_batches(0);
+
+  // Every batch has been claimed at this point. Wait for the ones still in flight.
+  std::unique_lock<std::mutex> lock(s_jobs.mutex);
+  s_jobs.done_cond.wait(lock, []() { return s_jobs.active == 0; });
+}
+
+nikol::u32 job_system_get_threads_count() {
+  return (nikol::u32)s_jobs.workers.size() + 1;
+}
+// Job system functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+
+#include <functional>
+
+// ----------------------------------------------------------------------------
+// JobFunc
+// Called with a half-open `[start, end)` range of items and the index of the 
+// thread running it (0 is always the calling thread).
+using JobFunc = std::function<void(const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index)>;
+// JobFunc
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Job system functions
+
+// Spawn the worker threads. A `threads_count` of 0 will use every hardware thread.
+void job_system_init(const nikol::u32 threads_count = 0);
+void job_system_shutdown();
+
+// Split `count` items into batches of (at least) `batch_size` and run `func` on them 
+// across all the workers. The calling thread helps out and this function only 
+// returns once every batch is done. Jobs must not call this function themselves.
+void job_system_parallel_for(const nikol::u32 count, const nikol::u32 batch_size, const JobFunc& func);
+
+// The number of threads that can run a job, including the calling thread. 
+// Handy for sizing per-thread scratch memory.
+nikol::u32 job_system_get_threads_count();
+// Job system functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,89 @@
+#include "linear_allocator.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::sizei align_up(const nikol::sizei value, const nikol::sizei alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void* bump(LinearBlock& block, const nikol::sizei size, const nikol::sizei alignment) {
+  // Aligning the address itself, since the block is only as aligned as `memory_allocate` makes it
+  nikol::sizei base  = (nikol::sizei)block.data;
+  nikol::sizei start = align_up(base + block.used, alignment) - base;
+
+  if((start + size) > block.size) {
+    return nullptr;
+  }
+
+  block.used = start + size;
+  return block.data + start;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// LinearAllocator functions
+void linear_allocator_init(LinearAllocator& alloc, const nikol::sizei block_size) {
+  alloc.blocks.clear();
+  alloc.current    = 0;
+  alloc.block_size = block_size;
+}
+
+void linear_allocator_shutdown(LinearAllocator& alloc) {
+  for(auto& block : alloc.blocks) {
+    nikol::memory_free(block.data);
+  }
+
+  alloc.blocks.clear();
+  alloc.current = 0;
+}
+
+void* linear_allocator_alloc(LinearAllocator& alloc, const nikol::sizei size, const nikol::sizei alignment) {
+  NIKOL_ASSERT((alignment & (alignment - 1)) == 0, "Linear allocator alignment has to be a power of two");
+
+  // Whatever is left in the current block first, then the blocks from the previous rounds
+  for(; alloc.current < alloc.blocks.size(); alloc.current++) {
+    void* ptr = bump(alloc.blocks[alloc.current], size, alignment);
+    if(ptr) {
+      return ptr;
+    }
+  }
+
+  // Out of blocks. Leaving room for the alignment.
+  nikol::sizei block_size = std::max(alloc.block_size, size + alignment);
+
+  LinearBlock block = {
+    .data = (nikol::u8*)nikol::memory_allocate(block_size),
+    .size = block_size,
+    .used = 0,
+  };
+
+  alloc.blocks.push_back(block);
+  alloc.current = (nikol::u32)(alloc.blocks.size() - 1);
+
+  return bump(alloc.blocks[alloc.current], size, alignment);
+}
+
+void linear_allocator_reset(LinearAllocator& alloc) {
+  for(auto& block : alloc.blocks) {
+    block.used = 0;
+  }
+
+  alloc.current = 0;
+}
+
+nikol::sizei linear_allocator_get_used(const LinearAllocator& alloc) {
+  nikol::sizei used = 0;
+  for(auto& block : alloc.blocks) {
+    used += block.used;
+  }
+
+  return used;
+}
+// LinearAllocator functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+const nikol::sizei LINEAR_ALLOCATOR_BLOCK_SIZE = 64 * 1024;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// LinearBlock
+struct LinearBlock {
+  nikol::u8* data   = nullptr;
+  nikol::sizei size = 0;
+  nikol::sizei used = 0;
+};
+// LinearBlock
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// LinearAllocator
+// Bump allocations out of a chain of blocks. Nothing gets freed on its own: a reset
+// hands every block back at once, while keeping them around for the next round.
+// Not thread-safe, so every thread gets its own.
+struct LinearAllocator {
+  std::vector<LinearBlock> blocks;
+  nikol::u32 current = 0;
+
+  nikol::sizei block_size = LINEAR_ALLOCATOR_BLOCK_SIZE;
+};
+// LinearAllocator
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// LinearAllocator functions
+void linear_allocator_init(LinearAllocator& alloc, const nikol::sizei block_size = LINEAR_ALLOCATOR_BLOCK_SIZE);
+void linear_allocator_shutdown(LinearAllocator& alloc);
+
+// `alignment` has to be a power of two. Allocations bigger than the block size get a block of their own.
+void* linear_allocator_alloc(LinearAllocator& alloc, const nikol::sizei size, const nikol::sizei alignment = 16);
+
+void linear_allocator_reset(LinearAllocator& alloc);
+
+// Every byte handed out since the last reset (padding included)
+nikol::sizei linear_allocator_get_used(const LinearAllocator& alloc);
+// LinearAllocator functions
+// ----------------------------------------------------------------------------
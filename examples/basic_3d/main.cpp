@@ -4,6 +4,50 @@
 #include "mesh.h"
 #include "renderer.h"
 #include "trasform.h"
+#include "job_system.h"
+#include "static_batch.h"
+#include "meshlet.h"
+#include "terrain.h"
+#include "voxel.h"
+#include "sorted_mesh.h"
+#include "mesh_generator.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <cmath>
+
+// Rolling hills, for when there is no heightmap around
+static void generate_hills(std::vector<nikol::u16>& heights, const nikol::u32 size) {
+  heights.resize(size * size);
+
+  for(nikol::u32 z = 0; z < size; z++) {
+    for(nikol::u32 x = 0; x < size; x++) {
+      nikol::f32 h = 0.5f + 0.25f * std::sin(x * 0.011f) * std::cos(z * 0.013f) + 0.12f * std::sin((x + z) * 0.037f) + 0.05f * std::cos(x * 0.091f - z * 0.077f);
+      heights[z * size + x] = (nikol::u16)(glm::clamp(h, 0.0f, 1.0f) * 65535.0f);
+    }
+  }
+}
+
+// Grass over dirt over stone, with a few floating blocks of gold
+static void generate_blocks(VoxelWorld& world) {
+  glm::ivec3 size = glm::ivec3(world.chunks_count * VOXEL_CHUNK_SIZE);
+
+  for(int z = 0; z < size.z; z++) {
+    for(int x = 0; x < size.x; x++) {
+      int height = (int)(size.y * (0.4f + 0.15f * std::sin(x * 0.08f) * std::cos(z * 0.06f) + 0.1f * std::sin((x - z) * 0.03f)));
+
+      for(int y = 0; y < height; y++) {
+        nikol::u8 type = (y == height - 1) ? 3 : (y >= height - 4) ? 2 : 1;
+        voxel_world_set_block(world, glm::ivec3(x, y, z), type);
+      }
+
+      if(((x * 7 + z * 13) % 97) == 0) {
+        voxel_world_set_block(world, glm::ivec3(x, height + 6, z), 4);
+      }
+    }
+  }
+}
 
 int main() {
   // Initialze the library
@@ -18,12 +62,98 @@ int main() {
     return -1;
   }
 
+  // Spin up the workers (used by the scene graph and friends)
+  job_system_init();
+
   Renderer* renderer = renderer_create(window);
   nikol::GfxContext* gfx = renderer_get_gfx_context(renderer);
 
   Mesh* mesh = mesh_create(gfx, MESH_TYPE_CUBE);
   Transform transform = transform_create(glm::vec3(10.0f, 0.0f, 5.0f), glm::vec3(1.0f));
 
+  // A field of pillars, merged into a few draws with the default material
+  ShapeDesc pillar_desc = {.type = SHAPE_CYLINDER, .segments = 12, .rings = 1, .height = 3.0f};
+  std::vector<Vertex> pillar_vertices;
+  std::vector<nikol::u32> pillar_indices;
+  shape_generate(pillar_desc, pillar_vertices, pillar_indices);
+
+  StaticBatch scenery;
+  for(int x = 0; x < 32; x++) {
+    for(int z = 0; z < 32; z++) {
+      glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x * 4.0f, -2.0f, z * -4.0f));
+      static_batch_add(scenery, pillar_vertices, pillar_indices, nullptr, model);
+    }
+  }
+  static_batch_build(scenery);
+  static_batch_upload(gfx, scenery);
+
+  // A dense dome, culled meshlet by meshlet
+  ShapeDesc dome_desc = {.type = SHAPE_ICOSPHERE, .subdivisions = 6, .radius = 20.0f};
+  std::vector<Vertex> dome_vertices;
+  std::vector<nikol::u32> dome_indices;
+  shape_generate(dome_desc, dome_vertices, dome_indices);
+
+  MeshletMesh dome;
+  meshlet_mesh_build(dome, dome_vertices, dome_indices);
+  meshlet_mesh_upload(gfx, dome, dome_vertices);
+  glm::mat4 dome_model = glm::translate(glm::mat4(1.0f), glm::vec3(60.0f, 0.0f, -160.0f));
+
+  // A large terrain under everything, drawn with a LOD picked per node
+  TerrainDesc terrain_desc = {.origin = glm::vec3(-1024.0f, -40.0f, -1024.0f), .height = 48.0f};
+  Terrain terrain;
+
+  if(!terrain_load(terrain, "assets/heightmap.png", terrain_desc)) {
+    std::vector<nikol::u16> heights;
+    generate_hills(heights, 2049);
+
+    terrain_build(terrain, heights.data(), 2049, 2049, terrain_desc);
+  }
+  terrain_upload(gfx, terrain);
+
+  BaseMaterial* terrain_base = base_material_create(renderer_get_materials(renderer),
+                                                    MATERIAL_FEATURE_TERRAIN | MATERIAL_FEATURE_LIT,
+                                                    MaterialParams{.color = glm::vec4(0.35f, 0.55f, 0.25f, 1.0f)});
+  Material* terrain_material = material_create(terrain_base, terrain.heightmap);
+
+  // Blocks, one greedy mesh per chunk. The block types pick their color out of a palette.
+  VoxelWorld blocks;
+  voxel_world_create(blocks, glm::uvec3(4, 2, 4), glm::vec3(-40.0f, -36.0f, 20.0f), 0.5f);
+  generate_blocks(blocks);
+
+  voxel_world_mesh(blocks);
+  voxel_world_upload(gfx, blocks);
+
+  nikol::u32 palette[256] = {0, 0xff808080, 0xff2a4a6b, 0xff3a9a4a, 0xff20d0ff};
+  nikol::GfxTextureDesc palette_desc = {
+    .width     = 256,
+    .height    = 1,
+    .depth     = 0,
+    .format    = nikol::GFX_TEXTURE_FORMAT_RGBA8,
+    .filter    = nikol::GFX_TEXTURE_FILTER_MIN_MAG_NEAREST,
+    .wrap_mode = nikol::GFX_TEXTURE_WRAP_REPEAT,
+    .data      = palette,
+  };
+  nikol::GfxTexture* palette_texture = nikol::gfx_texture_create(gfx, palette_desc);
+
+  BaseMaterial* blocks_base = base_material_create(renderer_get_materials(renderer), MATERIAL_FEATURE_DIFFUSE_MAP | MATERIAL_FEATURE_LIT);
+  Material* blocks_material = material_create(blocks_base, palette_texture);
+
+  // Glass, drawn after everything else and back to front. The torus overlaps itself, so its triangles get sorted too.
+  BaseMaterial* glass_base = base_material_create(renderer_get_materials(renderer),
+                                                  MATERIAL_FEATURE_TRANSLUCENT | MATERIAL_FEATURE_LIT,
+                                                  MaterialParams{.color = glm::vec4(0.4f, 0.7f, 0.9f, 0.35f)});
+  Material* glass_material = material_create(glass_base, palette_texture); // Never sampled, but something has to be bound
+
+  ShapeDesc torus_desc = {.type = SHAPE_TORUS, .segments = 96, .rings = 48, .radius = 3.0f, .tube_radius = 1.0f};
+  std::vector<Vertex> torus_vertices;
+  std::vector<nikol::u32> torus_indices;
+  shape_generate(torus_desc, torus_vertices, torus_indices);
+
+  SortedMesh torus;
+  sorted_mesh_build(torus, torus_vertices, torus_indices);
+  sorted_mesh_upload(gfx, torus, torus_vertices);
+  glm::mat4 torus_model = glm::translate(glm::mat4(1.0f), glm::vec3(-12.0f, 2.0f, -8.0f));
+
   Camera camera = camera_create(glm::vec3(10.0f, 0.0f, 10.0f), glm::vec3(-3.0f, 0.0f, 0.0f));
 
   // Main loop
@@ -39,6 +169,19 @@ int main() {
     renderer_begin(renderer, camera);
 
     // render_mesh(renderer, mesh, nullptr, transform);
+    render_static_batch(renderer, scenery);
+    render_meshlets(renderer, dome, nullptr, dome_model);
+    render_terrain(renderer, terrain, terrain_material);
+
+    // Only the chunks touched by `voxel_world_set_block` since the last frame get meshed again
+    voxel_world_mesh(blocks);
+    voxel_world_upload(gfx, blocks);
+    render_voxel_world(renderer, blocks, blocks_material);
+
+    for(int i = 0; i < 8; i++) {
+      render_mesh(renderer, mesh, glass_material, glm::translate(glm::mat4(1.0f), glm::vec3(-4.0f, 0.0f, i * -3.0f)));
+    }
+    render_sorted_mesh(renderer, torus, glass_material, torus_model);
 
     renderer_end(renderer);
     
@@ -47,7 +190,20 @@ int main() {
   }
 
   // De-initialze
+  static_batch_destroy(scenery);
+  meshlet_mesh_destroy(dome);
+  material_destroy(terrain_material);
+  base_material_destroy(terrain_base);
+  terrain_destroy(terrain);
+  material_destroy(blocks_material);
+  base_material_destroy(blocks_base);
+  nikol::gfx_texture_destroy(palette_texture);
+  voxel_world_destroy(blocks);
+  material_destroy(glass_material);
+  base_material_destroy(glass_base);
+  sorted_mesh_destroy(torus);
   renderer_destroy(renderer); 
+  job_system_shutdown();
   nikol::window_close(window);
   nikol::shutdown();
 }
@@ -1,28 +1,305 @@
 #include "material.h"
+#include "shaders.h"
+#include "vertex.h"
+#include "clustered_lighting.h"
+#include "skinning.h"
 
 #include <nikol/nikol_core.hpp>
-#include <glm/mat4x4.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <cstring>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+
+// Indexed by the bit of each `MaterialFeature`
+static const char* s_feature_defines[MATERIAL_FEATURES_COUNT] = {
+  "DIFFUSE_MAP",
+  "ALPHA_TEST",
+  "QUANTIZED",
+  "QUANTIZED_COMPACT",
+  "LIT",
+  "TERRAIN",
+  "VOXEL",
+  "TRANSLUCENT",
+  "SKINNED",
+};
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u32 hash_features(const nikol::u32 features) {
+  // Fibonacci hashing, keeping the top bits
+  return (features * 2654435769u) >> (32 - SHADER_PERMUTATIONS_BITS);
+}
+
+static std::string build_defines(const nikol::u32 features) {
+  char line[256];
+  std::snprintf(line, sizeof(line), 
+                "#define MATERIAL_PARAMS_MAX %u\n"
+                "#define CLUSTER_LIGHTS_COUNT %u\n"
+                "#define CLUSTER_RANGES_COUNT %u\n"
+                "#define CLUSTER_INDICES_COUNT %u\n"
+                "#define SKELETON_JOINTS_MAX %u\n",
+                MATERIAL_PARAMS_MAX, 
+                CLUSTER_GPU_LIGHTS_MAX, 
+                CLUSTERS_COUNT / 4,           // Four packed (offset, count) ranges per uvec4 
+                CLUSTER_GPU_INDICES_MAX / 8,  // Eight 16-bit indices per uvec4 
+                SKELETON_JOINTS_MAX);
+
+  std::string defines = line;
+  for(nikol::u32 i = 0; i < MATERIAL_FEATURES_COUNT; i++) {
+    if(features & (1 << i)) {
+      defines += "#define ";
+      defines += s_feature_defines[i];
+      defines += "\n";
+    }
+  }
+
+  return defines;
+}
+
+static std::string build_permutation_source(const nikol::u32 features) {
+  std::string defines = build_defines(features);
+
+#ifdef NIKOL_GFX_CONTEXT_OPENGL
+  // The defines have to come after the `#version` of both stages
+  const std::string version = "#version 460 core\n";
+  std::string source        = material_shader_glsl();
+
+  for(nikol::sizei pos = source.find(version); pos != std::string::npos; pos = source.find(version, pos)) {
+    pos += version.size();
+    source.insert(pos, defines);
+    pos += defines.size();
+  }
+
+  return source;
+#else
+  return defines + material_shader_hlsl();
+#endif
+}
+
+static nikol::u32 alloc_slot(MaterialSystem& system) {
+  if(system.free_slots_count == 0) {
+    return MATERIAL_SLOT_INVALID;
+  }
+
+  return system.free_slots[--system.free_slots_count];
+}
+
+static void mark_dirty(MaterialSystem& system, const nikol::u32 slot) {
+  system.dirty_min = glm::min(system.dirty_min, slot);
+  system.dirty_max = glm::max(system.dirty_max, slot);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MaterialSystem functions
+void material_system_init(MaterialSystem& system, nikol::GfxContext* gfx) {
+  system.gfx = gfx;
+
+  for(auto& perm : system.permutations) {
+    perm = ShaderPermutation{};
+  }
+
+  // Handing the lowest slots out first keeps the dirty ranges tight
+  system.free_slots_count = MATERIAL_PARAMS_MAX;
+  for(nikol::u32 i = 0; i < MATERIAL_PARAMS_MAX; i++) {
+    system.params[i]     = MaterialParams{};
+    system.free_slots[i] = MATERIAL_PARAMS_MAX - i - 1;
+  }
+
+  system.extra_uniforms_count = 0;
+
+  system.dirty_min = MATERIAL_PARAMS_MAX;
+  system.dirty_max = 0;
+  system.stats     = {};
+
+  // Uniform buffers init
+  nikol::GfxBufferDesc draw_desc = {
+    .data  = nullptr,
+    .size  = sizeof(DrawData),
+    .type  = nikol::GFX_BUFFER_UNIFORM,
+    .usage = nikol::GFX_BUFFER_USAGE_DYNAMIC_DRAW,
+  };
+  system.draw_buffer = nikol::gfx_buffer_create(gfx, draw_desc);
+
+  nikol::GfxBufferDesc params_desc = {
+    .data  = system.params,
+    .size  = sizeof(system.params),
+    .type  = nikol::GFX_BUFFER_UNIFORM,
+    .usage = nikol::GFX_BUFFER_USAGE_DYNAMIC_DRAW,
+  };
+  system.params_buffer = nikol::gfx_buffer_create(gfx, params_desc);
+
+  nikol::GfxBufferDesc palette_desc = {
+    .data  = nullptr,
+    .size  = SKINNING_PALETTE_SIZE,
+    .type  = nikol::GFX_BUFFER_UNIFORM,
+    .usage = nikol::GFX_BUFFER_USAGE_DYNAMIC_DRAW,
+  };
+  system.palette_buffer = nikol::gfx_buffer_create(gfx, palette_desc);
+}
+
+void material_system_shutdown(MaterialSystem& system) {
+  for(auto& perm : system.permutations) {
+    if(perm.shader) {
+      nikol::gfx_shader_destroy(perm.shader);
+    }
+
+    perm = ShaderPermutation{};
+  }
+
+  nikol::gfx_buffer_destroy(system.draw_buffer);
+  nikol::gfx_buffer_destroy(system.params_buffer);
+  nikol::gfx_buffer_destroy(system.palette_buffer);
+
+  system.draw_buffer    = nullptr;
+  system.params_buffer  = nullptr;
+  system.palette_buffer = nullptr;
+}
+
+nikol::u32 material_features_from_format(const VertexFormat format) {
+  switch(format) {
+    case VERTEX_FORMAT_QUANTIZED:
+      return MATERIAL_FEATURE_QUANTIZED;
+    case VERTEX_FORMAT_QUANTIZED_COMPACT:
+      return MATERIAL_FEATURE_QUANTIZED_COMPACT;
+    case VERTEX_FORMAT_VOXEL:
+      return MATERIAL_FEATURE_VOXEL;
+    case VERTEX_FORMAT_SKINNED:
+      return MATERIAL_FEATURE_SKINNED;
+    default:
+      return 0;
+  }
+}
+
+nikol::GfxShader* material_system_get_shader(MaterialSystem& system, const nikol::u32 features) {
+  nikol::u32 mask  = SHADER_PERMUTATIONS_MAX - 1;
+  nikol::u32 index = hash_features(features);
+
+  // Linear probing until either the permutation or an empty entry shows up
+  for(nikol::u32 i = 0; i < SHADER_PERMUTATIONS_MAX; i++, index = (index + 1) & mask) {
+    ShaderPermutation& perm = system.permutations[index];
+
+    if(perm.shader && perm.features == features) {
+      return perm.shader;
+    }
+    else if(perm.shader) {
+      continue;
+    }
+
+    std::string source = build_permutation_source(features);
+
+    perm.features = features;
+    perm.shader   = nikol::gfx_shader_create(system.gfx, source.c_str());
+
+    // The order of the attachments is the order of the bindings
+    nikol::gfx_shader_attach_uniform(system.gfx, perm.shader, nikol::GFX_SHADER_VERTEX, system.draw_buffer);
+    nikol::gfx_shader_attach_uniform(system.gfx, perm.shader, nikol::GFX_SHADER_PIXEL, system.params_buffer);
+    nikol::gfx_shader_attach_uniform(system.gfx, perm.shader, nikol::GFX_SHADER_VERTEX, system.palette_buffer);
+
+    if(features & MATERIAL_FEATURE_LIT) {
+      for(nikol::u32 j = 0; j < system.extra_uniforms_count; j++) {
+        const ExtraUniform& extra = system.extra_uniforms[j];
+        nikol::gfx_shader_attach_uniform(system.gfx, perm.shader, extra.stage, extra.buffer);
+      }
+    }
+
+    system.stats.shaders_compiled++;
+    return perm.shader;
+  }
+
+  NIKOL_ASSERT(false, "Too many shader permutations");
+  return nullptr;
+}
+
+void material_system_attach_uniform(MaterialSystem& system, const nikol::GfxShaderType stage, nikol::GfxBuffer* buffer) {
+  NIKOL_ASSERT(system.extra_uniforms_count < MATERIAL_EXTRA_UNIFORMS_MAX, "Too many extra uniform buffers");
+  system.extra_uniforms[system.extra_uniforms_count++] = ExtraUniform{stage, buffer};
+
+  for(auto& perm : system.permutations) {
+    if(perm.shader && (perm.features & MATERIAL_FEATURE_LIT)) {
+      nikol::gfx_shader_attach_uniform(system.gfx, perm.shader, stage, buffer);
+    }
+  }
+}
+
+void material_system_flush(MaterialSystem& system) {
+  if(system.dirty_min > system.dirty_max) {
+    return;
+  }
+
+  nikol::sizei offset = system.dirty_min * sizeof(MaterialParams);
+  nikol::sizei size   = (system.dirty_max - system.dirty_min + 1) * sizeof(MaterialParams);
+  nikol::gfx_buffer_update(system.gfx, system.params_buffer, offset, size, &system.params[system.dirty_min]);
+
+  system.stats.params_uploads++;
+  system.stats.params_bytes += (nikol::u32)size;
+
+  system.dirty_min = MATERIAL_PARAMS_MAX;
+  system.dirty_max = 0;
+}
+
+void material_system_reset_stats(MaterialSystem& system) {
+  nikol::u32 compiled = system.stats.shaders_compiled;
+  nikol::u32 live     = system.stats.materials_live;
+
+  system.stats                  = {};
+  system.stats.shaders_compiled = compiled;
+  system.stats.materials_live   = live;
+}
+// MaterialSystem functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// BaseMaterial functions
+BaseMaterial* base_material_create(MaterialSystem& system, const nikol::u32 features, const MaterialParams& defaults) {
+  BaseMaterial* base = (BaseMaterial*)nikol::memory_allocate(sizeof(BaseMaterial));
+
+  base->system   = &system;
+  base->features = features;
+  base->shader   = material_system_get_shader(system, features);
+  base->defaults = defaults;
+
+  return base;
+}
+
+void base_material_destroy(BaseMaterial* base) {
+  if(!base) {
+    return;
+  }
+
+  // The shader belongs to the system, since other bases might share it
+  nikol::memory_free(base);
+}
+// BaseMaterial functions
+// ----------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------
 // Material functions
-Material* material_create(nikol::GfxContext* gfx, nikol::GfxShader* shader, nikol::GfxTexture* texture) {
+Material* material_create(BaseMaterial* base, nikol::GfxTexture* texture) {
+  MaterialSystem& system = *base->system;
+
+  nikol::u32 slot = alloc_slot(system);
+  if(slot == MATERIAL_SLOT_INVALID) {
+    return nullptr;
+  }
+
   Material* mat = (Material*)nikol::memory_allocate(sizeof(Material));
 
-  mat->gfx     = gfx;
+  mat->base    = base;
   mat->diffuse = texture;
-  mat->shader  = shader; 
-  
-  nikol::GfxBufferDesc buff_desc = {
-    .data = nullptr,
-    .size = sizeof(glm::mat4),
-    .type = nikol::GFX_BUFFER_UNIFORM, 
-    .usage = nikol::GFX_BUFFER_USAGE_DYNAMIC_DRAW,
-  };
-  mat->uniform_buff = nikol::gfx_buffer_create(gfx, buff_desc);
+  mat->slot    = slot;
 
-  nikol::gfx_shader_attach_uniform(gfx, shader, nikol::GFX_SHADER_VERTEX, mat->uniform_buff);
+  system.params[slot] = base->defaults;
+  mark_dirty(system, slot);
 
+  system.stats.materials_live++;
   return mat;
 }
 
@@ -30,13 +307,41 @@ void material_destroy(Material* mat) {
   if(!mat) {
     return;
   }
- 
-  nikol::gfx_buffer_destroy(mat->uniform_buff);
+
+  MaterialSystem& system = *mat->base->system;
+
+  // The stale block is left as is, as nothing can draw with it anymore
+  system.free_slots[system.free_slots_count++] = mat->slot;
+  system.stats.materials_live--;
+
   nikol::memory_free(mat);
 }
 
-void material_apply(Material* mat) {
-  nikol::gfx_buffer_update(mat->gfx, mat->uniform_buff, 0, sizeof(glm::mat4), glm::value_ptr(mat->transform));
+void material_set_params(Material* mat, const MaterialParams& params) {
+  MaterialSystem& system = *mat->base->system;
+
+  if(std::memcmp(&system.params[mat->slot], &params, sizeof(MaterialParams)) == 0) {
+    system.stats.params_unchanged++;
+    return;
+  }
+
+  system.params[mat->slot] = params;
+  mark_dirty(system, mat->slot);
+}
+
+const MaterialParams& material_get_params(const Material* mat) {
+  return mat->base->system->params[mat->slot];
+}
+
+nikol::GfxShader* material_get_shader(const Material* mat, const VertexFormat format) {
+  nikol::u32 format_features = material_features_from_format(format);
+
+  // Most meshes use the format the base was made for
+  if(format_features == 0) {
+    return mat->base->shader;
+  }
+
+  return material_system_get_shader(*mat->base->system, mat->base->features | format_features);
 }
 // Material functions
 // ----------------------------------------------------------------------------
@@ -1,25 +1,232 @@
 #pragma once
 
+#include "vertex.h"
+
 #include <nikol/nikol_core.hpp>
-#include <glm/mat4x4.hpp>
+#include <glm/glm.hpp>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The size of the shared parameter buffer (in instances). 512 blocks of 32 bytes fit in
+// the smallest uniform buffer a backend has to support (16 KiB).
+const nikol::u32 MATERIAL_PARAMS_MAX = 512;
+
+// Has to be a power of two
+const nikol::u32 SHADER_PERMUTATIONS_BITS = 8;
+const nikol::u32 SHADER_PERMUTATIONS_MAX  = 1 << SHADER_PERMUTATIONS_BITS;
+
+const nikol::u32 MATERIAL_SLOT_INVALID = 0xffffffff;
+
+// Uniform buffers the lit permutations take on top of the three the system owns
+const nikol::u32 MATERIAL_EXTRA_UNIFORMS_MAX = 4;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MaterialFeature
+// Every combination of these bits is its own shader permutation
+enum MaterialFeature {
+  MATERIAL_FEATURE_DIFFUSE_MAP       = 1 << 0,
+  MATERIAL_FEATURE_ALPHA_TEST        = 1 << 1,
+
+  // Picked from the mesh's `VertexFormat`, never by the material itself
+  MATERIAL_FEATURE_QUANTIZED         = 1 << 2,
+  MATERIAL_FEATURE_QUANTIZED_COMPACT = 1 << 3,
+
+  // Clustered point lights (see clustered_lighting.h)
+  MATERIAL_FEATURE_LIT               = 1 << 4,
+
+  // Terrain nodes (see terrain.h). The texture is the heightmap then, read by the vertex shader.
+  MATERIAL_FEATURE_TERRAIN           = 1 << 5,
+
+  // Picked from the mesh's `VertexFormat` as well (see voxel.h)
+  MATERIAL_FEATURE_VOXEL             = 1 << 6,
+
+  // Blended over what is behind it, so it gets drawn after everything else, back to front (see `render_mesh`).
+  // The other permutations write an alpha of 1, which keeps them opaque even with blending on.
+  MATERIAL_FEATURE_TRANSLUCENT       = 1 << 7,
+
+  // Picked from the mesh's `VertexFormat` as well: the vertices get skinned with the draw's joint palette (see skinning.h)
+  MATERIAL_FEATURE_SKINNED           = 1 << 8,
+
+  MATERIAL_FEATURES_COUNT = 9,
+};
+// MaterialFeature
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MaterialParams
+// One element of the `Materials` array in the shader, so it has to follow std140
+struct MaterialParams {
+  glm::vec4 color         = glm::vec4(1.0f);
+  nikol::f32 roughness    = 1.0f;
+  nikol::f32 metallic     = 0.0f;
+  nikol::f32 alpha_cutoff = 0.5f;
+  nikol::f32 padding      = 0.0f;
+};
+static_assert((sizeof(MaterialParams) % 16) == 0, "MaterialParams has to be a multiple of a vec4 for std140");
+// MaterialParams
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// DrawData
+// The per-draw block (`DrawData` in the shader)
+struct DrawData {
+  glm::mat4 view_projection;
+
+  // Only read by the lit permutations
+  glm::mat4 model_view;
+  glm::mat4 normal_matrix;
+
+  nikol::u32 material_index;
+  nikol::u32 padding[3];
+
+  // Only read by the terrain permutations (see `TerrainNode`)
+  glm::vec4 terrain_node;
+  glm::vec4 terrain_morph;
+};
+// DrawData
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ShaderPermutation
+struct ShaderPermutation {
+  nikol::u32 features       = 0;
+  nikol::GfxShader* shader  = nullptr; // `nullptr` marks an empty entry
+};
+// ShaderPermutation
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ExtraUniform
+struct ExtraUniform {
+  nikol::GfxShaderType stage;
+  nikol::GfxBuffer* buffer;
+};
+// ExtraUniform
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MaterialSystemStats
+struct MaterialSystemStats {
+  nikol::u32 shaders_compiled = 0;
+  nikol::u32 materials_live   = 0;
+
+  // Per frame (see `material_system_reset_stats`)
+  nikol::u32 params_uploads   = 0;
+  nikol::u32 params_bytes     = 0;
+  nikol::u32 params_unchanged = 0; // `material_set_params` calls that did not change anything
+};
+// MaterialSystemStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MaterialSystem
+// Owns the shader permutations and the three uniform buffers every one of them shares:
+//  - `draw_buffer`:    the `DrawData` of the draw in flight (binding 0).
+//  - `params_buffer`:  the `MaterialParams` of every material instance, packed in one std140 array (binding 1).
+//  - `palette_buffer`: the joint palette of the skinned draw in flight (binding 2). Only the skinned permutations
+//                      read it, but every one has it attached so the bindings after it stay the same.
+//
+// The lit permutations also get the buffers of `material_system_attach_uniform` (from binding 3 on).
+//
+// The backend can only bind whole uniform buffers, so instead of binding a range per material, the
+// draw tells the shader which element of the array to read (`DrawData::material_index`).
+//
+// Everything in here is plain old data, so the system can live inside `memory_allocate`d structs.
+struct MaterialSystem {
+  nikol::GfxContext* gfx = nullptr;
+
+  // Open addressing on the feature bits
+  ShaderPermutation permutations[SHADER_PERMUTATIONS_MAX];
+
+  nikol::GfxBuffer* draw_buffer    = nullptr;
+  nikol::GfxBuffer* params_buffer  = nullptr;
+  nikol::GfxBuffer* palette_buffer = nullptr;
+
+  ExtraUniform extra_uniforms[MATERIAL_EXTRA_UNIFORMS_MAX];
+  nikol::u32 extra_uniforms_count = 0;
+
+  // The CPU side copy of `params_buffer` and which slots are still free
+  MaterialParams params[MATERIAL_PARAMS_MAX];
+  nikol::u32 free_slots[MATERIAL_PARAMS_MAX];
+  nikol::u32 free_slots_count = 0;
+
+  // The range of slots that changed since the last flush (empty if `dirty_min > dirty_max`)
+  nikol::u32 dirty_min = MATERIAL_PARAMS_MAX;
+  nikol::u32 dirty_max = 0;
+
+  MaterialSystemStats stats;
+};
+// MaterialSystem
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// BaseMaterial
+// What all of its instances have in common: the features (and so the shader) and the default parameters
+struct BaseMaterial {
+  MaterialSystem* system    = nullptr;
+  nikol::u32 features       = 0;
+  nikol::GfxShader* shader  = nullptr;
+
+  MaterialParams defaults;
+};
+// BaseMaterial
+// ----------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------
 // Material
+// An instance of a `BaseMaterial`. It only holds its own texture and a slot in the shared parameter buffer.
 struct Material {
-  nikol::GfxContext* gfx         = nullptr;
-  nikol::GfxShader* shader       = nullptr; 
-  nikol::GfxTexture* diffuse     = nullptr;
-  nikol::GfxBuffer* uniform_buff = nullptr;
-
-  glm::mat4 transform;
+  BaseMaterial* base         = nullptr;
+  nikol::GfxTexture* diffuse = nullptr;
+  nikol::u32 slot            = MATERIAL_SLOT_INVALID;
 };
 // Material
 // ----------------------------------------------------------------------------
 
+// ----------------------------------------------------------------------------
+// MaterialSystem functions
+void material_system_init(MaterialSystem& system, nikol::GfxContext* gfx);
+void material_system_shutdown(MaterialSystem& system);
+
+// The features every shader drawing a mesh of `format` needs
+nikol::u32 material_features_from_format(const VertexFormat format);
+
+// Look the permutation for `features` up, compiling it the first time it is asked for
+nikol::GfxShader* material_system_get_shader(MaterialSystem& system, const nikol::u32 features);
+
+// Attach `buffer` to every lit permutation, the ones already compiled included. 
+// The buffers get bound in the order they were attached in.
+void material_system_attach_uniform(MaterialSystem& system, const nikol::GfxShaderType stage, nikol::GfxBuffer* buffer);
+
+// Upload every parameter block that changed since the last flush (in one update). Call it once before drawing.
+void material_system_flush(MaterialSystem& system);
+
+void material_system_reset_stats(MaterialSystem& system);
+// MaterialSystem functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// BaseMaterial functions
+BaseMaterial* base_material_create(MaterialSystem& system, const nikol::u32 features, const MaterialParams& defaults = MaterialParams{});
+void base_material_destroy(BaseMaterial* base);
+// BaseMaterial functions
+// ----------------------------------------------------------------------------
+
 // ----------------------------------------------------------------------------
 // Material functions
-Material* material_create(nikol::GfxContext* gfx, nikol::GfxShader* shader, nikol::GfxTexture* texture);
+
+// Returns `nullptr` if the shared parameter buffer is full
+Material* material_create(BaseMaterial* base, nikol::GfxTexture* texture);
 void material_destroy(Material* mat);
-void material_apply(Material* mat);
+
+// Only marks the block as dirty if `params` is actually different
+void material_set_params(Material* mat, const MaterialParams& params);
+const MaterialParams& material_get_params(const Material* mat);
+
+// The permutation of `mat` that can draw a mesh of `format`
+nikol::GfxShader* material_get_shader(const Material* mat, const VertexFormat format);
 // Material functions
 // ----------------------------------------------------------------------------
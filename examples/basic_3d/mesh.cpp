@@ -1,10 +1,15 @@
 #include "mesh.h"
 #include "vertex.h"
+#include "mesh_generator.h"
+#include "mesh_file.h"
+#include "mesh_lod.h"
+#include "vertex_quantize.h"
 
 #include <nikol/nikol_core.hpp>
 #include <glm/glm.hpp>
 
 #include <vector>
+#include <cstring>
 
 // ----------------------------------------------------------------------------
 // Private functions
@@ -74,7 +79,7 @@ static void construct_cube_mesh(std::vector<Vertex>& vertices, std::vector<nikol
 }
 
 static void construct_sphere_mesh(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices) {
-  // @TODO
+  shape_generate(ShapeDesc{.type = SHAPE_UV_SPHERE}, vertices, indices);
 }
 
 static void construct_mesh_by_type(const MeshType type, std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices) {
@@ -88,38 +93,118 @@ static void construct_mesh_by_type(const MeshType type, std::vector<Vertex>& ver
   }
 }
 
-// Private functions
-// ----------------------------------------------------------------------------
+static nikol::GfxLayoutType get_layout_type(const MeshAttributeType type) {
+  switch(type) {
+    case MESH_ATTRIBUTE_FLOAT1:
+      return nikol::GFX_LAYOUT_FLOAT1;
+    case MESH_ATTRIBUTE_FLOAT2:
+      return nikol::GFX_LAYOUT_FLOAT2;
+    case MESH_ATTRIBUTE_FLOAT3:
+      return nikol::GFX_LAYOUT_FLOAT3;
+    case MESH_ATTRIBUTE_FLOAT4:
+      return nikol::GFX_LAYOUT_FLOAT4;
+  }
 
-// ----------------------------------------------------------------------------
-// Mesh functions
-Mesh* mesh_create(nikol::GfxContext* gfx, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  return nikol::GFX_LAYOUT_FLOAT3;
+}
+
+// The layout keeps the name pointers around, so hand out static strings instead 
+// of pointers into a (soon to be unmapped) mesh file.
+static const char* get_layout_name(const char* name) {
+  for(auto& known : MESH_FILE_ATTRIBUTE_NAMES) {
+    if(std::strcmp(known, name) == 0) {
+      return known;
+    }
+  }
+
+  // `mesh_file_open` already turned files with unknown names away
+  NIKOL_ASSERT(false, "Unknown vertex attribute in mesh file");
+  return MESH_FILE_ATTRIBUTE_NAMES[0];
+}
+
+static nikol::GfxBuffer* create_index_buffer(nikol::GfxContext* gfx, 
+                                             const nikol::u32* indices, 
+                                             const nikol::sizei indices_count, 
+                                             const nikol::GfxBufferUsage usage = nikol::GFX_BUFFER_USAGE_STATIC_DRAW) {
+  nikol::GfxBufferDesc index_desc = {
+    .data  = (void*)indices,
+    .size  = indices_count * sizeof(nikol::u32),
+    .type  = nikol::GFX_BUFFER_INDEX, 
+    .usage = usage,
+  };
+
+  return nikol::gfx_buffer_create(gfx, index_desc);
+}
+
+static void compute_bounds(const std::vector<Vertex>& vertices, glm::vec3& center, nikol::f32& radius) {
+  glm::vec3 min = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+  glm::vec3 max = min;
+
+  for(auto& vert : vertices) {
+    min = glm::min(min, vert.position);
+    max = glm::max(max, vert.position);
+  }
+
+  center = (min + max) * 0.5f;
+  radius = 0.0f;
+
+  for(auto& vert : vertices) {
+    radius = glm::max(radius, glm::length(vert.position - center));
+  }
+}
+
+// Weld the vertices and build the LOD chain (appended right after LOD 0 in `indices`)
+static MeshPrepareStats prepare_geometry(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices, MeshLod* lods, nikol::u32& lods_count) {
+  MeshPrepareStats stats = mesh_prepare(vertices, indices);
+  lods_count             = mesh_generate_lods(indices, vertices, lods);
+
+  // The upload is always 32-bit (see `mesh_create` from a file), whatever index size would have fit
+  stats.index_size        = sizeof(nikol::u32);
+  stats.index_bytes_after = indices.size() * sizeof(nikol::u32);
+
+  return stats;
+}
+
+static Mesh* create_mesh(nikol::GfxContext* gfx, 
+                         const void* vertices, const nikol::sizei vertices_size, const nikol::sizei vertices_count,
+                         const nikol::u32* indices, const nikol::sizei indices_count,
+                         const nikol::GfxBufferUsage usage = nikol::GFX_BUFFER_USAGE_STATIC_DRAW) {
   Mesh* mesh = (Mesh*)nikol::memory_allocate(sizeof(Mesh));
   
   // Vertex buffer init
   nikol::GfxBufferDesc vert_desc = {
-    .data  = (void*)vertices.data(),
-    .size  = vertices.size() * sizeof(Vertex),
+    .data  = (void*)vertices,
+    .size  = vertices_size,
     .type  = nikol::GFX_BUFFER_VERTEX, 
-    .usage = nikol::GFX_BUFFER_USAGE_STATIC_DRAW,
+    .usage = usage,
   };
   mesh->pipe_desc.vertex_buffer  = nikol::gfx_buffer_create(gfx, vert_desc);
-  mesh->pipe_desc.vertices_count = vertices.size();  
+  mesh->pipe_desc.vertices_count = vertices_count;  
 
   // Index buffer init
-  nikol::GfxBufferDesc index_desc = {
-    .data  = (void*)indices.data(),
-    .size  = indices.size() * sizeof(nikol::u32),
-    .type  = nikol::GFX_BUFFER_INDEX, 
-    .usage = nikol::GFX_BUFFER_USAGE_STATIC_DRAW,
-  };
-  mesh->pipe_desc.index_buffer  = nikol::gfx_buffer_create(gfx, index_desc);
-  mesh->pipe_desc.indices_count = indices.size();  
+  mesh->pipe_desc.index_buffer  = create_index_buffer(gfx, indices, indices_count, usage);
+  mesh->pipe_desc.indices_count = indices_count;  
+
+  // LOD init (just the full mesh for now)
+  mesh->lods[0]              = MeshLod{.index_offset = 0, .indices_count = (nikol::u32)indices_count};
+  mesh->lod_index_buffers[0] = mesh->pipe_desc.index_buffer;
+  mesh->lods_count           = 1;
+
+  // Not pooled
+  mesh->pool = nullptr;
+
+  // Not an occluder (see `mesh_set_occluder`)
+  mesh->occluder = nullptr;
+
+  // Not quantized
+  mesh->vertex_format  = VERTEX_FORMAT_FULL;
+  mesh->dequantize     = glm::mat4(1.0f);
+  mesh->quantize_stats = QuantizeStats{};
 
   // Shader init (will later be filled with the appropriate material)
   mesh->pipe_desc.shader = nullptr; 
 
-  // Layout init
+  // Layout init (the default `Vertex` layout)
   mesh->pipe_desc.layout[0]    = nikol::GfxLayoutDesc{"POS", nikol::GFX_LAYOUT_FLOAT3, 0};
   mesh->pipe_desc.layout[1]    = nikol::GfxLayoutDesc{"NORMAL", nikol::GFX_LAYOUT_FLOAT3, 0};
   mesh->pipe_desc.layout[2]    = nikol::GfxLayoutDesc{"TEXCOORDS0", nikol::GFX_LAYOUT_FLOAT2, 0};
@@ -128,6 +213,223 @@ Mesh* mesh_create(nikol::GfxContext* gfx, const std::vector<Vertex>& vertices, c
   // Draw mode init 
   mesh->pipe_desc.draw_mode = nikol::GFX_DRAW_MODE_TRIANGLE;
 
+  return mesh;
+}
+
+// Every packed format goes in as a single attribute of raw words
+static void set_packed_layout(Mesh* mesh, const VertexFormat format) {
+  if(format == VERTEX_FORMAT_FULL) {
+    return;
+  }
+
+  // Skinned vertices are plain floats, just with the joints and weights after the default `Vertex` layout
+  if(format == VERTEX_FORMAT_SKINNED) {
+    mesh->pipe_desc.layout[3]    = nikol::GfxLayoutDesc{"JOINTS", nikol::GFX_LAYOUT_FLOAT4, 0};
+    mesh->pipe_desc.layout[4]    = nikol::GfxLayoutDesc{"WEIGHTS", nikol::GFX_LAYOUT_FLOAT4, 0};
+    mesh->pipe_desc.layout_count = 5;
+    return;
+  }
+
+  // One float per 32-bit word
+  nikol::GfxLayoutType packed_types[] = {nikol::GFX_LAYOUT_FLOAT1, nikol::GFX_LAYOUT_FLOAT2, nikol::GFX_LAYOUT_FLOAT3, nikol::GFX_LAYOUT_FLOAT4};
+  nikol::u32 words                    = vertex_format_get_stride(format) / 4;
+
+  // The words get bit-cast back in the shader (see `material_shader_glsl`)
+  mesh->pipe_desc.layout[0]    = nikol::GfxLayoutDesc{"PACKED", packed_types[words - 1], 0};
+  mesh->pipe_desc.layout_count = 1;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh functions
+Mesh* mesh_create(nikol::GfxContext* gfx, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, const VertexFormat format) {
+  std::vector<Vertex> welded_vertices   = vertices;
+  std::vector<nikol::u32> welded_indices = indices;
+
+  MeshLod lods[MESH_LODS_MAX];
+  nikol::u32 lods_count  = 0;
+  MeshPrepareStats stats = prepare_geometry(welded_vertices, welded_indices, lods, lods_count);
+
+  // Welding and simplification want the full precision, so quantizing comes last
+  std::vector<nikol::u8> packed; 
+  glm::mat4 dequantize;
+  QuantizeStats quantize_stats = vertex_quantize(packed, welded_vertices, format, dequantize);
+
+  Mesh* mesh = create_mesh(gfx, 
+                           packed.data(), packed.size(), welded_vertices.size(), 
+                           welded_indices.data(), lods[0].indices_count);
+  mesh->stats = stats;
+
+  set_packed_layout(mesh, format);
+
+  mesh->vertex_format  = format;
+  mesh->dequantize     = dequantize;
+  mesh->quantize_stats = quantize_stats;
+  
+  for(nikol::u32 i = 0; i < lods_count; i++) {
+    mesh->lods[i] = lods[i];
+    
+    if(i > 0) {
+      mesh->lod_index_buffers[i] = create_index_buffer(gfx, &welded_indices[lods[i].index_offset], lods[i].indices_count);
+    }
+  }
+  mesh->lods_count = lods_count;
+
+  compute_bounds(welded_vertices, mesh->bounds_center, mesh->bounds_radius);
+
+  // Finally, creating the pipeline 
+  mesh->pipe = nikol::gfx_pipeline_create(gfx, mesh->pipe_desc);
+
+  return mesh;
+}
+
+Mesh* mesh_create(GeometryPool& pool, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  std::vector<Vertex> welded_vertices   = vertices;
+  std::vector<nikol::u32> welded_indices = indices;
+
+  MeshLod lods[MESH_LODS_MAX];
+  nikol::u32 lods_count  = 0;
+  MeshPrepareStats stats = prepare_geometry(welded_vertices, welded_indices, lods, lods_count);
+
+  nikol::u32 vertices_count = (nikol::u32)welded_vertices.size();
+
+  nikol::u32 vertex_offset = geometry_pool_alloc_vertices(pool, welded_vertices.data(), vertices_count);
+  if(vertex_offset == RANGE_INVALID) {
+    return mesh_create(pool.gfx, vertices, indices);
+  }
+
+  Mesh* mesh = (Mesh*)nikol::memory_allocate(sizeof(Mesh));
+  
+  // The pool's bindings, with room for the material to fill in its own
+  mesh->pipe_desc = pool.pipe_desc;
+  mesh->pipe      = pool.pipe;
+  mesh->stats     = stats;
+
+  // The pool only takes full vertices
+  mesh->vertex_format  = VERTEX_FORMAT_FULL;
+  mesh->dequantize     = glm::mat4(1.0f);
+  mesh->quantize_stats = QuantizeStats{};
+
+  // Every LOD gets its own index buffer, already pointing into the pool's vertices
+  for(nikol::u32 i = 0; i < lods_count; i++) {
+    mesh->lods[i]              = lods[i];
+    mesh->lod_index_buffers[i] = geometry_pool_create_index_buffer(pool, &welded_indices[lods[i].index_offset], lods[i].indices_count, vertex_offset);
+  }
+  mesh->lods_count = lods_count;
+
+  compute_bounds(welded_vertices, mesh->bounds_center, mesh->bounds_radius);
+
+  mesh->pool                = &pool;
+  mesh->pool_vertex_offset  = vertex_offset;
+  mesh->pool_vertices_count = vertices_count;
+
+  mesh->occluder = nullptr;
+
+  return mesh;
+}
+
+Mesh* mesh_create(nikol::GfxContext* gfx, const MeshFile& file) {
+  const MeshFileHeader* header = file.header;
+  NIKOL_ASSERT(header, "Cannot create a mesh from a closed mesh file");
+
+  // The backend only draws 32-bit indices for now (GfxPipelineDesc has no index format), 
+  // so 16-bit files get widened on the way in. 32-bit files go straight from the mapping into the buffer. 
+  std::vector<nikol::u32> wide_indices;
+  const nikol::u32* indices = (const nikol::u32*)file.indices;
+  const void* vertices      = file.vertices;
+
+  // Compressed files get decoded into the memory the buffers are created from (already widened)
+  std::vector<nikol::u8> decoded_vertices;
+
+  if(mesh_file_is_compressed(file)) {
+    decoded_vertices.resize((nikol::sizei)header->vertices_count * header->vertex_stride);
+    wide_indices.resize(header->indices_count);
+
+    if(!mesh_file_decode(file, decoded_vertices.data(), wide_indices.data(), sizeof(nikol::u32))) {
+      return nullptr;
+    }
+
+    vertices = decoded_vertices.data();
+    indices  = wide_indices.data();
+  }
+  else if(header->index_size == 2) {
+    const nikol::u16* narrow = (const nikol::u16*)file.indices;
+    
+    wide_indices.assign(narrow, narrow + header->indices_count);
+    indices = wide_indices.data();
+  }
+
+  Mesh* mesh = create_mesh(gfx, 
+                           vertices, (nikol::sizei)header->vertices_count * header->vertex_stride, header->vertices_count, 
+                           indices, header->indices_count);
+  
+  // The file was prepared offline
+  mesh->stats.vertices_before    = header->vertices_count;
+  mesh->stats.vertices_after     = header->vertices_count;
+  mesh->stats.index_size         = sizeof(nikol::u32);
+  mesh->stats.index_bytes_before = (nikol::sizei)header->indices_count * sizeof(nikol::u32);
+  mesh->stats.index_bytes_after  = (nikol::sizei)header->indices_count * sizeof(nikol::u32);
+
+  glm::vec3 bounds_min = glm::vec3(header->bounds_min[0], header->bounds_min[1], header->bounds_min[2]);
+  glm::vec3 bounds_max = glm::vec3(header->bounds_max[0], header->bounds_max[1], header->bounds_max[2]);
+  mesh->bounds_center  = (bounds_min + bounds_max) * 0.5f;
+  mesh->bounds_radius  = glm::length(bounds_max - bounds_min) * 0.5f;
+
+  // Layout init (straight from the file, which only opens with the attributes packed in order)
+  for(nikol::u32 i = 0; i < header->attributes_count; i++) {
+    const MeshFileAttribute& attrib = file.attributes[i];
+    mesh->pipe_desc.layout[i] = nikol::GfxLayoutDesc{get_layout_name(attrib.name), get_layout_type(attrib.type), 0};
+  }
+  mesh->pipe_desc.layout_count = header->attributes_count;
+
+  // Finally, creating the pipeline 
+  mesh->pipe = nikol::gfx_pipeline_create(gfx, mesh->pipe_desc);
+
+  return mesh;
+}
+
+Mesh* mesh_create_dynamic(nikol::GfxContext* gfx, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  Mesh* mesh = create_mesh(gfx, 
+                           vertices.data(), vertices.size() * sizeof(Vertex), vertices.size(), 
+                           indices.data(), indices.size(), 
+                           nikol::GFX_BUFFER_USAGE_DYNAMIC_DRAW);
+
+  mesh->stats.vertices_before    = (nikol::u32)vertices.size();
+  mesh->stats.vertices_after     = (nikol::u32)vertices.size();
+  mesh->stats.index_size         = sizeof(nikol::u32);
+  mesh->stats.index_bytes_before = indices.size() * sizeof(nikol::u32);
+  mesh->stats.index_bytes_after  = indices.size() * sizeof(nikol::u32);
+
+  compute_bounds(vertices, mesh->bounds_center, mesh->bounds_radius);
+
+  // Finally, creating the pipeline 
+  mesh->pipe = nikol::gfx_pipeline_create(gfx, mesh->pipe_desc);
+
+  return mesh;
+}
+
+Mesh* mesh_create(nikol::GfxContext* gfx, 
+                  const void* vertices, const nikol::u32 vertices_count, const VertexFormat format,
+                  const std::vector<nikol::u32>& indices, 
+                  const glm::vec3& bounds_min, const glm::vec3& bounds_max) {
+  Mesh* mesh = create_mesh(gfx, 
+                           vertices, (nikol::sizei)vertices_count * vertex_format_get_stride(format), vertices_count, 
+                           indices.data(), indices.size());
+
+  // Packed elsewhere
+  mesh->stats.vertices_before    = vertices_count;
+  mesh->stats.vertices_after     = vertices_count;
+  mesh->stats.index_size         = sizeof(nikol::u32);
+  mesh->stats.index_bytes_before = indices.size() * sizeof(nikol::u32);
+  mesh->stats.index_bytes_after  = indices.size() * sizeof(nikol::u32);
+
+  set_packed_layout(mesh, format);
+  mesh->vertex_format = format;
+
+  mesh->bounds_center = (bounds_min + bounds_max) * 0.5f;
+  mesh->bounds_radius = glm::length(bounds_max - bounds_min) * 0.5f;
+
   // Finally, creating the pipeline 
   mesh->pipe = nikol::gfx_pipeline_create(gfx, mesh->pipe_desc);
 
@@ -147,8 +449,29 @@ void mesh_destroy(Mesh* mesh) {
     return;
   }
  
+  // The pipeline belongs to the pool. Just give the vertices and the index buffers back.
+  if(mesh->pool) {
+    geometry_pool_free_vertices(*mesh->pool, mesh->pool_vertex_offset, mesh->pool_vertices_count);
+
+    for(nikol::u32 i = 0; i < mesh->lods_count; i++) {
+      geometry_pool_destroy_index_buffer(*mesh->pool, mesh->lod_index_buffers[i], mesh->lods[i].indices_count);
+    }
+
+    nikol::memory_free(mesh);
+    return;
+  }
+
+  // LOD 0's index buffer belongs to the pipeline
+  for(nikol::u32 i = 1; i < mesh->lods_count; i++) {
+    nikol::gfx_buffer_destroy(mesh->lod_index_buffers[i]);
+  }
+ 
   nikol::gfx_pipeline_destroy(mesh->pipe);
   nikol::memory_free(mesh);
 }
+
+void mesh_set_occluder(Mesh* mesh, const OccluderMesh* occluder) {
+  mesh->occluder = occluder;
+}
 // Mesh functions
 // ----------------------------------------------------------------------------
@@ -1,11 +1,19 @@
 #pragma once
 
 #include "vertex.h"
+#include "mesh_file.h"
+#include "mesh_prepare.h"
+#include "mesh_lod.h"
+#include "geometry_pool.h"
+#include "vertex_quantize.h"
 
 #include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
 
 #include <vector>
 
+struct OccluderMesh;
+
 // ----------------------------------------------------------------------------
 // MeshType
 enum MeshType {
@@ -20,14 +28,70 @@ enum MeshType {
 struct Mesh {
   nikol::GfxPipelineDesc pipe_desc;
   nikol::GfxPipeline* pipe;
+
+  // What the welding did to this mesh, and the index bytes actually uploaded (always 32-bit, LODs included)
+  MeshPrepareStats stats;
+
+  // Quantized meshes need `dequantize` applied before the model matrix
+  VertexFormat vertex_format;
+  glm::mat4 dequantize;
+  QuantizeStats quantize_stats;
+
+  // Every LOD indexes into the same vertex buffer. The pipeline is created with LOD 0's 
+  // index buffer and the others are swapped in through the desc when applied.
+  MeshLod lods[MESH_LODS_MAX];
+  nikol::GfxBuffer* lod_index_buffers[MESH_LODS_MAX];
+  nikol::u32 lods_count;
+
+  // Object space bounding sphere (used to pick the LOD)
+  glm::vec3 bounds_center;
+  nikol::f32 bounds_radius;
+
+  // Set when the mesh lives in a geometry pool. `pipe` is the pool's pipeline then, and 
+  // the LODs' index buffers come from the pool (see `geometry_pool_create_index_buffer`).
+  GeometryPool* pool;
+  nikol::u32 pool_vertex_offset, pool_vertices_count;
+
+  // Set for meshes that hide others. It gets rasterized for occlusion culling whenever the mesh is drawn.
+  const OccluderMesh* occluder;
 };
 // Mesh
 // ----------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------
 // Mesh functions
-Mesh* mesh_create(nikol::GfxContext* gfx, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices);
+// The vertices get welded (bitwise) before the upload. See `Mesh::stats` for the results. 
+// Meshes with enough triangles also get a LOD chain (see `mesh_generate_lods`). Any `format` other 
+// than `VERTEX_FORMAT_FULL` quantizes the vertices (see `Mesh::quantize_stats` for the error).
+Mesh* mesh_create(nikol::GfxContext* gfx, 
+                  const std::vector<Vertex>& vertices, 
+                  const std::vector<nikol::u32>& indices, 
+                  const VertexFormat format = VERTEX_FORMAT_FULL);
 Mesh* mesh_create(nikol::GfxContext* gfx, const MeshType type);
+
+// Same as above, but the geometry goes into `pool` instead of its own buffers. 
+// Falls back to its own buffers if the pool is full.
+Mesh* mesh_create(GeometryPool& pool, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices);
+
+// Upload vertices that were already packed into `format` (or plain `Vertex`es with `VERTEX_FORMAT_FULL`) as they 
+// are (no welding, no LODs, no quantization stats). 
+// The bounds are in the packed positions' space, and `Mesh::dequantize` is left to the caller.
+Mesh* mesh_create(nikol::GfxContext* gfx, 
+                  const void* vertices, const nikol::u32 vertices_count, const VertexFormat format,
+                  const std::vector<nikol::u32>& indices, 
+                  const glm::vec3& bounds_min, const glm::vec3& bounds_max);
+
+// Upload a mapped mesh file without parsing or copying the vertices (and with a single LOD). 
+// Compressed files get decoded first, and return `nullptr` if they turn out to be broken.
+Mesh* mesh_create(nikol::GfxContext* gfx, const MeshFile& file);
+
+// For vertices that get rewritten every frame (see `skinned_mesh_upload`). The vertices are kept 
+// exactly as given (no welding, no LODs), so they can be streamed into the buffer in the same order.
+// The index buffer is dynamic as well, for meshes drawing a different subset of their triangles every frame (see `render_meshlets`).
+Mesh* mesh_create_dynamic(nikol::GfxContext* gfx, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices);
 void mesh_destroy(Mesh* mesh);
+
+// Flag `mesh` as an occluder (or not, with `nullptr`). `occluder` is not copied and has to outlive the mesh.
+void mesh_set_occluder(Mesh* mesh, const OccluderMesh* occluder);
 // Mesh functions
 // ----------------------------------------------------------------------------
@@ -0,0 +1,666 @@
+#include "mesh_codec.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define CODEC_SIMD_SSE
+#endif
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The first byte of every stream, so a vertex stream never gets decoded as indices (and the other way around)
+const nikol::u8 VERTEX_STREAM_TAG = 0xa1;
+const nikol::u8 INDEX_STREAM_TAG  = 0xe1;
+
+// Bytes of a plane sharing one 2-bit mode
+const nikol::u32 GROUP_SIZE = 16;
+
+// How the bytes of a group are stored
+const nikol::u32 GROUP_MODE_ZERO  = 0; // All zero, nothing stored
+const nikol::u32 GROUP_MODE_BITS2 = 1;
+const nikol::u32 GROUP_MODE_BITS4 = 2;
+const nikol::u32 GROUP_MODE_BITS8 = 3;
+
+// Index codes. An edge triangle is `(edge << 4) | third`. Anything else is `CODE_NO_EDGE` and a code per vertex.
+const nikol::u8 CODE_NO_EDGE       = 0xf0;
+const nikol::u8 CODE_NEXT          = 0;
+const nikol::u8 CODE_EDGE_EXPLICIT = 15;
+const nikol::u8 CODE_EXPLICIT      = MESH_CODEC_VERTEX_FIFO + 1;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// IndexFifos
+// The history both sides of the index codec keep in lockstep
+struct IndexFifos {
+  nikol::u32 edges[MESH_CODEC_EDGE_FIFO][2];
+  nikol::u32 vertices[MESH_CODEC_VERTEX_FIFO];
+
+  nikol::u32 edge_head   = 0;
+  nikol::u32 vertex_head = 0;
+
+  nikol::u32 next          = 0; // The next vertex nothing has used yet (if the vertices are in first use order)
+  nikol::u32 last_explicit = 0; // Explicit indices are stored as a delta from this
+};
+// IndexFifos
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u32 zigzag(const nikol::u32 value) {
+  return (value << 1) ^ (nikol::u32)((nikol::i32)value >> 31);
+}
+
+static nikol::u32 unzigzag(const nikol::u32 value) {
+  return (value >> 1) ^ (0u - (value & 1));
+}
+
+#if defined(CODEC_SIMD_SSE)
+
+// The 16 bytes of a group, with the packed fields of every byte spread out lowest bits first
+static __m128i unpack_group(const nikol::u8* in, const nikol::u32 mode) {
+  switch(mode) {
+    case GROUP_MODE_BITS2: {
+      nikol::u32 packed;
+      std::memcpy(&packed, in, sizeof(packed));
+
+      __m128i value = _mm_cvtsi32_si128((int)packed);
+      __m128i mask  = _mm_set1_epi8(3);
+
+      __m128i f0 = _mm_and_si128(value, mask);
+      __m128i f1 = _mm_and_si128(_mm_srli_epi16(value, 2), mask);
+      __m128i f2 = _mm_and_si128(_mm_srli_epi16(value, 4), mask);
+      __m128i f3 = _mm_and_si128(_mm_srli_epi16(value, 6), mask);
+
+      return _mm_unpacklo_epi16(_mm_unpacklo_epi8(f0, f1), _mm_unpacklo_epi8(f2, f3));
+    }
+    case GROUP_MODE_BITS4: {
+      __m128i value = _mm_loadl_epi64((const __m128i*)in);
+      __m128i mask  = _mm_set1_epi8(15);
+
+      return _mm_unpacklo_epi8(_mm_and_si128(value, mask), _mm_and_si128(_mm_srli_epi16(value, 4), mask));
+    }
+    case GROUP_MODE_BITS8:
+      return _mm_loadu_si128((const __m128i*)in);
+  }
+
+  return _mm_setzero_si128();
+}
+
+// Same as above, but reads a full group of bytes whatever the mode
+static __m128i unpack_group_branchless(const nikol::u8* in, const nikol::u32 mode) {
+  __m128i raw   = _mm_loadu_si128((const __m128i*)in);
+  __m128i modes = _mm_set1_epi8((char)mode);
+
+  __m128i mask2 = _mm_set1_epi8(3);
+  __m128i f0    = _mm_and_si128(raw, mask2);
+  __m128i f1    = _mm_and_si128(_mm_srli_epi16(raw, 2), mask2);
+  __m128i f2    = _mm_and_si128(_mm_srli_epi16(raw, 4), mask2);
+  __m128i f3    = _mm_and_si128(_mm_srli_epi16(raw, 6), mask2);
+  __m128i bits2 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(f0, f1), _mm_unpacklo_epi8(f2, f3));
+
+  __m128i mask4 = _mm_set1_epi8(15);
+  __m128i bits4 = _mm_unpacklo_epi8(_mm_and_si128(raw, mask4), _mm_and_si128(_mm_srli_epi16(raw, 4), mask4));
+
+  __m128i group = _mm_and_si128(bits2, _mm_cmpeq_epi8(modes, _mm_set1_epi8(GROUP_MODE_BITS2)));
+  group         = _mm_or_si128(group, _mm_and_si128(bits4, _mm_cmpeq_epi8(modes, _mm_set1_epi8(GROUP_MODE_BITS4))));
+  group         = _mm_or_si128(group, _mm_and_si128(raw, _mm_cmpeq_epi8(modes, _mm_set1_epi8(GROUP_MODE_BITS8))));
+
+  return group;
+}
+
+#else
+
+// Every byte expanded into the 4 (2-bit) or 2 (4-bit) bytes it packs, lowest bits first
+struct UnpackTables {
+  nikol::u8 bits2[256][4];
+  nikol::u8 bits4[256][2];
+
+  UnpackTables() {
+    for(nikol::u32 i = 0; i < 256; i++) {
+      for(nikol::u32 j = 0; j < 4; j++) {
+        bits2[i][j] = (i >> (j * 2)) & 3;
+      }
+
+      bits4[i][0] = i & 15;
+      bits4[i][1] = i >> 4;
+    }
+  }
+};
+
+static const UnpackTables s_unpack;
+
+#endif
+
+static nikol::u32 group_mode(const nikol::u8* bytes) {
+  nikol::u8 combined = 0;
+  for(nikol::u32 i = 0; i < GROUP_SIZE; i++) {
+    combined |= bytes[i];
+  }
+
+  if(combined == 0) {
+    return GROUP_MODE_ZERO;
+  }
+  else if(combined < 4) {
+    return GROUP_MODE_BITS2;
+  }
+  else if(combined < 16) {
+    return GROUP_MODE_BITS4;
+  }
+
+  return GROUP_MODE_BITS8;
+}
+
+// A plane of `MESH_CODEC_VERTEX_BLOCK` bytes (zero padded): the modes of every group, then their bytes
+static void encode_plane(std::vector<nikol::u8>& out, const nikol::u8* plane, const nikol::u32 groups_count) {
+  nikol::sizei modes_start = out.size();
+  out.resize(out.size() + (groups_count + 3) / 4, 0);
+
+  for(nikol::u32 group = 0; group < groups_count; group++) {
+    const nikol::u8* bytes = plane + group * GROUP_SIZE;
+    nikol::u32 mode        = group_mode(bytes);
+
+    out[modes_start + group / 4] |= (nikol::u8)(mode << ((group % 4) * 2));
+
+    switch(mode) {
+      case GROUP_MODE_BITS2:
+        for(nikol::u32 i = 0; i < GROUP_SIZE; i += 4) {
+          out.push_back(bytes[i] | (bytes[i + 1] << 2) | (bytes[i + 2] << 4) | (bytes[i + 3] << 6));
+        }
+        break;
+      case GROUP_MODE_BITS4:
+        for(nikol::u32 i = 0; i < GROUP_SIZE; i += 2) {
+          out.push_back(bytes[i] | (bytes[i + 1] << 4));
+        }
+        break;
+      case GROUP_MODE_BITS8:
+        out.insert(out.end(), bytes, bytes + GROUP_SIZE);
+        break;
+    }
+  }
+}
+
+static const nikol::u8* decode_plane(nikol::u8* plane, const nikol::u32 groups_count, const nikol::u8* in, const nikol::u8* end) {
+  const nikol::u8* modes = in;
+  in                    += (groups_count + 3) / 4;
+  if(in > end) {
+    return nullptr;
+  }
+
+  for(nikol::u32 group = 0; group < groups_count; group++) {
+    nikol::u8* bytes = plane + group * GROUP_SIZE;
+    nikol::u32 mode  = (modes[group / 4] >> ((group % 4) * 2)) & 3;
+
+    // Every mode past zero doubles the bytes stored
+    nikol::u32 stored = mode == GROUP_MODE_ZERO ? 0 : (GROUP_SIZE / 4) << (mode - 1);
+    if(stored > (nikol::sizei)(end - in)) {
+      return nullptr;
+    }
+
+#if defined(CODEC_SIMD_SSE)
+    // Away from the end, every mode gets unpacked and the right one picked, since the modes are too random to branch on
+    __m128i unpacked = (nikol::sizei)(end - in) >= GROUP_SIZE ? unpack_group_branchless(in, mode) : unpack_group(in, mode);
+    _mm_storeu_si128((__m128i*)bytes, unpacked);
+#else
+    switch(mode) {
+      case GROUP_MODE_ZERO:
+        std::memset(bytes, 0, GROUP_SIZE);
+        break;
+      case GROUP_MODE_BITS2:
+        for(nikol::u32 i = 0; i < 4; i++) {
+          std::memcpy(bytes + i * 4, s_unpack.bits2[in[i]], 4);
+        }
+        break;
+      case GROUP_MODE_BITS4:
+        for(nikol::u32 i = 0; i < 8; i++) {
+          std::memcpy(bytes + i * 2, s_unpack.bits4[in[i]], 2);
+        }
+        break;
+      case GROUP_MODE_BITS8:
+        std::memcpy(bytes, in, GROUP_SIZE);
+        break;
+    }
+#endif
+
+    in += stored;
+  }
+
+  return in;
+}
+
+// Put the 4 byte planes of a lane back together and undo the zigzag
+static void assemble_deltas(nikol::u32* deltas, nikol::u8 planes[4][MESH_CODEC_VERTEX_BLOCK], const nikol::u32 count) {
+#if defined(CODEC_SIMD_SSE)
+  const __m128i one  = _mm_set1_epi32(1);
+  const __m128i zero = _mm_setzero_si128();
+
+  for(nikol::u32 i = 0; i < count; i += 16) {
+    __m128i b0 = _mm_loadu_si128((const __m128i*)&planes[0][i]);
+    __m128i b1 = _mm_loadu_si128((const __m128i*)&planes[1][i]);
+    __m128i b2 = _mm_loadu_si128((const __m128i*)&planes[2][i]);
+    __m128i b3 = _mm_loadu_si128((const __m128i*)&planes[3][i]);
+
+    // Byte pairs, then the full words
+    __m128i low01  = _mm_unpacklo_epi8(b0, b1);
+    __m128i high01 = _mm_unpackhi_epi8(b0, b1);
+    __m128i low23  = _mm_unpacklo_epi8(b2, b3);
+    __m128i high23 = _mm_unpackhi_epi8(b2, b3);
+
+    __m128i words[4] = {
+      _mm_unpacklo_epi16(low01, low23),
+      _mm_unpackhi_epi16(low01, low23),
+      _mm_unpacklo_epi16(high01, high23),
+      _mm_unpackhi_epi16(high01, high23),
+    };
+
+    for(nikol::u32 j = 0; j < 4; j++) {
+      __m128i sign = _mm_sub_epi32(zero, _mm_and_si128(words[j], one));
+      _mm_storeu_si128((__m128i*)&deltas[i + j * 4], _mm_xor_si128(_mm_srli_epi32(words[j], 1), sign));
+    }
+  }
+#else
+  for(nikol::u32 i = 0; i < count; i++) {
+    nikol::u32 word = planes[0][i] | (planes[1][i] << 8) | (planes[2][i] << 16) | ((nikol::u32)planes[3][i] << 24);
+    deltas[i]       = unzigzag(word);
+  }
+#endif
+}
+
+// Add the deltas of a block up into the words of each vertex, with `previous` holding the last vertex's words
+static void write_block(nikol::u8* out, const nikol::u32 stride, const nikol::u32 count, const nikol::u32* deltas, nikol::u32* previous) {
+  nikol::u32 lanes = stride / 4;
+  nikol::u32 lane  = 0;
+
+#if defined(CODEC_SIMD_SSE)
+  // 4 lanes of 4 vertices at a time, turned around so every vertex gets written with a single store
+  for(; lane + 4 <= lanes; lane += 4) {
+    const nikol::u32* rows = &deltas[lane * MESH_CODEC_VERTEX_BLOCK];
+    nikol::u8* dest        = out + lane * 4;
+
+    __m128i words = _mm_loadu_si128((const __m128i*)&previous[lane]);
+    nikol::u32 i  = 0;
+
+    for(; i + 4 <= count; i += 4) {
+      __m128i r0 = _mm_loadu_si128((const __m128i*)&rows[0 * MESH_CODEC_VERTEX_BLOCK + i]);
+      __m128i r1 = _mm_loadu_si128((const __m128i*)&rows[1 * MESH_CODEC_VERTEX_BLOCK + i]);
+      __m128i r2 = _mm_loadu_si128((const __m128i*)&rows[2 * MESH_CODEC_VERTEX_BLOCK + i]);
+      __m128i r3 = _mm_loadu_si128((const __m128i*)&rows[3 * MESH_CODEC_VERTEX_BLOCK + i]);
+
+      __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+      __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+      __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+      __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+      words = _mm_add_epi32(words, _mm_unpacklo_epi64(t0, t1));
+      _mm_storeu_si128((__m128i*)(dest + (nikol::sizei)(i + 0) * stride), words);
+
+      words = _mm_add_epi32(words, _mm_unpackhi_epi64(t0, t1));
+      _mm_storeu_si128((__m128i*)(dest + (nikol::sizei)(i + 1) * stride), words);
+
+      words = _mm_add_epi32(words, _mm_unpacklo_epi64(t2, t3));
+      _mm_storeu_si128((__m128i*)(dest + (nikol::sizei)(i + 2) * stride), words);
+
+      words = _mm_add_epi32(words, _mm_unpackhi_epi64(t2, t3));
+      _mm_storeu_si128((__m128i*)(dest + (nikol::sizei)(i + 3) * stride), words);
+    }
+
+    _mm_storeu_si128((__m128i*)&previous[lane], words);
+
+    // The last few vertices of the mesh go one lane at a time
+    for(nikol::u32 j = 0; j < 4; j++) {
+      for(nikol::u32 v = i; v < count; v++) {
+        previous[lane + j] += rows[j * MESH_CODEC_VERTEX_BLOCK + v];
+        std::memcpy(dest + (nikol::sizei)v * stride + j * 4, &previous[lane + j], sizeof(nikol::u32));
+      }
+    }
+  }
+#endif
+
+  // The running sum goes straight into its lane of the output
+  for(; lane < lanes; lane++) {
+    const nikol::u32* row = &deltas[lane * MESH_CODEC_VERTEX_BLOCK];
+    nikol::u8* dest       = out + lane * 4;
+    nikol::u32 word       = previous[lane];
+
+    for(nikol::u32 i = 0; i < count; i++) {
+      word += row[i];
+      std::memcpy(dest, &word, sizeof(word));
+
+      dest += stride;
+    }
+
+    previous[lane] = word;
+  }
+}
+
+static void write_varint(std::vector<nikol::u8>& out, nikol::u32 value) {
+  while(value >= 0x80) {
+    out.push_back((nikol::u8)(value | 0x80));
+    value >>= 7;
+  }
+
+  out.push_back((nikol::u8)value);
+}
+
+static const nikol::u8* read_varint(const nikol::u8* in, const nikol::u8* end, nikol::u32& value) {
+  value = 0;
+
+  for(nikol::u32 shift = 0; shift < 35; shift += 7) {
+    if(in == end) {
+      return nullptr;
+    }
+
+    nikol::u8 byte = *in++;
+    value         |= (nikol::u32)(byte & 0x7f) << shift;
+
+    if(byte < 0x80) {
+      return in;
+    }
+  }
+
+  return nullptr;
+}
+
+static void fifos_init(IndexFifos& fifos) {
+  fifos = IndexFifos{};
+
+  // Nothing a real index will ever match
+  std::memset(fifos.edges, 0xff, sizeof(fifos.edges));
+  std::memset(fifos.vertices, 0xff, sizeof(fifos.vertices));
+}
+
+static void push_edge(IndexFifos& fifos, const nikol::u32 a, const nikol::u32 b) {
+  fifos.edges[fifos.edge_head % MESH_CODEC_EDGE_FIFO][0] = a;
+  fifos.edges[fifos.edge_head % MESH_CODEC_EDGE_FIFO][1] = b;
+  fifos.edge_head++;
+}
+
+static void push_vertex(IndexFifos& fifos, const nikol::u32 index) {
+  fifos.vertices[fifos.vertex_head % MESH_CODEC_VERTEX_FIFO] = index;
+  fifos.vertex_head++;
+}
+
+// `distance` 1 is the most recent
+static nikol::u32 fifo_vertex(const IndexFifos& fifos, const nikol::u32 distance) {
+  return fifos.vertices[(fifos.vertex_head - distance) % MESH_CODEC_VERTEX_FIFO];
+}
+
+// The code of a single vertex. `fifo_limit` is the furthest FIFO distance the code can hold.
+static nikol::u8 encode_vertex(std::vector<nikol::u8>& explicits, IndexFifos& fifos, const nikol::u32 index, const nikol::u32 fifo_limit, const nikol::u8 explicit_code) {
+  if(index == fifos.next) {
+    fifos.next++;
+    push_vertex(fifos, index);
+
+    return CODE_NEXT;
+  }
+
+  for(nikol::u32 distance = 1; distance <= fifo_limit; distance++) {
+    if(fifo_vertex(fifos, distance) == index) {
+      return (nikol::u8)distance;
+    }
+  }
+
+  write_varint(explicits, zigzag(index - fifos.last_explicit));
+  fifos.last_explicit = index;
+  push_vertex(fifos, index);
+
+  return explicit_code;
+}
+
+static const nikol::u8* decode_vertex(const nikol::u8* in, const nikol::u8* end, IndexFifos& fifos, const nikol::u32 code, const nikol::u8 explicit_code, nikol::u32& index) {
+  if(code == CODE_NEXT) {
+    index = fifos.next++;
+    push_vertex(fifos, index);
+  }
+  else if(code == explicit_code) {
+    nikol::u32 delta;
+    in = read_varint(in, end, delta);
+
+    index               = fifos.last_explicit + unzigzag(delta);
+    fifos.last_explicit = index;
+    push_vertex(fifos, index);
+  }
+  else if(code < explicit_code) {
+    index = fifo_vertex(fifos, code);
+  }
+  else {
+    return nullptr;
+  }
+
+  return in;
+}
+
+template<typename T>
+static bool decode_indices(T* out, const nikol::u32 count, const nikol::u32 vertices_count, const nikol::u8* in, const nikol::u8* end) {
+  IndexFifos fifos;
+  fifos_init(fifos);
+
+  for(nikol::u32 i = 0; i < count; i += 3) {
+    if(in == end) {
+      return false;
+    }
+
+    nikol::u8 code = *in++;
+    nikol::u32 a, b, c;
+
+    if(code < CODE_NO_EDGE) {
+      const nikol::u32* edge = fifos.edges[(fifos.edge_head - 1 - (code >> 4)) % MESH_CODEC_EDGE_FIFO];
+      a                      = edge[0];
+      b                      = edge[1];
+
+      in = decode_vertex(in, end, fifos, code & 15, CODE_EDGE_EXPLICIT, c);
+      if(!in) {
+        return false;
+      }
+
+      push_edge(fifos, c, b);
+      push_edge(fifos, a, c);
+    }
+    else if(code == CODE_NO_EDGE) {
+      nikol::u32 corners[3];
+
+      for(nikol::u32 j = 0; j < 3; j++) {
+        if(in == end) {
+          return false;
+        }
+
+        nikol::u8 vertex_code = *in++;
+
+        in = decode_vertex(in, end, fifos, vertex_code, CODE_EXPLICIT, corners[j]);
+        if(!in) {
+          return false;
+        }
+      }
+
+      a = corners[0];
+      b = corners[1];
+      c = corners[2];
+
+      push_edge(fifos, b, a);
+      push_edge(fifos, c, b);
+      push_edge(fifos, a, c);
+    }
+    else {
+      return false;
+    }
+
+    // Anything pointing past the vertices (or not fitting the output) is a broken stream
+    if(a >= vertices_count || b >= vertices_count || c >= vertices_count) {
+      return false;
+    }
+
+    if(sizeof(T) < sizeof(nikol::u32) && (a | b | c) > 0xffff) {
+      return false;
+    }
+
+    out[i + 0] = (T)a;
+    out[i + 1] = (T)b;
+    out[i + 2] = (T)c;
+  }
+
+  return true;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh codec functions
+void mesh_codec_encode_vertices(std::vector<nikol::u8>& out, const void* vertices, const nikol::u32 count, const nikol::u32 stride) {
+  NIKOL_ASSERT((stride % 4) == 0, "The vertex codec only takes strides that are a multiple of 4");
+
+  const nikol::u8* bytes = (const nikol::u8*)vertices;
+  nikol::u32 lanes       = stride / 4;
+
+  out.push_back(VERTEX_STREAM_TAG);
+
+  // The words of the previous vertex, which every delta is taken from
+  std::vector<nikol::u32> previous(lanes, 0);
+  nikol::u8 planes[4][MESH_CODEC_VERTEX_BLOCK];
+
+  for(nikol::u32 block_start = 0; block_start < count; block_start += MESH_CODEC_VERTEX_BLOCK) {
+    nikol::u32 block_count  = std::min(count - block_start, MESH_CODEC_VERTEX_BLOCK);
+    nikol::u32 groups_count = (block_count + GROUP_SIZE - 1) / GROUP_SIZE;
+
+    for(nikol::u32 lane = 0; lane < lanes; lane++) {
+      std::memset(planes, 0, sizeof(planes));
+
+      for(nikol::u32 i = 0; i < block_count; i++) {
+        nikol::u32 word;
+        std::memcpy(&word, bytes + (nikol::sizei)(block_start + i) * stride + lane * 4, sizeof(word));
+
+        nikol::u32 delta = zigzag(word - previous[lane]);
+        previous[lane]   = word;
+
+        for(nikol::u32 plane = 0; plane < 4; plane++) {
+          planes[plane][i] = (nikol::u8)(delta >> (plane * 8));
+        }
+      }
+
+      for(nikol::u32 plane = 0; plane < 4; plane++) {
+        encode_plane(out, planes[plane], groups_count);
+      }
+    }
+  }
+}
+
+bool mesh_codec_decode_vertices(void* out, const nikol::u32 count, const nikol::u32 stride, const nikol::u8* in, const nikol::sizei size) {
+  if((stride % 4) != 0 || size == 0 || in[0] != VERTEX_STREAM_TAG) {
+    return false;
+  }
+
+  const nikol::u8* end = in + size;
+  in++;
+
+  nikol::u8* bytes = (nikol::u8*)out;
+  nikol::u32 lanes = stride / 4;
+
+  std::vector<nikol::u32> previous(lanes, 0);
+  std::vector<nikol::u32> deltas((nikol::sizei)lanes * MESH_CODEC_VERTEX_BLOCK);
+  alignas(16) nikol::u8 planes[4][MESH_CODEC_VERTEX_BLOCK];
+
+  for(nikol::u32 block_start = 0; block_start < count; block_start += MESH_CODEC_VERTEX_BLOCK) {
+    nikol::u32 block_count  = std::min(count - block_start, MESH_CODEC_VERTEX_BLOCK);
+    nikol::u32 groups_count = (block_count + GROUP_SIZE - 1) / GROUP_SIZE;
+
+    for(nikol::u32 lane = 0; lane < lanes; lane++) {
+      for(nikol::u32 plane = 0; plane < 4; plane++) {
+        in = decode_plane(planes[plane], groups_count, in, end);
+        if(!in) {
+          return false;
+        }
+      }
+
+      assemble_deltas(&deltas[lane * MESH_CODEC_VERTEX_BLOCK], planes, groups_count * GROUP_SIZE);
+    }
+
+    write_block(bytes + (nikol::sizei)block_start * stride, stride, block_count, deltas.data(), previous.data());
+  }
+
+  return true;
+}
+
+void mesh_codec_encode_indices(std::vector<nikol::u8>& out, const nikol::u32* indices, const nikol::u32 count) {
+  NIKOL_ASSERT((count % 3) == 0, "The index codec only takes triangle lists");
+
+  IndexFifos fifos;
+  fifos_init(fifos);
+
+  out.push_back(INDEX_STREAM_TAG);
+
+  // The varints of a triangle have to come after its code bytes
+  std::vector<nikol::u8> explicits;
+
+  for(nikol::u32 i = 0; i < count; i += 3) {
+    const nikol::u32* tri = &indices[i];
+    explicits.clear();
+
+    // Any rotation of the triangle can use an edge the previous ones left behind
+    nikol::u32 edge_distance = MESH_CODEC_EDGE_FIFO;
+    nikol::u32 rotation      = 0;
+
+    for(nikol::u32 distance = 0; distance < MESH_CODEC_EDGE_FIFO - 1 && edge_distance == MESH_CODEC_EDGE_FIFO; distance++) {
+      const nikol::u32* edge = fifos.edges[(fifos.edge_head - 1 - distance) % MESH_CODEC_EDGE_FIFO];
+
+      for(nikol::u32 r = 0; r < 3; r++) {
+        if(edge[0] == tri[r] && edge[1] == tri[(r + 1) % 3]) {
+          edge_distance = distance;
+          rotation      = r;
+          break;
+        }
+      }
+    }
+
+    nikol::u32 a = tri[rotation];
+    nikol::u32 b = tri[(rotation + 1) % 3];
+    nikol::u32 c = tri[(rotation + 2) % 3];
+
+    if(edge_distance < MESH_CODEC_EDGE_FIFO) {
+      nikol::u8 third = encode_vertex(explicits, fifos, c, CODE_EDGE_EXPLICIT - 1, CODE_EDGE_EXPLICIT);
+      out.push_back((nikol::u8)((edge_distance << 4) | third));
+
+      push_edge(fifos, c, b);
+      push_edge(fifos, a, c);
+    }
+    else {
+      out.push_back(CODE_NO_EDGE);
+
+      for(nikol::u32 j = 0; j < 3; j++) {
+        nikol::sizei explicits_start = explicits.size();
+        out.push_back(encode_vertex(explicits, fifos, tri[j], MESH_CODEC_VERTEX_FIFO, CODE_EXPLICIT));
+
+        // Read back right after its own code
+        out.insert(out.end(), explicits.begin() + explicits_start, explicits.end());
+      }
+      explicits.clear();
+
+      push_edge(fifos, b, a);
+      push_edge(fifos, c, b);
+      push_edge(fifos, a, c);
+    }
+
+    out.insert(out.end(), explicits.begin(), explicits.end());
+  }
+}
+
+bool mesh_codec_decode_indices(void* out, const nikol::u32 count, const nikol::u32 index_size, const nikol::u32 vertices_count, const nikol::u8* in, const nikol::sizei size) {
+  if((count % 3) != 0 || size == 0 || in[0] != INDEX_STREAM_TAG) {
+    return false;
+  }
+
+  if(index_size == 2) {
+    return decode_indices((nikol::u16*)out, count, vertices_count, in + 1, in + size);
+  }
+  else if(index_size == 4) {
+    return decode_indices((nikol::u32*)out, count, vertices_count, in + 1, in + size);
+  }
+
+  return false;
+}
+// Mesh codec functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Vertices encoded together. Every block can be decoded on its own once the previous vertex is known.
+const nikol::u32 MESH_CODEC_VERTEX_BLOCK = 256;
+
+// Recent edges and vertices the index codec can refer to instead of spelling out indices
+const nikol::u32 MESH_CODEC_EDGE_FIFO   = 16;
+const nikol::u32 MESH_CODEC_VERTEX_FIFO = 16;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh codec functions
+//
+// A lossless codec for the vertex and index blobs of mesh files, built to decode far faster than it
+// compresses. Both streams are byte-oriented, so decoding never has to read single bits.
+//
+// Vertices: every 32-bit lane of a vertex is stored as the zigzagged difference from the same lane of the
+// previous vertex. The differences of a block are split into byte planes (every first byte, then every
+// second byte...), and each group of 16 bytes in a plane is stored with 0, 2, 4 or 8 bits per byte.
+//
+// Indices: each triangle is a single code byte most of the time. It names an edge from a FIFO of the
+// edges of recent triangles, and the third vertex as either the next unseen vertex, one from a FIFO of
+// recent vertices, or an explicit (varint) index. Triangles keep their winding, but may come back rotated.
+
+// `stride` has to be a multiple of 4
+void mesh_codec_encode_vertices(std::vector<nikol::u8>& out, const void* vertices, const nikol::u32 count, const nikol::u32 stride);
+
+// Decode `count` vertices straight into `out` (`count * stride` bytes). Returns `false` if `in` is not a valid vertex stream.
+bool mesh_codec_decode_vertices(void* out, const nikol::u32 count, const nikol::u32 stride, const nikol::u8* in, const nikol::sizei size);
+
+// `count` has to be a multiple of 3
+void mesh_codec_encode_indices(std::vector<nikol::u8>& out, const nikol::u32* indices, const nikol::u32 count);
+
+// Decode `count` indices straight into `out` as 2 or 4 byte indices. Returns `false` if `in` is not a valid index 
+// stream, or if any index is not below `vertices_count`.
+bool mesh_codec_decode_indices(void* out, const nikol::u32 count, const nikol::u32 index_size, const nikol::u32 vertices_count, const nikol::u8* in, const nikol::sizei size);
+// Mesh codec functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,389 @@
+#include "mesh_file.h"
+#include "mesh_codec.h"
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+static_assert(sizeof(MeshFileHeader) == 96, "MeshFileHeader must not change size");
+static_assert(sizeof(MeshFileAttribute) == 40, "MeshFileAttribute must not change size");
+static_assert(sizeof(MeshFileSubmesh) == 64, "MeshFileSubmesh must not change size");
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u64 align_offset(const nikol::u64 offset) {
+  return (offset + (MESH_FILE_ALIGNMENT - 1)) & ~(nikol::u64)(MESH_FILE_ALIGNMENT - 1);
+}
+
+static void compute_bounds(const Vertex* vertices, const nikol::sizei count, nikol::f32* min, nikol::f32* max) {
+  glm::vec3 low  = count > 0 ? vertices[0].position : glm::vec3(0.0f);
+  glm::vec3 high = low;
+
+  for(nikol::sizei i = 1; i < count; i++) {
+    low  = glm::min(low, vertices[i].position);
+    high = glm::max(high, vertices[i].position);
+  }
+
+  std::memcpy(min, &low.x, sizeof(nikol::f32) * 3);
+  std::memcpy(max, &high.x, sizeof(nikol::f32) * 3);
+}
+
+static bool is_known_attribute(const char* name) {
+  for(auto& known : MESH_FILE_ATTRIBUTE_NAMES) {
+    if(std::strcmp(known, name) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template<typename T>
+static bool indices_out_of_range(const T* indices, const nikol::u32 count, const nikol::u32 vertices_count) {
+  // No early out, so the loop stays a plain reduction
+  T largest = 0;
+  for(nikol::u32 i = 0; i < count; i++) {
+    largest = indices[i] > largest ? indices[i] : largest;
+  }
+
+  return count > 0 && (nikol::u64)largest >= vertices_count;
+}
+
+static bool validate_file(const MeshFile& file) {
+  const MeshFileHeader* header = (const MeshFileHeader*)file.base;
+  
+  if(file.size < sizeof(MeshFileHeader)) {
+    return false;
+  }
+
+  bool is_compressed = (header->version == MESH_FILE_VERSION_COMPRESSED);
+  if(header->magic != MESH_FILE_MAGIC || (header->version != MESH_FILE_VERSION && !is_compressed) || header->file_size != file.size) {
+    return false;
+  }
+
+  if((header->index_size != 2 && header->index_size != 4) || header->attributes_count > MESH_FILE_MAX_ATTRIBUTES) {
+    return false;
+  }
+
+  // Every section has to be aligned and fit inside the file
+  auto section_fits = [&](const nikol::u64 offset, const nikol::u64 size) {
+    return (offset % MESH_FILE_ALIGNMENT) == 0 && offset <= file.size && size <= (file.size - offset);
+  };
+
+  bool tables_fit = section_fits(header->attributes_offset, (nikol::u64)header->attributes_count * sizeof(MeshFileAttribute)) && 
+                    section_fits(header->submeshes_offset, (nikol::u64)header->submeshes_count * sizeof(MeshFileSubmesh));
+  if(!tables_fit || header->vertex_stride == 0) {
+    return false;
+  }
+
+  const nikol::u8* base = (const nikol::u8*)file.base;
+
+  // Every attribute has to be named (the names get compared as C strings) with a name a layout knows about. 
+  // The layouts have no offsets, so the attributes have to follow each other and fill the whole vertex.
+  const MeshFileAttribute* attributes = (const MeshFileAttribute*)(base + header->attributes_offset);
+  nikol::u64 packed_size              = 0;
+
+  for(nikol::u32 i = 0; i < header->attributes_count; i++) {
+    const MeshFileAttribute& attrib = attributes[i];
+    if(!std::memchr(attrib.name, 0, MESH_FILE_NAME_MAX) || !is_known_attribute(attrib.name) || attrib.type > MESH_ATTRIBUTE_FLOAT4) {
+      return false;
+    }
+
+    if(attrib.offset != packed_size) {
+      return false;
+    }
+
+    packed_size += sizeof(nikol::f32) * ((nikol::u64)attrib.type + 1);
+  }
+
+  if(packed_size != header->vertex_stride) {
+    return false;
+  }
+
+  // Every submesh has to stay inside the indices
+  const MeshFileSubmesh* submeshes = (const MeshFileSubmesh*)(base + header->submeshes_offset);
+  for(nikol::u32 i = 0; i < header->submeshes_count; i++) {
+    const MeshFileSubmesh& sub = submeshes[i];
+    if(!std::memchr(sub.name, 0, MESH_FILE_NAME_MAX) || (nikol::u64)sub.index_offset + sub.indices_count > header->indices_count) {
+      return false;
+    }
+  }
+
+  // The codec checks the streams themselves while decoding. They only have to be in the right order here.
+  if(is_compressed) {
+    return (header->vertex_stride % 4) == 0 && 
+           header->vertices_offset <= header->indices_offset && 
+           section_fits(header->vertices_offset, header->indices_offset - header->vertices_offset) && 
+           section_fits(header->indices_offset, 0);
+  }
+
+  bool blobs_fit = section_fits(header->vertices_offset, (nikol::u64)header->vertices_count * header->vertex_stride) && 
+                   section_fits(header->indices_offset, (nikol::u64)header->indices_count * header->index_size);
+  if(!blobs_fit) {
+    return false;
+  }
+
+  // Every index has to point at a vertex. This is the only pass over a blob before it gets used.
+  const nikol::u8* indices = base + header->indices_offset;
+  if(header->index_size == 2) {
+    return !indices_out_of_range((const nikol::u16*)indices, header->indices_count, header->vertices_count);
+  }
+
+  return !indices_out_of_range((const nikol::u32*)indices, header->indices_count, header->vertices_count);
+}
+
+static bool map_file(MeshFile& file, const char* path) {
+#if defined(_WIN32)
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER size; 
+  GetFileSizeEx(handle, &size);
+
+  HANDLE mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(handle);
+  if(!mapping) {
+    return false;
+  }
+
+  file.base   = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  file.size   = (nikol::sizei)size.QuadPart;
+  file.handle = mapping;
+  
+  if(!file.base) {
+    CloseHandle(mapping);
+    return false;
+  }
+#else
+  int fd = open(path, O_RDONLY);
+  if(fd < 0) {
+    return false;
+  }
+
+  struct stat info; 
+  if(fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  void* base = mmap(nullptr, (nikol::sizei)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(base == MAP_FAILED) {
+    return false;
+  }
+
+  file.base = base; 
+  file.size = (nikol::sizei)info.st_size;
+#endif
+
+  return true;
+}
+
+static void unmap_file(MeshFile& file) {
+#if defined(_WIN32)
+  UnmapViewOfFile(file.base);
+  CloseHandle((HANDLE)file.handle);
+#else
+  munmap(file.base, file.size);
+#endif
+}
+
+static void write_padding(FILE* out, const nikol::u64 offset) {
+  static const nikol::u8 zeros[MESH_FILE_ALIGNMENT] = {};
+  
+  nikol::u64 padding = align_offset(offset) - offset;
+  if(padding > 0) {
+    fwrite(zeros, 1, padding, out);
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshFile functions
+bool mesh_file_open(MeshFile& file, const char* path) {
+  file = MeshFile{};
+
+  if(!map_file(file, path)) {
+    return false;
+  }
+
+  if(!validate_file(file)) {
+    mesh_file_close(file);
+    return false;
+  }
+
+  const nikol::u8* base = (const nikol::u8*)file.base;
+  
+  file.header     = (const MeshFileHeader*)base;
+  file.attributes = (const MeshFileAttribute*)(base + file.header->attributes_offset);
+  file.submeshes  = (const MeshFileSubmesh*)(base + file.header->submeshes_offset);
+  file.vertices   = base + file.header->vertices_offset;
+  file.indices    = base + file.header->indices_offset;
+
+  if(mesh_file_is_compressed(file)) {
+    file.vertices_size = (nikol::sizei)(file.header->indices_offset - file.header->vertices_offset);
+    file.indices_size  = (nikol::sizei)(file.header->file_size - file.header->indices_offset);
+  }
+  else {
+    file.vertices_size = (nikol::sizei)file.header->vertices_count * file.header->vertex_stride;
+    file.indices_size  = (nikol::sizei)file.header->indices_count * file.header->index_size;
+  }
+
+  return true;
+}
+
+void mesh_file_close(MeshFile& file) {
+  if(file.base) {
+    unmap_file(file);
+  }
+
+  file = MeshFile{};
+}
+
+bool mesh_file_is_compressed(const MeshFile& file) {
+  return file.header && file.header->version == MESH_FILE_VERSION_COMPRESSED;
+}
+
+bool mesh_file_decode(const MeshFile& file, void* vertices, void* indices, const nikol::u32 index_size) {
+  NIKOL_ASSERT(mesh_file_is_compressed(file), "Only compressed mesh files have to be decoded");
+
+  const MeshFileHeader* header = file.header;
+
+  // The padding after each stream never gets read
+  return mesh_codec_decode_vertices(vertices, header->vertices_count, header->vertex_stride, (const nikol::u8*)file.vertices, file.vertices_size) && 
+         mesh_codec_decode_indices(indices, header->indices_count, index_size, header->vertices_count, (const nikol::u8*)file.indices, file.indices_size);
+}
+
+bool mesh_file_write(const char* path, 
+                     const std::vector<Vertex>& vertices, 
+                     const std::vector<nikol::u32>& indices, 
+                     const std::vector<MeshFileSubmesh>& submeshes, 
+                     const nikol::u32 index_size, 
+                     const bool compress, 
+                     const std::vector<glm::vec4>& tangents) {
+  NIKOL_ASSERT(index_size == 2 || index_size == 4, "Mesh file indices can only be 2 or 4 bytes");
+  NIKOL_ASSERT(index_size == 4 || vertices.size() <= 0x10000, "Too many vertices for 16-bit indices");
+  NIKOL_ASSERT(tangents.empty() || tangents.size() == vertices.size(), "Every vertex needs a tangent");
+
+  // The layout of `TangentVertex`, which starts out as a `Vertex`
+  MeshFileAttribute attributes[4] = {
+    {"POS",        MESH_ATTRIBUTE_FLOAT3, (nikol::u32)offsetof(TangentVertex, position)}, 
+    {"NORMAL",     MESH_ATTRIBUTE_FLOAT3, (nikol::u32)offsetof(TangentVertex, normal)}, 
+    {"TEXCOORDS0", MESH_ATTRIBUTE_FLOAT2, (nikol::u32)offsetof(TangentVertex, texture_coords)}, 
+    {"TANGENT",    MESH_ATTRIBUTE_FLOAT4, (nikol::u32)offsetof(TangentVertex, tangent)}, 
+  };
+
+  bool has_tangents            = !tangents.empty();
+  nikol::u32 attributes_count  = has_tangents ? 4 : 3;
+  nikol::u32 vertex_stride     = has_tangents ? sizeof(TangentVertex) : sizeof(Vertex);
+  nikol::sizei attributes_size = attributes_count * sizeof(MeshFileAttribute);
+
+  // The tangents get interleaved, so the vertex blob can still go up as is
+  std::vector<TangentVertex> tangent_vertices;
+  const void* vertex_data = vertices.data();
+
+  if(has_tangents) {
+    tangent_vertices.resize(vertices.size());
+
+    for(nikol::sizei i = 0; i < vertices.size(); i++) {
+      tangent_vertices[i] = TangentVertex{vertices[i].position, vertices[i].normal, vertices[i].texture_coords, tangents[i]};
+    }
+
+    vertex_data = tangent_vertices.data();
+  }
+
+  // One submesh for everything if none were given 
+  std::vector<MeshFileSubmesh> subs = submeshes;
+  if(subs.empty()) {
+    MeshFileSubmesh whole = {"default", 0, (nikol::u32)indices.size()};
+    compute_bounds(vertices.data(), vertices.size(), whole.bounds_min, whole.bounds_max);
+    
+    subs.push_back(whole);
+  }
+
+  // The blobs as they go into the file
+  std::vector<nikol::u8> vertex_blob, index_blob;
+
+  if(compress) {
+    mesh_codec_encode_vertices(vertex_blob, vertex_data, (nikol::u32)vertices.size(), vertex_stride);
+    mesh_codec_encode_indices(index_blob, indices.data(), (nikol::u32)indices.size());
+  }
+  else {
+    const nikol::u8* vertex_bytes = (const nikol::u8*)vertex_data;
+    vertex_blob.assign(vertex_bytes, vertex_bytes + vertices.size() * vertex_stride);
+
+    if(index_size == 4) {
+      const nikol::u8* index_bytes = (const nikol::u8*)indices.data();
+      index_blob.assign(index_bytes, index_bytes + indices.size() * sizeof(nikol::u32));
+    }
+    else {
+      std::vector<nikol::u16> narrow(indices.begin(), indices.end());
+      
+      const nikol::u8* index_bytes = (const nikol::u8*)narrow.data();
+      index_blob.assign(index_bytes, index_bytes + narrow.size() * sizeof(nikol::u16));
+    }
+  }
+
+  MeshFileHeader header = {
+    .magic            = MESH_FILE_MAGIC, 
+    .version          = compress ? MESH_FILE_VERSION_COMPRESSED : MESH_FILE_VERSION, 
+    .vertex_stride    = vertex_stride, 
+    .attributes_count = attributes_count, 
+    .index_size       = index_size, 
+    .submeshes_count  = (nikol::u32)subs.size(), 
+    .vertices_count   = (nikol::u32)vertices.size(), 
+    .indices_count    = (nikol::u32)indices.size(),
+  };
+  compute_bounds(vertices.data(), vertices.size(), header.bounds_min, header.bounds_max);
+
+  header.attributes_offset = align_offset(sizeof(MeshFileHeader));
+  header.submeshes_offset  = align_offset(header.attributes_offset + attributes_size);
+  header.vertices_offset   = align_offset(header.submeshes_offset + subs.size() * sizeof(MeshFileSubmesh));
+  header.indices_offset    = align_offset(header.vertices_offset + vertex_blob.size());
+  header.file_size         = align_offset(header.indices_offset + index_blob.size());
+
+  FILE* out = fopen(path, "wb");
+  if(!out) {
+    return false;
+  }
+
+  fwrite(&header, sizeof(header), 1, out);
+  write_padding(out, sizeof(header));
+
+  fwrite(attributes, attributes_size, 1, out);
+  write_padding(out, header.attributes_offset + attributes_size);
+
+  fwrite(subs.data(), sizeof(MeshFileSubmesh), subs.size(), out);
+  write_padding(out, header.submeshes_offset + subs.size() * sizeof(MeshFileSubmesh));
+
+  fwrite(vertex_blob.data(), 1, vertex_blob.size(), out);
+  write_padding(out, header.vertices_offset + vertex_blob.size());
+
+  fwrite(index_blob.data(), 1, index_blob.size(), out);
+  write_padding(out, header.indices_offset + index_blob.size());
+
+  bool success = (ferror(out) == 0);
+  fclose(out);
+
+  return success;
+}
+// MeshFile functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+const nikol::u32 MESH_FILE_MAGIC   = 0x48534d4e; // "NMSH"
+const nikol::u32 MESH_FILE_VERSION = 1;
+
+// Same layout, but the vertex and index blobs went through the mesh codec (see `mesh_codec.h`)
+const nikol::u32 MESH_FILE_VERSION_COMPRESSED = 2;
+
+// Every blob in the file starts at a multiple of this
+const nikol::u32 MESH_FILE_ALIGNMENT = 64;
+
+const nikol::u32 MESH_FILE_MAX_ATTRIBUTES  = 8;
+const nikol::u32 MESH_FILE_NAME_MAX        = 32;
+
+// The attribute names a layout can be built from. Files naming anything else get rejected.
+const char* const MESH_FILE_ATTRIBUTE_NAMES[] = {"POS", "NORMAL", "TEXCOORDS0", "TANGENT", "COLOR"};
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshAttributeType
+enum MeshAttributeType : nikol::u32 {
+  MESH_ATTRIBUTE_FLOAT1 = 0, 
+  MESH_ATTRIBUTE_FLOAT2, 
+  MESH_ATTRIBUTE_FLOAT3, 
+  MESH_ATTRIBUTE_FLOAT4, 
+};
+// MeshAttributeType
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshFileHeader
+// The file is laid out as follows, with every section aligned to `MESH_FILE_ALIGNMENT`:
+//  - MeshFileHeader
+//  - MeshFileAttribute[attributes_count]
+//  - MeshFileSubmesh[submeshes_count]
+//  - Vertex blob (vertices_count * vertex_stride bytes)
+//  - Index blob (indices_count * index_size bytes)
+// Everything is little-endian and can be used in place once the file is mapped. Compressed files
+// (`MESH_FILE_VERSION_COMPRESSED`) store each blob as a codec stream that runs up to the next section 
+// (or the end of the file) instead, which has to be decoded first (see `mesh_file_decode`).
+struct MeshFileHeader {
+  nikol::u32 magic; 
+  nikol::u32 version;
+
+  nikol::u32 vertex_stride;
+  nikol::u32 attributes_count;
+  nikol::u32 index_size;       // 2 or 4 bytes
+  nikol::u32 submeshes_count;
+
+  nikol::u32 vertices_count; 
+  nikol::u32 indices_count;
+
+  nikol::f32 bounds_min[3];
+  nikol::f32 bounds_max[3];
+
+  nikol::u64 attributes_offset;
+  nikol::u64 submeshes_offset;
+  nikol::u64 vertices_offset;
+  nikol::u64 indices_offset;
+  nikol::u64 file_size;
+};
+// MeshFileHeader
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshFileAttribute
+struct MeshFileAttribute {
+  char name[MESH_FILE_NAME_MAX];  // The semantic name handed to the layout ("POS", "NORMAL", ...)
+  MeshAttributeType type;
+  nikol::u32 offset;              // Byte offset within a vertex
+};
+// MeshFileAttribute
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshFileSubmesh
+struct MeshFileSubmesh {
+  char name[MESH_FILE_NAME_MAX];
+
+  nikol::u32 index_offset;  // In indices, not bytes
+  nikol::u32 indices_count;
+
+  nikol::f32 bounds_min[3];
+  nikol::f32 bounds_max[3];
+};
+// MeshFileSubmesh
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshFile
+// A read-only view over a mapped mesh file. All the pointers point straight 
+// into the mapping and are valid until `mesh_file_close`.
+struct MeshFile {
+  const MeshFileHeader* header        = nullptr;
+  const MeshFileAttribute* attributes = nullptr;
+  const MeshFileSubmesh* submeshes    = nullptr;
+  
+  const void* vertices = nullptr; 
+  const void* indices  = nullptr;
+
+  // The bytes of each blob as stored (less than the decoded size if compressed)
+  nikol::sizei vertices_size = 0;
+  nikol::sizei indices_size  = 0;
+
+  // Platform mapping
+  void* base       = nullptr;
+  nikol::sizei size = 0;
+  void* handle     = nullptr;
+};
+// MeshFile
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshFile functions
+
+// Map the file at `path` into memory and validate it. Nothing is parsed or copied, but the tables get checked
+// and the indices of an uncompressed file get read once, so none of them can point past the vertices. 
+// The attributes have to be known (see `MESH_FILE_ATTRIBUTE_NAMES`) and tightly packed in the order they 
+// are listed in, since that is the only way a layout can describe them.
+bool mesh_file_open(MeshFile& file, const char* path);
+void mesh_file_close(MeshFile& file);
+
+bool mesh_file_is_compressed(const MeshFile& file);
+
+// Decode the blobs of a compressed file straight into `vertices` (`vertices_count * vertex_stride` bytes) 
+// and `indices` (`indices_count * index_size` bytes). `index_size` does not have to match the file's, 
+// so 16-bit files can be decoded straight into 32-bit indices. Returns `false` if either blob is broken. 
+bool mesh_file_decode(const MeshFile& file, void* vertices, void* indices, const nikol::u32 index_size);
+
+// Write a mesh in the layout of `Vertex`, or of `TangentVertex` (with a "TANGENT" attribute) if `tangents` 
+// has one for every vertex. An `index_size` of 2 will narrow the indices to 16 bits (every index has to fit). 
+// An empty `submeshes` writes a single submesh covering everything. With `compress`, the blobs are encoded 
+// with the mesh codec. The codec does best on vertices and indices that went through the vertex cache and 
+// vertex fetch passes (see `mesh_optimizer.h`). 
+bool mesh_file_write(const char* path, 
+                     const std::vector<Vertex>& vertices, 
+                     const std::vector<nikol::u32>& indices, 
+                     const std::vector<MeshFileSubmesh>& submeshes, 
+                     const nikol::u32 index_size            = 4, 
+                     const bool compress                    = false, 
+                     const std::vector<glm::vec4>& tangents = {});
+// MeshFile functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,419 @@
+#include "mesh_generator.h"
+#include "mesh.h"
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <vector>
+#include <functional>
+
+// ----------------------------------------------------------------------------
+// ShapeWriter
+struct ShapeWriter {
+  Vertex* vertices    = nullptr; 
+  nikol::u32* indices = nullptr;
+
+  nikol::u32 vertex_offset = 0; 
+  nikol::u32 index_offset  = 0;
+};
+// ShapeWriter
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u32 icosphere_frequency(const ShapeDesc& desc) {
+  return 1u << desc.subdivisions;
+}
+
+static void write_vertex(ShapeWriter& writer, const glm::vec3& pos, const glm::vec3& normal, const glm::vec2& uv) {
+  writer.vertices[writer.vertex_offset++] = Vertex{pos, normal, uv};
+}
+
+static void write_triangle(ShapeWriter& writer, const nikol::u32 a, const nikol::u32 b, const nikol::u32 c) {
+  writer.indices[writer.index_offset++] = a;
+  writer.indices[writer.index_offset++] = b;
+  writer.indices[writer.index_offset++] = c;
+}
+
+// Triangulate a `(rows + 1) x (columns + 1)` grid of vertices starting at `base`. 
+// Columns go counter-clockwise around the Y-axis and rows go from top to bottom.
+static void write_grid_indices(ShapeWriter& writer, const nikol::u32 base, const nikol::u32 columns, const nikol::u32 rows) {
+  for(nikol::u32 row = 0; row < rows; row++) {
+    for(nikol::u32 col = 0; col < columns; col++) {
+      nikol::u32 top    = base + row * (columns + 1) + col;
+      nikol::u32 bottom = top + columns + 1;
+
+      write_triangle(writer, top, top + 1, bottom);
+      write_triangle(writer, top + 1, bottom + 1, bottom);
+    }
+  }
+}
+
+// A flat disk facing up (or down) at `y`
+static void write_cap(ShapeWriter& writer, const nikol::u32 segments, const float radius, const float y, const bool facing_up) {
+  glm::vec3 normal = glm::vec3(0.0f, facing_up ? 1.0f : -1.0f, 0.0f);
+  nikol::u32 center = writer.vertex_offset;
+
+  write_vertex(writer, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f));
+  
+  for(nikol::u32 seg = 0; seg <= segments; seg++) {
+    float phi = glm::two_pi<float>() * ((float)seg / segments);
+    float x   = glm::cos(phi);
+    float z   = glm::sin(phi);
+
+    write_vertex(writer, glm::vec3(x * radius, y, z * radius), normal, glm::vec2(x, z) * 0.5f + 0.5f);
+  }
+
+  for(nikol::u32 seg = 0; seg < segments; seg++) {
+    nikol::u32 rim = center + 1 + seg;
+
+    if(facing_up) {
+      write_triangle(writer, center, rim + 1, rim);
+    }
+    else {
+      write_triangle(writer, center, rim, rim + 1);
+    }
+  }
+}
+
+static void generate_uv_sphere(const ShapeDesc& desc, ShapeWriter& writer) {
+  nikol::u32 base = writer.vertex_offset;
+
+  for(nikol::u32 ring = 0; ring <= desc.rings; ring++) {
+    float v     = (float)ring / desc.rings;
+    float theta = glm::pi<float>() * v;
+
+    for(nikol::u32 seg = 0; seg <= desc.segments; seg++) {
+      float u   = (float)seg / desc.segments;
+      float phi = glm::two_pi<float>() * u;
+
+      glm::vec3 normal = glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+      write_vertex(writer, normal * desc.radius, normal, glm::vec2(u, 1.0f - v));
+    }
+  }
+
+  write_grid_indices(writer, base, desc.segments, desc.rings);
+}
+
+static void generate_icosphere(const ShapeDesc& desc, ShapeWriter& writer) {
+  const float t = (1.0f + glm::sqrt(5.0f)) * 0.5f;
+
+  const glm::vec3 corners[12] = {
+    glm::vec3(-1.0f,  t, 0.0f), glm::vec3(1.0f,  t, 0.0f), glm::vec3(-1.0f, -t, 0.0f), glm::vec3(1.0f, -t, 0.0f),
+    glm::vec3(0.0f, -1.0f,  t), glm::vec3(0.0f, 1.0f,  t), glm::vec3(0.0f, -1.0f, -t), glm::vec3(0.0f, 1.0f, -t),
+    glm::vec3( t, 0.0f, -1.0f), glm::vec3( t, 0.0f, 1.0f), glm::vec3(-t, 0.0f, -1.0f), glm::vec3(-t, 0.0f, 1.0f),
+  };
+
+  const nikol::u32 faces[20][3] = {
+    {0, 11, 5}, {0, 5, 1},  {0, 1, 7},   {0, 7, 10}, {0, 10, 11},
+    {1, 5, 9},  {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+    {3, 9, 4},  {3, 4, 2},  {3, 2, 6},   {3, 6, 8},  {3, 8, 9},
+    {4, 9, 5},  {2, 4, 11}, {6, 2, 10},  {8, 6, 7},  {9, 8, 1},
+  };
+
+  // Every face gets subdivided into its own triangular grid. The edges are not 
+  // shared between faces, which is what keeps the counts closed-form.
+  nikol::u32 freq = icosphere_frequency(desc);
+
+  for(auto& face : faces) {
+    glm::vec3 a = corners[face[0]];
+    glm::vec3 b = corners[face[1]];
+    glm::vec3 c = corners[face[2]];
+    
+    nikol::u32 base = writer.vertex_offset;
+
+    // Row `i` holds `i + 1` points, going from A (row 0) to the BC edge (row `freq`)
+    for(nikol::u32 i = 0; i <= freq; i++) {
+      for(nikol::u32 j = 0; j <= i; j++) {
+        glm::vec3 normal = glm::normalize(a + (b - a) * ((float)i / freq) + (c - b) * ((float)j / freq));
+        glm::vec2 uv     = glm::vec2(glm::atan(normal.z, normal.x) / glm::two_pi<float>() + 0.5f, 
+                                     1.0f - glm::acos(glm::clamp(normal.y, -1.0f, 1.0f)) / glm::pi<float>());
+
+        write_vertex(writer, normal * desc.radius, normal, uv);
+      }
+    }
+
+    auto point = [base](const nikol::u32 i, const nikol::u32 j) {
+      return base + (i * (i + 1)) / 2 + j;
+    };
+
+    for(nikol::u32 i = 0; i < freq; i++) {
+      for(nikol::u32 j = 0; j <= i; j++) {
+        write_triangle(writer, point(i, j), point(i + 1, j), point(i + 1, j + 1));
+
+        if(j < i) {
+          write_triangle(writer, point(i, j), point(i + 1, j + 1), point(i, j + 1));
+        }
+      }
+    }
+  }
+}
+
+static void generate_plane(const ShapeDesc& desc, ShapeWriter& writer) {
+  nikol::u32 base = writer.vertex_offset;
+  float half      = desc.size * 0.5f;
+
+  // Rows go from +Z to -Z so the grid indices face up
+  for(nikol::u32 row = 0; row <= desc.rings; row++) {
+    float v = (float)row / desc.rings;
+
+    for(nikol::u32 col = 0; col <= desc.segments; col++) {
+      float u = (float)col / desc.segments;
+
+      write_vertex(writer, glm::vec3(-half + u * desc.size, 0.0f, half - v * desc.size), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(u, v));
+    }
+  }
+
+  write_grid_indices(writer, base, desc.segments, desc.rings);
+}
+
+// The side of a cylinder or a cone, from `top_radius` at the top to `bottom_radius` at the bottom
+static void generate_tube_side(const ShapeDesc& desc, ShapeWriter& writer, const float top_radius, const float bottom_radius) {
+  nikol::u32 base = writer.vertex_offset;
+  float half      = desc.height * 0.5f;
+  
+  // The slope of the side pushes the normals up (or down)
+  float slope = (bottom_radius - top_radius) / desc.height;
+
+  for(nikol::u32 ring = 0; ring <= desc.rings; ring++) {
+    float v      = (float)ring / desc.rings;
+    float radius = glm::mix(top_radius, bottom_radius, v);
+    float y      = half - v * desc.height;
+
+    for(nikol::u32 seg = 0; seg <= desc.segments; seg++) {
+      float u   = (float)seg / desc.segments;
+      float phi = glm::two_pi<float>() * u;
+      float x   = glm::cos(phi);
+      float z   = glm::sin(phi);
+
+      glm::vec3 normal = glm::normalize(glm::vec3(x, slope, z));
+      write_vertex(writer, glm::vec3(x * radius, y, z * radius), normal, glm::vec2(u, 1.0f - v));
+    }
+  }
+
+  write_grid_indices(writer, base, desc.segments, desc.rings);
+}
+
+static void generate_cylinder(const ShapeDesc& desc, ShapeWriter& writer) {
+  generate_tube_side(desc, writer, desc.radius, desc.radius);
+
+  write_cap(writer, desc.segments, desc.radius, desc.height * 0.5f, true);
+  write_cap(writer, desc.segments, desc.radius, -desc.height * 0.5f, false);
+}
+
+static void generate_cone(const ShapeDesc& desc, ShapeWriter& writer) {
+  // The apex ring collapses into a single point, but keeps its own normals per segment 
+  generate_tube_side(desc, writer, 0.0f, desc.radius);
+  
+  write_cap(writer, desc.segments, desc.radius, -desc.height * 0.5f, false);
+}
+
+static void generate_torus(const ShapeDesc& desc, ShapeWriter& writer) {
+  nikol::u32 base = writer.vertex_offset;
+
+  // Rings go around the tube, starting from the outer edge and heading down first
+  for(nikol::u32 ring = 0; ring <= desc.rings; ring++) {
+    float v     = (float)ring / desc.rings;
+    float theta = glm::two_pi<float>() * v;
+
+    for(nikol::u32 seg = 0; seg <= desc.segments; seg++) {
+      float u   = (float)seg / desc.segments;
+      float phi = glm::two_pi<float>() * u;
+
+      glm::vec3 normal = glm::vec3(glm::cos(theta) * glm::cos(phi), -glm::sin(theta), glm::cos(theta) * glm::sin(phi));
+      glm::vec3 center = glm::vec3(glm::cos(phi), 0.0f, glm::sin(phi)) * desc.radius;
+
+      write_vertex(writer, center + normal * desc.tube_radius, normal, glm::vec2(u, v));
+    }
+  }
+
+  write_grid_indices(writer, base, desc.segments, desc.rings);
+}
+
+static void generate_capsule(const ShapeDesc& desc, ShapeWriter& writer) {
+  nikol::u32 base = writer.vertex_offset;
+  
+  float half         = desc.height * 0.5f;
+  float total_height = desc.height + desc.radius * 2.0f;
+
+  // Two hemispheres of `rings + 1` rows each. The band between the 
+  // two equators is the cylinder in the middle.
+  for(nikol::u32 half_index = 0; half_index < 2; half_index++) {
+    float offset = half_index == 0 ? half : -half;
+
+    for(nikol::u32 ring = 0; ring <= desc.rings; ring++) {
+      float theta = glm::half_pi<float>() * ((float)(ring + half_index * desc.rings) / desc.rings);
+
+      for(nikol::u32 seg = 0; seg <= desc.segments; seg++) {
+        float u   = (float)seg / desc.segments;
+        float phi = glm::two_pi<float>() * u;
+
+        glm::vec3 normal = glm::vec3(glm::sin(theta) * glm::cos(phi), glm::cos(theta), glm::sin(theta) * glm::sin(phi));
+        glm::vec3 pos    = normal * desc.radius + glm::vec3(0.0f, offset, 0.0f);
+
+        write_vertex(writer, pos, normal, glm::vec2(u, (pos.y + total_height * 0.5f) / total_height));
+      }
+    }
+  }
+
+  write_grid_indices(writer, base, desc.segments, desc.rings * 2 + 1);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshCache
+nikol::sizei ShapeDescHash::operator()(const ShapeDesc& desc) const {
+  nikol::sizei hash = std::hash<nikol::u32>{}((nikol::u32)desc.type);
+  
+  auto combine = [&hash](const nikol::sizei value) {
+    hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  };
+
+  combine(std::hash<nikol::u32>{}(desc.segments));
+  combine(std::hash<nikol::u32>{}(desc.rings));
+  combine(std::hash<nikol::u32>{}(desc.subdivisions));
+  combine(std::hash<nikol::f32>{}(desc.radius));
+  combine(std::hash<nikol::f32>{}(desc.tube_radius));
+  combine(std::hash<nikol::f32>{}(desc.height));
+  combine(std::hash<nikol::f32>{}(desc.size));
+
+  return hash;
+}
+
+bool ShapeDescEqual::operator()(const ShapeDesc& a, const ShapeDesc& b) const {
+  return a.type == b.type                 && 
+         a.segments == b.segments         && 
+         a.rings == b.rings               && 
+         a.subdivisions == b.subdivisions && 
+         a.radius == b.radius             && 
+         a.tube_radius == b.tube_radius   && 
+         a.height == b.height             && 
+         a.size == b.size;
+}
+// MeshCache
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Shape functions
+void shape_get_counts(const ShapeDesc& desc, nikol::u32* vertices_count, nikol::u32* indices_count) {
+  nikol::u32 segs  = desc.segments; 
+  nikol::u32 rings = desc.rings;
+  
+  nikol::u32 grid_vertices = (segs + 1) * (rings + 1);
+  nikol::u32 grid_indices  = segs * rings * 6;
+  
+  nikol::u32 cap_vertices = segs + 2; 
+  nikol::u32 cap_indices  = segs * 3;
+
+  switch(desc.type) {
+    case SHAPE_UV_SPHERE:
+    case SHAPE_PLANE:
+    case SHAPE_TORUS:
+      *vertices_count = grid_vertices; 
+      *indices_count  = grid_indices;
+      break;
+    case SHAPE_ICOSPHERE: {
+      nikol::u32 freq = icosphere_frequency(desc);
+     
+      *vertices_count = 20 * ((freq + 1) * (freq + 2)) / 2;
+      *indices_count  = 20 * freq * freq * 3;
+    } break;
+    case SHAPE_CYLINDER:
+      *vertices_count = grid_vertices + cap_vertices * 2; 
+      *indices_count  = grid_indices + cap_indices * 2;
+      break;
+    case SHAPE_CONE:
+      *vertices_count = grid_vertices + cap_vertices; 
+      *indices_count  = grid_indices + cap_indices;
+      break;
+    case SHAPE_CAPSULE:
+      *vertices_count = (segs + 1) * (rings + 1) * 2; 
+      *indices_count  = segs * (rings * 2 + 1) * 6;
+      break;
+  }
+}
+
+void shape_generate(const ShapeDesc& desc, Vertex* vertices, nikol::u32* indices) {
+  ShapeWriter writer = {
+    .vertices = vertices, 
+    .indices  = indices,
+  };
+
+  switch(desc.type) {
+    case SHAPE_UV_SPHERE:
+      generate_uv_sphere(desc, writer);
+      break;
+    case SHAPE_ICOSPHERE:
+      generate_icosphere(desc, writer);
+      break;
+    case SHAPE_PLANE:
+      generate_plane(desc, writer);
+      break;
+    case SHAPE_CYLINDER:
+      generate_cylinder(desc, writer);
+      break;
+    case SHAPE_CONE:
+      generate_cone(desc, writer);
+      break;
+    case SHAPE_TORUS:
+      generate_torus(desc, writer);
+      break;
+    case SHAPE_CAPSULE:
+      generate_capsule(desc, writer);
+      break;
+  }
+
+  nikol::u32 vertices_count, indices_count;
+  shape_get_counts(desc, &vertices_count, &indices_count);
+  
+  NIKOL_ASSERT(writer.vertex_offset == vertices_count && writer.index_offset == indices_count, "Shape counts went out of sync with its generator");
+}
+
+void shape_generate(const ShapeDesc& desc, std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices) {
+  nikol::u32 vertices_count, indices_count;
+  shape_get_counts(desc, &vertices_count, &indices_count);
+  
+  // One allocation each. The generators write straight into the memory.
+  vertices.resize(vertices_count);
+  indices.resize(indices_count);
+
+  shape_generate(desc, vertices.data(), indices.data());
+}
+// Shape functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshCache functions
+void mesh_cache_init(MeshCache& cache, nikol::GfxContext* gfx) {
+  cache.gfx = gfx;
+  cache.meshes.clear();
+}
+
+void mesh_cache_clear(MeshCache& cache) {
+  for(auto& [desc, mesh] : cache.meshes) {
+    mesh_destroy(mesh);
+  }
+
+  cache.meshes.clear();
+}
+
+Mesh* mesh_cache_get(MeshCache& cache, const ShapeDesc& desc) {
+  auto it = cache.meshes.find(desc);
+  if(it != cache.meshes.end()) {
+    return it->second;
+  }
+
+  std::vector<Vertex> vertices; 
+  std::vector<nikol::u32> indices;
+  shape_generate(desc, vertices, indices);
+
+  Mesh* mesh = mesh_create(cache.gfx, vertices, indices);
+  cache.meshes[desc] = mesh;
+
+  return mesh;
+}
+// MeshCache functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "vertex.h"
+#include "mesh.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <unordered_map>
+
+// ----------------------------------------------------------------------------
+// ShapeType
+enum ShapeType {
+  SHAPE_UV_SPHERE = 0, 
+  SHAPE_ICOSPHERE, 
+  SHAPE_PLANE, 
+  SHAPE_CYLINDER, 
+  SHAPE_CONE, 
+  SHAPE_TORUS, 
+  SHAPE_CAPSULE,
+};
+// ShapeType
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ShapeDesc
+// Not every field is used by every shape: 
+//  - `segments`:     Slices around the Y-axis (or along X for the plane).
+//  - `rings`:        Stacks along the Y-axis (or along Z for the plane, or around the tube for the torus).
+//  - `subdivisions`: Icosphere only. Every level splits each triangle into 4.
+//  - `radius`:       Sphere/cylinder/cone/capsule radius or the distance to the tube center for the torus.
+//  - `tube_radius`:  Torus only.
+//  - `height`:       Cylinder/cone height or the length of the capsule's middle section.
+//  - `size`:         Plane only. The length of each side.
+struct ShapeDesc {
+  ShapeType type; 
+
+  nikol::u32 segments     = 32; 
+  nikol::u32 rings        = 16;
+  nikol::u32 subdivisions = 3;
+
+  nikol::f32 radius      = 0.5f;
+  nikol::f32 tube_radius = 0.2f;
+  nikol::f32 height      = 1.0f;
+  nikol::f32 size        = 1.0f;
+};
+// ShapeDesc
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshCache
+struct ShapeDescHash {
+  nikol::sizei operator()(const ShapeDesc& desc) const;
+};
+
+struct ShapeDescEqual {
+  bool operator()(const ShapeDesc& a, const ShapeDesc& b) const;
+};
+
+struct MeshCache {
+  nikol::GfxContext* gfx = nullptr;
+  std::unordered_map<ShapeDesc, Mesh*, ShapeDescHash, ShapeDescEqual> meshes;
+};
+// MeshCache
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Shape functions
+
+// The exact number of vertices and indices `shape_generate` will write for `desc`
+void shape_get_counts(const ShapeDesc& desc, nikol::u32* vertices_count, nikol::u32* indices_count);
+
+// Write the shape into `vertices` and `indices`, which have to be big enough 
+// to hold the counts given by `shape_get_counts`.
+void shape_generate(const ShapeDesc& desc, Vertex* vertices, nikol::u32* indices);
+void shape_generate(const ShapeDesc& desc, std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices);
+// Shape functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshCache functions
+void mesh_cache_init(MeshCache& cache, nikol::GfxContext* gfx);
+
+// Destroys every cached mesh
+void mesh_cache_clear(MeshCache& cache);
+
+// Returns the existing mesh for `desc` if there is one. Otherwise, generate it, upload it, and cache it.
+Mesh* mesh_cache_get(MeshCache& cache, const ShapeDesc& desc);
+// MeshCache functions
+// ----------------------------------------------------------------------------
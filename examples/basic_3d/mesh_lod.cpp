@@ -0,0 +1,419 @@
+#include "mesh_lod.h"
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Globals
+// A LOD that keeps more than this much of the previous one ends the chain
+const nikol::f32 LOD_MIN_REDUCTION = 0.9f;
+
+// Collapses that rotate a neighbouring triangle's normal past this (cosine) are rejected
+const nikol::f32 COLLAPSE_MAX_NORMAL_COS = 0.25f;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Quadric
+// A symmetric 4x4 matrix (the sum of every plane's outer product), stored as its upper triangle
+struct Quadric {
+  nikol::f32 a2 = 0.0f, ab = 0.0f, ac = 0.0f, ad = 0.0f;
+  nikol::f32 b2 = 0.0f, bc = 0.0f, bd = 0.0f;
+  nikol::f32 c2 = 0.0f, cd = 0.0f;
+  nikol::f32 d2 = 0.0f;
+};
+// Quadric
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Collapse
+struct Collapse {
+  nikol::u32 from, to;
+  nikol::f32 cost;
+};
+// Collapse
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void quadric_add_plane(Quadric& q, const glm::vec3& normal, const nikol::f32 dist) {
+  q.a2 += normal.x * normal.x;
+  q.ab += normal.x * normal.y;
+  q.ac += normal.x * normal.z;
+  q.ad += normal.x * dist;
+
+  q.b2 += normal.y * normal.y;
+  q.bc += normal.y * normal.z;
+  q.bd += normal.y * dist;
+
+  q.c2 += normal.z * normal.z;
+  q.cd += normal.z * dist;
+
+  q.d2 += dist * dist;
+}
+
+static void quadric_add(Quadric& q, const Quadric& other) {
+  q.a2 += other.a2; q.ab += other.ab; q.ac += other.ac; q.ad += other.ad;
+  q.b2 += other.b2; q.bc += other.bc; q.bd += other.bd;
+  q.c2 += other.c2; q.cd += other.cd;
+  q.d2 += other.d2;
+}
+
+// The sum of squared distances from `p` to every plane in the quadric
+static nikol::f32 quadric_eval(const Quadric& q, const glm::vec3& p) {
+  nikol::f32 result = (q.a2 * p.x * p.x) + (2.0f * q.ab * p.x * p.y) + (2.0f * q.ac * p.x * p.z) + (2.0f * q.ad * p.x) +
+                      (q.b2 * p.y * p.y) + (2.0f * q.bc * p.y * p.z) + (2.0f * q.bd * p.y) +
+                      (q.c2 * p.z * p.z) + (2.0f * q.cd * p.z) +
+                      q.d2;
+
+  // Float round-off can dip slightly below zero
+  return std::max(result, 0.0f);
+}
+
+static nikol::u64 edge_key(const nikol::u32 from, const nikol::u32 to) {
+  return ((nikol::u64)from << 32) | to;
+}
+
+// Any edge without a twin going the other way lies on a border (or a UV/normal seam,
+// since those vertices were never welded). Moving them would tear the mesh open.
+static void find_locked_vertices(const nikol::u32* indices, const nikol::sizei indices_count, std::vector<bool>& locked) {
+  std::unordered_set<nikol::u64> edges;
+  edges.reserve(indices_count);
+
+  for(nikol::sizei i = 0; i < indices_count; i += 3) {
+    for(nikol::u32 e = 0; e < 3; e++) {
+      edges.insert(edge_key(indices[i + e], indices[i + (e + 1) % 3]));
+    }
+  }
+
+  for(nikol::sizei i = 0; i < indices_count; i += 3) {
+    for(nikol::u32 e = 0; e < 3; e++) {
+      nikol::u32 from = indices[i + e];
+      nikol::u32 to   = indices[i + (e + 1) % 3];
+
+      if(edges.find(edge_key(to, from)) == edges.end()) {
+        locked[from] = true;
+        locked[to]   = true;
+      }
+    }
+  }
+}
+
+static void build_adjacency(const nikol::u32* indices,
+                            const nikol::sizei indices_count,
+                            const nikol::sizei vertices_count,
+                            std::vector<nikol::u32>& offsets,
+                            std::vector<nikol::u32>& triangles) {
+  offsets.assign(vertices_count + 1, 0);
+  triangles.resize(indices_count);
+
+  for(nikol::sizei i = 0; i < indices_count; i++) {
+    offsets[indices[i] + 1]++;
+  }
+  for(nikol::sizei i = 0; i < vertices_count; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  std::vector<nikol::u32> cursor(offsets.begin(), offsets.end() - 1);
+  for(nikol::sizei i = 0; i < indices_count; i++) {
+    triangles[cursor[indices[i]]++] = (nikol::u32)(i / 3);
+  }
+}
+
+// Would moving `from` onto `to` flip (or badly twist) any of the triangles that survive the collapse?
+static bool collapse_flips(const Collapse& collapse,
+                           const nikol::u32* indices,
+                           const Vertex* vertices,
+                           const std::vector<nikol::u32>& offsets,
+                           const std::vector<nikol::u32>& triangles) {
+  for(nikol::u32 i = offsets[collapse.from]; i < offsets[collapse.from + 1]; i++) {
+    const nikol::u32* tri = &indices[triangles[i] * 3];
+
+    // This one degenerates and goes away anyway
+    if(tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+      continue;
+    }
+
+    glm::vec3 p0 = vertices[tri[0]].position;
+    glm::vec3 p1 = vertices[tri[1]].position;
+    glm::vec3 p2 = vertices[tri[2]].position;
+    glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+
+    glm::vec3 moved[3] = {p0, p1, p2};
+    for(nikol::u32 j = 0; j < 3; j++) {
+      if(tri[j] == collapse.from) {
+        moved[j] = vertices[collapse.to].position;
+      }
+    }
+    glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+    nikol::f32 len = glm::length(before) * glm::length(after);
+    if(len == 0.0f || glm::dot(before, after) < (COLLAPSE_MAX_NORMAL_COS * len)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Around the center of the bounding box, like the bounds of a `Mesh`
+static nikol::f32 bounding_radius(const std::vector<Vertex>& vertices) {
+  glm::vec3 min = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+  glm::vec3 max = min;
+
+  for(auto& vert : vertices) {
+    min = glm::min(min, vert.position);
+    max = glm::max(max, vert.position);
+  }
+
+  glm::vec3 center  = (min + max) * 0.5f;
+  nikol::f32 radius = 0.0f;
+
+  for(auto& vert : vertices) {
+    radius = glm::max(radius, glm::length(vert.position - center));
+  }
+
+  return radius;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh LOD functions
+nikol::sizei mesh_simplify(nikol::u32* dest,
+                           const nikol::u32* indices,
+                           const nikol::sizei indices_count,
+                           const Vertex* vertices,
+                           const nikol::sizei vertices_count,
+                           const nikol::sizei target_indices_count,
+                           nikol::f32* out_error) {
+  if(dest != indices) {
+    std::copy(indices, indices + indices_count, dest);
+  }
+
+  std::vector<bool> locked(vertices_count, false);
+  find_locked_vertices(dest, indices_count, locked);
+
+  // Every vertex starts with the planes of the triangles around it
+  std::vector<Quadric> quadrics(vertices_count);
+  for(nikol::sizei i = 0; i < indices_count; i += 3) {
+    glm::vec3 p0 = vertices[dest[i + 0]].position;
+    glm::vec3 p1 = vertices[dest[i + 1]].position;
+    glm::vec3 p2 = vertices[dest[i + 2]].position;
+
+    glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+    nikol::f32 len   = glm::length(normal);
+    if(len == 0.0f) {
+      continue;
+    }
+
+    normal /= len;
+    nikol::f32 dist = -glm::dot(normal, p0);
+
+    for(nikol::u32 j = 0; j < 3; j++) {
+      quadric_add_plane(quadrics[dest[i + j]], normal, dist);
+    }
+  }
+
+  std::vector<nikol::u32> remap(vertices_count);
+  std::vector<bool> touched(vertices_count);
+  std::vector<nikol::u32> offsets, triangles;
+  std::vector<Collapse> collapses;
+
+  nikol::sizei count   = indices_count;
+  nikol::f32 max_error = 0.0f;
+
+  // Every pass collapses a batch of the cheapest independent edges and then rebuilds the triangles
+  while(count > target_indices_count) {
+    build_adjacency(dest, count, vertices_count, offsets, triangles);
+    collapses.clear();
+
+    // Every interior edge shows up twice (once per side), so only take it from one side
+    for(nikol::sizei i = 0; i < count; i += 3) {
+      for(nikol::u32 e = 0; e < 3; e++) {
+        nikol::u32 a = dest[i + e];
+        nikol::u32 b = dest[i + (e + 1) % 3];
+        if(a > b || (locked[a] && locked[b])) {
+          continue;
+        }
+
+        Quadric q = quadrics[a];
+        quadric_add(q, quadrics[b]);
+
+        // Half-edge collapses only: the vertex moves onto its neighbour, so no new vertices are ever made
+        nikol::f32 cost_ab = locked[a] ? INFINITY : quadric_eval(q, vertices[b].position);
+        nikol::f32 cost_ba = locked[b] ? INFINITY : quadric_eval(q, vertices[a].position);
+
+        if(cost_ab <= cost_ba) {
+          collapses.push_back(Collapse{a, b, cost_ab});
+        }
+        else {
+          collapses.push_back(Collapse{b, a, cost_ba});
+        }
+      }
+    }
+
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) {
+      return lhs.cost < rhs.cost;
+    });
+
+    // Each collapse removes (about) two triangles
+    nikol::sizei needed  = ((count - target_indices_count) / 6) + 1;
+    nikol::sizei applied = 0;
+
+    for(nikol::sizei i = 0; i < vertices_count; i++) {
+      remap[i] = (nikol::u32)i;
+    }
+    std::fill(touched.begin(), touched.end(), false);
+
+    for(auto& collapse : collapses) {
+      if(applied >= needed) {
+        break;
+      }
+
+      // Collapses in the same pass must not share any triangle, or the flip test above goes stale
+      if(touched[collapse.from] || touched[collapse.to]) {
+        continue;
+      }
+      if(collapse_flips(collapse, dest, vertices, offsets, triangles)) {
+        continue;
+      }
+
+      remap[collapse.from] = collapse.to;
+      quadric_add(quadrics[collapse.to], quadrics[collapse.from]);
+      max_error = std::max(max_error, collapse.cost);
+
+      for(nikol::u32 i = offsets[collapse.from]; i < offsets[collapse.from + 1]; i++) {
+        const nikol::u32* tri = &dest[triangles[i] * 3];
+
+        touched[tri[0]] = true;
+        touched[tri[1]] = true;
+        touched[tri[2]] = true;
+      }
+
+      applied++;
+    }
+
+    // Nothing left that can go without breaking the mesh
+    if(applied == 0) {
+      break;
+    }
+
+    // Remap and drop the triangles that degenerated
+    nikol::sizei write = 0;
+    for(nikol::sizei i = 0; i < count; i += 3) {
+      nikol::u32 a = remap[dest[i + 0]];
+      nikol::u32 b = remap[dest[i + 1]];
+      nikol::u32 c = remap[dest[i + 2]];
+
+      if(a == b || b == c || a == c) {
+        continue;
+      }
+
+      dest[write++] = a;
+      dest[write++] = b;
+      dest[write++] = c;
+    }
+
+    count = write;
+  }
+
+  if(out_error) {
+    *out_error = std::sqrt(max_error);
+  }
+
+  return count;
+}
+
+nikol::u32 mesh_generate_lods(std::vector<nikol::u32>& indices, const std::vector<Vertex>& vertices, MeshLod* lods) {
+  nikol::u32 base_count = (nikol::u32)indices.size();
+
+  lods[0] = MeshLod{
+    .index_offset  = 0,
+    .indices_count = base_count,
+    .error         = 0.0f,
+  };
+  nikol::u32 lods_count = 1;
+
+  if(base_count / 3 >= MESH_LOD_MIN_TRIANGLES) {
+    // Each LOD starts from the previous one, which is both faster and keeps the chain consistent
+    std::vector<nikol::u32> scratch;
+
+    for(nikol::u32 i = 1; i < MESH_LODS_MAX; i++) {
+      const MeshLod& prev = lods[i - 1];
+      nikol::sizei target = ((nikol::sizei)(base_count * MESH_LOD_RATIOS[i]) / 3) * 3;
+
+      scratch.resize(prev.indices_count);
+
+      nikol::f32 error   = 0.0f;
+      nikol::sizei count = mesh_simplify(scratch.data(),
+                                         indices.data() + prev.index_offset, prev.indices_count,
+                                         vertices.data(), vertices.size(),
+                                         target, &error);
+
+      if(count > (prev.indices_count * LOD_MIN_REDUCTION)) {
+        break;
+      }
+
+      lods[i] = MeshLod{
+        .index_offset  = (nikol::u32)indices.size(),
+        .indices_count = (nikol::u32)count,
+        .error         = std::max(prev.error, error),
+      };
+      indices.insert(indices.end(), scratch.begin(), scratch.begin() + count);
+
+      lods_count++;
+    }
+  }
+
+  // The screen size is the radius in NDC units (half the viewport's height), so the next LOD's error covers
+  // `error / radius * screen_size * height / 2` pixels. Its threshold is wherever that reaches the pixels allowed. 
+  // An exact LOD (no error at all) always takes over, and the last LOD takes over from there on.
+  nikol::f32 radius  = bounding_radius(vertices);
+  nikol::f32 max_ndc = (MESH_LOD_ERROR_PIXELS * 2.0f) / MESH_LOD_REFERENCE_HEIGHT;
+
+  for(nikol::u32 i = 0; i < lods_count; i++) {
+    nikol::u32 next = i + 1;
+    if(next >= lods_count) {
+      lods[i].min_screen_size = 0.0f;
+    }
+    else if(lods[next].error > 0.0f) {
+      lods[i].min_screen_size = (max_ndc * radius) / lods[next].error;
+    }
+    else {
+      lods[i].min_screen_size = std::numeric_limits<nikol::f32>::max();
+    }
+  }
+
+  return lods_count;
+}
+
+nikol::f32 mesh_lod_screen_size(const glm::vec3& center, const nikol::f32 radius, const glm::vec3& eye, const nikol::f32 proj_scale) {
+  nikol::f32 dist = glm::length(center - eye);
+
+  // Inside the bounds
+  if(dist <= radius) {
+    return INFINITY;
+  }
+
+  return (radius * proj_scale) / dist;
+}
+
+nikol::u32 mesh_lod_select(const MeshLod* lods, const nikol::u32 lods_count, const nikol::f32 screen_size) {
+  for(nikol::u32 i = 0; i < lods_count; i++) {
+    if(screen_size >= lods[i].min_screen_size) {
+      return i;
+    }
+  }
+
+  return lods_count - 1;
+}
+// Mesh LOD functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+const nikol::u32 MESH_LODS_MAX = 4;
+
+// The triangle ratio (relative to LOD 0) each LOD is simplified towards
+const nikol::f32 MESH_LOD_RATIOS[MESH_LODS_MAX] = {1.0f, 0.5f, 0.25f, 0.125f};
+
+// Meshes with fewer triangles than this are not worth a LOD chain
+const nikol::u32 MESH_LOD_MIN_TRIANGLES = 256;
+
+// How far (in pixels) a LOD's surface may stray from the original's before a more detailed LOD has to
+// take over, on a viewport `MESH_LOD_REFERENCE_HEIGHT` pixels high
+const nikol::f32 MESH_LOD_ERROR_PIXELS     = 1.0f;
+const nikol::f32 MESH_LOD_REFERENCE_HEIGHT = 1080.0f;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshLod
+struct MeshLod {
+  nikol::u32 index_offset  = 0; // Into the combined index array of every LOD
+  nikol::u32 indices_count = 0;
+
+  nikol::f32 error = 0.0f; // Largest quadric error (in object space units) accumulated so far
+
+  // The LOD is used while the mesh covers at least this much of the screen (see `mesh_lod_screen_size`).
+  // Below it, the next LOD's error projects to less than `MESH_LOD_ERROR_PIXELS`.
+  nikol::f32 min_screen_size = 0.0f;
+};
+// MeshLod
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh LOD functions
+
+// Simplify the triangles towards `target_indices_count` with quadric error metric edge collapses.
+// Vertices only ever collapse onto other existing vertices, so the result can share the
+// original vertex buffer. Border (and seam) vertices are never moved.
+// Returns the new index count. `dest` may alias `indices`. The resulting error goes into `out_error`.
+nikol::sizei mesh_simplify(nikol::u32* dest,
+                           const nikol::u32* indices,
+                           const nikol::sizei indices_count,
+                           const Vertex* vertices,
+                           const nikol::sizei vertices_count,
+                           const nikol::sizei target_indices_count,
+                           nikol::f32* out_error = nullptr);
+
+// Append a simplified copy of `indices` for every ratio in `MESH_LOD_RATIOS` (LOD 0 being `indices` as is).
+// The chain stops early once a LOD fails to shrink much. Each LOD switches to the next one once the next one's 
+// error gets smaller than `MESH_LOD_ERROR_PIXELS` on screen, relative to the bounding sphere around the center 
+// of the vertices' bounding box (the one `render_mesh` measures the screen size with). 
+// Returns the number of LODs written into `lods`.
+nikol::u32 mesh_generate_lods(std::vector<nikol::u32>& indices, const std::vector<Vertex>& vertices, MeshLod* lods);
+
+// The projected radius of the bounding sphere in NDC units (1.0 covers half of the screen's height).
+// `proj_scale` is the projection's `[1][1]` entry.
+nikol::f32 mesh_lod_screen_size(const glm::vec3& center, const nikol::f32 radius, const glm::vec3& eye, const nikol::f32 proj_scale);
+
+// The most detailed LOD whose `min_screen_size` is met at `screen_size`
+nikol::u32 mesh_lod_select(const MeshLod* lods, const nikol::u32 lods_count, const nikol::f32 screen_size);
+// Mesh LOD functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,436 @@
+#include "mesh_normals.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <vector>
+#include <atomic>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define NORMALS_SIMD_SSE
+#endif
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Triangles accumulated by one job
+const nikol::u32 TRIANGLES_BATCH_SIZE = 16384;
+
+// Groups of 4 vertices summed and normalized by one job
+const nikol::u32 GROUPS_BATCH_SIZE = 4096;
+
+// The widest range of vertices a batch gets summed locally in. The batches of a mesh in vertex 
+// fetch order (or any grid) use far fewer. Wider ones add straight into the shared sums instead.
+const nikol::u32 RANGE_VERTICES_MAX = 65536;
+
+const nikol::u32 NORMAL_COMPONENTS  = 3; // x, y, z
+const nikol::u32 TANGENT_COMPONENTS = 6; // The tangent's x, y, z then the bitangent's
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// VertexSums
+// The SoA sums of every vertex, padded to a multiple of 4 vertices for the SIMD passes, and one 
+// scratch range per job system thread. A batch sums into its thread's range (from the lowest to the highest
+// vertex it uses) and adds that into the shared arrays with atomics once done, so the memory only grows 
+// by a fixed amount per thread instead of a copy of every array.
+struct VertexSums {
+  nikol::u32 components;
+  nikol::u32 padded_count;
+
+  std::vector<nikol::f32> shared;
+  std::vector<nikol::f32> ranges; // `components` arrays of `RANGE_VERTICES_MAX` per thread
+};
+// VertexSums
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// BatchSums
+// Where one batch of triangles sums into: its thread's range (starting at vertex `first`) or, if
+// the batch spans too many vertices, the shared arrays themselves.
+struct BatchSums {
+  nikol::f32* arrays[TANGENT_COMPONENTS];
+  nikol::u32 first;
+  nikol::u32 count;
+  bool is_shared;
+};
+// BatchSums
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void vertex_sums_init(VertexSums& sums, const nikol::u32 components, const nikol::u32 vertices_count) {
+  sums.components   = components;
+  sums.padded_count = (vertices_count + 3) & ~3u;
+
+  sums.shared.assign((nikol::sizei)components * sums.padded_count, 0.0f);
+  sums.ranges.resize((nikol::sizei)job_system_get_threads_count() * components * RANGE_VERTICES_MAX);
+}
+
+static const nikol::f32* vertex_sums_get(const VertexSums& sums, const nikol::u32 component) {
+  return &sums.shared[(nikol::sizei)component * sums.padded_count];
+}
+
+static BatchSums batch_sums_begin(VertexSums& sums, const nikol::u32* indices, const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+  nikol::u32 low  = 0xffffffff;
+  nikol::u32 high = 0;
+
+  for(nikol::u32 i = start * 3; i < end * 3; i++) {
+    low  = glm::min(low, indices[i]);
+    high = glm::max(high, indices[i]);
+  }
+
+  BatchSums batch;
+  batch.first     = low;
+  batch.count     = (low <= high) ? (high - low + 1) : 0;
+  batch.is_shared = batch.count > RANGE_VERTICES_MAX;
+
+  for(nikol::u32 i = 0; i < sums.components; i++) {
+    if(batch.is_shared) {
+      batch.arrays[i] = &sums.shared[(nikol::sizei)i * sums.padded_count];
+      continue;
+    }
+
+    batch.arrays[i] = &sums.ranges[((nikol::sizei)thread_index * sums.components + i) * RANGE_VERTICES_MAX];
+    std::memset(batch.arrays[i], 0, batch.count * sizeof(nikol::f32));
+  }
+
+  if(batch.is_shared) {
+    batch.first = 0;
+  }
+
+  return batch;
+}
+
+static void batch_sums_add(BatchSums& batch, const nikol::u32 component, const nikol::u32 index, const nikol::f32 value) {
+  nikol::f32& sum = batch.arrays[component][index - batch.first];
+
+  if(batch.is_shared) {
+    std::atomic_ref<nikol::f32>(sum).fetch_add(value, std::memory_order_relaxed);
+  }
+  else {
+    sum += value;
+  }
+}
+
+static void batch_sums_end(VertexSums& sums, const BatchSums& batch) {
+  if(batch.is_shared) {
+    return;
+  }
+
+  // Only the borders are ever shared with other batches, but any of them could be
+  for(nikol::u32 i = 0; i < sums.components; i++) {
+    nikol::f32* shared = &sums.shared[(nikol::sizei)i * sums.padded_count + batch.first];
+
+    for(nikol::u32 j = 0; j < batch.count; j++) {
+      if(batch.arrays[i][j] != 0.0f) {
+        std::atomic_ref<nikol::f32>(shared[j]).fetch_add(batch.arrays[i][j], std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+// The angles of a triangle at each of its corners
+static glm::vec3 corner_angles(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+  glm::vec3 e01 = p1 - p0;
+  glm::vec3 e02 = p2 - p0;
+  glm::vec3 e12 = p2 - p1;
+
+  nikol::f32 a0 = std::acos(glm::clamp(glm::dot(e01, e02) / std::sqrt(glm::dot(e01, e01) * glm::dot(e02, e02)), -1.0f, 1.0f));
+  nikol::f32 a1 = std::acos(glm::clamp(glm::dot(-e01, e12) / std::sqrt(glm::dot(e01, e01) * glm::dot(e12, e12)), -1.0f, 1.0f));
+
+  return glm::vec3(a0, a1, glm::pi<nikol::f32>() - a0 - a1);
+}
+
+static void accumulate_normals(BatchSums& batch,
+                               const Vertex* vertices,
+                               const nikol::u32* indices,
+                               const nikol::u32 start,
+                               const nikol::u32 end,
+                               const NormalWeighting weighting) {
+  for(nikol::u32 i = start; i < end; i++) {
+    const nikol::u32* tri = &indices[i * 3];
+
+    glm::vec3 p0 = vertices[tri[0]].position;
+    glm::vec3 p1 = vertices[tri[1]].position;
+    glm::vec3 p2 = vertices[tri[2]].position;
+
+    // Twice the area long, which is exactly the weight the area weighting wants
+    glm::vec3 face     = glm::cross(p1 - p0, p2 - p0);
+    glm::vec3 weights  = glm::vec3(1.0f);
+    nikol::f32 length2 = glm::dot(face, face);
+
+    if(length2 == 0.0f) {
+      continue;
+    }
+
+    if(weighting == NORMAL_WEIGHT_ANGLE) {
+      face   /= std::sqrt(length2);
+      weights = corner_angles(p0, p1, p2);
+    }
+
+    for(int corner = 0; corner < 3; corner++) {
+      nikol::u32 index = tri[corner];
+
+      batch_sums_add(batch, 0, index, face.x * weights[corner]);
+      batch_sums_add(batch, 1, index, face.y * weights[corner]);
+      batch_sums_add(batch, 2, index, face.z * weights[corner]);
+    }
+  }
+}
+
+static void accumulate_tangents(BatchSums& batch,
+                                const Vertex* vertices,
+                                const nikol::u32* indices,
+                                const nikol::u32 start,
+                                const nikol::u32 end) {
+  for(nikol::u32 i = start; i < end; i++) {
+    const nikol::u32* tri = &indices[i * 3];
+    const Vertex& v0      = vertices[tri[0]];
+    const Vertex& v1      = vertices[tri[1]];
+    const Vertex& v2      = vertices[tri[2]];
+
+    glm::vec3 e01 = v1.position - v0.position;
+    glm::vec3 e02 = v2.position - v0.position;
+    glm::vec2 uv1 = v1.texture_coords - v0.texture_coords;
+    glm::vec2 uv2 = v2.texture_coords - v0.texture_coords;
+
+    // No UV mapping to follow (or no area to begin with)
+    glm::vec3 face = glm::cross(e01, e02);
+    nikol::f32 det = uv1.x * uv2.y - uv2.x * uv1.y;
+    if(std::abs(det) < 1e-20f || glm::dot(face, face) == 0.0f) {
+      continue;
+    }
+
+    glm::vec3 sdir    = (e01 * uv2.y - e02 * uv1.y) / det;
+    glm::vec3 tdir    = (e02 * uv1.x - e01 * uv2.x) / det;
+    glm::vec3 weights = corner_angles(v0.position, v1.position, v2.position);
+
+    for(int corner = 0; corner < 3; corner++) {
+      nikol::u32 index = tri[corner];
+      glm::vec3 normal = vertices[index].normal;
+
+      // Both projected onto the plane of the corner's normal, then normalized, as MikkTSpace does
+      glm::vec3 tangent   = sdir - normal * glm::dot(normal, sdir);
+      glm::vec3 bitangent = tdir - normal * glm::dot(normal, tdir);
+
+      nikol::f32 tangent_len   = glm::length(tangent);
+      nikol::f32 bitangent_len = glm::length(bitangent);
+
+      if(tangent_len > 0.0f) {
+        tangent *= weights[corner] / tangent_len;
+      }
+      if(bitangent_len > 0.0f) {
+        bitangent *= weights[corner] / bitangent_len;
+      }
+
+      batch_sums_add(batch, 0, index, tangent.x);
+      batch_sums_add(batch, 1, index, tangent.y);
+      batch_sums_add(batch, 2, index, tangent.z);
+      batch_sums_add(batch, 3, index, bitangent.x);
+      batch_sums_add(batch, 4, index, bitangent.y);
+      batch_sums_add(batch, 5, index, bitangent.z);
+    }
+  }
+}
+
+// Any unit vector perpendicular to `normal`, for the vertices without a usable UV mapping
+static glm::vec3 any_perpendicular(const glm::vec3& normal) {
+  glm::vec3 axis = (std::abs(normal.x) < 0.9f) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+  return glm::normalize(axis - normal * glm::dot(normal, axis));
+}
+
+#if defined(NORMALS_SIMD_SSE)
+
+static void resolve_normals(const VertexSums& sums, Vertex* vertices, const nikol::u32 count, const nikol::u32 group) {
+  nikol::u32 first = group * 4;
+
+  __m128 x = _mm_loadu_ps(vertex_sums_get(sums, 0) + first);
+  __m128 y = _mm_loadu_ps(vertex_sums_get(sums, 1) + first);
+  __m128 z = _mm_loadu_ps(vertex_sums_get(sums, 2) + first);
+
+  __m128 length2 = _mm_add_ps(_mm_mul_ps(x, x), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+  __m128 is_set  = _mm_cmpgt_ps(length2, _mm_setzero_ps());
+  __m128 one     = _mm_set1_ps(1.0f);
+
+  // The zero lengths divide into garbage, which the mask throws away
+  __m128 inv_length = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(length2, _mm_set1_ps(1e-30f))));
+
+  x = _mm_and_ps(is_set, _mm_mul_ps(x, inv_length));
+  y = _mm_or_ps(_mm_and_ps(is_set, _mm_mul_ps(y, inv_length)), _mm_andnot_ps(is_set, one));
+  z = _mm_and_ps(is_set, _mm_mul_ps(z, inv_length));
+
+  alignas(16) nikol::f32 out_x[4], out_y[4], out_z[4];
+  _mm_store_ps(out_x, x);
+  _mm_store_ps(out_y, y);
+  _mm_store_ps(out_z, z);
+
+  for(nikol::u32 i = 0; i < 4 && first + i < count; i++) {
+    vertices[first + i].normal = glm::vec3(out_x[i], out_y[i], out_z[i]);
+  }
+}
+
+static void resolve_tangents(const VertexSums& sums, const Vertex* vertices, glm::vec4* tangents, const nikol::u32 count, const nikol::u32 group) {
+  nikol::u32 first = group * 4;
+
+  // The normals into SoA first
+  alignas(16) nikol::f32 normal_x[4] = {}, normal_y[4] = {}, normal_z[4] = {};
+  for(nikol::u32 i = 0; i < 4 && first + i < count; i++) {
+    normal_x[i] = vertices[first + i].normal.x;
+    normal_y[i] = vertices[first + i].normal.y;
+    normal_z[i] = vertices[first + i].normal.z;
+  }
+
+  __m128 nx = _mm_load_ps(normal_x);
+  __m128 ny = _mm_load_ps(normal_y);
+  __m128 nz = _mm_load_ps(normal_z);
+
+  __m128 tx = _mm_loadu_ps(vertex_sums_get(sums, 0) + first);
+  __m128 ty = _mm_loadu_ps(vertex_sums_get(sums, 1) + first);
+  __m128 tz = _mm_loadu_ps(vertex_sums_get(sums, 2) + first);
+  __m128 bx = _mm_loadu_ps(vertex_sums_get(sums, 3) + first);
+  __m128 by = _mm_loadu_ps(vertex_sums_get(sums, 4) + first);
+  __m128 bz = _mm_loadu_ps(vertex_sums_get(sums, 5) + first);
+
+  // Gram-Schmidt against the normal, then normalized
+  __m128 n_dot_t = _mm_add_ps(_mm_mul_ps(nx, tx), _mm_add_ps(_mm_mul_ps(ny, ty), _mm_mul_ps(nz, tz)));
+  tx             = _mm_sub_ps(tx, _mm_mul_ps(nx, n_dot_t));
+  ty             = _mm_sub_ps(ty, _mm_mul_ps(ny, n_dot_t));
+  tz             = _mm_sub_ps(tz, _mm_mul_ps(nz, n_dot_t));
+
+  __m128 length2    = _mm_add_ps(_mm_mul_ps(tx, tx), _mm_add_ps(_mm_mul_ps(ty, ty), _mm_mul_ps(tz, tz)));
+  __m128 inv_length = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(length2, _mm_set1_ps(1e-30f))));
+  tx                = _mm_mul_ps(tx, inv_length);
+  ty                = _mm_mul_ps(ty, inv_length);
+  tz                = _mm_mul_ps(tz, inv_length);
+
+  // The handedness: does `cross(n, t)` point along the accumulated bitangent?
+  __m128 cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+  __m128 cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+  __m128 cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+
+  __m128 c_dot_b = _mm_add_ps(_mm_mul_ps(cx, bx), _mm_add_ps(_mm_mul_ps(cy, by), _mm_mul_ps(cz, bz)));
+  __m128 w       = _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(_mm_cmplt_ps(c_dot_b, _mm_setzero_ps()), _mm_set1_ps(-0.0f)));
+
+  alignas(16) nikol::f32 out_x[4], out_y[4], out_z[4], out_w[4], out_length2[4];
+  _mm_store_ps(out_x, tx);
+  _mm_store_ps(out_y, ty);
+  _mm_store_ps(out_z, tz);
+  _mm_store_ps(out_w, w);
+  _mm_store_ps(out_length2, length2);
+
+  for(nikol::u32 i = 0; i < 4 && first + i < count; i++) {
+    if(out_length2[i] > 1e-20f) {
+      tangents[first + i] = glm::vec4(out_x[i], out_y[i], out_z[i], out_w[i]);
+    }
+    else {
+      tangents[first + i] = glm::vec4(any_perpendicular(vertices[first + i].normal), 1.0f);
+    }
+  }
+}
+
+#else
+
+static nikol::f32 sum_at(const VertexSums& sums, const nikol::u32 component, const nikol::u32 index) {
+  return vertex_sums_get(sums, component)[index];
+}
+
+static void resolve_normals(const VertexSums& sums, Vertex* vertices, const nikol::u32 count, const nikol::u32 group) {
+  for(nikol::u32 i = group * 4; i < group * 4 + 4 && i < count; i++) {
+    glm::vec3 normal   = glm::vec3(sum_at(sums, 0, i), sum_at(sums, 1, i), sum_at(sums, 2, i));
+    nikol::f32 length2 = glm::dot(normal, normal);
+
+    vertices[i].normal = (length2 > 0.0f) ? normal / std::sqrt(length2) : glm::vec3(0.0f, 1.0f, 0.0f);
+  }
+}
+
+static void resolve_tangents(const VertexSums& sums, const Vertex* vertices, glm::vec4* tangents, const nikol::u32 count, const nikol::u32 group) {
+  for(nikol::u32 i = group * 4; i < group * 4 + 4 && i < count; i++) {
+    glm::vec3 normal    = vertices[i].normal;
+    glm::vec3 tangent   = glm::vec3(sum_at(sums, 0, i), sum_at(sums, 1, i), sum_at(sums, 2, i));
+    glm::vec3 bitangent = glm::vec3(sum_at(sums, 3, i), sum_at(sums, 4, i), sum_at(sums, 5, i));
+
+    tangent            = tangent - normal * glm::dot(normal, tangent);
+    nikol::f32 length2 = glm::dot(tangent, tangent);
+
+    if(length2 <= 1e-20f) {
+      tangents[i] = glm::vec4(any_perpendicular(normal), 1.0f);
+      continue;
+    }
+
+    tangent     = tangent / std::sqrt(length2);
+    tangents[i] = glm::vec4(tangent, (glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f) ? -1.0f : 1.0f);
+  }
+}
+
+#endif
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh normals functions
+void mesh_compute_normals(std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, const NormalWeighting weighting) {
+  nikol::u32 vertices_count  = (nikol::u32)vertices.size();
+  nikol::u32 triangles_count = (nikol::u32)(indices.size() / 3);
+
+  VertexSums sums;
+  vertex_sums_init(sums, NORMAL_COMPONENTS, vertices_count);
+
+  job_system_parallel_for(triangles_count, TRIANGLES_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    // The jobs can get more than a batch (all of it, without any workers), which would not fit a range
+    for(nikol::u32 first = start; first < end; first += TRIANGLES_BATCH_SIZE) {
+      nikol::u32 last = glm::min(first + TRIANGLES_BATCH_SIZE, end);
+
+      BatchSums batch = batch_sums_begin(sums, indices.data(), first, last, thread_index);
+      accumulate_normals(batch, vertices.data(), indices.data(), first, last, weighting);
+      batch_sums_end(sums, batch);
+    }
+  });
+
+  job_system_parallel_for(sums.padded_count / 4, GROUPS_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 group = start; group < end; group++) {
+      resolve_normals(sums, vertices.data(), vertices_count, group);
+    }
+  });
+}
+
+void mesh_compute_tangents(const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, std::vector<glm::vec4>& tangents) {
+  nikol::u32 vertices_count  = (nikol::u32)vertices.size();
+  nikol::u32 triangles_count = (nikol::u32)(indices.size() / 3);
+
+  tangents.resize(vertices_count);
+
+  VertexSums sums;
+  vertex_sums_init(sums, TANGENT_COMPONENTS, vertices_count);
+
+  job_system_parallel_for(triangles_count, TRIANGLES_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    // The jobs can get more than a batch (all of it, without any workers), which would not fit a range
+    for(nikol::u32 first = start; first < end; first += TRIANGLES_BATCH_SIZE) {
+      nikol::u32 last = glm::min(first + TRIANGLES_BATCH_SIZE, end);
+
+      BatchSums batch = batch_sums_begin(sums, indices.data(), first, last, thread_index);
+      accumulate_tangents(batch, vertices.data(), indices.data(), first, last);
+      batch_sums_end(sums, batch);
+    }
+  });
+
+  job_system_parallel_for(sums.padded_count / 4, GROUPS_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 group = start; group < end; group++) {
+      resolve_tangents(sums, vertices.data(), tangents.data(), vertices_count, group);
+    }
+  });
+}
+
+nikol::sizei mesh_tangents_scratch_size(const nikol::u32 vertices_count) {
+  nikol::sizei padded_count = (vertices_count + 3) & ~3u;
+  nikol::sizei ranges_count = (nikol::sizei)job_system_get_threads_count() * RANGE_VERTICES_MAX;
+
+  return (padded_count + ranges_count) * TANGENT_COMPONENTS * sizeof(nikol::f32);
+}
+// Mesh normals functions
+// ----------------------------------------------------------------------------
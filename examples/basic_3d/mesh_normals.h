@@ -0,0 +1,40 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// NormalWeighting
+// How much each triangle adds to the normals of its corners
+enum NormalWeighting {
+  NORMAL_WEIGHT_AREA = 0, // Bigger triangles count more (smooth normals)
+  NORMAL_WEIGHT_ANGLE,    // By the angle at the corner, so how a surface is triangulated barely matters
+};
+// NormalWeighting
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh normals functions
+//
+// Both run over the triangles on the job system. Every batch sums into a bounded range of its thread's
+// scratch, which gets added into one shared array per component (with atomics). The shared arrays are 
+// then normalized (with SIMD) in a second pass over the vertices.
+
+// Overwrite the normal of every vertex. Vertices no triangle uses (or only degenerate ones) get +Y.
+void mesh_compute_normals(std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, const NormalWeighting weighting = NORMAL_WEIGHT_ANGLE);
+
+// Tangent frames the way MikkTSpace builds them: per corner tangents projected onto the normal's plane and
+// weighted by the corner's angle, with the bitangent's sign in `w` (`bitangent = cross(normal, tangent) * w`).
+// The normals have to be there already. Vertices are never split, so seams and mirrored UVs should already
+// be separate vertices (which they are for anything coming out of the importer).
+void mesh_compute_tangents(const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, std::vector<glm::vec4>& tangents);
+
+// The bytes of scratch `mesh_compute_tangents` takes for `vertices_count` vertices (the most of the two), 
+// with as many threads as the job system has now
+nikol::sizei mesh_tangents_scratch_size(const nikol::u32 vertices_count);
+// Mesh normals functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,491 @@
+#include "mesh_optimizer.h"
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Globals
+// Forsyth's tuning values
+const nikol::u32 FORSYTH_CACHE_SIZE        = 32;
+const nikol::f32 FORSYTH_LAST_TRI_SCORE    = 0.75f;
+const nikol::f32 FORSYTH_CACHE_DECAY_POWER = 1.5f;
+const nikol::f32 FORSYTH_VALENCE_SCALE     = 2.0f;
+const nikol::f32 FORSYTH_VALENCE_POWER     = -0.5f;
+
+// Clusters smaller than this (in triangles) are never split off
+const nikol::u32 OVERDRAW_MIN_CLUSTER = 32;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ForsythVertex
+struct ForsythVertex {
+  nikol::u32 tris_offset = 0;  // Into the adjacency array
+  nikol::u32 live_tris   = 0;  // Triangles using this vertex that are not emitted yet
+  nikol::i32 cache_pos   = -1;
+  nikol::f32 score       = 0.0f;
+};
+// ForsythVertex
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Cluster
+struct Cluster {
+  nikol::u32 start, count; // In triangles
+  nikol::f32 sort_key;
+};
+// Cluster
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::f32 forsyth_vertex_score(const ForsythVertex& vert) {
+  // Nothing left to draw with it
+  if(vert.live_tris == 0) {
+    return -1.0f;
+  }
+
+  nikol::f32 score = 0.0f;
+  
+  if(vert.cache_pos >= 0) {
+    // The last triangle's vertices get a fixed score so the next triangle doesn't just reuse them all
+    if(vert.cache_pos < 3) {
+      score = FORSYTH_LAST_TRI_SCORE;
+    }
+    else {
+      nikol::f32 scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+      score = std::pow(1.0f - (vert.cache_pos - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+    }
+  }
+
+  // Low valence vertices get a boost, so lone triangles don't get left behind
+  score += FORSYTH_VALENCE_SCALE * std::pow((nikol::f32)vert.live_tris, FORSYTH_VALENCE_POWER);
+  return score;
+}
+
+// A fresh FIFO simulation for every call, which is how a cluster looks after any other cluster ran
+static nikol::u32 simulate_fifo(const nikol::u32* indices, 
+                                const nikol::sizei indices_count, 
+                                std::vector<nikol::u32>& timestamps, 
+                                nikol::u32& time, 
+                                const nikol::u32 cache_size) {
+  nikol::u32 misses = 0;
+
+  for(nikol::sizei i = 0; i < indices_count; i++) {
+    nikol::u32 index = indices[i];
+
+    // A vertex is in the FIFO if fewer than `cache_size` misses happened since it got in
+    if(time - timestamps[index] >= cache_size) {
+      timestamps[index] = time++;
+      misses++;
+    }
+  }
+
+  return misses;
+}
+
+static void reset_cache(nikol::u32& time, const nikol::u32 cache_size) {
+  // Makes every vertex look like it fell out of the cache a long time ago
+  time += cache_size + 1;
+}
+
+static void compute_cluster_key(Cluster& cluster, const nikol::u32* indices, const Vertex* vertices, const glm::vec3& mesh_center) {
+  glm::vec3 centroid = glm::vec3(0.0f); 
+  glm::vec3 normal   = glm::vec3(0.0f);
+  nikol::f32 area    = 0.0f;
+
+  for(nikol::u32 tri = cluster.start; tri < cluster.start + cluster.count; tri++) {
+    const glm::vec3& a = vertices[indices[tri * 3 + 0]].position;
+    const glm::vec3& b = vertices[indices[tri * 3 + 1]].position;
+    const glm::vec3& c = vertices[indices[tri * 3 + 2]].position;
+
+    glm::vec3 cross    = glm::cross(b - a, c - a);
+    nikol::f32 tri_area = glm::length(cross);
+
+    // Area-weighted, so slivers don't skew the result
+    centroid += (a + b + c) * (tri_area / 3.0f);
+    normal   += cross;
+    area     += tri_area;
+  }
+
+  if(area > 0.0f) {
+    centroid /= area;
+  }
+
+  nikol::f32 normal_len = glm::length(normal);
+  if(normal_len > 0.0f) {
+    normal /= normal_len;
+  }
+
+  // The more a cluster faces away from the center, the more likely it is to occlude others
+  cluster.sort_key = glm::dot(centroid - mesh_center, normal);
+}
+
+// Rasterize the front faces into `depth`, looking down `axis` from its positive (`sign` of 1) or negative side
+static void rasterize_view(const nikol::u32* indices, 
+                           const nikol::sizei indices_count, 
+                           const Vertex* vertices, 
+                           const glm::vec3& min, 
+                           const nikol::f32 scale, 
+                           const int axis, 
+                           const nikol::f32 sign, 
+                           std::vector<nikol::f32>& depth, 
+                           OverdrawStats& stats) {
+  int u = (axis + 1) % 3;
+  int v = (axis + 2) % 3;
+
+  std::fill(depth.begin(), depth.end(), INFINITY);
+
+  for(nikol::sizei i = 0; i < indices_count; i += 3) {
+    glm::vec3 p[3] = {
+      vertices[indices[i + 0]].position, 
+      vertices[indices[i + 1]].position, 
+      vertices[indices[i + 2]].position,
+    };
+
+    // Facing away from the eye
+    glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+    if(normal[axis] * sign <= 0.0f) {
+      continue;
+    }
+
+    // Into pixels, with the depth growing away from the eye
+    glm::vec3 pixel[3];
+    for(int j = 0; j < 3; j++) {
+      pixel[j] = glm::vec3((p[j][u] - min[u]) * scale, (p[j][v] - min[v]) * scale, -p[j][axis] * sign);
+    }
+
+    // Looking from the negative side mirrors the winding
+    nikol::f32 area = (pixel[1].x - pixel[0].x) * (pixel[2].y - pixel[0].y) - (pixel[2].x - pixel[0].x) * (pixel[1].y - pixel[0].y);
+    if(area < 0.0f) {
+      std::swap(pixel[1], pixel[2]);
+      area = -area;
+    }
+
+    int min_x = glm::max((int)std::floor(glm::min(pixel[0].x, glm::min(pixel[1].x, pixel[2].x))), 0);
+    int min_y = glm::max((int)std::floor(glm::min(pixel[0].y, glm::min(pixel[1].y, pixel[2].y))), 0);
+    int max_x = glm::min((int)std::ceil(glm::max(pixel[0].x, glm::max(pixel[1].x, pixel[2].x))), (int)OVERDRAW_SIM_SIZE - 1);
+    int max_y = glm::min((int)std::ceil(glm::max(pixel[0].y, glm::max(pixel[1].y, pixel[2].y))), (int)OVERDRAW_SIM_SIZE - 1);
+
+    for(int y = min_y; y <= max_y; y++) {
+      for(int x = min_x; x <= max_x; x++) {
+        nikol::f32 px = x + 0.5f; 
+        nikol::f32 py = y + 0.5f;
+
+        // Edge functions, each weighing the vertex across from its edge
+        nikol::f32 w0 = (pixel[2].x - pixel[1].x) * (py - pixel[1].y) - (pixel[2].y - pixel[1].y) * (px - pixel[1].x);
+        nikol::f32 w1 = (pixel[0].x - pixel[2].x) * (py - pixel[2].y) - (pixel[0].y - pixel[2].y) * (px - pixel[2].x);
+        nikol::f32 w2 = (pixel[1].x - pixel[0].x) * (py - pixel[0].y) - (pixel[1].y - pixel[0].y) * (px - pixel[0].x);
+        if(w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+          continue;
+        }
+
+        nikol::f32 z       = (pixel[0].z * w0 + pixel[1].z * w1 + pixel[2].z * w2) / area;
+        nikol::f32& stored = depth[y * OVERDRAW_SIM_SIZE + x];
+
+        if(z < stored) {
+          stored = z;
+          stats.pixels_shaded++;
+        }
+      }
+    }
+  }
+
+  for(auto z : depth) {
+    stats.pixels_covered += (z != INFINITY);
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh optimizer functions
+VertexCacheStats mesh_analyze_vertex_cache(const nikol::u32* indices, 
+                                           const nikol::sizei indices_count, 
+                                           const nikol::sizei vertices_count, 
+                                           const nikol::u32 cache_size) {
+  VertexCacheStats stats;
+  if(indices_count == 0 || vertices_count == 0) {
+    return stats;
+  }
+  
+  std::vector<nikol::u32> timestamps(vertices_count, 0);
+  nikol::u32 time = cache_size + 1;
+
+  stats.vertices_transformed = simulate_fifo(indices, indices_count, timestamps, time, cache_size);
+  stats.acmr                 = (nikol::f32)stats.vertices_transformed / (indices_count / 3);
+  stats.atvr                 = (nikol::f32)stats.vertices_transformed / vertices_count;
+
+  return stats;
+}
+
+OverdrawStats mesh_analyze_overdraw(const nikol::u32* indices, 
+                                    const nikol::sizei indices_count, 
+                                    const Vertex* vertices, 
+                                    const nikol::sizei vertices_count) {
+  OverdrawStats stats;
+  if(indices_count == 0 || vertices_count == 0) {
+    return stats;
+  }
+
+  glm::vec3 min = vertices[0].position; 
+  glm::vec3 max = min;
+  for(nikol::sizei i = 1; i < vertices_count; i++) {
+    min = glm::min(min, vertices[i].position);
+    max = glm::max(max, vertices[i].position);
+  }
+
+  // The same scale on every axis, so the pixels stay square whichever side is looked at
+  glm::vec3 extent = max - min;
+  nikol::f32 scale = (OVERDRAW_SIM_SIZE - 1) / glm::max(glm::max(extent.x, extent.y), glm::max(extent.z, 1e-6f));
+
+  std::vector<nikol::f32> depth(OVERDRAW_SIM_SIZE * OVERDRAW_SIM_SIZE);
+  for(int axis = 0; axis < 3; axis++) {
+    rasterize_view(indices, indices_count, vertices, min, scale, axis, 1.0f, depth, stats);
+    rasterize_view(indices, indices_count, vertices, min, scale, axis, -1.0f, depth, stats);
+  }
+
+  stats.overdraw = stats.pixels_covered > 0 ? (nikol::f32)stats.pixels_shaded / stats.pixels_covered : 0.0f;
+  return stats;
+}
+
+void mesh_optimize_vertex_cache(nikol::u32* dest, const nikol::u32* indices, const nikol::sizei indices_count, const nikol::sizei vertices_count) {
+  nikol::sizei tris_count = indices_count / 3;
+  
+  std::vector<ForsythVertex> verts(vertices_count);
+  std::vector<nikol::u32> adjacency(indices_count);
+  std::vector<bool> emitted(tris_count, false);
+
+  // Build the vertex -> triangles adjacency
+  for(nikol::sizei i = 0; i < indices_count; i++) {
+    verts[indices[i]].live_tris++;
+  }
+  
+  nikol::u32 offset = 0;
+  for(auto& vert : verts) {
+    vert.tris_offset = offset; 
+    offset          += vert.live_tris; 
+    vert.live_tris   = 0;
+  }
+  
+  for(nikol::sizei i = 0; i < indices_count; i++) {
+    ForsythVertex& vert = verts[indices[i]];
+    adjacency[vert.tris_offset + vert.live_tris++] = (nikol::u32)(i / 3);
+  }
+
+  // Initial scores
+  for(auto& vert : verts) {
+    vert.score = forsyth_vertex_score(vert);
+  }
+  
+  nikol::u32 cache[FORSYTH_CACHE_SIZE + 3];
+  nikol::u32 new_cache[FORSYTH_CACHE_SIZE + 3];
+  nikol::u32 cache_count = 0;
+  
+  nikol::i64 best_tri = -1;
+  nikol::sizei cursor = 0;
+
+  for(nikol::sizei out_tri = 0; out_tri < tris_count; out_tri++) {
+    // Nothing good in the cache. Take the next triangle that hasn't been drawn yet.
+    if(best_tri < 0) {
+      while(emitted[cursor]) {
+        cursor++;
+      }
+
+      best_tri = (nikol::i64)cursor;
+    }
+
+    // Emit the triangle
+    const nikol::u32* tri_verts = &indices[best_tri * 3];
+    dest[out_tri * 3 + 0]       = tri_verts[0];
+    dest[out_tri * 3 + 1]       = tri_verts[1];
+    dest[out_tri * 3 + 2]       = tri_verts[2];
+    emitted[best_tri]           = true;
+
+    // Take the triangle out of its vertices' adjacency lists 
+    for(int i = 0; i < 3; i++) {
+      ForsythVertex& vert = verts[tri_verts[i]];
+      nikol::u32* tris    = &adjacency[vert.tris_offset];
+
+      for(nikol::u32 j = 0; j < vert.live_tris; j++) {
+        if(tris[j] == best_tri) {
+          tris[j] = tris[vert.live_tris - 1];
+          vert.live_tris--;
+          break;
+        }
+      }
+    }
+
+    // The triangle's vertices go to the front of the LRU cache, followed by the rest of it
+    nikol::u32 new_count = 0;
+    for(int i = 0; i < 3; i++) {
+      new_cache[new_count++] = tri_verts[i];
+    }
+    
+    for(nikol::u32 i = 0; i < cache_count; i++) {
+      nikol::u32 index = cache[i];
+      if(index != tri_verts[0] && index != tri_verts[1] && index != tri_verts[2]) {
+        new_cache[new_count++] = index;
+      }
+    }
+
+    // Update the positions (and scores) of everything that was or still is in the cache
+    for(nikol::u32 i = 0; i < new_count; i++) {
+      ForsythVertex& vert = verts[new_cache[i]];
+      
+      vert.cache_pos = i < FORSYTH_CACHE_SIZE ? (nikol::i32)i : -1;
+      vert.score     = forsyth_vertex_score(vert);
+    }
+
+    // Find the best triangle touching the cache 
+    best_tri              = -1;
+    nikol::f32 best_score = -1.0f;
+    
+    for(nikol::u32 i = 0; i < new_count; i++) {
+      const ForsythVertex& vert = verts[new_cache[i]];
+      
+      for(nikol::u32 j = 0; j < vert.live_tris; j++) {
+        nikol::u32 tri = adjacency[vert.tris_offset + j];
+        
+        nikol::f32 score = verts[indices[tri * 3]].score + verts[indices[tri * 3 + 1]].score + verts[indices[tri * 3 + 2]].score;
+
+        if(score > best_score) {
+          best_score = score; 
+          best_tri   = tri;
+        }
+      }
+    }
+
+    cache_count = std::min(new_count, FORSYTH_CACHE_SIZE);
+    std::copy(new_cache, new_cache + cache_count, cache);
+  }
+}
+
+nikol::u32 mesh_optimize_overdraw(nikol::u32* dest, 
+                                  const nikol::u32* indices, 
+                                  const nikol::sizei indices_count, 
+                                  const Vertex* vertices, 
+                                  const nikol::sizei vertices_count, 
+                                  const nikol::f32 threshold) {
+  nikol::u32 tris_count = (nikol::u32)(indices_count / 3);
+  if(tris_count == 0) {
+    return 0;
+  }
+
+  std::vector<nikol::u32> timestamps(vertices_count, 0);
+  nikol::u32 time = VERTEX_CACHE_SIM_SIZE + 1;
+
+  // Hard boundaries: a triangle that misses on all three of its vertices starts 
+  // with a cold cache anyway, so starting a new cluster there costs nothing.
+  std::vector<nikol::u32> hard_starts;
+  for(nikol::u32 tri = 0; tri < tris_count; tri++) {
+    if(simulate_fifo(&indices[tri * 3], 3, timestamps, time, VERTEX_CACHE_SIM_SIZE) == 3) {
+      hard_starts.push_back(tri);
+    }
+  }
+  hard_starts.push_back(tris_count);
+
+  // Soft boundaries: split the hard clusters further, but only where the cache 
+  // efficiency of the piece stays within `threshold` of the whole cluster
+  std::vector<Cluster> clusters;
+  
+  for(nikol::sizei i = 0; i + 1 < hard_starts.size(); i++) {
+    nikol::u32 start = hard_starts[i]; 
+    nikol::u32 end   = hard_starts[i + 1];
+    
+    reset_cache(time, VERTEX_CACHE_SIM_SIZE);
+    nikol::f32 cluster_acmr = (nikol::f32)simulate_fifo(&indices[start * 3], (end - start) * 3, timestamps, time, VERTEX_CACHE_SIM_SIZE) / (end - start);
+   
+    nikol::u32 piece_start  = start;
+    nikol::u32 piece_misses = 0;
+    reset_cache(time, VERTEX_CACHE_SIM_SIZE);
+
+    for(nikol::u32 tri = start; tri < end; tri++) {
+      piece_misses += simulate_fifo(&indices[tri * 3], 3, timestamps, time, VERTEX_CACHE_SIM_SIZE);
+      
+      nikol::u32 piece_tris = tri - piece_start + 1;
+      bool can_split        = piece_tris >= OVERDRAW_MIN_CLUSTER && (end - tri - 1) >= OVERDRAW_MIN_CLUSTER;
+
+      if(can_split && ((nikol::f32)piece_misses / piece_tris) <= cluster_acmr * threshold) {
+        clusters.push_back(Cluster{piece_start, piece_tris, 0.0f});
+        
+        piece_start  = tri + 1;
+        piece_misses = 0;
+        reset_cache(time, VERTEX_CACHE_SIM_SIZE);
+      }
+    }
+
+    if(piece_start < end) {
+      clusters.push_back(Cluster{piece_start, end - piece_start, 0.0f});
+    }
+  }
+
+  // Sort the clusters front-to-back, roughly speaking
+  glm::vec3 mesh_center = glm::vec3(0.0f);
+  for(nikol::sizei i = 0; i < vertices_count; i++) {
+    mesh_center += vertices[i].position;
+  }
+  mesh_center /= (nikol::f32)vertices_count;
+
+  for(auto& cluster : clusters) {
+    compute_cluster_key(cluster, indices, vertices, mesh_center);
+  }
+
+  std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+    return a.sort_key > b.sort_key;
+  });
+
+  nikol::sizei out = 0;
+  for(auto& cluster : clusters) {
+    std::copy(&indices[cluster.start * 3], &indices[(cluster.start + cluster.count) * 3], &dest[out]);
+    out += cluster.count * 3;
+  }
+
+  return (nikol::u32)clusters.size();
+}
+
+nikol::sizei mesh_optimize_vertex_fetch(Vertex* dest, nikol::u32* indices, const nikol::sizei indices_count, const Vertex* vertices, const nikol::sizei vertices_count) {
+  const nikol::u32 UNUSED = (nikol::u32)-1;
+
+  std::vector<nikol::u32> remap(vertices_count, UNUSED);
+  nikol::u32 next = 0;
+
+  for(nikol::sizei i = 0; i < indices_count; i++) {
+    nikol::u32& new_index = remap[indices[i]];
+
+    if(new_index == UNUSED) {
+      new_index       = next++;
+      dest[new_index] = vertices[indices[i]];
+    }
+
+    indices[i] = new_index;
+  }
+
+  return next;
+}
+
+MeshOptimizeStats mesh_optimize(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices) {
+  MeshOptimizeStats stats;
+  stats.before = mesh_analyze_vertex_cache(indices.data(), indices.size(), vertices.size());
+
+  std::vector<nikol::u32> cache_indices(indices.size());
+  mesh_optimize_vertex_cache(cache_indices.data(), indices.data(), indices.size(), vertices.size());
+  
+  stats.clusters_count = mesh_optimize_overdraw(indices.data(), cache_indices.data(), cache_indices.size(), vertices.data(), vertices.size());
+  
+  std::vector<Vertex> fetch_vertices(vertices.size());
+  nikol::sizei used = mesh_optimize_vertex_fetch(fetch_vertices.data(), indices.data(), indices.size(), vertices.data(), vertices.size());
+  
+  fetch_vertices.resize(used);
+  vertices.swap(fetch_vertices);
+
+  stats.after = mesh_analyze_vertex_cache(indices.data(), indices.size(), vertices.size());
+  return stats;
+}
+// Mesh optimizer functions
+// ----------------------------------------------------------------------------
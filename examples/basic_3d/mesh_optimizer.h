@@ -0,0 +1,88 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+// The post-transform cache size assumed by the simulator (a FIFO, like most GPUs)
+const nikol::u32 VERTEX_CACHE_SIM_SIZE = 16;
+
+// The resolution of every view the overdraw analyzer rasterizes
+const nikol::u32 OVERDRAW_SIM_SIZE = 256;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// VertexCacheStats
+struct VertexCacheStats {
+  nikol::u32 vertices_transformed = 0;
+
+  nikol::f32 acmr = 0.0f; // Average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3.0 is the worst)
+  nikol::f32 atvr = 0.0f; // Average transformed vertex ratio: transformed vertices per vertex (1.0 is ideal)
+};
+// VertexCacheStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OverdrawStats
+struct OverdrawStats {
+  nikol::u32 pixels_covered = 0;
+  nikol::u32 pixels_shaded  = 0;
+
+  nikol::f32 overdraw = 0.0f; // Shaded pixels per covered pixel (1.0 is ideal)
+};
+// OverdrawStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshOptimizeStats
+struct MeshOptimizeStats {
+  VertexCacheStats before; 
+  VertexCacheStats after;
+  
+  nikol::u32 clusters_count = 0;
+};
+// MeshOptimizeStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh optimizer functions
+
+// Run the index buffer through a simulated FIFO cache of `cache_size` entries
+VertexCacheStats mesh_analyze_vertex_cache(const nikol::u32* indices, 
+                                           const nikol::sizei indices_count, 
+                                           const nikol::sizei vertices_count, 
+                                           const nikol::u32 cache_size = VERTEX_CACHE_SIM_SIZE);
+
+// Rasterize the triangles in order, with a depth test and back faces culled, from the 6 axis-aligned 
+// orthographic views of the bounding box. Front faces are the ones wound counter-clockwise around their outside.
+OverdrawStats mesh_analyze_overdraw(const nikol::u32* indices, 
+                                    const nikol::sizei indices_count, 
+                                    const Vertex* vertices, 
+                                    const nikol::sizei vertices_count);
+
+// Reorder the triangles for the post-transform cache (Forsyth's algorithm). `dest` can't alias `indices`.
+void mesh_optimize_vertex_cache(nikol::u32* dest, const nikol::u32* indices, const nikol::sizei indices_count, const nikol::sizei vertices_count);
+
+// Split cache-optimized triangles into clusters and order them so the outward-facing 
+// ones draw first. A cluster is only split further while its ACMR stays within `threshold` 
+// of the original. Returns the number of clusters. `dest` can't alias `indices`.
+nikol::u32 mesh_optimize_overdraw(nikol::u32* dest, 
+                                  const nikol::u32* indices, 
+                                  const nikol::sizei indices_count, 
+                                  const Vertex* vertices, 
+                                  const nikol::sizei vertices_count, 
+                                  const nikol::f32 threshold = 1.05f);
+
+// Reorder the vertices in the order the indices first use them (and remap the indices in place). 
+// Unreferenced vertices are dropped. Returns the new vertex count.
+nikol::sizei mesh_optimize_vertex_fetch(Vertex* dest, nikol::u32* indices, const nikol::sizei indices_count, const Vertex* vertices, const nikol::sizei vertices_count);
+
+// All of the above in order. The stats are computed with the simulator before and after.
+MeshOptimizeStats mesh_optimize(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices);
+// Mesh optimizer functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,137 @@
+#include "mesh_prepare.h"
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 WELD_EMPTY_SLOT = (nikol::u32)-1;
+
+// Number of floats in a `Vertex`
+const nikol::u32 VERTEX_FLOATS = sizeof(Vertex) / sizeof(nikol::f32);
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// WeldKey
+// The bits every vertex gets hashed and compared by: either the raw floats or their epsilon cells.
+struct WeldKey {
+  nikol::u32 words[VERTEX_FLOATS];
+};
+// WeldKey
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static WeldKey make_key(const Vertex& vertex, const nikol::f32 epsilon) {
+  WeldKey key; 
+  
+  if(epsilon <= 0.0f) {
+    std::memcpy(key.words, &vertex, sizeof(Vertex));
+    return key;
+  }
+
+  const nikol::f32* floats = (const nikol::f32*)&vertex;
+  for(nikol::u32 i = 0; i < VERTEX_FLOATS; i++) {
+    key.words[i] = (nikol::u32)(nikol::i32)std::floor(floats[i] / epsilon + 0.5f);
+  }
+
+  return key;
+}
+
+static nikol::u32 hash_key(const WeldKey& key) {
+  // FNV-1a over the words
+  nikol::u32 hash = 2166136261u;
+  
+  for(nikol::u32 i = 0; i < VERTEX_FLOATS; i++) {
+    hash ^= key.words[i];
+    hash *= 16777619u;
+  }
+
+  // Spread the low bits a bit more, since the table size is a power of two
+  hash ^= hash >> 15;
+  return hash;
+}
+
+static nikol::sizei next_power_of_two(const nikol::sizei value) {
+  nikol::sizei result = 1;
+  while(result < value) {
+    result <<= 1;
+  }
+
+  return result;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh prepare functions
+nikol::sizei mesh_weld_vertices(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices, const nikol::f32 epsilon) {
+  nikol::sizei count = vertices.size();
+  if(count == 0) {
+    return 0;
+  }
+
+  // Open addressing with linear probing. The table stays under half full.
+  nikol::sizei table_size = next_power_of_two(count * 2);
+  nikol::sizei mask       = table_size - 1;
+
+  std::vector<nikol::u32> table(table_size, WELD_EMPTY_SLOT);
+  std::vector<WeldKey> keys(count);
+  std::vector<nikol::u32> remap(count);
+  
+  nikol::u32 unique = 0;
+
+  for(nikol::sizei i = 0; i < count; i++) {
+    keys[i]           = make_key(vertices[i], epsilon);
+    nikol::sizei slot = hash_key(keys[i]) & mask;
+
+    while(true) {
+      nikol::u32 existing = table[slot];
+
+      // First of its kind. Move it down to the next free spot.
+      if(existing == WELD_EMPTY_SLOT) {
+        table[slot]      = unique;
+        keys[unique]     = keys[i];
+        vertices[unique] = vertices[i];
+        remap[i]         = unique++;
+        break;
+      }
+
+      if(std::memcmp(&keys[existing], &keys[i], sizeof(WeldKey)) == 0) {
+        remap[i] = existing;
+        break;
+      }
+
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  for(auto& index : indices) {
+    index = remap[index];
+  }
+
+  vertices.resize(unique);
+  return count - unique;
+}
+
+MeshPrepareStats mesh_prepare(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices, const nikol::f32 weld_epsilon) {
+  MeshPrepareStats stats; 
+  stats.vertices_before    = (nikol::u32)vertices.size();
+  stats.index_bytes_before = indices.size() * sizeof(nikol::u32);
+
+  mesh_weld_vertices(vertices, indices, weld_epsilon);
+
+  // Every index is below the vertex count, so that's all there is to check
+  stats.vertices_after    = (nikol::u32)vertices.size();
+  stats.index_size        = vertices.size() <= 0x10000 ? sizeof(nikol::u16) : sizeof(nikol::u32);
+  stats.index_bytes_after = indices.size() * stats.index_size;
+
+  return stats;
+}
+// Mesh prepare functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// MeshPrepareStats
+struct MeshPrepareStats {
+  nikol::u32 vertices_before = 0; 
+  nikol::u32 vertices_after  = 0;
+
+  // 2 if every index fits in 16 bits, otherwise 4. Only mesh files store 16-bit indices, 
+  // the uploads are always 32-bit (so `Mesh::stats` has 4 here).
+  nikol::u32 index_size = 4; 
+
+  nikol::sizei index_bytes_before = 0; // Always with 32-bit indices
+  nikol::sizei index_bytes_after  = 0; // With `index_size`
+};
+// MeshPrepareStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Mesh prepare functions
+
+// Merge duplicate vertices and remap the indices. With an `epsilon` of 0, only bitwise-identical 
+// vertices are merged. Otherwise, vertices whose attributes land in the same `epsilon`-sized cell are. 
+// The surviving vertices keep their original order. Returns the number of vertices removed.
+nikol::sizei mesh_weld_vertices(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices, const nikol::f32 epsilon = 0.0f);
+
+// Weld the vertices and pick the smallest index size that fits
+MeshPrepareStats mesh_prepare(std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices, const nikol::f32 weld_epsilon = 0.0f);
+// Mesh prepare functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,507 @@
+#include "meshlet.h"
+#include "mesh.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define MESHLET_SIMD_SSE
+#endif
+
+// ----------------------------------------------------------------------------
+// Consts
+const nikol::u32 TRIANGLE_INVALID = 0xffffffff;
+const nikol::u8 SLOT_EMPTY        = 0xff;
+
+// How much the triangles left around a candidate's vertices count against it (next to the vertices it adds)
+const nikol::f32 LIVE_WEIGHT = 0.05f;
+
+// Normals spread wider than this (around 84 degrees from the axis) make the cone useless
+const nikol::f32 CONE_MIN_DOT = 0.1f;
+
+// Indices of the SoA culling arrays
+const nikol::u32 CULL_CENTER_X = 0;
+const nikol::u32 CULL_CENTER_Y = 1;
+const nikol::u32 CULL_CENTER_Z = 2;
+const nikol::u32 CULL_RADIUS   = 3;
+const nikol::u32 CULL_AXIS_X   = 4;
+const nikol::u32 CULL_AXIS_Y   = 5;
+const nikol::u32 CULL_AXIS_Z   = 6;
+const nikol::u32 CULL_CUTOFF   = 7;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshletBuilder
+// Everything the greedy growing needs on the side
+struct MeshletBuilder {
+  const Vertex* vertices;
+  const nikol::u32* indices;
+
+  std::vector<glm::vec3> normals; // Unit triangle normals (zero for degenerate triangles)
+
+  // The triangles around every vertex
+  std::vector<nikol::u32> adjacency_offsets;
+  std::vector<nikol::u32> adjacency;
+
+  std::vector<nikol::u8> used;
+  std::vector<nikol::u32> live;  // Unused triangles left around every vertex
+  std::vector<nikol::u8> slots; // Where each vertex is in the current meshlet
+
+  // The meshlet being grown
+  Meshlet current;
+  std::vector<nikol::u32> triangles;
+  glm::vec3 cone_sum;
+  nikol::u32 last_triangle;
+};
+// MeshletBuilder
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void builder_init(MeshletBuilder& builder, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  nikol::u32 triangles_count = (nikol::u32)(indices.size() / 3);
+
+  builder.vertices = vertices.data();
+  builder.indices  = indices.data();
+
+  builder.normals.resize(triangles_count);
+  for(nikol::u32 i = 0; i < triangles_count; i++) {
+    glm::vec3 p0 = vertices[indices[i * 3 + 0]].position;
+    glm::vec3 p1 = vertices[indices[i * 3 + 1]].position;
+    glm::vec3 p2 = vertices[indices[i * 3 + 2]].position;
+
+    glm::vec3 normal   = glm::cross(p1 - p0, p2 - p0);
+    nikol::f32 length  = glm::length(normal);
+    builder.normals[i] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+  }
+
+  // Counted, then filled
+  builder.adjacency_offsets.assign(vertices.size() + 1, 0);
+  for(auto index : indices) {
+    builder.adjacency_offsets[index + 1]++;
+  }
+
+  for(nikol::sizei i = 1; i < builder.adjacency_offsets.size(); i++) {
+    builder.adjacency_offsets[i] += builder.adjacency_offsets[i - 1];
+  }
+
+  std::vector<nikol::u32> cursors(builder.adjacency_offsets.begin(), builder.adjacency_offsets.end() - 1);
+  builder.adjacency.resize(indices.size());
+
+  for(nikol::sizei i = 0; i < indices.size(); i++) {
+    builder.adjacency[cursors[indices[i]]++] = (nikol::u32)(i / 3);
+  }
+
+  builder.used.assign(triangles_count, 0);
+  builder.live.assign(vertices.size(), 0);
+  for(auto index : indices) {
+    builder.live[index]++;
+  }
+
+  builder.slots.assign(vertices.size(), SLOT_EMPTY);
+
+  builder.current       = Meshlet{};
+  builder.cone_sum      = glm::vec3(0.0f);
+  builder.last_triangle = TRIANGLE_INVALID;
+}
+
+// How many vertices `triangle` would add to the current meshlet
+static nikol::u32 new_vertices_count(const MeshletBuilder& builder, const nikol::u32 triangle) {
+  const nikol::u32* tri = &builder.indices[triangle * 3];
+
+  return (builder.slots[tri[0]] == SLOT_EMPTY) +
+         (builder.slots[tri[1]] == SLOT_EMPTY) +
+         (builder.slots[tri[2]] == SLOT_EMPTY);
+}
+
+// The best unused triangle around `vertex` that still fits, if it beats `best_score`
+static void score_neighbours(const MeshletBuilder& builder,
+                             const nikol::u32 vertex,
+                             const glm::vec3& axis,
+                             const nikol::f32 cone_weight,
+                             nikol::u32& best,
+                             nikol::f32& best_score) {
+  for(nikol::u32 i = builder.adjacency_offsets[vertex]; i < builder.adjacency_offsets[vertex + 1]; i++) {
+    nikol::u32 triangle = builder.adjacency[i];
+    if(builder.used[triangle]) {
+      continue;
+    }
+
+    nikol::u32 extra = new_vertices_count(builder, triangle);
+    if(builder.current.vertices_count + extra > MESHLET_MAX_VERTICES) {
+      continue;
+    }
+
+    // Vertices with few triangles left get finished off first, so no scraps are left behind
+    const nikol::u32* tri = &builder.indices[triangle * 3];
+    nikol::u32 live       = builder.live[tri[0]] + builder.live[tri[1]] + builder.live[tri[2]];
+
+    nikol::f32 score = (nikol::f32)extra + 
+                       cone_weight * (1.0f - glm::dot(builder.normals[triangle], axis)) + 
+                       LIVE_WEIGHT * (nikol::f32)live;
+    if(score < best_score) {
+      best       = triangle;
+      best_score = score;
+    }
+  }
+}
+
+// The next triangle to grow the current meshlet with, or `TRIANGLE_INVALID` if nothing connected fits
+static nikol::u32 pick_triangle(const MeshletBuilder& builder, const std::vector<nikol::u32>& meshlet_vertices, const nikol::f32 cone_weight) {
+  const Meshlet& current = builder.current;
+  if(current.triangles_count == 0 || current.triangles_count == MESHLET_MAX_TRIANGLES) {
+    return TRIANGLE_INVALID;
+  }
+
+  nikol::f32 cone_length = glm::length(builder.cone_sum);
+  glm::vec3 axis         = cone_length > 0.0f ? builder.cone_sum / cone_length : glm::vec3(0.0f);
+
+  nikol::u32 best       = TRIANGLE_INVALID;
+  nikol::f32 best_score = 1e30f;
+
+  // Around the last triangle first, so the meshlet grows like a strip
+  const nikol::u32* last = &builder.indices[builder.last_triangle * 3];
+  for(nikol::u32 i = 0; i < 3; i++) {
+    score_neighbours(builder, last[i], axis, cone_weight, best, best_score);
+  }
+
+  // Then around anything in the meshlet
+  if(best == TRIANGLE_INVALID) {
+    for(nikol::u32 i = 0; i < current.vertices_count; i++) {
+      score_neighbours(builder, meshlet_vertices[current.vertex_offset + i], axis, cone_weight, best, best_score);
+    }
+  }
+
+  return best;
+}
+
+static void append_triangle(MeshletBuilder& builder, MeshletMesh& mesh, const nikol::u32 triangle) {
+  Meshlet& current      = builder.current;
+  const nikol::u32* tri = &builder.indices[triangle * 3];
+
+  for(nikol::u32 i = 0; i < 3; i++) {
+    nikol::u8& slot = builder.slots[tri[i]];
+
+    if(slot == SLOT_EMPTY) {
+      slot = (nikol::u8)current.vertices_count++;
+      mesh.meshlet_vertices.push_back(tri[i]);
+    }
+
+    mesh.meshlet_triangles.push_back(slot);
+    mesh.indices.push_back(tri[i]);
+    builder.live[tri[i]]--;
+  }
+
+  current.triangles_count++;
+  builder.triangles.push_back(triangle);
+
+  builder.cone_sum      += builder.normals[triangle];
+  builder.used[triangle] = 1;
+  builder.last_triangle  = triangle;
+}
+
+static MeshletBounds compute_bounds(const MeshletBuilder& builder, const MeshletMesh& mesh) {
+  const Meshlet& meshlet = builder.current;
+  MeshletBounds bounds;
+
+  // The sphere around the box of the vertices
+  const nikol::u32* verts = &mesh.meshlet_vertices[meshlet.vertex_offset];
+  glm::vec3 min           = builder.vertices[verts[0]].position;
+  glm::vec3 max           = min;
+
+  for(nikol::u32 i = 1; i < meshlet.vertices_count; i++) {
+    min = glm::min(min, builder.vertices[verts[i]].position);
+    max = glm::max(max, builder.vertices[verts[i]].position);
+  }
+
+  bounds.center = (min + max) * 0.5f;
+  bounds.radius = 0.0f;
+
+  for(nikol::u32 i = 0; i < meshlet.vertices_count; i++) {
+    bounds.radius = glm::max(bounds.radius, glm::length(builder.vertices[verts[i]].position - bounds.center));
+  }
+
+  // The cone around the average normal, just wide enough for the normal furthest from it
+  bounds.cone_axis   = glm::vec3(0.0f);
+  bounds.cone_cutoff = 1.0f;
+
+  nikol::f32 cone_length = glm::length(builder.cone_sum);
+  if(cone_length <= 0.0f) {
+    return bounds;
+  }
+
+  glm::vec3 axis    = builder.cone_sum / cone_length;
+  nikol::f32 min_dp = 1.0f;
+
+  for(auto triangle : builder.triangles) {
+    const glm::vec3& normal = builder.normals[triangle];
+
+    // Degenerate triangles have no facing (and never get drawn anyway)
+    if(normal != glm::vec3(0.0f)) {
+      min_dp = glm::min(min_dp, glm::dot(normal, axis));
+    }
+  }
+
+  if(min_dp > CONE_MIN_DOT) {
+    bounds.cone_axis   = axis;
+    bounds.cone_cutoff = std::sqrt(1.0f - min_dp * min_dp); // cos(angle + 90 degrees), flipped
+  }
+
+  return bounds;
+}
+
+static void finish_meshlet(MeshletBuilder& builder, MeshletMesh& mesh) {
+  Meshlet& current = builder.current;
+
+  mesh.meshlets.push_back(current);
+  mesh.bounds.push_back(compute_bounds(builder, mesh));
+
+  for(nikol::u32 i = 0; i < current.vertices_count; i++) {
+    builder.slots[mesh.meshlet_vertices[current.vertex_offset + i]] = SLOT_EMPTY;
+  }
+
+  current.vertex_offset   = (nikol::u32)mesh.meshlet_vertices.size();
+  current.triangle_offset = (nikol::u32)(mesh.indices.size() / 3);
+  current.vertices_count  = 0;
+  current.triangles_count = 0;
+
+  builder.triangles.clear();
+  builder.cone_sum      = glm::vec3(0.0f);
+  builder.last_triangle = TRIANGLE_INVALID;
+}
+
+static void fill_cull_data(MeshletMesh& mesh) {
+  nikol::sizei padded_count = (mesh.bounds.size() + 3) & ~(nikol::sizei)3;
+
+  // The padding is a zero sized sphere at the origin that never gets looked at
+  for(auto& data : mesh.cull_data) {
+    data.assign(padded_count, 0.0f);
+  }
+
+  for(nikol::sizei i = 0; i < mesh.bounds.size(); i++) {
+    const MeshletBounds& bounds = mesh.bounds[i];
+
+    mesh.cull_data[CULL_CENTER_X][i] = bounds.center.x;
+    mesh.cull_data[CULL_CENTER_Y][i] = bounds.center.y;
+    mesh.cull_data[CULL_CENTER_Z][i] = bounds.center.z;
+    mesh.cull_data[CULL_RADIUS][i]   = bounds.radius;
+    mesh.cull_data[CULL_AXIS_X][i]   = bounds.cone_axis.x;
+    mesh.cull_data[CULL_AXIS_Y][i]   = bounds.cone_axis.y;
+    mesh.cull_data[CULL_AXIS_Z][i]   = bounds.cone_axis.z;
+    mesh.cull_data[CULL_CUTOFF][i]   = bounds.cone_cutoff;
+  }
+}
+
+static nikol::u32 count_bits(const nikol::u32 bits) {
+  return (bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1) + ((bits >> 3) & 1);
+}
+
+// Flag every meshlet inside the frustum and facing the camera, 4 at a time
+static void test_meshlets(MeshletMesh& mesh, const glm::vec4* planes, const glm::vec3& camera) {
+  nikol::u32 count = (nikol::u32)mesh.meshlets.size();
+
+  const nikol::f32* center_x = mesh.cull_data[CULL_CENTER_X].data();
+  const nikol::f32* center_y = mesh.cull_data[CULL_CENTER_Y].data();
+  const nikol::f32* center_z = mesh.cull_data[CULL_CENTER_Z].data();
+  const nikol::f32* radius   = mesh.cull_data[CULL_RADIUS].data();
+  const nikol::f32* axis_x   = mesh.cull_data[CULL_AXIS_X].data();
+  const nikol::f32* axis_y   = mesh.cull_data[CULL_AXIS_Y].data();
+  const nikol::f32* axis_z   = mesh.cull_data[CULL_AXIS_Z].data();
+  const nikol::f32* cutoff   = mesh.cull_data[CULL_CUTOFF].data();
+
+  for(nikol::u32 i = 0; i < count; i += 4) {
+    nikol::u32 frustum_bits = 0, cone_bits = 0;
+
+#if defined(MESHLET_SIMD_SSE)
+    __m128 cx = _mm_loadu_ps(&center_x[i]);
+    __m128 cy = _mm_loadu_ps(&center_y[i]);
+    __m128 cz = _mm_loadu_ps(&center_z[i]);
+    __m128 r  = _mm_loadu_ps(&radius[i]);
+
+    // Further than the radius behind any plane
+    __m128 neg_r   = _mm_sub_ps(_mm_setzero_ps(), r);
+    __m128 outside = _mm_setzero_ps();
+
+    for(nikol::u32 p = 0; p < 6; p++) {
+      __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), cx), _mm_mul_ps(_mm_set1_ps(planes[p].y), cy)),
+                               _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), cz), _mm_set1_ps(planes[p].w)));
+      outside     = _mm_or_ps(outside, _mm_cmplt_ps(dist, neg_r));
+    }
+
+    // Facing away: dot(center - camera, axis) >= cutoff * length(center - camera) + radius
+    __m128 dx = _mm_sub_ps(cx, _mm_set1_ps(camera.x));
+    __m128 dy = _mm_sub_ps(cy, _mm_set1_ps(camera.y));
+    __m128 dz = _mm_sub_ps(cz, _mm_set1_ps(camera.z));
+
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+    __m128 along  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&axis_x[i])), _mm_mul_ps(dy, _mm_loadu_ps(&axis_y[i]))), 
+                               _mm_mul_ps(dz, _mm_loadu_ps(&axis_z[i])));
+    __m128 limit  = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[i]), length), r);
+    __m128 away   = _mm_cmpge_ps(along, limit);
+
+    frustum_bits = (nikol::u32)_mm_movemask_ps(outside);
+    cone_bits    = (nikol::u32)_mm_movemask_ps(_mm_andnot_ps(outside, away));
+#else
+    for(nikol::u32 j = 0; j < 4; j++) {
+      glm::vec3 center = glm::vec3(center_x[i + j], center_y[i + j], center_z[i + j]);
+      bool outside     = false;
+
+      for(nikol::u32 p = 0; p < 6; p++) {
+        outside |= glm::dot(glm::vec3(planes[p]), center) + planes[p].w < -radius[i + j];
+      }
+
+      glm::vec3 to_center = center - camera;
+      glm::vec3 axis      = glm::vec3(axis_x[i + j], axis_y[i + j], axis_z[i + j]);
+      bool away           = glm::dot(to_center, axis) >= cutoff[i + j] * glm::length(to_center) + radius[i + j];
+
+      frustum_bits |= (nikol::u32)outside << j;
+      cone_bits    |= (nikol::u32)(!outside && away) << j;
+    }
+#endif
+
+    // The padding at the end does not count
+    nikol::u32 valid = (count - i) >= 4 ? 0xf : (1u << (count - i)) - 1;
+    frustum_bits    &= valid;
+    cone_bits       &= valid;
+
+    nikol::u32 visible_bits = ~(frustum_bits | cone_bits) & valid;
+    for(nikol::u32 j = 0; j < 4; j++) {
+      mesh.visible[i + j] = (visible_bits >> j) & 1;
+    }
+
+    mesh.stats.culled_frustum += count_bits(frustum_bits);
+    mesh.stats.culled_cone    += count_bits(cone_bits);
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshletMesh functions
+void meshlet_mesh_build(MeshletMesh& mesh, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, const nikol::f32 cone_weight) {
+  NIKOL_ASSERT((indices.size() % 3) == 0, "Meshlets can only be built out of triangle lists");
+
+  mesh.meshlets.clear();
+  mesh.bounds.clear();
+  mesh.meshlet_vertices.clear();
+  mesh.meshlet_triangles.clear();
+  mesh.indices.clear();
+
+  mesh.meshlet_triangles.reserve(indices.size());
+  mesh.indices.reserve(indices.size());
+
+  MeshletBuilder builder;
+  builder_init(builder, vertices, indices);
+
+  nikol::u32 triangles_count = (nikol::u32)(indices.size() / 3);
+  nikol::u32 scan_cursor     = 0;
+
+  for(nikol::u32 added = 0; added < triangles_count; added++) {
+    nikol::u32 triangle = pick_triangle(builder, mesh.meshlet_vertices, cone_weight);
+
+    // Nothing connected fits anymore, so the meshlet is done. The next one starts 
+    // at the first unused triangle (which is close by in a cache optimized order).
+    if(triangle == TRIANGLE_INVALID) {
+      if(builder.current.triangles_count > 0) {
+        finish_meshlet(builder, mesh);
+      }
+
+      while(builder.used[scan_cursor]) {
+        scan_cursor++;
+      }
+      triangle = scan_cursor;
+    }
+
+    append_triangle(builder, mesh, triangle);
+  }
+
+  if(builder.current.triangles_count > 0) {
+    finish_meshlet(builder, mesh);
+  }
+
+  fill_cull_data(mesh);
+  mesh.visible.assign(mesh.cull_data[0].size(), 1);
+}
+
+void meshlet_mesh_cull(MeshletMesh& mesh, const glm::mat4& model_view_projection, const glm::vec3& camera_position) {
+  nikol::f64 start = nikol::niclock_get_time();
+
+  // The frustum planes in object space (Gribb/Hartmann), normalized so the spheres can be tested against them
+  const glm::mat4& mvp = model_view_projection;
+  glm::vec4 row0       = glm::vec4(mvp[0][0], mvp[1][0], mvp[2][0], mvp[3][0]);
+  glm::vec4 row1       = glm::vec4(mvp[0][1], mvp[1][1], mvp[2][1], mvp[3][1]);
+  glm::vec4 row2       = glm::vec4(mvp[0][2], mvp[1][2], mvp[2][2], mvp[3][2]);
+  glm::vec4 row3       = glm::vec4(mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3]);
+
+  glm::vec4 planes[6] = {
+    row3 + row0, row3 - row0,
+    row3 + row1, row3 - row1,
+    row3 + row2, row3 - row2,
+  };
+
+  for(auto& plane : planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+
+  mesh.stats                 = {};
+  mesh.stats.meshlets_count  = (nikol::u32)mesh.meshlets.size();
+  mesh.stats.triangles_count = (nikol::u32)(mesh.indices.size() / 3);
+
+  test_meshlets(mesh, planes, camera_position);
+
+  // Neighbouring meshlets are neighbours in `indices` too, so they merge into one range
+  mesh.ranges.clear();
+  nikol::u32 visible_count = 0;
+
+  for(nikol::sizei i = 0; i < mesh.meshlets.size(); i++) {
+    if(!mesh.visible[i]) {
+      continue;
+    }
+
+    const Meshlet& meshlet = mesh.meshlets[i];
+    nikol::u32 first_index = meshlet.triangle_offset * 3;
+    nikol::u32 count       = meshlet.triangles_count * 3;
+
+    if(!mesh.ranges.empty() && (mesh.ranges.back().first_index + mesh.ranges.back().indices_count) == first_index) {
+      mesh.ranges.back().indices_count += count;
+    }
+    else {
+      mesh.ranges.push_back(MeshletRange{first_index, count});
+    }
+
+    mesh.stats.meshlets_visible++;
+    visible_count += count;
+  }
+
+  mesh.visible_indices.resize(visible_count);
+  nikol::u32* dest = mesh.visible_indices.data();
+
+  for(auto& range : mesh.ranges) {
+    std::memcpy(dest, &mesh.indices[range.first_index], range.indices_count * sizeof(nikol::u32));
+    dest += range.indices_count;
+  }
+
+  mesh.stats.triangles_culled = mesh.stats.triangles_count - visible_count / 3;
+  mesh.stats.cull_time        = (nikol::niclock_get_time() - start) * 1000.0;
+}
+
+void meshlet_mesh_upload(nikol::GfxContext* gfx, MeshletMesh& mesh, const std::vector<Vertex>& vertices) {
+  if(mesh.mesh) {
+    mesh_destroy(mesh.mesh);
+  }
+
+  mesh.mesh = mesh_create_dynamic(gfx, vertices, mesh.indices);
+}
+
+void meshlet_mesh_destroy(MeshletMesh& mesh) {
+  mesh_destroy(mesh.mesh);
+  mesh.mesh = nullptr;
+}
+// MeshletMesh functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "vertex.h"
+#include "mesh.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The limits of a single meshlet (the usual mesh shader sizes, so the same clusters could be fed to one)
+const nikol::u32 MESHLET_MAX_VERTICES  = 64;
+const nikol::u32 MESHLET_MAX_TRIANGLES = 124;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Meshlet
+struct Meshlet {
+  nikol::u32 vertex_offset;   // Into `MeshletMesh::meshlet_vertices`
+  nikol::u32 triangle_offset; // In triangles, so `* 3` into both `MeshletMesh::meshlet_triangles` and `MeshletMesh::indices`
+  nikol::u32 vertices_count;
+  nikol::u32 triangles_count;
+};
+// Meshlet
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshletBounds
+// Object space bounds of a meshlet. The cone holds the normals of every triangle: the whole
+// meshlet faces away from the camera when
+// `dot(center - camera, cone_axis) >= cone_cutoff * length(center - camera) + radius`.
+struct MeshletBounds {
+  glm::vec3 center;
+  nikol::f32 radius;
+
+  glm::vec3 cone_axis;
+  nikol::f32 cone_cutoff; // 1 when the normals are spread too wide to ever be culled
+};
+// MeshletBounds
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshletRange
+// Neighbouring visible meshlets, as one range of `MeshletMesh::indices`
+struct MeshletRange {
+  nikol::u32 first_index;
+  nikol::u32 indices_count;
+};
+// MeshletRange
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshletCullStats
+// Per cull (see `meshlet_mesh_cull`)
+struct MeshletCullStats {
+  nikol::u32 meshlets_count   = 0;
+  nikol::u32 meshlets_visible = 0;
+  nikol::u32 culled_frustum   = 0;
+  nikol::u32 culled_cone      = 0; // Inside the frustum, but facing away
+
+  nikol::u32 triangles_count  = 0;
+  nikol::u32 triangles_culled = 0;
+
+  nikol::f64 cull_time = 0.0; // In milliseconds, the compaction included
+};
+// MeshletCullStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshletMesh
+// A mesh split into small clusters of neighbouring triangles, each with its own bounds, so big
+// meshes can be culled piece by piece on the CPU. The triangles are stored meshlet after meshlet
+// in `indices`, which is what gets uploaded. Every frame the visible ones are compacted into
+// `visible_indices`, which gets streamed into the index buffer and drawn in one go.
+struct MeshletMesh {
+  std::vector<Meshlet> meshlets;
+  std::vector<MeshletBounds> bounds;
+
+  std::vector<nikol::u32> meshlet_vertices; // Global vertex indices
+  std::vector<nikol::u8> meshlet_triangles; // Local to each meshlet
+  std::vector<nikol::u32> indices;          // The same triangles with global indices
+
+  // The bounds again as SoA arrays (padded to a multiple of 4) for the SIMD culling:
+  // center x, y, z, radius, cone axis x, y, z and cutoff
+  std::vector<nikol::f32> cull_data[8];
+
+  // Per frame
+  std::vector<nikol::u8> visible;
+  std::vector<MeshletRange> ranges;
+  std::vector<nikol::u32> visible_indices;
+  MeshletCullStats stats;
+
+  Mesh* mesh = nullptr;
+};
+// MeshletMesh
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// MeshletMesh functions
+
+// Greedily grow meshlets out of neighbouring triangles, starting a new one whenever a limit is hit.
+// Among the neighbours, the triangles adding the fewest vertices come first, with `cone_weight`
+// favoring the ones facing the same way as the meshlet (which keeps the cones tight). Works best
+// on triangles already ordered for the vertex cache. Anything built before is replaced.
+void meshlet_mesh_build(MeshletMesh& mesh,
+                        const std::vector<Vertex>& vertices,
+                        const std::vector<nikol::u32>& indices,
+                        const nikol::f32 cone_weight = 0.5f);
+
+// Test every meshlet against the frustum of `model_view_projection` and the camera (both in the mesh's
+// object space) with SIMD, then write the visible meshlets into `ranges` (neighbours merged) and their
+// triangles into `visible_indices`. Only meant for perspective projections.
+void meshlet_mesh_cull(MeshletMesh& mesh, const glm::mat4& model_view_projection, const glm::vec3& camera_position);
+
+// Create the mesh from `vertices` (the ones given to `meshlet_mesh_build`) and `indices`. The index buffer is
+// dynamic, since it gets the visible triangles streamed into it every frame (see `render_meshlets`).
+void meshlet_mesh_upload(nikol::GfxContext* gfx, MeshletMesh& mesh, const std::vector<Vertex>& vertices);
+
+// Destroys the mesh
+void meshlet_mesh_destroy(MeshletMesh& mesh);
+// MeshletMesh functions
+// ----------------------------------------------------------------------------
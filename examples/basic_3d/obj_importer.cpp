@@ -0,0 +1,331 @@
+#include "obj_importer.h"
+#include "mesh_file.h"
+#include "vertex.h"
+#include "mesh_normals.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+// ObjCorner
+// A single `v/vt/vn` reference of a face. Zero means "missing".
+struct ObjCorner {
+  nikol::i32 position, uv, normal;
+
+  bool operator==(const ObjCorner& other) const {
+    return position == other.position && uv == other.uv && normal == other.normal;
+  }
+};
+
+struct ObjCornerHash {
+  nikol::sizei operator()(const ObjCorner& corner) const {
+    nikol::u64 hash = (nikol::u64)(nikol::u32)corner.position * 0x9e3779b97f4a7c15ull;
+    hash ^= (nikol::u64)(nikol::u32)corner.uv * 0xc2b2ae3d27d4eb4full + (hash << 6);
+    hash ^= (nikol::u64)(nikol::u32)corner.normal * 0x165667b19e3779f9ull + (hash >> 2);
+
+    return (nikol::sizei)hash;
+  }
+};
+// ObjCorner
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ObjParser
+struct ObjParser {
+  const char* cursor; 
+  const char* end;
+
+  std::vector<glm::vec3> positions; 
+  std::vector<glm::vec2> uvs; 
+  std::vector<glm::vec3> normals;
+
+  std::unordered_map<ObjCorner, nikol::u32, ObjCornerHash> corner_to_vertex;
+  std::vector<nikol::u32> face;
+
+  char submesh_name[MESH_FILE_NAME_MAX];
+};
+// ObjParser
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static bool is_space(const char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static void skip_spaces(ObjParser& parser) {
+  while(parser.cursor < parser.end && is_space(*parser.cursor)) {
+    parser.cursor++;
+  }
+}
+
+static void skip_line(ObjParser& parser) {
+  while(parser.cursor < parser.end && *parser.cursor != '\n') {
+    parser.cursor++;
+  }
+
+  if(parser.cursor < parser.end) {
+    parser.cursor++;
+  }
+}
+
+static float parse_float(ObjParser& parser) {
+  skip_spaces(parser);
+
+  char* float_end = nullptr; 
+  float value     = std::strtof(parser.cursor, &float_end);
+  parser.cursor   = float_end;
+
+  return value;
+}
+
+static nikol::i32 parse_index(ObjParser& parser) {
+  bool negative = false;
+  if(*parser.cursor == '-') {
+    negative = true; 
+    parser.cursor++;
+  }
+
+  nikol::i32 value = 0;
+  while(parser.cursor < parser.end && *parser.cursor >= '0' && *parser.cursor <= '9') {
+    value = value * 10 + (*parser.cursor - '0');
+    parser.cursor++;
+  }
+
+  return negative ? -value : value;
+}
+
+// OBJ indices are 1-based and negative ones count back from the end
+static nikol::i32 resolve_index(const nikol::i32 index, const nikol::sizei count) {
+  if(index < 0) {
+    return (nikol::i32)count + index + 1;
+  }
+
+  return index;
+}
+
+static void parse_name(ObjParser& parser) {
+  skip_spaces(parser);
+
+  nikol::sizei length = 0;
+  while(parser.cursor < parser.end && *parser.cursor != '\n' && *parser.cursor != '\r') {
+    if(length < MESH_FILE_NAME_MAX - 1) {
+      parser.submesh_name[length++] = *parser.cursor;
+    }
+
+    parser.cursor++;
+  }
+
+  parser.submesh_name[length] = '\0';
+}
+
+static void begin_submesh(ObjParser& parser, ObjMesh& mesh) {
+  nikol::u32 index_offset = (nikol::u32)mesh.indices.size();
+
+  // The previous submesh never got any faces. Just rename it instead.
+  if(!mesh.submeshes.empty() && mesh.submeshes.back().index_offset == index_offset) {
+    std::memcpy(mesh.submeshes.back().name, parser.submesh_name, MESH_FILE_NAME_MAX);
+    return;
+  }
+
+  MeshFileSubmesh submesh = {}; 
+  std::memcpy(submesh.name, parser.submesh_name, MESH_FILE_NAME_MAX);
+  submesh.index_offset = index_offset;
+
+  mesh.submeshes.push_back(submesh);
+}
+
+static nikol::u32 get_vertex(ObjParser& parser, ObjMesh& mesh, const ObjCorner& corner) {
+  auto it = parser.corner_to_vertex.find(corner);
+  if(it != parser.corner_to_vertex.end()) {
+    return it->second;
+  }
+
+  Vertex vertex = {}; 
+  if(corner.position > 0 && corner.position <= (nikol::i32)parser.positions.size()) {
+    vertex.position = parser.positions[corner.position - 1];
+  }
+  if(corner.normal > 0 && corner.normal <= (nikol::i32)parser.normals.size()) {
+    vertex.normal = parser.normals[corner.normal - 1];
+  }
+  if(corner.uv > 0 && corner.uv <= (nikol::i32)parser.uvs.size()) {
+    vertex.texture_coords = parser.uvs[corner.uv - 1];
+  }
+
+  nikol::u32 index = (nikol::u32)mesh.vertices.size();
+  mesh.vertices.push_back(vertex);
+  parser.corner_to_vertex[corner] = index;
+
+  return index;
+}
+
+static void parse_face(ObjParser& parser, ObjMesh& mesh) {
+  parser.face.clear();
+
+  while(true) {
+    skip_spaces(parser);
+    if(parser.cursor >= parser.end || *parser.cursor == '\n' || *parser.cursor == '#') {
+      break;
+    }
+
+    ObjCorner corner = {};
+    corner.position  = resolve_index(parse_index(parser), parser.positions.size());
+    
+    if(parser.cursor < parser.end && *parser.cursor == '/') {
+      parser.cursor++;
+
+      // `v//vn` has no UV
+      if(*parser.cursor != '/') {
+        corner.uv = resolve_index(parse_index(parser), parser.uvs.size());
+      }
+      
+      if(parser.cursor < parser.end && *parser.cursor == '/') {
+        parser.cursor++;
+        corner.normal = resolve_index(parse_index(parser), parser.normals.size());
+      }
+    }
+
+    // Garbage in the face. Bail before looping forever.
+    if(corner.position == 0) {
+      break;
+    }
+
+    parser.face.push_back(get_vertex(parser, mesh, corner));
+  }
+
+  // Fan triangulation
+  for(nikol::sizei i = 2; i < parser.face.size(); i++) {
+    mesh.indices.push_back(parser.face[0]);
+    mesh.indices.push_back(parser.face[i - 1]);
+    mesh.indices.push_back(parser.face[i]);
+  }
+}
+
+static void finish_submeshes(ObjMesh& mesh) {
+  // Drop the trailing empty submesh (if any)
+  if(!mesh.submeshes.empty() && mesh.submeshes.back().index_offset == mesh.indices.size()) {
+    mesh.submeshes.pop_back();
+  }
+
+  for(nikol::sizei i = 0; i < mesh.submeshes.size(); i++) {
+    MeshFileSubmesh& submesh = mesh.submeshes[i];
+    
+    nikol::u32 next_offset = (i + 1) < mesh.submeshes.size() ? mesh.submeshes[i + 1].index_offset : (nikol::u32)mesh.indices.size();
+    submesh.indices_count  = next_offset - submesh.index_offset;
+
+    glm::vec3 low  = glm::vec3(0.0f); 
+    glm::vec3 high = glm::vec3(0.0f);
+    
+    for(nikol::u32 j = 0; j < submesh.indices_count; j++) {
+      const glm::vec3& pos = mesh.vertices[mesh.indices[submesh.index_offset + j]].position;
+
+      low  = (j == 0) ? pos : glm::min(low, pos);
+      high = (j == 0) ? pos : glm::max(high, pos);
+    }
+
+    std::memcpy(submesh.bounds_min, &low.x, sizeof(float) * 3);
+    std::memcpy(submesh.bounds_max, &high.x, sizeof(float) * 3);
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ObjMesh functions
+bool obj_import(const char* path, ObjMesh& mesh) {
+  FILE* file = fopen(path, "rb");
+  if(!file) {
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  // One extra byte so `strtof` always stops at a terminator
+  std::vector<char> text(size + 1, '\0');
+  bool success = fread(text.data(), 1, size, file) == (nikol::sizei)size;
+  fclose(file);
+
+  return success && obj_import_from_memory(text.data(), (nikol::sizei)size, mesh);
+}
+
+bool obj_import_from_memory(const char* text, const nikol::sizei size, ObjMesh& mesh) {
+  ObjParser parser = {
+    .cursor = text, 
+    .end    = text + size,
+  };
+  std::strcpy(parser.submesh_name, "default");
+
+  mesh.vertices.clear();
+  mesh.indices.clear();
+  mesh.submeshes.clear();
+  mesh.tangents.clear();
+  
+  begin_submesh(parser, mesh);
+
+  while(parser.cursor < parser.end) {
+    skip_spaces(parser);
+    
+    const char* line = parser.cursor;
+    nikol::sizei left = parser.end - line;
+
+    if(left >= 2 && line[0] == 'v' && is_space(line[1])) {
+      parser.cursor += 2;
+      
+      float x = parse_float(parser), y = parse_float(parser), z = parse_float(parser);
+      parser.positions.push_back(glm::vec3(x, y, z));
+    }
+    else if(left >= 3 && line[0] == 'v' && line[1] == 't' && is_space(line[2])) {
+      parser.cursor += 3;
+      
+      float u = parse_float(parser), v = parse_float(parser);
+      parser.uvs.push_back(glm::vec2(u, v));
+    }
+    else if(left >= 3 && line[0] == 'v' && line[1] == 'n' && is_space(line[2])) {
+      parser.cursor += 3;
+      
+      float x = parse_float(parser), y = parse_float(parser), z = parse_float(parser);
+      parser.normals.push_back(glm::vec3(x, y, z));
+    }
+    else if(left >= 2 && line[0] == 'f' && is_space(line[1])) {
+      parser.cursor += 2;
+      parse_face(parser, mesh);
+    }
+    else if(left >= 2 && (line[0] == 'o' || line[0] == 'g') && is_space(line[1])) {
+      parser.cursor += 2;
+      parse_name(parser);
+      begin_submesh(parser, mesh);
+    }
+    else if(left >= 7 && std::strncmp(line, "usemtl", 6) == 0 && is_space(line[6])) {
+      parser.cursor += 7;
+      parse_name(parser);
+      begin_submesh(parser, mesh);
+    }
+
+    // Comments, materials, smoothing groups and whatever else is left are ignored
+    skip_line(parser);
+  }
+
+  finish_submeshes(mesh);
+
+  // Nothing to shade with otherwise
+  if(parser.normals.empty() && !mesh.indices.empty()) {
+    mesh_compute_normals(mesh.vertices, mesh.indices, NORMAL_WEIGHT_ANGLE);
+  }
+
+  // Without UVs, there is no frame for a normal map to follow
+  if(!parser.uvs.empty() && !mesh.indices.empty()) {
+    mesh_compute_tangents(mesh.vertices, mesh.indices, mesh.tangents);
+  }
+
+  return !mesh.indices.empty();
+}
+// ObjMesh functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vertex.h"
+#include "mesh_file.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// ObjMesh
+struct ObjMesh {
+  std::vector<Vertex> vertices; 
+  std::vector<nikol::u32> indices;
+
+  // One per vertex (see `mesh_compute_tangents`), or none if the file has no UVs
+  std::vector<glm::vec4> tangents;
+
+  // One submesh for every `o`, `g` or `usemtl` that actually has faces under it
+  std::vector<MeshFileSubmesh> submeshes;
+};
+// ObjMesh
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// ObjMesh functions
+
+// Parse a Wavefront OBJ file. Polygons are triangulated as fans and identical 
+// position/uv/normal combinations share a single vertex. Files without any normals get 
+// angle-weighted ones (see `mesh_compute_normals`) and files with UVs get tangents. The text given to 
+// `obj_import_from_memory` has to be null-terminated.
+bool obj_import(const char* path, ObjMesh& mesh);
+bool obj_import_from_memory(const char* text, const nikol::sizei size, ObjMesh& mesh);
+// ObjMesh functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,333 @@
+#include "occlusion_culling.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define OCCLUSION_SIMD_SSE
+#endif
+
+// Rows get rasterized 4 pixels at a time without ever crossing into another tile
+static_assert((OCCLUSION_TILE_WIDTH % 4) == 0, "OCCLUSION_TILE_WIDTH has to be a multiple of 4");
+static_assert((OCCLUSION_WIDTH % OCCLUSION_TILE_WIDTH) == 0 && (OCCLUSION_HEIGHT % OCCLUSION_TILE_HEIGHT) == 0, "The tiles have to cover the whole buffer");
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Anything with a `w` below this is treated as crossing the near plane
+const nikol::f32 NEAR_W_EPSILON = 1e-5f;
+
+const nikol::u32 TEST_BATCH_SIZE = 256;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static glm::vec3 to_screen(const glm::vec4& clip) {
+  nikol::f32 inv_w = 1.0f / clip.w;
+
+  return glm::vec3((clip.x * inv_w * 0.5f + 0.5f) * OCCLUSION_WIDTH,
+                   (clip.y * inv_w * 0.5f + 0.5f) * OCCLUSION_HEIGHT,
+                   clip.z * inv_w * 0.5f + 0.5f);
+}
+
+static glm::vec3 edge_function(const glm::vec3& a, const glm::vec3& b) {
+  nikol::f32 ea = a.y - b.y;
+  nikol::f32 eb = b.x - a.x;
+
+  return glm::vec3(ea, eb, -(ea * a.x + eb * a.y));
+}
+
+static bool setup_triangle(OcclusionTriangle& tri, glm::vec3 p0, glm::vec3 p1, glm::vec3 p2) {
+  nikol::f32 area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+  if(std::abs(area) < 1e-6f) {
+    return false;
+  }
+
+  // Both sides get rasterized (a wall hides things from either side), so everything is made counter-clockwise
+  if(area < 0.0f) {
+    std::swap(p1, p2);
+    area = -area;
+  }
+
+  // The pixels that can be entirely inside
+  tri.min_x = glm::max((nikol::i32)std::ceil(glm::min(p0.x, glm::min(p1.x, p2.x))), 0);
+  tri.min_y = glm::max((nikol::i32)std::ceil(glm::min(p0.y, glm::min(p1.y, p2.y))), 0);
+  tri.max_x = glm::min((nikol::i32)std::floor(glm::max(p0.x, glm::max(p1.x, p2.x))) - 1, (nikol::i32)OCCLUSION_WIDTH - 1);
+  tri.max_y = glm::min((nikol::i32)std::floor(glm::max(p0.y, glm::max(p1.y, p2.y))) - 1, (nikol::i32)OCCLUSION_HEIGHT - 1);
+  if(tri.min_x > tri.max_x || tri.min_y > tri.max_y) {
+    return false;
+  }
+
+  // Inner conservative: an edge only passes a pixel whose every corner is inside it. Tested at 
+  // the center, that means being at least half the pixel's extent along the edge's normal away.
+  tri.edges[0] = edge_function(p0, p1);
+  tri.edges[1] = edge_function(p1, p2);
+  tri.edges[2] = edge_function(p2, p0);
+
+  for(auto& edge : tri.edges) {
+    edge.z -= 0.5f * (std::abs(edge.x) + std::abs(edge.y));
+  }
+
+  // The farthest depth over the pixel instead of the one at its center, the pixel being inside the triangle
+  nikol::f32 dz1 = p1.z - p0.z;
+  nikol::f32 dz2 = p2.z - p0.z;
+  nikol::f32 a   = (dz1 * (p2.y - p0.y) - dz2 * (p1.y - p0.y)) / area;
+  nikol::f32 b   = (dz2 * (p1.x - p0.x) - dz1 * (p2.x - p0.x)) / area;
+  tri.depth      = glm::vec3(a, b, p0.z - a * p0.x - b * p0.y + 0.5f * (std::abs(a) + std::abs(b)));
+
+  return true;
+}
+
+static void rasterize_triangle(nikol::f32* depth, const OcclusionTriangle& tri, const nikol::i32 tile_x, const nikol::i32 tile_y) {
+  nikol::i32 tile_max_x = tile_x + (nikol::i32)OCCLUSION_TILE_WIDTH - 1;
+  nikol::i32 tile_max_y = tile_y + (nikol::i32)OCCLUSION_TILE_HEIGHT - 1;
+
+  // Starting on a group of 4, which is fine since the edges reject whatever is outside anyway
+  nikol::i32 x0 = glm::max(tri.min_x, tile_x) & ~3;
+  nikol::i32 x1 = glm::min(tri.max_x, tile_max_x);
+  nikol::i32 y0 = glm::max(tri.min_y, tile_y);
+  nikol::i32 y1 = glm::min(tri.max_y, tile_max_y);
+
+#if defined(OCCLUSION_SIMD_SSE)
+  __m128 zero  = _mm_setzero_ps();
+  __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  __m128 px0   = _mm_add_ps(_mm_set1_ps((nikol::f32)x0), lanes);
+
+  __m128 ea[3], eb[3], ec[3], step[3];
+  for(int i = 0; i < 3; i++) {
+    ea[i]   = _mm_set1_ps(tri.edges[i].x);
+    eb[i]   = _mm_set1_ps(tri.edges[i].y);
+    ec[i]   = _mm_set1_ps(tri.edges[i].z);
+    step[i] = _mm_set1_ps(tri.edges[i].x * 4.0f);
+  }
+
+  __m128 za     = _mm_set1_ps(tri.depth.x);
+  __m128 zb     = _mm_set1_ps(tri.depth.y);
+  __m128 zc     = _mm_set1_ps(tri.depth.z);
+  __m128 z_step = _mm_set1_ps(tri.depth.x * 4.0f);
+
+  for(nikol::i32 y = y0; y <= y1; y++) {
+    __m128 py = _mm_set1_ps((nikol::f32)y + 0.5f);
+
+    __m128 e0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ea[0], px0), _mm_mul_ps(eb[0], py)), ec[0]);
+    __m128 e1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ea[1], px0), _mm_mul_ps(eb[1], py)), ec[1]);
+    __m128 e2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ea[2], px0), _mm_mul_ps(eb[2], py)), ec[2]);
+    __m128 z  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(za, px0), _mm_mul_ps(zb, py)), zc);
+
+    nikol::f32* row = &depth[y * OCCLUSION_WIDTH];
+
+    for(nikol::i32 x = x0; x <= x1; x += 4) {
+      __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+
+      if(_mm_movemask_ps(inside)) {
+        __m128 old     = _mm_loadu_ps(&row[x]);
+        __m128 nearest = _mm_min_ps(old, z);
+        _mm_storeu_ps(&row[x], _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+      }
+
+      e0 = _mm_add_ps(e0, step[0]);
+      e1 = _mm_add_ps(e1, step[1]);
+      e2 = _mm_add_ps(e2, step[2]);
+      z  = _mm_add_ps(z, z_step);
+    }
+  }
+#else
+  for(nikol::i32 y = y0; y <= y1; y++) {
+    nikol::f32 py   = (nikol::f32)y + 0.5f;
+    nikol::f32* row = &depth[y * OCCLUSION_WIDTH];
+
+    for(nikol::i32 x = x0; x <= x1; x++) {
+      nikol::f32 px = (nikol::f32)x + 0.5f;
+
+      bool inside = true;
+      for(auto& edge : tri.edges) {
+        inside = inside && (edge.x * px + edge.y * py + edge.z) >= 0.0f;
+      }
+
+      if(inside) {
+        row[x] = glm::min(row[x], tri.depth.x * px + tri.depth.y * py + tri.depth.z);
+      }
+    }
+  }
+#endif
+}
+
+static bool is_rect_visible(const nikol::f32* depth, const nikol::i32 x0, const nikol::i32 y0, const nikol::i32 x1, const nikol::i32 y1, const nikol::f32 nearest) {
+#if defined(OCCLUSION_SIMD_SSE)
+  __m128 near_z = _mm_set1_ps(nearest);
+  __m128 first  = _mm_set1_ps((nikol::f32)x0);
+  __m128 last   = _mm_set1_ps((nikol::f32)x1);
+
+  for(nikol::i32 y = y0; y <= y1; y++) {
+    const nikol::f32* row = &depth[y * OCCLUSION_WIDTH];
+
+    for(nikol::i32 x = x0 & ~3; x <= x1; x += 4) {
+      __m128 lanes    = _mm_setr_ps((nikol::f32)x, (nikol::f32)(x + 1), (nikol::f32)(x + 2), (nikol::f32)(x + 3));
+      __m128 in_range = _mm_and_ps(_mm_cmpge_ps(lanes, first), _mm_cmple_ps(lanes, last));
+
+      // Any pixel at least as far as the box means it can be seen through there
+      __m128 open = _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&row[x]), near_z), in_range);
+      if(_mm_movemask_ps(open)) {
+        return true;
+      }
+    }
+  }
+#else
+  for(nikol::i32 y = y0; y <= y1; y++) {
+    const nikol::f32* row = &depth[y * OCCLUSION_WIDTH];
+
+    for(nikol::i32 x = x0; x <= x1; x++) {
+      if(row[x] >= nearest) {
+        return true;
+      }
+    }
+  }
+#endif
+
+  return false;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OccluderMesh functions
+void occluder_mesh_init(OccluderMesh& occluder, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  occluder.positions.resize(vertices.size());
+  for(nikol::sizei i = 0; i < vertices.size(); i++) {
+    occluder.positions[i] = vertices[i].position;
+  }
+
+  occluder.indices = indices;
+}
+// OccluderMesh functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OcclusionBuffer functions
+void occlusion_buffer_init(OcclusionBuffer& buffer) {
+  buffer.view_projection = glm::mat4(1.0f);
+  buffer.stats           = {};
+
+  buffer.depth.assign(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 1.0f);
+  buffer.triangles.clear();
+
+  for(auto& tile : buffer.tile_triangles) {
+    tile.clear();
+  }
+}
+
+void occlusion_buffer_begin(OcclusionBuffer& buffer, const glm::mat4& view_projection) {
+  buffer.view_projection = view_projection;
+  buffer.stats           = {};
+
+  buffer.triangles.clear();
+  for(auto& tile : buffer.tile_triangles) {
+    tile.clear();
+  }
+}
+
+void occlusion_buffer_add_occluder(OcclusionBuffer& buffer, const OccluderMesh& occluder, const glm::mat4& model) {
+  glm::mat4 mvp = buffer.view_projection * model;
+  buffer.stats.occluders++;
+
+  for(nikol::sizei i = 0; i + 2 < occluder.indices.size(); i += 3) {
+    glm::vec4 c0 = mvp * glm::vec4(occluder.positions[occluder.indices[i + 0]], 1.0f);
+    glm::vec4 c1 = mvp * glm::vec4(occluder.positions[occluder.indices[i + 1]], 1.0f);
+    glm::vec4 c2 = mvp * glm::vec4(occluder.positions[occluder.indices[i + 2]], 1.0f);
+
+    // No clipping. Dropping an occluder triangle can only ever hide less.
+    if(c0.w < NEAR_W_EPSILON || c1.w < NEAR_W_EPSILON || c2.w < NEAR_W_EPSILON) {
+      buffer.stats.triangles_clipped++;
+      continue;
+    }
+
+    OcclusionTriangle tri;
+    if(!setup_triangle(tri, to_screen(c0), to_screen(c1), to_screen(c2))) {
+      buffer.stats.triangles_offscreen++;
+      continue;
+    }
+
+    nikol::u32 index = (nikol::u32)buffer.triangles.size();
+    buffer.triangles.push_back(tri);
+    buffer.stats.triangles_setup++;
+
+    for(nikol::i32 ty = tri.min_y / OCCLUSION_TILE_HEIGHT; ty <= tri.max_y / (nikol::i32)OCCLUSION_TILE_HEIGHT; ty++) {
+      for(nikol::i32 tx = tri.min_x / OCCLUSION_TILE_WIDTH; tx <= tri.max_x / (nikol::i32)OCCLUSION_TILE_WIDTH; tx++) {
+        buffer.tile_triangles[ty * OCCLUSION_TILES_X + tx].push_back(index);
+      }
+    }
+  }
+}
+
+void occlusion_buffer_rasterize(OcclusionBuffer& buffer) {
+  // Every tile only ever touches its own pixels, so they need no synchronization at all
+  job_system_parallel_for(OCCLUSION_TILES_COUNT, 1, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 tile = start; tile < end; tile++) {
+      nikol::i32 tile_x = (nikol::i32)((tile % OCCLUSION_TILES_X) * OCCLUSION_TILE_WIDTH);
+      nikol::i32 tile_y = (nikol::i32)((tile / OCCLUSION_TILES_X) * OCCLUSION_TILE_HEIGHT);
+
+      for(nikol::u32 y = 0; y < OCCLUSION_TILE_HEIGHT; y++) {
+        nikol::f32* row = &buffer.depth[(tile_y + y) * OCCLUSION_WIDTH + tile_x];
+        std::fill(row, row + OCCLUSION_TILE_WIDTH, 1.0f);
+      }
+
+      for(auto index : buffer.tile_triangles[tile]) {
+        rasterize_triangle(buffer.depth.data(), buffer.triangles[index], tile_x, tile_y);
+      }
+    }
+  });
+}
+
+bool occlusion_buffer_test_aabb(const OcclusionBuffer& buffer, const glm::vec3& min, const glm::vec3& max) {
+  glm::vec2 screen_min = glm::vec2( 1e30f);
+  glm::vec2 screen_max = glm::vec2(-1e30f);
+  nikol::f32 nearest   = 1.0f;
+
+  for(nikol::u32 i = 0; i < 8; i++) {
+    glm::vec3 corner = glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+    glm::vec4 clip   = buffer.view_projection * glm::vec4(corner, 1.0f);
+
+    if(clip.w < NEAR_W_EPSILON) {
+      return true;
+    }
+
+    glm::vec3 screen = to_screen(clip);
+    screen_min       = glm::min(screen_min, glm::vec2(screen.x, screen.y));
+    screen_max       = glm::max(screen_max, glm::vec2(screen.x, screen.y));
+    nearest          = glm::min(nearest, screen.z);
+  }
+
+  // Every pixel the box touches, even partly
+  nikol::i32 x0 = glm::max((nikol::i32)std::floor(screen_min.x), 0);
+  nikol::i32 y0 = glm::max((nikol::i32)std::floor(screen_min.y), 0);
+  nikol::i32 x1 = glm::min((nikol::i32)std::floor(screen_max.x), (nikol::i32)OCCLUSION_WIDTH - 1);
+  nikol::i32 y1 = glm::min((nikol::i32)std::floor(screen_max.y), (nikol::i32)OCCLUSION_HEIGHT - 1);
+  if(x0 > x1 || y0 > y1) {
+    return true;
+  }
+
+  return is_rect_visible(buffer.depth.data(), x0, y0, x1, y1, nearest);
+}
+
+void occlusion_buffer_test_batch(OcclusionBuffer& buffer, const glm::vec3* mins, const glm::vec3* maxs, const nikol::u32 count, nikol::u8* visible) {
+  job_system_parallel_for(count, TEST_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      visible[i] = occlusion_buffer_test_aabb(buffer, mins[i], maxs[i]);
+    }
+  });
+
+  buffer.stats.tested += count;
+  for(nikol::u32 i = 0; i < count; i++) {
+    buffer.stats.occluded += (visible[i] == 0);
+  }
+}
+// OcclusionBuffer functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The depth buffer is far smaller than the screen. Occluders only cover the pixels they cover
+// entirely, at the farthest depth they have over them, so the low resolution never hides anything
+// that should be visible. Small or thin occluders end up hiding less (or nothing) instead.
+const nikol::u32 OCCLUSION_WIDTH  = 320;
+const nikol::u32 OCCLUSION_HEIGHT = 192;
+
+// Every tile is rasterized by a single job
+const nikol::u32 OCCLUSION_TILE_WIDTH  = 64;
+const nikol::u32 OCCLUSION_TILE_HEIGHT = 32;
+const nikol::u32 OCCLUSION_TILES_X     = OCCLUSION_WIDTH / OCCLUSION_TILE_WIDTH;
+const nikol::u32 OCCLUSION_TILES_Y     = OCCLUSION_HEIGHT / OCCLUSION_TILE_HEIGHT;
+const nikol::u32 OCCLUSION_TILES_COUNT = OCCLUSION_TILES_X * OCCLUSION_TILES_Y;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OccluderMesh
+// The CPU side geometry an occluder gets rasterized with. It is usually a much
+// coarser mesh than the one drawn (a box for a building, say), but it must never
+// stick out of it.
+struct OccluderMesh {
+  std::vector<glm::vec3> positions;
+  std::vector<nikol::u32> indices;
+};
+// OccluderMesh
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OcclusionTriangle
+// A triangle ready to be rasterized: three edge functions and a depth plane, all in pixels and 
+// biased so they can be evaluated at the pixel centers (see `OCCLUSION_WIDTH`)
+struct OcclusionTriangle {
+  glm::vec3 edges[3]; // (a, b, c) with a * x + b * y + c >= 0 if the whole pixel is inside
+  glm::vec3 depth;    // depth = a * x + b * y + c, the farthest over the pixel
+
+  nikol::i32 min_x, min_y, max_x, max_y; // Inclusive, clamped to the buffer
+};
+// OcclusionTriangle
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OcclusionStats
+struct OcclusionStats {
+  nikol::u32 occluders           = 0;
+  nikol::u32 triangles_setup     = 0; // Made it into at least one tile
+  nikol::u32 triangles_clipped   = 0; // Crossed the near plane, so they were skipped
+  nikol::u32 triangles_offscreen = 0; // Degenerate or outside the buffer
+
+  nikol::u32 tested   = 0;
+  nikol::u32 occluded = 0;
+};
+// OcclusionStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OcclusionBuffer
+// A low resolution depth buffer (depth in [0, 1], the far plane being 1) that flagged occluders get
+// rasterized into with SIMD, one tile per job. The bounds of every other draw are then tested
+// against it before anything reaches the GPU.
+//
+// Occluders only ever make the buffer nearer and every test is conservative, so a draw is only ever
+// dropped when it is really hidden.
+struct OcclusionBuffer {
+  glm::mat4 view_projection;
+
+  std::vector<nikol::f32> depth; // Row after row, bottom up
+
+  // The triangles of this frame and the ones overlapping each tile
+  std::vector<OcclusionTriangle> triangles;
+  std::vector<nikol::u32> tile_triangles[OCCLUSION_TILES_COUNT];
+
+  OcclusionStats stats;
+};
+// OcclusionBuffer
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OccluderMesh functions
+void occluder_mesh_init(OccluderMesh& occluder, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices);
+// OccluderMesh functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// OcclusionBuffer functions
+void occlusion_buffer_init(OcclusionBuffer& buffer);
+
+// Clear the buffer and forget every occluder of the last frame
+void occlusion_buffer_begin(OcclusionBuffer& buffer, const glm::mat4& view_projection);
+
+// Transform and set up the triangles of `occluder` (both sides of them), binning them into the tiles
+void occlusion_buffer_add_occluder(OcclusionBuffer& buffer, const OccluderMesh& occluder, const glm::mat4& model);
+
+// Rasterize every occluder added since `occlusion_buffer_begin`, using the job system
+void occlusion_buffer_rasterize(OcclusionBuffer& buffer);
+
+// Returns `false` only if the (world space) box is hidden behind the occluders.
+// Boxes crossing the near plane or outside the screen are left to the other culling stages.
+// Safe to call from any thread once rasterized.
+bool occlusion_buffer_test_aabb(const OcclusionBuffer& buffer, const glm::vec3& min, const glm::vec3& max);
+
+// Test `count` boxes at once (using the job system), writing 1 into `visible` for every box that might be visible
+void occlusion_buffer_test_batch(OcclusionBuffer& buffer, const glm::vec3* mins, const glm::vec3* maxs, const nikol::u32 count, nikol::u8* visible);
+// OcclusionBuffer functions
+// ----------------------------------------------------------------------------
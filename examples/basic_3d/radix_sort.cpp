@@ -0,0 +1,94 @@
+#include "radix_sort.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+#include <cstring>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// Negative floats have every bit flipped (so the larger magnitudes come first), the others only the sign bit
+static nikol::u32 float_to_key(const nikol::f32 value) {
+  // -0 turns into +0 here, since they have to tie like they compare
+  nikol::f32 zeroed = value + 0.0f;
+
+  nikol::u32 bits;
+  std::memcpy(&bits, &zeroed, sizeof(bits));
+
+  nikol::u32 mask = (nikol::u32)((nikol::i32)bits >> 31) | 0x80000000u;
+  return bits ^ mask;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RadixSort functions
+void radix_sort_floats(RadixSort& sort, const nikol::f32* keys, const nikol::u32 count, const bool descending) {
+  sort.keys.resize(count);
+  sort.keys_temp.resize(count);
+  sort.order.resize(count);
+  sort.order_temp.resize(count);
+  sort.passes = 0;
+
+  // Flipping every bit again turns the order around without breaking the stability
+  nikol::u32 flip = descending ? 0xffffffffu : 0;
+
+  nikol::u32 histograms[RADIX_SORT_PASSES][RADIX_SORT_BUCKETS];
+  std::memset(histograms, 0, sizeof(histograms));
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    nikol::u32 key = float_to_key(keys[i]) ^ flip;
+
+    sort.keys[i]  = key;
+    sort.order[i] = i;
+
+    for(nikol::u32 pass = 0; pass < RADIX_SORT_PASSES; pass++) {
+      histograms[pass][(key >> (pass * RADIX_SORT_BITS)) & (RADIX_SORT_BUCKETS - 1)]++;
+    }
+  }
+
+  nikol::u32* src_keys  = sort.keys.data();
+  nikol::u32* dst_keys  = sort.keys_temp.data();
+  nikol::u32* src_order = sort.order.data();
+  nikol::u32* dst_order = sort.order_temp.data();
+
+  for(nikol::u32 pass = 0; pass < RADIX_SORT_PASSES; pass++) {
+    nikol::u32* histogram = histograms[pass];
+    nikol::u32 shift      = pass * RADIX_SORT_BITS;
+
+    // Every key lands in the same bucket, so this pass would not move anything
+    if(count == 0 || histogram[(src_keys[0] >> shift) & (RADIX_SORT_BUCKETS - 1)] == count) {
+      continue;
+    }
+
+    // The counts turn into where each bucket starts
+    nikol::u32 offset = 0;
+    for(nikol::u32 i = 0; i < RADIX_SORT_BUCKETS; i++) {
+      nikol::u32 bucket_count = histogram[i];
+      histogram[i]            = offset;
+      offset                 += bucket_count;
+    }
+
+    for(nikol::u32 i = 0; i < count; i++) {
+      nikol::u32 key = src_keys[i];
+      nikol::u32 pos = histogram[(key >> shift) & (RADIX_SORT_BUCKETS - 1)]++;
+
+      dst_keys[pos]  = key;
+      dst_order[pos] = src_order[i];
+    }
+
+    std::swap(src_keys, dst_keys);
+    std::swap(src_order, dst_order);
+    sort.passes++;
+  }
+
+  // An odd number of passes leaves the result in the scratch array
+  if(src_order != sort.order.data()) {
+    std::swap(sort.order, sort.order_temp);
+    std::swap(sort.keys, sort.keys_temp);
+  }
+}
+// RadixSort functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Bits of the key sorted by each pass (so 4 passes for 32-bit keys)
+const nikol::u32 RADIX_SORT_BITS    = 8;
+const nikol::u32 RADIX_SORT_BUCKETS = 1 << RADIX_SORT_BITS;
+const nikol::u32 RADIX_SORT_PASSES  = 32 / RADIX_SORT_BITS;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RadixSort
+// A stable LSD radix sort of 32-bit keys, a byte per pass. The floats get flipped into unsigned keys
+// that sort the same way (every bit of the negative ones, only the sign bit of the others), so no
+// two keys ever get compared. The histograms of every pass come out of a single read of the keys, and
+// the passes where all keys share the same byte (the exponent, very often) are skipped.
+//
+// The result is an order of the input indices rather than the sorted keys, so whatever they
+// belong to only gets moved once.
+struct RadixSort {
+  std::vector<nikol::u32> order; // The indices of the keys, from the first to the last after sorting
+
+  // Scratch space
+  std::vector<nikol::u32> keys, keys_temp;
+  std::vector<nikol::u32> order_temp;
+
+  nikol::u32 passes = 0; // Actually run by the last sort
+};
+// RadixSort
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// RadixSort functions
+
+// Fill `sort.order` with `count` indices into `keys`, from the smallest key to the largest (or the other
+// way around with `descending`). Equal keys keep their order either way. NaNs are not supported.
+void radix_sort_floats(RadixSort& sort, const nikol::f32* keys, const nikol::u32 count, const bool descending = false);
+// RadixSort functions
+// ----------------------------------------------------------------------------
@@ -3,11 +3,39 @@
 #include "material.h"
 #include "trasform.h"
 #include "camera.h"
-#include "shaders.h"
+#include "state_cache.h"
+#include "mesh_lod.h"
+#include "geometry_pool.h"
+#include "frame_graph.h"
+#include "command_buffer.h"
+#include "linear_allocator.h"
+#include "clustered_lighting.h"
+#include "occlusion_culling.h"
+#include "static_batch.h"
+#include "indirect_draw.h"
+#include "terrain.h"
+#include "voxel.h"
+#include "radix_sort.h"
+#include "sorted_mesh.h"
+#include "skinning.h"
+#include "job_system.h"
 
 #include <nikol/nikol_core.hpp>
 
 #include <vector>
+#include <algorithm>
+#include <new>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Draws prepared by one job
+const nikol::u32 PREPARE_BATCH_SIZE = 128;
+
+// State batches recorded into one command buffer (and so by one job)
+const nikol::u32 RECORD_BATCH_SIZE = 32;
+// Consts
+// ----------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------
 // Vertex3D 
@@ -19,30 +47,382 @@ struct Vertex3D {
 // Vertex3D 
 // ----------------------------------------------------------------------------
 
+// ----------------------------------------------------------------------------
+// DrawCall 
+struct DrawCall {
+  Mesh* mesh; 
+  Material* material;
+  nikol::u32 lod;
+
+  glm::mat4 model;
+
+  // Set to draw these indices instead of the LOD's (streamed into LOD 0's index buffer)
+  const nikol::u32* indices = nullptr;
+  nikol::u32 indices_count  = 0;
+
+  // Set for the nodes of a terrain, which all share the same patches (and so the mesh's bounds mean nothing)
+  const TerrainNode* terrain_node = nullptr;
+
+  // Set for the meshes skinned on the GPU (see `render_skinned_mesh`)
+  const glm::mat4* palette  = nullptr;
+  nikol::u32 palette_joints = 0;
+
+  // The model space bounding sphere (radius in `w`). Left negative, it gets the mesh's own. 
+  // Skinned meshes set it, since every pose of a shared mesh has different bounds.
+  glm::vec4 bounds = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+};
+// DrawCall 
+// ----------------------------------------------------------------------------
+
 // ----------------------------------------------------------------------------
 // Renderer 
 struct Renderer {
+  nikol::Window* window  = nullptr;
   nikol::GfxContext* gfx = nullptr; 
+  StateCache state_cache;
+
+  // The shader permutations and the parameters of every material
+  MaterialSystem materials;
+
+  BaseMaterial* default_base = nullptr; 
+  Material* default_material = nullptr;
 
-  nikol::GfxShader* default_shader = nullptr;
   nikol::GfxTexture* white_texture = nullptr;
-  Material* default_material       = nullptr;
 
-  std::vector<Mesh*> draw_calls;
+  std::vector<DrawCall> draw_calls;
+  RendererStats stats;
+
+  // Drawn after the opaque draws, back to front by the view space depth of their centers
+  std::vector<DrawCall> translucent_draws;
+  std::vector<nikol::f32> translucent_depths;
+  RadixSort translucent_sort;
+
+  // One allocator per job system thread, and a command buffer per batch of draws
+  std::vector<LinearAllocator> thread_memory;
+  std::vector<CommandBuffer> command_buffers;
+  CommandStats command_stats;
+
+  // The draws of the frame as indirect arguments, with their per-draw data (and palettes) indexed by draw ID
+  std::vector<IndirectDraw> indirect_draws;
+  std::vector<DrawData> draw_data;
+  std::vector<DrawBlock> draw_blocks;
+  std::vector<nikol::GfxBuffer*> draw_index_buffers; // Only looked up for the pooled draws
+  IndirectDrawList indirect;
+
+  // Rebuilt every frame, but only recompiled when the passes change
+  FrameGraph frame_graph;
+  FrameGraphResource backbuffer;
+  FrameGraphPass forward_pass;
+
+  // The point lights of this frame, binned right before the forward pass
+  ClusteredLighting lighting;
+  std::vector<PointLight> lights;
+  glm::vec3 ambient;
+  bool is_lighting_overflowed = false; // Only warned about when it changes
 
+  // Draws hidden behind the occluders never make it to the forward pass
+  OcclusionBuffer occlusion;
+  bool is_occlusion_enabled;
+  std::vector<glm::vec3> draw_mins, draw_maxs;
+  std::vector<nikol::u8> draw_visible;
+
+  // The CPU skinned meshes streamed this frame. Each has a single vertex buffer, so only one pose per frame.
+  std::vector<const SkinnedMesh*> streamed_meshes;
+
+  glm::mat4 view;
   glm::mat4 view_proj;
+
+  // Needed to pick the LODs
+  glm::vec3 eye;
+  nikol::f32 proj_scale;
 };
 // Renderer 
 // ----------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------
 // Private functions
-static const char* get_default_shader() {
-#ifdef NIKOL_GFX_CONTEXT_OPENGL
-  return default_shader_glsl();
-#else 
-  return default_shader_hlsl();
-#endif
+static nikol::u32 get_draw_indices_count(const DrawCall& draw) {
+  return draw.indices ? draw.indices_count : draw.mesh->lods[draw.lod].indices_count;
+}
+
+static bool is_translucent(const DrawCall& draw) {
+  return (draw.material->base->features & MATERIAL_FEATURE_TRANSLUCENT) != 0;
+}
+
+// The opaque draws can go in any order, but the translucent ones get sorted by `center` (in world space)
+static void push_draw(Renderer* renderer, DrawCall draw, const glm::vec3& center) {
+  if(draw.bounds.w < 0.0f) {
+    draw.bounds = glm::vec4(draw.mesh->bounds_center, draw.mesh->bounds_radius);
+  }
+
+  if(!is_translucent(draw)) {
+    renderer->draw_calls.push_back(draw);
+    return;
+  }
+
+  glm::vec4 view_pos = renderer->view * glm::vec4(center, 1.0f);
+
+  renderer->translucent_draws.push_back(draw);
+  renderer->translucent_depths.push_back(-view_pos.z);
+  renderer->stats.draws_translucent++;
+}
+
+// Right after the opaque draws, the furthest first. The culling and the forward pass both keep that order.
+static void sort_translucent_draws(Renderer* renderer) {
+  nikol::u32 count = (nikol::u32)renderer->translucent_draws.size();
+  radix_sort_floats(renderer->translucent_sort, renderer->translucent_depths.data(), count, true);
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    renderer->draw_calls.push_back(renderer->translucent_draws[renderer->translucent_sort.order[i]]);
+  }
+}
+
+static void cull_occluded_draws(Renderer* renderer) {
+  OcclusionBuffer& occlusion = renderer->occlusion;
+  occlusion_buffer_begin(occlusion, renderer->view_proj);
+
+  for(auto& draw : renderer->draw_calls) {
+    if(draw.mesh->occluder) {
+      occlusion_buffer_add_occluder(occlusion, *draw.mesh->occluder, draw.model);
+    }
+  }
+
+  // Nothing can hide anything then
+  if(occlusion.stats.occluders == 0) {
+    return;
+  }
+
+  occlusion_buffer_rasterize(occlusion);
+
+  // The world space box around every bounding sphere or terrain node (the occluders themselves are always kept)
+  nikol::u32 draws_count = (nikol::u32)renderer->draw_calls.size();
+  renderer->draw_mins.resize(draws_count);
+  renderer->draw_maxs.resize(draws_count);
+  renderer->draw_visible.resize(draws_count);
+
+  for(nikol::u32 i = 0; i < draws_count; i++) {
+    const DrawCall& draw   = renderer->draw_calls[i];
+    const glm::mat4& model = draw.model;
+
+    if(draw.terrain_node) {
+      renderer->draw_mins[i] = draw.terrain_node->bounds_min;
+      renderer->draw_maxs[i] = draw.terrain_node->bounds_max;
+      continue;
+    }
+
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(draw.bounds), 1.0f));
+    nikol::f32 scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    glm::vec3 extent = glm::vec3(draw.bounds.w * scale);
+
+    renderer->draw_mins[i] = center - extent;
+    renderer->draw_maxs[i] = center + extent;
+  }
+
+  occlusion_buffer_test_batch(occlusion, renderer->draw_mins.data(), renderer->draw_maxs.data(), draws_count, renderer->draw_visible.data());
+
+  // Keeping the order, since it is the order of the command buffers as well
+  nikol::u32 kept = 0;
+  for(nikol::u32 i = 0; i < draws_count; i++) {
+    const DrawCall& draw = renderer->draw_calls[i];
+
+    if(renderer->draw_visible[i] || draw.mesh->occluder) {
+      renderer->draw_calls[kept++] = draw;
+      continue;
+    }
+
+    renderer->stats.draws_occluded      += 1;
+    renderer->stats.triangles_submitted -= get_draw_indices_count(draw) / 3;
+  }
+
+  renderer->draw_calls.resize(kept);
+}
+
+// The frustum planes, straight out of the rows of the view projection (Gribb/Hartmann)
+static void get_frustum_planes(const glm::mat4& vp, glm::vec4* planes) {
+  glm::vec4 row0 = glm::vec4(vp[0][0], vp[1][0], vp[2][0], vp[3][0]);
+  glm::vec4 row1 = glm::vec4(vp[0][1], vp[1][1], vp[2][1], vp[3][1]);
+  glm::vec4 row2 = glm::vec4(vp[0][2], vp[1][2], vp[2][2], vp[3][2]);
+  glm::vec4 row3 = glm::vec4(vp[0][3], vp[1][3], vp[2][3], vp[3][3]);
+
+  planes[0] = row3 + row0;
+  planes[1] = row3 - row0;
+  planes[2] = row3 + row1;
+  planes[3] = row3 - row1;
+  planes[4] = row3 + row2;
+  planes[5] = row3 - row2;
+}
+
+static bool is_box_visible(const glm::vec4* planes, const glm::vec3& min, const glm::vec3& max) {
+  for(int i = 0; i < 6; i++) {
+    const glm::vec4& plane = planes[i];
+
+    // The corner furthest along the plane's normal
+    glm::vec3 corner = glm::vec3(plane.x >= 0.0f ? max.x : min.x,
+                                 plane.y >= 0.0f ? max.y : min.y,
+                                 plane.z >= 0.0f ? max.z : min.z);
+
+    if(glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void prepare_draw(Renderer* renderer, const DrawCall& draw, IndirectDraw& out, DrawData& data, DrawBlock& block, nikol::GfxBuffer*& index_buffer) {
+  Mesh* mesh    = draw.mesh;
+  Material* mat = draw.material;
+
+  // Every LOD shares the vertex buffer, so only the index buffer changes
+  out.state.pipe          = mesh->pipe;
+  out.state.desc          = &mesh->pipe_desc;
+  out.state.shader        = material_get_shader(mat, mesh->vertex_format);
+  out.state.texture       = mat->diffuse;
+  out.state.index_buffer  = mesh->lod_index_buffers[draw.lod];
+  out.state.index_source  = draw.indices;
+  out.state.index_buffers = nullptr;
+
+  // Pooled meshes each carry a copy of the pool's desc, so they get keyed on the pool's own instead. Their
+  // index buffers already point into the pool's vertices, so every one of them can go in the same batch.
+  index_buffer = out.state.index_buffer;
+  if(mesh->pool && !draw.indices) {
+    out.state.pipe          = mesh->pool->pipe;
+    out.state.desc          = &mesh->pool->pipe_desc;
+    out.state.index_buffer  = nullptr;
+    out.state.index_buffers = renderer->draw_index_buffers.data();
+  }
+
+  out.args.indices_count   = get_draw_indices_count(draw);
+  out.args.instances_count = 1;
+  out.args.first_index     = 0;
+  out.args.base_vertex     = 0;
+  out.args.base_instance   = 0;
+
+  // Quantized positions have to go back to object space first, while the normals already are in there
+  glm::mat4 model_view = renderer->view * draw.model;
+
+  data                 = {};
+  data.view_projection = renderer->view_proj * draw.model * mesh->dequantize;
+  data.model_view      = model_view * mesh->dequantize;
+  data.normal_matrix   = glm::transpose(glm::inverse(model_view));
+  data.material_index  = mat->slot;
+
+  if(draw.terrain_node) {
+    data.terrain_node  = draw.terrain_node->node;
+    data.terrain_morph = draw.terrain_node->morph;
+  }
+
+  block = DrawBlock{draw.palette, draw.palette_joints * sizeof(glm::mat4)};
+}
+
+static void record_batch(Renderer* renderer, CommandBuffer& cmd, const IndirectBatch& batch) {
+  const IndirectDrawState& state = batch.state;
+  const DrawIndirectArgs* args   = &renderer->indirect.args[batch.first_args];
+
+  command_buffer_apply_pipeline(cmd, 
+                                state.pipe, 
+                                state.desc, 
+                                state.shader, 
+                                state.texture, 
+                                state.index_buffers ? state.index_buffers[args[0].base_instance] : state.index_buffer, 
+                                args[0].indices_count);
+  command_buffer_draw_indirect(cmd, 
+                               state, 
+                               args, 
+                               batch.args_count, 
+                               renderer->materials.draw_buffer, 
+                               renderer->draw_data.data(), 
+                               sizeof(DrawData), 
+                               renderer->materials.palette_buffer, 
+                               renderer->draw_blocks.data());
+}
+
+// The shader goes without whatever did not fit. Once when it starts and once when it stops, rather than every frame.
+static void report_lighting_overflow(Renderer* renderer) {
+  const ClusterStats& stats = renderer->lighting.stats;
+  bool is_overflowed        = stats.lights_dropped > 0 || stats.indices_dropped > 0 || stats.clusters_overflowed > 0;
+
+  if(is_overflowed == renderer->is_lighting_overflowed) {
+    return;
+  }
+
+  renderer->is_lighting_overflowed = is_overflowed;
+  if(!is_overflowed) {
+    NIKOL_LOG_INFO("Every visible light fits in the cluster buffers again");
+    return;
+  }
+
+  NIKOL_LOG_WARN("Too many lights for the cluster buffers: %u of %u visible lights dropped (the furthest), " 
+                 "cluster lists cut to %u lights (%u indices dropped), %u clusters past %u lights", 
+                 stats.lights_dropped, 
+                 stats.lights_visible, 
+                 stats.cluster_lights_cap, 
+                 stats.indices_dropped, 
+                 stats.clusters_overflowed, 
+                 CLUSTER_LIGHTS_MAX);
+}
+
+static void execute_forward_pass(void* user_data) {
+  Renderer* renderer = (Renderer*)user_data;
+
+  // Whatever parameters changed this frame go up in one go
+  material_system_flush(renderer->materials);
+
+  clustered_lighting_bin(renderer->lighting, renderer->lights.data(), (nikol::u32)renderer->lights.size(), renderer->view);
+  clustered_lighting_upload(renderer->lighting, renderer->ambient);
+  report_lighting_overflow(renderer);
+
+  for(auto& memory : renderer->thread_memory) {
+    linear_allocator_reset(memory);
+  }
+
+  // Recording in parallel. Only the shader permutations are created here if they are 
+  // missing, so they get looked up (and compiled) on this thread first.
+  for(auto& draw : renderer->draw_calls) {
+    material_get_shader(draw.material, draw.mesh->vertex_format);
+  }
+
+  // The state, arguments and per-draw data of every draw (the matrices being most of the work)
+  nikol::u32 draws_count = (nikol::u32)renderer->draw_calls.size();
+  renderer->indirect_draws.resize(draws_count);
+  renderer->draw_data.resize(draws_count);
+  renderer->draw_blocks.resize(draws_count);
+  renderer->draw_index_buffers.resize(draws_count);
+
+  job_system_parallel_for(draws_count, PREPARE_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      prepare_draw(renderer, renderer->draw_calls[i], renderer->indirect_draws[i], renderer->draw_data[i], renderer->draw_blocks[i], renderer->draw_index_buffers[i]);
+    }
+  });
+
+  // The opaque draws get grouped by state, so every batch is a single apply and a single indirect 
+  // draw. The translucent ones come last and have to stay in order for the blending to be right.
+  auto first_translucent = std::partition_point(renderer->draw_calls.begin(), renderer->draw_calls.end(), [](const DrawCall& draw) {
+    return !is_translucent(draw);
+  });
+  nikol::u32 opaque_count = (nikol::u32)(first_translucent - renderer->draw_calls.begin());
+
+  indirect_draw_list_build(renderer->indirect, renderer->indirect_draws.data(), draws_count, opaque_count);
+
+  nikol::u32 batches_count = (nikol::u32)renderer->indirect.batches.size();
+  nikol::u32 buffers_count = (batches_count + RECORD_BATCH_SIZE - 1) / RECORD_BATCH_SIZE;
+  renderer->command_buffers.resize(buffers_count);
+
+  job_system_parallel_for(buffers_count, 1, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      CommandBuffer& cmd = renderer->command_buffers[i];
+      command_buffer_begin(cmd, renderer->thread_memory[thread_index], i);
+
+      nikol::u32 first = i * RECORD_BATCH_SIZE;
+      nikol::u32 last  = glm::min(first + RECORD_BATCH_SIZE, batches_count);
+      for(nikol::u32 j = first; j < last; j++) {
+        record_batch(renderer, cmd, renderer->indirect.batches[j]);
+      }
+    }
+  });
+
+  // The buffers go in order of their batches, no matter which thread recorded them
+  renderer->command_stats = command_buffers_submit(renderer->command_buffers.data(), buffers_count, renderer->gfx, renderer->state_cache);
 }
 // Private functions
 // ----------------------------------------------------------------------------
@@ -50,18 +430,32 @@ static const char* get_default_shader() {
 // ----------------------------------------------------------------------------
 // Renderer functions
 Renderer* renderer_create(nikol::Window* window) {
-  Renderer* renderer = (Renderer*)nikol::memory_allocate(sizeof(Renderer)); 
+  // Constructed in place, since the renderer holds containers of its own
+  Renderer* renderer = new (nikol::memory_allocate(sizeof(Renderer))) Renderer();
 
   // Creating a graphics context
   nikol::GfxContextDesc gfx_desc = {
     .window = window,
-    .states = nikol::GFX_STATE_DEPTH | nikol::GFX_STATE_STENCIL,
+    .states = nikol::GFX_STATE_DEPTH | nikol::GFX_STATE_STENCIL | nikol::GFX_STATE_BLEND,
   };
-  renderer->gfx = nikol::gfx_context_init(gfx_desc);
+  renderer->window = window;
+  renderer->gfx    = nikol::gfx_context_init(gfx_desc);
   NIKOL_ASSERT(renderer->gfx, "Could not create a graphics context");
 
-  // Creating a default shader 
-  renderer->default_shader = nikol::gfx_shader_create(renderer->gfx, get_default_shader());
+  // State cache init
+  state_cache_init(renderer->state_cache, renderer->gfx);
+
+  // Material system init
+  material_system_init(renderer->materials, renderer->gfx);
+
+  // Lighting init (the buffers go at bindings 3 to 6 of the lit permutations)
+  clustered_lighting_init(renderer->lighting, renderer->gfx);
+  renderer->ambient = glm::vec3(1.0f);
+
+  material_system_attach_uniform(renderer->materials, nikol::GFX_SHADER_PIXEL, renderer->lighting.params_buffer);
+  material_system_attach_uniform(renderer->materials, nikol::GFX_SHADER_PIXEL, renderer->lighting.lights_buffer);
+  material_system_attach_uniform(renderer->materials, nikol::GFX_SHADER_PIXEL, renderer->lighting.ranges_buffer);
+  material_system_attach_uniform(renderer->materials, nikol::GFX_SHADER_PIXEL, renderer->lighting.indices_buffer);
 
   // Creating a white texture 
   nikol::u32 pixels = 0xffffffff; 
@@ -76,12 +470,23 @@ Renderer* renderer_create(nikol::Window* window) {
   };
   renderer->white_texture = nikol::gfx_texture_create(renderer->gfx, tex_desc);
 
-  // Creating a default material
-  renderer->default_material = material_create(renderer->gfx, renderer->default_shader, renderer->white_texture);
+  // Creating the default material (the other vertex formats get their permutations on first use)
+  renderer->default_base     = base_material_create(renderer->materials, MATERIAL_FEATURE_LIT);
+  renderer->default_material = material_create(renderer->default_base, renderer->white_texture);
 
   // Give some initial space 
   renderer->draw_calls.reserve(32);
 
+  // Occlusion culling init
+  occlusion_buffer_init(renderer->occlusion);
+  renderer->is_occlusion_enabled = true;
+
+  // Command recording init
+  renderer->thread_memory.resize(job_system_get_threads_count());
+  for(auto& memory : renderer->thread_memory) {
+    linear_allocator_init(memory);
+  }
+
   return renderer;
 }
 
@@ -91,12 +496,20 @@ void renderer_destroy(Renderer* renderer) {
   }
   
   renderer->draw_calls.clear();
+  for(auto& memory : renderer->thread_memory) {
+    linear_allocator_shutdown(memory);
+  }
+
   material_destroy(renderer->default_material);
+  base_material_destroy(renderer->default_base);
  
   nikol::gfx_texture_destroy(renderer->white_texture);
-  nikol::gfx_shader_destroy(renderer->default_shader);
+  material_system_shutdown(renderer->materials);
+  clustered_lighting_shutdown(renderer->lighting);
   
   nikol::gfx_context_shutdown(renderer->gfx);
+
+  renderer->~Renderer();
   nikol::memory_free(renderer);
 }
 
@@ -105,35 +518,268 @@ void renderer_clear(Renderer* renderer, const glm::vec4& color) {
 }
 
 void renderer_begin(Renderer* renderer, const Camera& cam) {
-  renderer->view_proj = cam.view_projection; 
+  renderer->view       = cam.view;
+  renderer->view_proj  = cam.view_projection; 
+  renderer->eye        = cam.position;
+  renderer->proj_scale = cam.projection[1][1];
+  
   renderer->draw_calls.clear();
+  renderer->translucent_draws.clear();
+  renderer->translucent_depths.clear();
+  renderer->lights.clear();
+  renderer->streamed_meshes.clear();
+  renderer->stats = {};
+
+  state_cache_reset_stats(renderer->state_cache);
+  material_system_reset_stats(renderer->materials);
+
+  // The frame graph gets declared again. Other passes can hook onto these two until `renderer_end`.
+  int width, height;
+  nikol::window_get_size(renderer->window, &width, &height);
+
+  RenderTargetDesc backbuffer_desc = {
+    .width  = (nikol::u32)width, 
+    .height = (nikol::u32)height, 
+    .format = RENDER_TARGET_FORMAT_RGBA8,
+  };
+
+  // Only rebuilt when the projection or the window changes
+  clustered_lighting_update_grid(renderer->lighting, cam.projection, backbuffer_desc.width, backbuffer_desc.height);
+
+  frame_graph_reset(renderer->frame_graph);
+  renderer->backbuffer   = frame_graph_import_target(renderer->frame_graph, "backbuffer", backbuffer_desc);
+  renderer->forward_pass = frame_graph_add_pass(renderer->frame_graph, "forward", execute_forward_pass, renderer);
+
+  frame_graph_write(renderer->frame_graph, renderer->forward_pass, renderer->backbuffer);
 }
 
 void renderer_end(Renderer* renderer) {
-  for(auto& draw : renderer->draw_calls) {
-    nikol::gfx_context_apply_pipeline(renderer->gfx, draw->pipe, draw->pipe_desc);
-    nikol::gfx_pipeline_draw_index(renderer->gfx, draw->pipe);
+  sort_translucent_draws(renderer);
+
+  if(renderer->is_occlusion_enabled) {
+    cull_occluded_draws(renderer);
   }
+
+  frame_graph_compile(renderer->frame_graph);
+  frame_graph_execute(renderer->frame_graph);
 }
 
 nikol::GfxContext* renderer_get_gfx_context(Renderer* renderer) {
   return renderer->gfx;
 }
 
+const StateCacheStats& renderer_get_state_stats(Renderer* renderer) {
+  return renderer->state_cache.stats;
+}
+
+const RendererStats& renderer_get_stats(Renderer* renderer) {
+  return renderer->stats;
+}
+
+MaterialSystem& renderer_get_materials(Renderer* renderer) {
+  return renderer->materials;
+}
+
+const IndirectStats& renderer_get_indirect_stats(Renderer* renderer) {
+  return renderer->indirect.stats;
+}
+
+const CommandStats& renderer_get_command_stats(Renderer* renderer) {
+  return renderer->command_stats;
+}
+
+const ClusterStats& renderer_get_lighting_stats(Renderer* renderer) {
+  return renderer->lighting.stats;
+}
+
+const OcclusionStats& renderer_get_occlusion_stats(Renderer* renderer) {
+  return renderer->occlusion.stats;
+}
+
+void renderer_set_occlusion_culling(Renderer* renderer, const bool enabled) {
+  renderer->is_occlusion_enabled = enabled;
+}
+
+void renderer_set_ambient(Renderer* renderer, const glm::vec3& ambient) {
+  renderer->ambient = ambient;
+}
+
+FrameGraph& renderer_get_frame_graph(Renderer* renderer) {
+  return renderer->frame_graph;
+}
+
+FrameGraphResource renderer_get_backbuffer(Renderer* renderer) {
+  return renderer->backbuffer;
+}
+
+FrameGraphPass renderer_get_forward_pass(Renderer* renderer) {
+  return renderer->forward_pass;
+}
+
 void render_mesh(Renderer* renderer, Mesh* mesh, Material* material, Transform& transform) {
+  render_mesh(renderer, mesh, material, transform_get_model(transform));
+}
+
+void render_mesh(Renderer* renderer, Mesh* mesh, Material* material, const glm::mat4& model) {
   if(!material) {
     material = renderer->default_material;
   }
 
-  mesh->pipe_desc.shader = material->shader;
+  // The bounding sphere scales with the largest axis
+  glm::vec3 center = glm::vec3(model * glm::vec4(mesh->bounds_center, 1.0f));
+  nikol::f32 scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+  nikol::f32 size  = mesh_lod_screen_size(center, mesh->bounds_radius * scale, renderer->eye, renderer->proj_scale);
+  nikol::u32 lod   = mesh_lod_select(mesh->lods, mesh->lods_count, size);
 
-  mesh->pipe_desc.textures[0]    = material->diffuse;
-  mesh->pipe_desc.textures_count = 1; 
+  renderer->stats.draw_calls          += 1;
+  renderer->stats.triangles_submitted += mesh->lods[lod].indices_count / 3;
+  renderer->stats.triangles_full      += mesh->lods[0].indices_count / 3;
 
-  material->transform = renderer->view_proj * transform.model;  
-  material_apply(material);
+  push_draw(renderer, DrawCall{mesh, material, lod, model}, center);
+}
+
+void render_static_batch(Renderer* renderer, StaticBatch& batch) {
+  glm::vec4 planes[6];
+  get_frustum_planes(renderer->view_proj, planes);
+
+  batch.stats.chunks_visible = 0;
+
+  // Already in world space
+  for(auto& chunk : batch.chunks) {
+    if(!chunk.mesh || !is_box_visible(planes, chunk.bounds_min, chunk.bounds_max)) {
+      continue;
+    }
+
+    render_mesh(renderer, chunk.mesh, chunk.material, glm::mat4(1.0f));
+    batch.stats.chunks_visible++;
+  }
+}
+
+void render_meshlets(Renderer* renderer, MeshletMesh& meshlets, Material* material, const glm::mat4& model) {
+  NIKOL_ASSERT(meshlets.mesh, "Meshlets have to be uploaded before being rendered");
+
+  if(!material) {
+    material = renderer->default_material;
+  }
+
+  // Culled in object space, so the bounds never have to be transformed
+  glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(renderer->eye, 1.0f));
+  meshlet_mesh_cull(meshlets, renderer->view_proj * model, camera);
+
+  const MeshletCullStats& cull = meshlets.stats;
+  renderer->stats.triangles_culled += cull.triangles_culled;
+  renderer->stats.triangles_full   += cull.triangles_count;
+
+  if(meshlets.visible_indices.empty()) {
+    return;
+  }
+
+  nikol::u32 indices_count = (nikol::u32)meshlets.visible_indices.size();
+
+  renderer->stats.draw_calls          += 1;
+  renderer->stats.triangles_submitted += indices_count / 3;
+
+  glm::vec3 center = glm::vec3(model * glm::vec4(meshlets.mesh->bounds_center, 1.0f));
+  push_draw(renderer, DrawCall{meshlets.mesh, material, 0, model, meshlets.visible_indices.data(), indices_count}, center);
+}
+
+void render_terrain(Renderer* renderer, Terrain& terrain, Material* material) {
+  NIKOL_ASSERT(terrain.heightmap, "A terrain has to be uploaded before being rendered");
+  NIKOL_ASSERT(material && (material->base->features & MATERIAL_FEATURE_TERRAIN), "A terrain needs a material with MATERIAL_FEATURE_TERRAIN");
+
+  terrain_select(terrain, renderer->view_proj, renderer->eye);
+
+  const TerrainStats& stats = terrain.stats;
+  renderer->stats.draw_calls          += stats.nodes_selected;
+  renderer->stats.triangles_submitted += stats.triangles_count;
+  renderer->stats.triangles_full      += stats.triangles_full;
+
+  // The nodes are placed relative to the terrain's origin
+  glm::mat4 model = glm::mat4(1.0f);
+  model[3]        = glm::vec4(terrain.desc.origin, 1.0f);
+
+  for(auto& node : terrain.selection) {
+    push_draw(renderer, DrawCall{terrain.patches[node.part], material, 0, model, nullptr, 0, &node}, (node.bounds_min + node.bounds_max) * 0.5f);
+  }
+}
+
+void render_voxel_world(Renderer* renderer, VoxelWorld& world, Material* material) {
+  glm::vec4 planes[6];
+  get_frustum_planes(renderer->view_proj, planes);
+
+  glm::vec3 chunk_size = glm::vec3(VOXEL_CHUNK_SIZE * world.block_size);
+
+  for(auto& chunk : world.chunks) {
+    glm::vec3 min = world.origin + glm::vec3(chunk.coords) * chunk_size;
+    if(!chunk.mesh || !is_box_visible(planes, min, min + chunk_size)) {
+      continue;
+    }
+
+    render_mesh(renderer, chunk.mesh, material, voxel_chunk_get_model(world, chunk));
+  }
+}
+
+void render_sorted_mesh(Renderer* renderer, SortedMesh& mesh, Material* material, const glm::mat4& model) {
+  NIKOL_ASSERT(mesh.mesh, "A sorted mesh has to be uploaded before being rendered");
+
+  if(!material) {
+    material = renderer->default_material;
+  }
+
+  sorted_mesh_sort(mesh, renderer->view * model);
+
+  nikol::u32 indices_count = (nikol::u32)mesh.sorted_indices.size();
+
+  renderer->stats.draw_calls          += 1;
+  renderer->stats.triangles_submitted += indices_count / 3;
+  renderer->stats.triangles_full      += indices_count / 3;
+
+  glm::vec3 center = glm::vec3(model * glm::vec4(mesh.mesh->bounds_center, 1.0f));
+  push_draw(renderer, DrawCall{mesh.mesh, material, 0, model, mesh.sorted_indices.data(), indices_count}, center);
+}
+
+void render_skinned_mesh(Renderer* renderer, SkinnedMesh* mesh, const SkeletonPose& pose, Material* material, const glm::mat4& model) {
+  NIKOL_ASSERT(pose.palette.size() <= SKELETON_JOINTS_MAX, "Too many joints in a pose");
+
+  if(!material) {
+    material = renderer->default_material;
+  }
+
+  // The CPU fallback draws like any other mesh once streamed
+  if(mesh->path == SKINNING_PATH_CPU) {
+    bool is_streamed = std::find(renderer->streamed_meshes.begin(), renderer->streamed_meshes.end(), mesh) != renderer->streamed_meshes.end();
+    NIKOL_ASSERT(!is_streamed, "A CPU skinned mesh can only be drawn once per frame");
+    renderer->streamed_meshes.push_back(mesh);
+
+    skinned_mesh_skin(mesh, pose.palette.data());
+    skinned_mesh_upload(renderer->gfx, mesh);
+
+    render_mesh(renderer, mesh->mesh, material, model);
+    return;
+  }
+
+  // Kept in the draw, since other characters might share the mesh
+  glm::vec3 bounds_center;
+  nikol::f32 bounds_radius;
+  skinned_mesh_compute_bounds(mesh, pose.palette.data(), bounds_center, bounds_radius);
+
+  Mesh* gpu_mesh   = mesh->mesh;
+  glm::vec3 center = glm::vec3(model * glm::vec4(bounds_center, 1.0f));
+
+  renderer->stats.draw_calls          += 1;
+  renderer->stats.triangles_submitted += gpu_mesh->lods[0].indices_count / 3;
+  renderer->stats.triangles_full      += gpu_mesh->lods[0].indices_count / 3;
+
+  DrawCall draw       = DrawCall{gpu_mesh, material, 0, model};
+  draw.palette        = pose.palette.data();
+  draw.palette_joints = (nikol::u32)pose.palette.size();
+  draw.bounds         = glm::vec4(bounds_center, bounds_radius);
+
+  push_draw(renderer, draw, center);
+}
 
-  renderer->draw_calls.push_back(mesh);
+void render_light(Renderer* renderer, const PointLight& light) {
+  renderer->lights.push_back(light);
 }
 // Renderer functions
 // ----------------------------------------------------------------------------
@@ -4,9 +4,36 @@
 #include "material.h"
 #include "trasform.h"
 #include "camera.h"
+#include "state_cache.h"
+#include "frame_graph.h"
+#include "command_buffer.h"
+#include "clustered_lighting.h"
+#include "occlusion_culling.h"
+#include "static_batch.h"
+#include "indirect_draw.h"
+#include "meshlet.h"
+#include "terrain.h"
+#include "voxel.h"
+#include "sorted_mesh.h"
+#include "skinning.h"
 
 #include <nikol/nikol_core.hpp>
 
+// ----------------------------------------------------------------------------
+// RendererStats
+struct RendererStats {
+  nikol::u32 draw_calls     = 0; 
+  nikol::u32 draws_occluded = 0; // Dropped by the occlusion culling (and so not part of the triangles below)
+
+  nikol::u32 draws_translucent = 0; // Sorted back to front after the opaque ones (before the occlusion culling)
+
+  nikol::u32 triangles_submitted = 0; // With the LODs that were picked
+  nikol::u32 triangles_full      = 0; // What it would have been with LOD 0 everywhere
+  nikol::u32 triangles_culled    = 0; // Dropped by the meshlet culling (see `render_meshlets`)
+};
+// RendererStats
+// ----------------------------------------------------------------------------
+
 // ----------------------------------------------------------------------------
 // Renderer 
 struct Renderer;
@@ -23,7 +50,62 @@ void renderer_begin(Renderer* renderer, const Camera& cam);
 void renderer_end(Renderer* renderer);
 
 nikol::GfxContext* renderer_get_gfx_context(Renderer* renderer);
+const StateCacheStats& renderer_get_state_stats(Renderer* renderer);
+const RendererStats& renderer_get_stats(Renderer* renderer);
+const CommandStats& renderer_get_command_stats(Renderer* renderer);
+const IndirectStats& renderer_get_indirect_stats(Renderer* renderer);
+const ClusterStats& renderer_get_lighting_stats(Renderer* renderer);
+const OcclusionStats& renderer_get_occlusion_stats(Renderer* renderer);
+
+// On by default. Only does anything once some mesh is flagged with `mesh_set_occluder`.
+void renderer_set_occlusion_culling(Renderer* renderer, const bool enabled);
+
+// Added to every light of the lit materials. Starts at 1 (white), so nothing looks different without lights.
+void renderer_set_ambient(Renderer* renderer, const glm::vec3& ambient);
+
+// Where the base materials and their instances come from
+MaterialSystem& renderer_get_materials(Renderer* renderer);
 
+// Passes can be added to the frame graph between `renderer_begin` and `renderer_end`.
+// The forward pass draws every mesh into the back buffer, so anything it needs
+// (a shadow map, say) only has to be marked as read by it.
+FrameGraph& renderer_get_frame_graph(Renderer* renderer);
+FrameGraphResource renderer_get_backbuffer(Renderer* renderer);
+FrameGraphPass renderer_get_forward_pass(Renderer* renderer);
+
+// A `nullptr` material draws with the default (plain white) one. The LOD is picked from the mesh's projected size on screen.
+// Materials with `MATERIAL_FEATURE_TRANSLUCENT` get drawn after every opaque mesh, sorted back to front by the view space depth of
+// their bounding spheres' centers (with a stable radix sort, so the ones at the same depth keep their order). The same goes for
+// the translucent draws of every `render_*` below.
 void render_mesh(Renderer* renderer, Mesh* mesh, Material* material, Transform& transform);
+void render_mesh(Renderer* renderer, Mesh* mesh, Material* material, const glm::mat4& model);
+
+// Draw every (uploaded) chunk of `batch` inside the frustum. See `StaticBatchStats::chunks_visible`.
+void render_static_batch(Renderer* renderer, StaticBatch& batch);
+
+// Cull the meshlets of `meshlets` and draw the visible ones with a single draw. The culling happens right
+// away, so a meshlet mesh can only be drawn once per frame. See `MeshletMesh::stats` for what got culled.
+void render_meshlets(Renderer* renderer, MeshletMesh& meshlets, Material* material, const glm::mat4& model);
+
+// Pick the nodes of `terrain` for this camera and draw every one of them (see `Terrain::stats` for the selection's cost).
+// `material` needs `MATERIAL_FEATURE_TERRAIN` and the terrain's heightmap as its texture. Only one camera per frame, like the meshlets.
+void render_terrain(Renderer* renderer, Terrain& terrain, Material* material);
+
+// Draw every chunk of `world` that was uploaded and is inside the frustum, as one mesh each
+void render_voxel_world(Renderer* renderer, VoxelWorld& world, Material* material);
+
+// Sort the triangles of `mesh` back to front for this camera and draw them, for translucent meshes that overlap themselves. 
+// The sorting happens right away, so a sorted mesh can only be drawn once per frame (like the meshlets).
+void render_sorted_mesh(Renderer* renderer, SortedMesh& mesh, Material* material, const glm::mat4& model);
+
+// Draw `mesh` in `pose`, with its bounds moved along with the pose first. On the GPU path, the palette gets uploaded 
+// right before the draw and the skinned permutation of `material` deforms the vertices, so `pose` has to stay 
+// unchanged until `renderer_end`. Any number of characters can share the mesh there. The CPU path (the fallback) 
+// gets skinned and streamed into the mesh's only vertex buffer right away instead, so it can only be drawn once per frame.
+void render_skinned_mesh(Renderer* renderer, SkinnedMesh* mesh, const SkeletonPose& pose, Material* material, const glm::mat4& model);
+
+// Only lights the materials with `MATERIAL_FEATURE_LIT` (the default one included) for this frame. Past 
+// `CLUSTER_GPU_LIGHTS_MAX` visible lights, the furthest ones get left out (with a warning, see `ClusterStats`).
+void render_light(Renderer* renderer, const PointLight& light);
 // Renderer functions
 // ----------------------------------------------------------------------------
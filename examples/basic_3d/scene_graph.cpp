@@ -0,0 +1,295 @@
+#include "scene_graph.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+// Globals
+// Subtrees smaller than this are never split into more tasks
+const nikol::u32 MIN_TASK_NODES = 256;
+
+// How many tasks to aim for per thread, so uneven subtrees still balance out
+const nikol::u32 TASKS_PER_THREAD = 4;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static glm::mat4 compose_trs(const glm::vec3& pos, const glm::quat& rot, const glm::vec3& scale) {
+  glm::mat3 rot_mat = glm::mat3_cast(rot);
+
+  return glm::mat4(glm::vec4(rot_mat[0] * scale.x, 0.0f), 
+                   glm::vec4(rot_mat[1] * scale.y, 0.0f), 
+                   glm::vec4(rot_mat[2] * scale.z, 0.0f), 
+                   glm::vec4(pos, 1.0f));
+}
+
+template<typename T>
+static void permute_array(std::vector<T>& array, const std::vector<nikol::u32>& old_indices) {
+  std::vector<T> sorted(array.size());
+  
+  for(nikol::sizei i = 0; i < old_indices.size(); i++) {
+    sorted[i] = array[old_indices[i]];
+  }
+
+  array.swap(sorted);
+}
+
+static void build_tasks(SceneGraph& graph) {
+  graph.tasks.clear();
+  graph.serial_nodes.clear();
+
+  nikol::u32 count = (nikol::u32)graph.parents.size();
+
+  // Every root starts out as its own task
+  for(nikol::u32 i = 0; i < count; i += graph.subtree_sizes[i]) {
+    graph.tasks.push_back(glm::uvec2(i, i + graph.subtree_sizes[i]));
+  }
+
+  // Keep splitting the biggest subtree into its children until there is enough work to go around
+  nikol::u32 target = job_system_get_threads_count() * TASKS_PER_THREAD;
+  while(graph.tasks.size() < target) {
+    auto largest = std::max_element(graph.tasks.begin(), graph.tasks.end(), [](const glm::uvec2& a, const glm::uvec2& b) {
+      return (a.y - a.x) < (b.y - b.x);
+    });
+    
+    if(largest == graph.tasks.end() || (largest->y - largest->x) < MIN_TASK_NODES) {
+      break;
+    }
+
+    // The root of the split subtree has to be updated before any of its children
+    glm::uvec2 range = *largest;
+    graph.tasks.erase(largest);
+    graph.serial_nodes.push_back(range.x);
+
+    for(nikol::u32 child = range.x + 1; child < range.y; child += graph.subtree_sizes[child]) {
+      graph.tasks.push_back(glm::uvec2(child, child + graph.subtree_sizes[child]));
+    }
+  }
+
+  // Parents before children
+  std::sort(graph.serial_nodes.begin(), graph.serial_nodes.end());
+}
+
+static void sort_nodes(SceneGraph& graph) {
+  nikol::u32 count = (nikol::u32)graph.parent_handles.size();
+
+  // Gather the children of every handle in one flat array
+  std::vector<nikol::u32> child_offsets(count + 1, 0);
+  std::vector<SceneNode> children(count);
+  
+  for(SceneNode node = 0; node < count; node++) {
+    if(graph.parent_handles[node] != SCENE_NODE_INVALID) {
+      child_offsets[graph.parent_handles[node] + 1]++;
+    }
+  }
+  
+  for(nikol::u32 i = 0; i < count; i++) {
+    child_offsets[i + 1] += child_offsets[i];
+  }
+  
+  std::vector<nikol::u32> cursors(child_offsets.begin(), child_offsets.end() - 1);
+  for(SceneNode node = 0; node < count; node++) {
+    SceneNode parent = graph.parent_handles[node];
+    if(parent != SCENE_NODE_INVALID) {
+      children[cursors[parent]++] = node;
+    }
+  }
+
+  // Depth-first walk from every root
+  std::vector<SceneNode> order; 
+  std::vector<SceneNode> stack;
+  order.reserve(count);
+
+  for(SceneNode root = 0; root < count; root++) {
+    if(graph.parent_handles[root] != SCENE_NODE_INVALID) {
+      continue;
+    }
+
+    stack.push_back(root);
+    while(!stack.empty()) {
+      SceneNode node = stack.back();
+      stack.pop_back();
+      order.push_back(node);
+
+      // Reversed so the children keep their creation order
+      for(nikol::u32 i = child_offsets[node + 1]; i > child_offsets[node]; i--) {
+        stack.push_back(children[i - 1]);
+      }
+    }
+  }
+
+  // Move the data into its new place
+  std::vector<nikol::u32> old_indices(count);
+  for(nikol::u32 i = 0; i < count; i++) {
+    old_indices[i] = graph.handle_to_index[order[i]];
+  }
+  
+  permute_array(graph.positions, old_indices);
+  permute_array(graph.rotations, old_indices);
+  permute_array(graph.scales, old_indices);
+  permute_array(graph.worlds, old_indices);
+  
+  for(nikol::u32 i = 0; i < count; i++) {
+    graph.index_to_handle[i]         = order[i];
+    graph.handle_to_index[order[i]]  = i;
+  }
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    SceneNode parent  = graph.parent_handles[order[i]];
+    graph.parents[i]  = parent != SCENE_NODE_INVALID ? graph.handle_to_index[parent] : SCENE_NODE_INVALID;
+  }
+
+  // Children always come after their parents, so walking backwards accumulates the sizes bottom-up
+  std::fill(graph.subtree_sizes.begin(), graph.subtree_sizes.end(), 1);
+  for(nikol::u32 i = count; i > 0; i--) {
+    nikol::u32 parent = graph.parents[i - 1];
+    if(parent != SCENE_NODE_INVALID) {
+      graph.subtree_sizes[parent] += graph.subtree_sizes[i - 1];
+    }
+  }
+
+  // A re-parented node needs a new world matrix, and so does everything under it
+  std::fill(graph.dirty.begin(), graph.dirty.end(), 1);
+  
+  build_tasks(graph);
+  graph.is_topology_dirty = false;
+}
+
+static void update_node(SceneGraph& graph, const nikol::u32 index) {
+  nikol::u32 parent = graph.parents[index];
+
+  // A dirty parent dirties the whole subtree below it
+  if(parent != SCENE_NODE_INVALID) {
+    graph.dirty[index] |= graph.dirty[parent];
+  }
+
+  if(!graph.dirty[index]) {
+    return;
+  }
+
+  glm::mat4 local = compose_trs(graph.positions[index], graph.rotations[index], graph.scales[index]);
+  graph.worlds[index] = parent != SCENE_NODE_INVALID ? graph.worlds[parent] * local : local;
+}
+
+static void mark_dirty(SceneGraph& graph, const SceneNode node) {
+  graph.dirty[graph.handle_to_index[node]] = 1;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SceneGraph functions
+SceneNode scene_graph_create_node(SceneGraph& graph, const SceneNode parent, const glm::vec3& pos, const glm::vec3& scale, const glm::quat& rotation) {
+  NIKOL_ASSERT(parent == SCENE_NODE_INVALID || parent < graph.parent_handles.size(), "Invalid scene node parent");
+
+  SceneNode node   = (SceneNode)graph.parent_handles.size();
+  nikol::u32 index = (nikol::u32)graph.parents.size();
+
+  graph.positions.push_back(pos);
+  graph.rotations.push_back(rotation);
+  graph.scales.push_back(scale);
+
+  graph.parents.push_back(SCENE_NODE_INVALID);
+  graph.subtree_sizes.push_back(1);
+
+  graph.worlds.push_back(glm::mat4(1.0f));
+  graph.dirty.push_back(1);
+
+  graph.handle_to_index.push_back(index);
+  graph.index_to_handle.push_back(node);
+  graph.parent_handles.push_back(parent);
+
+  // Appending might break the depth-first order. Re-sort on the next update.
+  graph.is_topology_dirty = true;
+
+  return node;
+}
+
+void scene_graph_set_parent(SceneGraph& graph, const SceneNode node, const SceneNode parent) {
+  // Parenting a node to one of its own descendants would create a cycle 
+  for(SceneNode ancestor = parent; ancestor != SCENE_NODE_INVALID; ancestor = graph.parent_handles[ancestor]) {
+    if(ancestor == node) {
+      NIKOL_ASSERT(false, "Cannot parent a scene node to one of its descendants");
+      return;
+    }
+  }
+
+  graph.parent_handles[node] = parent;
+  graph.is_topology_dirty    = true;
+}
+
+void scene_graph_clear(SceneGraph& graph) {
+  graph.positions.clear();
+  graph.rotations.clear();
+  graph.scales.clear();
+
+  graph.parents.clear();
+  graph.subtree_sizes.clear();
+  
+  graph.worlds.clear();
+  graph.dirty.clear();
+
+  graph.handle_to_index.clear();
+  graph.index_to_handle.clear();
+  graph.parent_handles.clear();
+
+  graph.tasks.clear();
+  graph.serial_nodes.clear();
+  graph.is_topology_dirty = false;
+}
+
+void scene_graph_translate(SceneGraph& graph, const SceneNode node, const glm::vec3& pos) {
+  graph.positions[graph.handle_to_index[node]] = pos;
+  mark_dirty(graph, node);
+}
+
+void scene_graph_rotate(SceneGraph& graph, const SceneNode node, const float angle, const glm::vec3& axis) {
+  graph.rotations[graph.handle_to_index[node]] = glm::angleAxis(glm::radians(angle), glm::normalize(axis));
+  mark_dirty(graph, node);
+}
+
+void scene_graph_scale(SceneGraph& graph, const SceneNode node, const glm::vec3& scale) {
+  graph.scales[graph.handle_to_index[node]] = scale;
+  mark_dirty(graph, node);
+}
+
+void scene_graph_update(SceneGraph& graph) {
+  if(graph.is_topology_dirty) {
+    sort_nodes(graph);
+  }
+
+  // The ancestors of the split subtrees go first...
+  for(auto& index : graph.serial_nodes) {
+    update_node(graph, index);
+  }
+
+  // ...then every independent subtree in parallel 
+  job_system_parallel_for((nikol::u32)graph.tasks.size(), 1, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      glm::uvec2 range = graph.tasks[i];
+
+      for(nikol::u32 index = range.x; index < range.y; index++) {
+        update_node(graph, index);
+      }
+
+      // Every child of this range lives in this range, so it's safe to clear now
+      std::fill(graph.dirty.begin() + range.x, graph.dirty.begin() + range.y, 0);
+    }
+  });
+
+  for(auto& index : graph.serial_nodes) {
+    graph.dirty[index] = 0;
+  }
+}
+
+const glm::mat4& scene_graph_get_world(const SceneGraph& graph, const SceneNode node) {
+  return graph.worlds[graph.handle_to_index[node]];
+}
+// SceneGraph functions
+// ----------------------------------------------------------------------------
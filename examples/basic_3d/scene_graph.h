@@ -0,0 +1,73 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// SceneNode
+// A stable handle to a node. Stays valid even when the graph re-sorts itself.
+using SceneNode = nikol::u32;
+
+const SceneNode SCENE_NODE_INVALID = (SceneNode)-1;
+// SceneNode
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SceneGraph
+// Every array below is indexed by the node's *sorted* index, not its handle. 
+// The nodes are kept in depth-first order, so a parent always comes before 
+// its children and every subtree is a contiguous range `[i, i + subtree_sizes[i])`.
+struct SceneGraph {
+  // Local TRS 
+  std::vector<glm::vec3> positions; 
+  std::vector<glm::quat> rotations; 
+  std::vector<glm::vec3> scales;
+
+  // Hierarchy 
+  std::vector<nikol::u32> parents;        // Sorted index of the parent or `SCENE_NODE_INVALID`
+  std::vector<nikol::u32> subtree_sizes;  // Including the node itself
+  
+  // Results
+  std::vector<glm::mat4> worlds;
+  std::vector<nikol::u8> dirty;
+
+  // Handle <-> sorted index
+  std::vector<nikol::u32> handle_to_index;
+  std::vector<SceneNode> index_to_handle;
+  
+  // Parents of every handle. Only used to re-sort the nodes.
+  std::vector<SceneNode> parent_handles;
+  bool is_topology_dirty = false;
+
+  // Independent ranges that can be updated in parallel, along with the nodes 
+  // that have to be updated before them (the ancestors of those ranges).
+  std::vector<glm::uvec2> tasks;
+  std::vector<nikol::u32> serial_nodes;
+};
+// SceneGraph
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SceneGraph functions
+SceneNode scene_graph_create_node(SceneGraph& graph, 
+                                  const SceneNode parent, 
+                                  const glm::vec3& pos, 
+                                  const glm::vec3& scale = glm::vec3(1.0f), 
+                                  const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+void scene_graph_set_parent(SceneGraph& graph, const SceneNode node, const SceneNode parent);
+void scene_graph_clear(SceneGraph& graph);
+
+void scene_graph_translate(SceneGraph& graph, const SceneNode node, const glm::vec3& pos);
+void scene_graph_rotate(SceneGraph& graph, const SceneNode node, const float angle, const glm::vec3& axis);
+void scene_graph_scale(SceneGraph& graph, const SceneNode node, const glm::vec3& scale);
+
+// Recompute the world matrices of every dirty node (and its children). 
+// Meant to be called once per frame, before anything reads a world matrix.
+void scene_graph_update(SceneGraph& graph);
+
+const glm::mat4& scene_graph_get_world(const SceneGraph& graph, const SceneNode node);
+// SceneGraph functions
+// ----------------------------------------------------------------------------
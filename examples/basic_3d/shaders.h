@@ -1,27 +1,186 @@
 #pragma once
 
-inline const char* default_shader_glsl() {
-  return 
+// Every material permutation (see material.h) is this one shader with a `#define` per feature bit
+// put in front of each stage. `MATERIAL_PARAMS_MAX` and the sizes of the cluster arrays get defined the same way.
+//
+// The quantized formats (see vertex_quantize.h) come in as 32-bit words declared as floats, since the
+// layouts only know about floats. Each word only carries 31 bits, so it is always a normal float that
+// no GPU flushes or canonicalizes, and the fields get read back out of the bit stream they make.
+// The positions stay integers here, as the dequantization is already part of `view_projection`
+// (through the model matrix).
+//
+// The voxel permutations unpack everything out of one (31-bit) word per vertex (see voxel.h). The block type
+// turns into a texel of the diffuse map, which works as a palette of 256 colors then.
+//
+// The skinned permutations blend the (up to) 4 matrices of every vertex out of the draw's joint palette,
+// the same way `skinning_apply` does on the CPU. The joint indices come in as float values (see `SkinnedGpuVertex`).
+//
+// The terrain permutations place and lift a flat grid patch per node (see terrain.h). The 16-bit heights
+// come split over two channels of the texture, so they get fetched and filtered by hand.
+//
+// Blending is on for every permutation, so only the translucent ones keep their alpha.
+//
+// The lit permutations light in view space. Each fragment finds its cluster the same way
+// `clustered_lighting_find_cluster` does and only loops over the lights binned into it.
+inline const char* material_shader_glsl() {
+  return
     "#version 460 core\n"
     "\n"
     "// Layouts\n"
+    "#if defined(QUANTIZED_COMPACT)\n"
+    "layout (location = 0) in vec3 aPacked;\n"
+    "#elif defined(QUANTIZED)\n"
+    "layout (location = 0) in vec4 aPacked;\n"
+    "#elif defined(VOXEL)\n"
+    "layout (location = 0) in float aPacked;\n"
+    "#else\n"
     "layout (location = 0) in vec3 aPos;\n"
     "layout (location = 1) in vec3 aNormal;\n"
     "layout (location = 2) in vec2 aTextureCoords;\n"
+    "#endif\n"
+    "\n"
+    "#if defined(SKINNED)\n"
+    "layout (location = 3) in vec4 aJoints;\n"
+    "layout (location = 4) in vec4 aWeights;\n"
+    "#endif\n"
     "\n"
     "// Outputs\n"
     "out VS_OUT {\n"
+    "  vec3 normal;\n"
     "  vec2 tex_coords;\n"
+    "  flat uint material_index;\n"
+    "#if defined(LIT)\n"
+    "  vec3 view_pos;\n"
+    "#endif\n"
     "} vs_out;\n"
     "\n"
-    "layout (std140, binding = 0) uniform Matrices {\n"
+    "layout (std140, binding = 0) uniform DrawData {\n"
     "  mat4 view_projection;\n"
+    "  mat4 model_view;\n"
+    "  mat4 normal_matrix;\n"
+    "  uint material_index;\n"
+    "  vec4 terrain_node;\n"
+    "  vec4 terrain_morph;\n"
+    "};\n"
+    "\n"
+    "#if defined(SKINNED)\n"
+    "layout (std140, binding = 2) uniform SkinPalette {\n"
+    "  mat4 palette[SKELETON_JOINTS_MAX];\n"
     "};\n"
+    "#endif\n"
+    "\n"
+    "#if defined(TERRAIN)\n"
+    "uniform sampler2D u_texture;\n"
+    "\n"
+    "float terrain_sample(ivec2 texel) {\n"
+    "  ivec2 last = textureSize(u_texture, 0) - 1;\n"
+    "  vec2 bytes = texelFetch(u_texture, clamp(texel, ivec2(0), last), 0).rg;\n"
+    "  return dot(bytes, vec2(65280.0, 255.0) / 65535.0);\n"
+    "}\n"
+    "\n"
+    "float terrain_height(vec2 xz) {\n"
+    "  vec2 texel = xz * terrain_node.w;\n"
+    "  ivec2 base = ivec2(floor(texel));\n"
+    "  vec2 t     = texel - vec2(base);\n"
+    "\n"
+    "  float h0 = mix(terrain_sample(base), terrain_sample(base + ivec2(1, 0)), t.x);\n"
+    "  float h1 = mix(terrain_sample(base + ivec2(0, 1)), terrain_sample(base + ivec2(1, 1)), t.x);\n"
+    "  return mix(h0, h1, t.y) * terrain_morph.z;\n"
+    "}\n"
+    "\n"
+    "vec3 terrain_normal(vec2 xz) {\n"
+    "  float spacing = 1.0 / terrain_node.w;\n"
+    "  float dx      = terrain_height(xz + vec2(spacing, 0.0)) - terrain_height(xz - vec2(spacing, 0.0));\n"
+    "  float dz      = terrain_height(xz + vec2(0.0, spacing)) - terrain_height(xz - vec2(0.0, spacing));\n"
+    "  return normalize(vec3(-dx, 2.0 * spacing, -dz));\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "vec3 octahedral_decode(vec2 oct) {\n"
+    "  vec3 n = vec3(oct, 1.0 - abs(oct.x) - abs(oct.y));\n"
+    "  float t = max(-n.z, 0.0);\n"
+    "  n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);\n"
+    "  return normalize(n);\n"
+    "}\n"
+    "\n"
+    "// `packed_word_decode` of every component\n"
+    "uvec4 packed_word_decode(vec4 value) {\n"
+    "  uvec4 word     = floatBitsToUint(value);\n"
+    "  uvec4 exponent = (((word >> 23u) & 0xffu) - 1u) & 0x7fu;\n"
+    "  return (word & 0x7fffffu) | (exponent << 23u) | ((word >> 31u) << 30u);\n"
+    "}\n"
+    "\n"
+    "// `count` bits at `offset` of the stream of 31-bit words\n"
+    "uint read_bits(uvec4 words, uint offset, uint count) {\n"
+    "  uint index = offset / 31u;\n"
+    "  uint shift = offset % 31u;\n"
+    "  uint bits  = words[index] >> shift;\n"
+    "  if(shift + count > 31u) {\n"
+    "    bits |= words[index + 1u] << (31u - shift);\n"
+    "  }\n"
+    "  return bits & ((1u << count) - 1u);\n"
+    "}\n"
+    "\n"
+    "float read_snorm(uvec4 words, uint offset, uint count) {\n"
+    "  int value = int(read_bits(words, offset, count) << (32u - count)) >> (32u - count);\n"
+    "  return max(float(value) / float((1 << (count - 1u)) - 1), -1.0);\n"
+    "}\n"
     "\n"
     "void main() {\n"
+    "#if defined(TERRAIN)\n"
+    "  // The odd vertices slide onto their even neighbours towards the end of the level's range\n"
+    "  vec2 grid   = aPos.xz;\n"
+    "  vec2 xz     = terrain_node.xy + grid * terrain_node.z;\n"
+    "  float dist  = length(vec3(model_view * vec4(xz.x, terrain_height(xz), xz.y, 1.0)));\n"
+    "  float morph = clamp((dist - terrain_morph.x) * terrain_morph.y, 0.0, 1.0);\n"
+    "\n"
+    "  xz       = terrain_node.xy + (grid - fract(grid * 0.5) * 2.0 * morph) * terrain_node.z;\n"
+    "  vec3 pos = vec3(xz.x, terrain_height(xz), xz.y);\n"
+    "\n"
+    "  vs_out.normal     = terrain_normal(xz);\n"
+    "  vs_out.tex_coords = xz * terrain_node.w / vec2(textureSize(u_texture, 0));\n"
+    "#elif defined(QUANTIZED_COMPACT)\n"
+    "  uvec4 words = packed_word_decode(vec4(aPacked, 0.0));\n"
+    "  vec3 pos    = vec3(read_bits(words, 0u, 15u), read_bits(words, 15u, 15u), read_bits(words, 30u, 15u));\n"
+    "\n"
+    "  vs_out.normal     = octahedral_decode(vec2(read_snorm(words, 45u, 8u), read_snorm(words, 53u, 8u)));\n"
+    "  vs_out.tex_coords = unpackHalf2x16(read_bits(words, 61u, 16u) | (read_bits(words, 77u, 16u) << 16u));\n"
+    "#elif defined(QUANTIZED)\n"
+    "  uvec4 words = packed_word_decode(aPacked);\n"
+    "  vec3 pos    = vec3(read_bits(words, 0u, 16u), read_bits(words, 16u, 16u), read_bits(words, 32u, 16u));\n"
+    "\n"
+    "  vs_out.normal     = octahedral_decode(vec2(read_snorm(words, 48u, 16u), read_snorm(words, 64u, 16u)));\n"
+    "  vs_out.tex_coords = unpackHalf2x16(read_bits(words, 80u, 16u) | (read_bits(words, 96u, 16u) << 16u));\n"
+    "#elif defined(VOXEL)\n"
+    "  uint word = packed_word_decode(vec4(aPacked)).x;\n"
+    "  vec3 pos  = vec3(word & 63u, (word >> 6u) & 63u, (word >> 12u) & 63u);\n"
+    "  uint face = (word >> 18u) & 7u;\n"
+    "\n"
+    "  vs_out.normal     = vec3(equal(uvec3(face >> 1u), uvec3(0u, 1u, 2u))) * ((face & 1u) == 0u ? 1.0 : -1.0);\n"
+    "  vs_out.tex_coords = vec2((float(word >> 21u) + 0.5) / 256.0, 0.5);\n"
+    "#elif defined(SKINNED)\n"
+    "  mat4 skin = palette[uint(aJoints.x)] * aWeights.x +\n"
+    "              palette[uint(aJoints.y)] * aWeights.y +\n"
+    "              palette[uint(aJoints.z)] * aWeights.z +\n"
+    "              palette[uint(aJoints.w)] * aWeights.w;\n"
+    "  vec3 pos  = vec3(skin * vec4(aPos, 1.0));\n"
+    "\n"
+    "  vs_out.normal     = normalize(mat3(skin) * aNormal);\n"
+    "  vs_out.tex_coords = aTextureCoords;\n"
+    "#else\n"
+    "  vec3 pos = aPos;\n"
+    "\n"
+    "  vs_out.normal     = aNormal;\n"
     "  vs_out.tex_coords = aTextureCoords;\n"
+    "#endif\n"
+    "  vs_out.material_index = material_index;\n"
     "\n"
-    "  gl_Position = view_projection * vec4(aPos, 1.0f);\n"
+    "#if defined(LIT)\n"
+    "  vs_out.view_pos = vec3(model_view * vec4(pos, 1.0));\n"
+    "  vs_out.normal   = mat3(normal_matrix) * vs_out.normal;\n"
+    "#endif\n"
+    "\n"
+    "  gl_Position = view_projection * vec4(pos, 1.0f);\n"
     "}"
     "\n"
     "#version 460 core\n"
@@ -31,47 +190,350 @@ inline const char* default_shader_glsl() {
     "\n"
     "// Inputs\n"
     "in VS_OUT {\n"
+    "  vec3 normal;\n"
     "  vec2 tex_coords;\n"
+    "  flat uint material_index;\n"
+    "#if defined(LIT)\n"
+    "  vec3 view_pos;\n"
+    "#endif\n"
     "} fs_in;\n"
     "\n"
     "// Uniforms\n"
+    "struct MaterialParams {\n"
+    "  vec4 color;\n"
+    "  float roughness;\n"
+    "  float metallic;\n"
+    "  float alpha_cutoff;\n"
+    "  float padding;\n"
+    "};\n"
+    "\n"
+    "layout (std140, binding = 1) uniform Materials {\n"
+    "  MaterialParams materials[MATERIAL_PARAMS_MAX];\n"
+    "};\n"
+    "\n"
     "uniform sampler2D u_texture;\n"
     "\n"
+    "#if defined(LIT)\n"
+    "struct PointLight {\n"
+    "  vec4 position_radius;\n"
+    "  vec4 color_intensity;\n"
+    "};\n"
+    "\n"
+    "layout (std140, binding = 3) uniform ClusterParams {\n"
+    "  uvec4 grid_size;\n"
+    "  vec4 tile_size;\n"
+    "  vec4 slicing;\n"
+    "  vec4 ambient;\n"
+    "};\n"
+    "\n"
+    "layout (std140, binding = 4) uniform ClusterLights {\n"
+    "  PointLight lights[CLUSTER_LIGHTS_COUNT];\n"
+    "};\n"
+    "\n"
+    "layout (std140, binding = 5) uniform ClusterRanges {\n"
+    "  uvec4 cluster_ranges[CLUSTER_RANGES_COUNT];\n"
+    "};\n"
+    "\n"
+    "layout (std140, binding = 6) uniform ClusterIndices {\n"
+    "  uvec4 light_indices[CLUSTER_INDICES_COUNT];\n"
+    "};\n"
+    "\n"
+    "vec3 cluster_lighting(vec3 view_pos, vec3 normal) {\n"
+    "  uvec2 tile  = min(uvec2(gl_FragCoord.xy / tile_size.xy), grid_size.xy - 1u);\n"
+    "  uint slice  = uint(clamp(log(-view_pos.z) * slicing.x + slicing.y, 0.0, float(grid_size.z - 1u)));\n"
+    "  uint index  = (slice * grid_size.y + tile.y) * grid_size.x + tile.x;\n"
+    "\n"
+    "  uint packed = cluster_ranges[index >> 2u][index & 3u];\n"
+    "  uvec2 range = uvec2(packed & 0xffffu, packed >> 16u);\n"
+    "  uint last   = min(range.x + range.y, CLUSTER_INDICES_COUNT * 8u);\n"
+    "\n"
+    "  vec3 result = ambient.rgb;\n"
+    "  for(uint i = range.x; i < last; i++) {\n"
+    "    uint light_index = (light_indices[i >> 3u][(i >> 1u) & 3u] >> ((i & 1u) * 16u)) & 0xffffu;\n"
+    "    if(light_index >= grid_size.w) {\n"
+    "      continue;\n"
+    "    }\n"
+    "\n"
+    "    PointLight light = lights[light_index];\n"
+    "    vec3 to_light    = light.position_radius.xyz - view_pos;\n"
+    "    float dist       = length(to_light);\n"
+    "    float falloff    = clamp(1.0 - (dist * dist) / (light.position_radius.w * light.position_radius.w), 0.0, 1.0);\n"
+    "    float lambert    = max(dot(normal, to_light / max(dist, 0.0001)), 0.0);\n"
+    "\n"
+    "    result += light.color_intensity.rgb * light.color_intensity.w * lambert * falloff * falloff;\n"
+    "  }\n"
+    "\n"
+    "  return result;\n"
+    "}\n"
+    "#endif\n"
+    "\n"
     "void main() {\n"
-    "  frag_color = vec4(1.0);//texture(u_texture, fs_in.tex_coords);\n"
+    "  MaterialParams params = materials[fs_in.material_index];\n"
+    "  vec4 color            = params.color;\n"
+    "\n"
+    "#if defined(DIFFUSE_MAP)\n"
+    "  color *= texture(u_texture, fs_in.tex_coords);\n"
+    "#endif\n"
+    "\n"
+    "#if defined(ALPHA_TEST)\n"
+    "  if(color.a < params.alpha_cutoff) {\n"
+    "    discard;\n"
+    "  }\n"
+    "#endif\n"
+    "\n"
+    "#if defined(LIT)\n"
+    "  color.rgb *= cluster_lighting(fs_in.view_pos, normalize(fs_in.normal));\n"
+    "#endif\n"
+    "\n"
+    "#if !defined(TRANSLUCENT)\n"
+    "  color.a = 1.0;\n"
+    "#endif\n"
+    "\n"
+    "  frag_color = color;\n"
     "};\n";
 }
 
-inline const char* default_shader_hlsl() {
-  return 
+inline const char* material_shader_hlsl() {
+  return
     "struct vs_in {"
+    "\n#if defined(QUANTIZED_COMPACT)\n"
+    "  float3 packed : PACKED;"
+    "\n#elif defined(QUANTIZED)\n"
+    "  float4 packed : PACKED;"
+    "\n#elif defined(VOXEL)\n"
+    "  float packed : PACKED;"
+    "\n#else\n"
     "  float3 position   : POS;"
     "  float3 normal     : NORMAL;"
     "  float2 tex_coords : TEX;"
+    "\n#endif\n"
+    "\n#if defined(SKINNED)\n"
+    "  float4 joints  : JOINTS;"
+    "  float4 weights : WEIGHTS;"
+    "\n#endif\n"
     "};"
     "\n"
     "struct vs_out {"
-    "  float3 position   : SV_POSITION;"
+    "  float4 position   : SV_POSITION;"
+    "  float3 normal     : NORMAL;"
     "  float2 tex_coords : TEX;"
+    "  nointerpolation uint material_index : MATERIAL;"
+    "\n#if defined(LIT)\n"
+    "  float3 view_pos : VIEW_POS;"
+    "\n#endif\n"
     "};"
     "\n"
-    "cbuff Matrices {"
+    "cbuffer DrawData : register(b0) {"
     "  float4x4 view_projection;"
+    "  float4x4 model_view;"
+    "  float4x4 normal_matrix;"
+    "  uint material_index;"
+    "  float4 terrain_node;"
+    "  float4 terrain_morph;"
     "};"
     "\n"
-    "vs_out vs_main(vs_in input) {"
-    "  vs_out out;"
+    "struct MaterialParams {"
+    "  float4 color;"
+    "  float roughness;"
+    "  float metallic;"
+    "  float alpha_cutoff;"
+    "  float padding;"
+    "};"
+    "\n"
+    "cbuffer Materials : register(b1) {"
+    "  MaterialParams materials[MATERIAL_PARAMS_MAX];"
+    "};"
+    "\n#if defined(SKINNED)\n"
+    "cbuffer SkinPalette : register(b2) {"
+    "  float4x4 palette[SKELETON_JOINTS_MAX];"
+    "};"
+    "\n#endif\n"
+    "\n"
+    "float3 octahedral_decode(float2 oct) {"
+    "  float3 n = float3(oct, 1.0 - abs(oct.x) - abs(oct.y));"
+    "  float t  = max(-n.z, 0.0);"
+    "  n.xy    += float2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);"
+    "  return normalize(n);"
+    "}"
     "\n"
-    "  out.position   = mul(view_projection, input.position);"
-    "  out.tex_coords = input.tex_coords;"
+    "uint4 packed_word_decode(float4 value) {"
+    "  uint4 word     = asuint(value);"
+    "  uint4 exponent = (((word >> 23) & 0xff) - 1) & 0x7f;"
+    "  return (word & 0x7fffff) | (exponent << 23) | ((word >> 31) << 30);"
+    "}"
+    "\n"
+    "uint read_bits(uint4 words, uint offset, uint count) {"
+    "  uint index = offset / 31;"
+    "  uint shift = offset % 31;"
+    "  uint bits  = words[index] >> shift;"
+    "  if(shift + count > 31) {"
+    "    bits |= words[index + 1] << (31 - shift);"
+    "  }"
+    "  return bits & ((1u << count) - 1);"
+    "}"
     "\n"
-    "  return out;"
+    "float read_snorm(uint4 words, uint offset, uint count) {"
+    "  int value = int(read_bits(words, offset, count) << (32 - count)) >> (32 - count);"
+    "  return max(float(value) / float((1 << (count - 1)) - 1), -1.0);"
     "}"
     "\n"
     "Texture2D text    : register(t0);"
     "SamplerState samp : register(s0);"
+    "\n#if defined(TERRAIN)\n"
+    "float terrain_sample(int2 texel) {"
+    "  uint width, height;"
+    "  text.GetDimensions(width, height);"
+    "\n"
+    "  float2 bytes = text.Load(int3(clamp(texel, int2(0, 0), int2(width, height) - 1), 0)).rg;"
+    "  return dot(bytes, float2(65280.0, 255.0) / 65535.0);"
+    "}"
+    "\n"
+    "float terrain_height(float2 xz) {"
+    "  float2 texel = xz * terrain_node.w;"
+    "  int2 base    = int2(floor(texel));"
+    "  float2 t     = texel - float2(base);"
+    "\n"
+    "  float h0 = lerp(terrain_sample(base), terrain_sample(base + int2(1, 0)), t.x);"
+    "  float h1 = lerp(terrain_sample(base + int2(0, 1)), terrain_sample(base + int2(1, 1)), t.x);"
+    "  return lerp(h0, h1, t.y) * terrain_morph.z;"
+    "}"
+    "\n"
+    "float3 terrain_normal(float2 xz) {"
+    "  float spacing = 1.0 / terrain_node.w;"
+    "  float dx      = terrain_height(xz + float2(spacing, 0.0)) - terrain_height(xz - float2(spacing, 0.0));"
+    "  float dz      = terrain_height(xz + float2(0.0, spacing)) - terrain_height(xz - float2(0.0, spacing));"
+    "  return normalize(float3(-dx, 2.0 * spacing, -dz));"
+    "}"
+    "\n#endif\n"
+    "\n"
+    "vs_out vs_main(vs_in input) {"
+    "  vs_out output;"
+    "\n#if defined(TERRAIN)\n"
+    "  float2 grid = input.position.xz;"
+    "  float2 xz   = terrain_node.xy + grid * terrain_node.z;"
+    "  float dist  = length(mul(model_view, float4(xz.x, terrain_height(xz), xz.y, 1.0)).xyz);"
+    "  float morph = saturate((dist - terrain_morph.x) * terrain_morph.y);"
+    "\n"
+    "  xz         = terrain_node.xy + (grid - frac(grid * 0.5) * 2.0 * morph) * terrain_node.z;"
+    "  float3 pos = float3(xz.x, terrain_height(xz), xz.y);"
+    "\n"
+    "  uint width, height;"
+    "  text.GetDimensions(width, height);"
+    "\n"
+    "  output.normal     = terrain_normal(xz);"
+    "  output.tex_coords = xz * terrain_node.w / float2(width, height);"
+    "\n#elif defined(QUANTIZED_COMPACT)\n"
+    "  uint4 words = packed_word_decode(float4(input.packed, 0.0));"
+    "  float3 pos  = float3(read_bits(words, 0, 15), read_bits(words, 15, 15), read_bits(words, 30, 15));"
+    "\n"
+    "  output.normal     = octahedral_decode(float2(read_snorm(words, 45, 8), read_snorm(words, 53, 8)));"
+    "  output.tex_coords = f16tof32(uint2(read_bits(words, 61, 16), read_bits(words, 77, 16)));"
+    "\n#elif defined(QUANTIZED)\n"
+    "  uint4 words = packed_word_decode(input.packed);"
+    "  float3 pos  = float3(read_bits(words, 0, 16), read_bits(words, 16, 16), read_bits(words, 32, 16));"
+    "\n"
+    "  output.normal     = octahedral_decode(float2(read_snorm(words, 48, 16), read_snorm(words, 64, 16)));"
+    "  output.tex_coords = f16tof32(uint2(read_bits(words, 80, 16), read_bits(words, 96, 16)));"
+    "\n#elif defined(VOXEL)\n"
+    "  uint word  = packed_word_decode(input.packed.xxxx).x;"
+    "  float3 pos = float3(word & 63, (word >> 6) & 63, (word >> 12) & 63);"
+    "  uint face  = (word >> 18) & 7;"
+    "\n"
+    "  output.normal     = float3((face >> 1) == uint3(0, 1, 2)) * ((face & 1) == 0 ? 1.0 : -1.0);"
+    "  output.tex_coords = float2((float(word >> 21) + 0.5) / 256.0, 0.5);"
+    "\n#elif defined(SKINNED)\n"
+    "  float4x4 skin = palette[uint(input.joints.x)] * input.weights.x +"
+    "                  palette[uint(input.joints.y)] * input.weights.y +"
+    "                  palette[uint(input.joints.z)] * input.weights.z +"
+    "                  palette[uint(input.joints.w)] * input.weights.w;"
+    "  float3 pos    = mul(skin, float4(input.position, 1.0)).xyz;"
+    "\n"
+    "  output.normal     = normalize(mul((float3x3)skin, input.normal));"
+    "  output.tex_coords = input.tex_coords;"
+    "\n#else\n"
+    "  float3 pos = input.position;"
+    "\n"
+    "  output.normal     = input.normal;"
+    "  output.tex_coords = input.tex_coords;"
+    "\n#endif\n"
+    "  output.position       = mul(view_projection, float4(pos, 1.0));"
+    "  output.material_index = material_index;"
+    "\n#if defined(LIT)\n"
+    "  output.view_pos = mul(model_view, float4(pos, 1.0)).xyz;"
+    "  output.normal   = mul((float3x3)normal_matrix, output.normal);"
+    "\n#endif\n"
+    "  return output;"
+    "}"
+    "\n#if defined(LIT)\n"
+    "struct PointLight {"
+    "  float4 position_radius;"
+    "  float4 color_intensity;"
+    "};"
+    "\n"
+    "cbuffer ClusterParams : register(b3) {"
+    "  uint4 grid_size;"
+    "  float4 tile_size;"
+    "  float4 slicing;"
+    "  float4 ambient;"
+    "};"
+    "\n"
+    "cbuffer ClusterLights : register(b4) {"
+    "  PointLight lights[CLUSTER_LIGHTS_COUNT];"
+    "};"
+    "\n"
+    "cbuffer ClusterRanges : register(b5) {"
+    "  uint4 cluster_ranges[CLUSTER_RANGES_COUNT];"
+    "};"
+    "\n"
+    "cbuffer ClusterIndices : register(b6) {"
+    "  uint4 light_indices[CLUSTER_INDICES_COUNT];"
+    "};"
+    "\n"
+    "float3 cluster_lighting(float4 frag_pos, float3 view_pos, float3 normal) {"
+    "  uint2 tile  = min(uint2(frag_pos.xy / tile_size.xy), grid_size.xy - 1);"
+    "  tile.y      = (grid_size.y - 1) - tile.y;" // The rows go bottom up, like in OpenGL
+    "  uint slice  = uint(clamp(log(-view_pos.z) * slicing.x + slicing.y, 0.0, float(grid_size.z - 1)));"
+    "  uint index  = (slice * grid_size.y + tile.y) * grid_size.x + tile.x;"
+    "\n"
+    "  uint packed = cluster_ranges[index >> 2][index & 3];"
+    "  uint2 range = uint2(packed & 0xffff, packed >> 16);"
+    "  uint last   = min(range.x + range.y, CLUSTER_INDICES_COUNT * 8);"
+    "\n"
+    "  float3 result = ambient.rgb;"
+    "  for(uint i = range.x; i < last; i++) {"
+    "    uint light_index = (light_indices[i >> 3][(i >> 1) & 3] >> ((i & 1) * 16)) & 0xffff;"
+    "    if(light_index >= grid_size.w) {"
+    "      continue;"
+    "    }"
+    "\n"
+    "    PointLight light = lights[light_index];"
+    "    float3 to_light  = light.position_radius.xyz - view_pos;"
+    "    float dist       = length(to_light);"
+    "    float falloff    = saturate(1.0 - (dist * dist) / (light.position_radius.w * light.position_radius.w));"
+    "    float lambert    = max(dot(normal, to_light / max(dist, 0.0001)), 0.0);"
+    "\n"
+    "    result += light.color_intensity.rgb * light.color_intensity.w * lambert * falloff * falloff;"
+    "  }"
+    "\n"
+    "  return result;"
+    "}"
+    "\n#endif\n"
     "\n"
-    "float4 ps_main(vs_out input) {"
-    "  return float4(1.0, 1.0, 1.0, 1.0);"
+    "float4 ps_main(vs_out input) : SV_TARGET {"
+    "  MaterialParams params = materials[input.material_index];"
+    "  float4 color          = params.color;"
+    "\n#if defined(DIFFUSE_MAP)\n"
+    "  color *= text.Sample(samp, input.tex_coords);"
+    "\n#endif\n"
+    "\n#if defined(ALPHA_TEST)\n"
+    "  clip(color.a - params.alpha_cutoff);"
+    "\n#endif\n"
+    "\n#if defined(LIT)\n"
+    "  color.rgb *= cluster_lighting(input.position, input.view_pos, normalize(input.normal));"
+    "\n#endif\n"
+    "\n#if !defined(TRANSLUCENT)\n"
+    "  color.a = 1.0;"
+    "\n#endif\n"
+    "  return color;"
     "}";
 }
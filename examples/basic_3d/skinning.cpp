@@ -0,0 +1,346 @@
+#include "skinning.h"
+#include "mesh.h"
+#include "trasform.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <new>
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define SKINNING_SIMD_SSE
+#endif
+
+// ----------------------------------------------------------------------------
+// Private functions
+static inline void mat4_mul(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#if defined(SKINNING_SIMD_SSE)
+  __m128 a0 = _mm_loadu_ps(&a[0].x);
+  __m128 a1 = _mm_loadu_ps(&a[1].x);
+  __m128 a2 = _mm_loadu_ps(&a[2].x);
+  __m128 a3 = _mm_loadu_ps(&a[3].x);
+
+  // Every column of `b` is read before the same column of `out` is written, so `out` can be `b`
+  for(int col = 0; col < 4; col++) {
+    const nikol::f32* b_col = &b[col].x;
+
+    __m128 result = _mm_mul_ps(a0, _mm_set1_ps(b_col[0]));
+    result        = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b_col[1])));
+    result        = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b_col[2])));
+    result        = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b_col[3])));
+
+    _mm_storeu_ps(&out[col].x, result);
+  }
+#else
+  out = a * b;
+#endif
+}
+
+static glm::mat4 compute_model(const Skeleton& skeleton, std::vector<glm::mat4>& models, const nikol::u32 joint) {
+  glm::mat4 local   = transform_get_model(skeleton.bind_pose[joint]);
+  nikol::u32 parent = skeleton.parents[joint];
+
+  return (parent == JOINT_INVALID) ? local : models[parent] * local;
+}
+
+#if defined(SKINNING_SIMD_SSE)
+static void skin_vertices_sse(const SkinnedVertex* in, Vertex* out, const nikol::sizei count, const glm::mat4* palette) {
+  for(nikol::sizei i = 0; i < count; i++) {
+    const SkinnedVertex& vert = in[i];
+
+    // Blend the (up to) 4 matrices, one column at a time
+    __m128 cols[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+
+    for(int j = 0; j < 4; j++) {
+      __m128 weight           = _mm_set1_ps(vert.weights[j]);
+      const nikol::f32* joint = &palette[vert.joints[j]][0].x;
+
+      cols[0] = _mm_add_ps(cols[0], _mm_mul_ps(weight, _mm_loadu_ps(joint + 0)));
+      cols[1] = _mm_add_ps(cols[1], _mm_mul_ps(weight, _mm_loadu_ps(joint + 4)));
+      cols[2] = _mm_add_ps(cols[2], _mm_mul_ps(weight, _mm_loadu_ps(joint + 8)));
+      cols[3] = _mm_add_ps(cols[3], _mm_mul_ps(weight, _mm_loadu_ps(joint + 12)));
+    }
+
+    __m128 pos = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cols[0], _mm_set1_ps(vert.position.x)), 
+                                       _mm_mul_ps(cols[1], _mm_set1_ps(vert.position.y))), 
+                            _mm_add_ps(_mm_mul_ps(cols[2], _mm_set1_ps(vert.position.z)), cols[3]));
+
+    __m128 normal = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cols[0], _mm_set1_ps(vert.normal.x)), 
+                                          _mm_mul_ps(cols[1], _mm_set1_ps(vert.normal.y))), 
+                               _mm_mul_ps(cols[2], _mm_set1_ps(vert.normal.z)));
+
+    // The 4th lane of the normal is 0 (the palette is affine), so it does not affect the length
+    __m128 len2 = _mm_mul_ps(normal, normal);
+    len2        = _mm_add_ps(len2, _mm_shuffle_ps(len2, len2, _MM_SHUFFLE(2, 3, 0, 1)));
+    len2        = _mm_add_ps(len2, _mm_shuffle_ps(len2, len2, _MM_SHUFFLE(1, 0, 3, 2)));
+    normal      = _mm_mul_ps(normal, _mm_rsqrt_ps(_mm_max_ps(len2, _mm_set1_ps(1e-12f))));
+
+    alignas(16) nikol::f32 pos_out[4], normal_out[4];
+    _mm_store_ps(pos_out, pos);
+    _mm_store_ps(normal_out, normal);
+
+    out[i].position       = glm::vec3(pos_out[0], pos_out[1], pos_out[2]);
+    out[i].normal         = glm::vec3(normal_out[0], normal_out[1], normal_out[2]);
+    out[i].texture_coords = vert.texture_coords;
+  }
+}
+#else
+static void skin_vertices_scalar(const SkinnedVertex* in, Vertex* out, const nikol::sizei count, const glm::mat4* palette) {
+  for(nikol::sizei i = 0; i < count; i++) {
+    const SkinnedVertex& vert = in[i];
+
+    glm::mat4 blended = palette[vert.joints[0]] * vert.weights[0] +
+                        palette[vert.joints[1]] * vert.weights[1] +
+                        palette[vert.joints[2]] * vert.weights[2] +
+                        palette[vert.joints[3]] * vert.weights[3];
+
+    out[i].position       = glm::vec3(blended * glm::vec4(vert.position, 1.0f));
+    out[i].normal         = glm::normalize(glm::vec3(blended * glm::vec4(vert.normal, 0.0f)));
+    out[i].texture_coords = vert.texture_coords;
+  }
+}
+#endif
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Skeleton functions
+nikol::u32 skeleton_add_joint(Skeleton& skeleton, const nikol::u32 parent, const Transform& bind_local) {
+  nikol::u32 index = (nikol::u32)skeleton.parents.size();
+
+  NIKOL_ASSERT(index < SKELETON_JOINTS_MAX, "Too many joints in a skeleton");
+  NIKOL_ASSERT(parent == JOINT_INVALID || parent < index, "A joint's parent has to be added before it");
+
+  skeleton.parents.push_back(parent);
+  skeleton.bind_pose.push_back(bind_local);
+
+  return index;
+}
+
+void skeleton_finalize(Skeleton& skeleton) {
+  nikol::sizei joints_count = skeleton.parents.size();
+
+  std::vector<glm::mat4> models(joints_count);
+  skeleton.inverse_binds.resize(joints_count);
+
+  // Only done once, so no need for anything fancy
+  for(nikol::u32 i = 0; i < joints_count; i++) {
+    models[i]                 = compute_model(skeleton, models, i);
+    skeleton.inverse_binds[i] = glm::inverse(models[i]);
+  }
+}
+// Skeleton functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SkeletonPose functions
+void skeleton_pose_init(SkeletonPose& pose, const Skeleton& skeleton) {
+  nikol::sizei joints_count = skeleton.parents.size();
+
+  pose.skeleton = &skeleton;
+  pose.locals   = skeleton.bind_pose;
+
+  pose.local_matrices.resize(joints_count);
+  pose.models.resize(joints_count);
+  pose.palette.assign(joints_count, glm::mat4(1.0f));
+}
+
+void skeleton_pose_update(SkeletonPose& pose) {
+  const Skeleton& skeleton  = *pose.skeleton;
+  nikol::sizei joints_count = skeleton.parents.size();
+
+  // Every local TRS at once (4 or 8 at a time)
+  transform_compose_batch(pose.locals.data(), pose.local_matrices.data(), joints_count);
+
+  // Parents come first, so one pass is enough
+  for(nikol::u32 i = 0; i < joints_count; i++) {
+    nikol::u32 parent = skeleton.parents[i];
+
+    if(parent == JOINT_INVALID) {
+      pose.models[i] = pose.local_matrices[i];
+    }
+    else {
+      mat4_mul(pose.models[parent], pose.local_matrices[i], pose.models[i]);
+    }
+  }
+
+  for(nikol::u32 i = 0; i < joints_count; i++) {
+    mat4_mul(pose.models[i], skeleton.inverse_binds[i], pose.palette[i]);
+  }
+}
+
+void skeleton_update_palettes(SkeletonPose* poses, const nikol::u32 count) {
+  // A pose is a few dozen microseconds of work at most, so a handful go into every job
+  job_system_parallel_for(count, 8, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      skeleton_pose_update(poses[i]);
+    }
+  });
+}
+// SkeletonPose functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SkinnedMesh functions
+SkinnedMesh* skinned_mesh_create(nikol::GfxContext* gfx, 
+                                 const std::vector<SkinnedVertex>& vertices, 
+                                 const std::vector<nikol::u32>& indices, 
+                                 const SkinningPath path) {
+  SkinnedMesh* mesh = new (nikol::memory_allocate(sizeof(SkinnedMesh))) SkinnedMesh();
+
+  mesh->path     = path;
+  mesh->vertices = vertices;
+  skinning_compute_joint_spheres(vertices, mesh->joint_spheres);
+
+  if(path == SKINNING_PATH_CPU) {
+    mesh->skinned.resize(vertices.size());
+
+    // Starting out in the bind pose
+    for(nikol::sizei i = 0; i < vertices.size(); i++) {
+      mesh->skinned[i] = Vertex{vertices[i].position, vertices[i].normal, vertices[i].texture_coords};
+    }
+
+    mesh->mesh = mesh_create_dynamic(gfx, mesh->skinned, indices);
+    return mesh;
+  }
+
+  // Only the bind pose goes up, once
+  std::vector<SkinnedGpuVertex> gpu_vertices(vertices.size());
+  glm::vec3 min = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+  glm::vec3 max = min;
+
+  for(nikol::sizei i = 0; i < vertices.size(); i++) {
+    const SkinnedVertex& vert = vertices[i];
+
+    gpu_vertices[i] = SkinnedGpuVertex{
+      .position       = vert.position, 
+      .normal         = vert.normal, 
+      .texture_coords = vert.texture_coords, 
+      .joints         = glm::vec4(vert.joints[0], vert.joints[1], vert.joints[2], vert.joints[3]), 
+      .weights        = vert.weights,
+    };
+
+    min = glm::min(min, vert.position);
+    max = glm::max(max, vert.position);
+  }
+
+  mesh->mesh = mesh_create(gfx, gpu_vertices.data(), (nikol::u32)gpu_vertices.size(), VERTEX_FORMAT_SKINNED, indices, min, max);
+  return mesh;
+}
+
+void skinned_mesh_destroy(SkinnedMesh* mesh) {
+  if(!mesh) {
+    return;
+  }
+
+  mesh_destroy(mesh->mesh);
+
+  mesh->~SkinnedMesh();
+  nikol::memory_free(mesh);
+}
+
+void skinned_mesh_compute_bounds(const SkinnedMesh* mesh, const glm::mat4* palette, glm::vec3& center, nikol::f32& radius) {
+  skinning_compute_bounds(mesh->joint_spheres, palette, center, radius);
+}
+
+void skinned_mesh_skin(SkinnedMesh* mesh, const glm::mat4* palette) {
+  NIKOL_ASSERT(mesh->path == SKINNING_PATH_CPU, "Only the CPU path skins on the CPU");
+
+  skinning_apply(mesh->vertices.data(), mesh->skinned.data(), mesh->vertices.size(), palette);
+  skinned_mesh_compute_bounds(mesh, palette, mesh->mesh->bounds_center, mesh->mesh->bounds_radius);
+}
+
+void skinned_mesh_upload(nikol::GfxContext* gfx, SkinnedMesh* mesh) {
+  NIKOL_ASSERT(mesh->path == SKINNING_PATH_CPU, "Only the CPU path streams its vertices");
+
+  nikol::gfx_buffer_update(gfx, mesh->mesh->pipe_desc.vertex_buffer, 0, mesh->skinned.size() * sizeof(Vertex), mesh->skinned.data());
+}
+
+void skinning_apply(const SkinnedVertex* in, Vertex* out, const nikol::sizei count, const glm::mat4* palette) {
+#if defined(SKINNING_SIMD_SSE)
+  skin_vertices_sse(in, out, count, palette);
+#else
+  skin_vertices_scalar(in, out, count, palette);
+#endif
+}
+
+void skinning_compute_joint_spheres(const std::vector<SkinnedVertex>& vertices, std::vector<glm::vec4>& spheres) {
+  spheres.assign(SKELETON_JOINTS_MAX, glm::vec4(0.0f));
+  std::vector<nikol::u32> counts(SKELETON_JOINTS_MAX, 0);
+
+  nikol::u32 joints_count = 0;
+  for(auto& vert : vertices) {
+    for(int i = 0; i < 4; i++) {
+      if(vert.weights[i] <= 0.0f) {
+        continue;
+      }
+
+      nikol::u32 joint = vert.joints[i];
+      spheres[joint]  += glm::vec4(vert.position, 0.0f);
+      counts[joint]   += 1;
+      joints_count     = glm::max(joints_count, joint + 1);
+    }
+  }
+
+  spheres.resize(joints_count);
+  for(nikol::u32 i = 0; i < joints_count; i++) {
+    spheres[i] = counts[i] ? glm::vec4(glm::vec3(spheres[i]) / (nikol::f32)counts[i], 0.0f) : glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+  }
+
+  for(auto& vert : vertices) {
+    for(int i = 0; i < 4; i++) {
+      if(vert.weights[i] <= 0.0f) {
+        continue;
+      }
+
+      glm::vec4& sphere = spheres[vert.joints[i]];
+      sphere.w          = glm::max(sphere.w, glm::length(vert.position - glm::vec3(sphere)));
+    }
+  }
+}
+
+void skinning_compute_bounds(const std::vector<glm::vec4>& joint_spheres, const glm::mat4* palette, glm::vec3& center, nikol::f32& radius) {
+  glm::vec3 min = glm::vec3(FLT_MAX);
+  glm::vec3 max = glm::vec3(-FLT_MAX);
+
+  for(nikol::u32 i = 0; i < joint_spheres.size(); i++) {
+    const glm::vec4& sphere = joint_spheres[i];
+    if(sphere.w < 0.0f) {
+      continue;
+    }
+
+    glm::vec3 posed = glm::vec3(palette[i] * glm::vec4(glm::vec3(sphere), 1.0f));
+    min             = glm::min(min, posed);
+    max             = glm::max(max, posed);
+  }
+
+  // No vertex is bound to any joint
+  if(min.x > max.x) {
+    center = glm::vec3(0.0f);
+    radius = 0.0f;
+    return;
+  }
+
+  center = (min + max) * 0.5f;
+  radius = 0.0f;
+
+  // Each vertex is a blend of where its joints move it, so it stays within the largest of their (scaled) spheres
+  for(nikol::u32 i = 0; i < joint_spheres.size(); i++) {
+    const glm::vec4& sphere = joint_spheres[i];
+    if(sphere.w < 0.0f) {
+      continue;
+    }
+
+    const glm::mat4& joint = palette[i];
+    nikol::f32 scale       = glm::max(glm::length(glm::vec3(joint[0])), glm::max(glm::length(glm::vec3(joint[1])), glm::length(glm::vec3(joint[2]))));
+    glm::vec3 posed        = glm::vec3(joint * glm::vec4(glm::vec3(sphere), 1.0f));
+
+    radius = glm::max(radius, glm::length(posed - center) + sphere.w * scale);
+  }
+}
+// SkinnedMesh functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "vertex.h"
+#include "mesh.h"
+#include "trasform.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Joint indices are 8-bit (see `SkinnedVertex`)
+const nikol::u32 SKELETON_JOINTS_MAX = 256;
+
+const nikol::u32 JOINT_INVALID = 0xffffffff;
+
+// The palette uniform block of the skinned permutations (see `MATERIAL_FEATURE_SKINNED`)
+const nikol::sizei SKINNING_PALETTE_SIZE = SKELETON_JOINTS_MAX * sizeof(glm::mat4);
+static_assert(SKINNING_PALETTE_SIZE <= 16 * 1024, "The palette has to fit in the smallest uniform buffer a backend has to support");
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Skeleton
+// The joints are stored parents first, so every model space matrix can be built in one pass.
+// Shared by every character using it.
+struct Skeleton {
+  std::vector<nikol::u32> parents;  // `JOINT_INVALID` for the roots
+  std::vector<Transform> bind_pose; // Local to the parent
+
+  // Model space -> joint space in the bind pose (see `skeleton_finalize`)
+  std::vector<glm::mat4> inverse_binds;
+};
+// Skeleton
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SkeletonPose
+// One character's pose. The animation writes `locals` and `skeleton_update_palettes`
+// turns them into the joint palette the vertices get skinned with.
+struct SkeletonPose {
+  const Skeleton* skeleton = nullptr;
+
+  std::vector<Transform> locals;
+
+  // Scratch space, then the results
+  std::vector<glm::mat4> local_matrices;
+  std::vector<glm::mat4> models;  // Model space joints
+  std::vector<glm::mat4> palette; // `models * inverse_binds`
+};
+// SkeletonPose
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SkinningPath
+enum SkinningPath {
+  // The bind pose gets uploaded once and the skinned permutations deform it with the draw's palette
+  SKINNING_PATH_GPU = 0,
+
+  // For when the backend cannot skin in the vertex shader: the deformed vertices get written on
+  // the CPU and streamed into a dynamic mesh every frame. That mesh draws like any other.
+  SKINNING_PATH_CPU,
+};
+// SkinningPath
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SkinnedMesh
+struct SkinnedMesh {
+  SkinningPath path;
+
+  std::vector<SkinnedVertex> vertices; // Bind pose
+  std::vector<Vertex> skinned;         // Output of the last `skinned_mesh_skin` (CPU path only)
+
+  // Per joint, the center (in the bind pose) and radius of the vertices it moves. Every skinned 
+  // vertex ends up within the posed spheres, which is what the bounds get rebuilt from.
+  std::vector<glm::vec4> joint_spheres;
+
+  Mesh* mesh = nullptr;
+};
+// SkinnedMesh
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Skeleton functions
+
+// `parent` has to be added already (or be `JOINT_INVALID`). Returns the index of the joint.
+nikol::u32 skeleton_add_joint(Skeleton& skeleton, const nikol::u32 parent, const Transform& bind_local);
+
+// Compute the inverse bind matrices once every joint is in
+void skeleton_finalize(Skeleton& skeleton);
+// Skeleton functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SkeletonPose functions
+
+// Starts out in the bind pose
+void skeleton_pose_init(SkeletonPose& pose, const Skeleton& skeleton);
+
+// Rebuild the palette of a single pose with SIMD
+void skeleton_pose_update(SkeletonPose& pose);
+
+// Same as above for `count` poses, spread over the job system
+void skeleton_update_palettes(SkeletonPose* poses, const nikol::u32 count);
+// SkeletonPose functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SkinnedMesh functions
+
+// The GPU path uploads the vertices as `VERTEX_FORMAT_SKINNED`, the CPU path as a dynamic mesh (see `SkinningPath`)
+SkinnedMesh* skinned_mesh_create(nikol::GfxContext* gfx, 
+                                 const std::vector<SkinnedVertex>& vertices, 
+                                 const std::vector<nikol::u32>& indices, 
+                                 const SkinningPath path = SKINNING_PATH_GPU);
+void skinned_mesh_destroy(SkinnedMesh* mesh);
+
+// The mesh's bounding sphere moved along with `palette` (from the joint spheres, so it is only a few 
+// dozen matrices of work). The bind pose bounds would not hold anymore once the character moves. 
+// Leaves the mesh alone, since every character sharing it has its own pose.
+void skinned_mesh_compute_bounds(const SkinnedMesh* mesh, const glm::mat4* palette, glm::vec3& center, nikol::f32& radius);
+
+// CPU path only. Deform every vertex with `palette` (linear blend skinning) and move the mesh's bounds 
+// along (the streamed vertices only hold one pose anyway). Touches no GPU state, so any thread can do it.
+void skinned_mesh_skin(SkinnedMesh* mesh, const glm::mat4* palette);
+
+// CPU path only. Stream the last skinned vertices into the mesh's vertex buffer.
+void skinned_mesh_upload(nikol::GfxContext* gfx, SkinnedMesh* mesh);
+
+// The skinning kernel itself (SIMD when available)
+void skinning_apply(const SkinnedVertex* in, Vertex* out, const nikol::sizei count, const glm::mat4* palette);
+
+// One sphere per joint (center in the bind pose, radius in `w`) around the vertices with any weight on it. 
+// The joints no vertex uses get a negative radius.
+void skinning_compute_joint_spheres(const std::vector<SkinnedVertex>& vertices, std::vector<glm::vec4>& spheres);
+
+// A bounding sphere of every vertex skinned with `palette`, out of the posed `joint_spheres`
+void skinning_compute_bounds(const std::vector<glm::vec4>& joint_spheres, const glm::mat4* palette, glm::vec3& center, nikol::f32& radius);
+// SkinnedMesh functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,94 @@
+#include "sorted_mesh.h"
+#include "mesh.h"
+#include "radix_sort.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// SortedMesh functions
+void sorted_mesh_build(SortedMesh& mesh, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  NIKOL_ASSERT((indices.size() % 3) == 0, "A sorted mesh has to be made of triangles");
+
+  nikol::u32 triangles_count = (nikol::u32)(indices.size() / 3);
+
+  mesh.indices = indices;
+  mesh.sorted_indices.resize(indices.size());
+  mesh.last_axis = glm::vec4(0.0f);
+  mesh.stats     = {};
+
+  for(auto& axis : mesh.centroids) {
+    axis.resize(triangles_count);
+  }
+
+  for(nikol::u32 i = 0; i < triangles_count; i++) {
+    glm::vec3 centroid = (vertices[indices[i * 3 + 0]].position +
+                          vertices[indices[i * 3 + 1]].position +
+                          vertices[indices[i * 3 + 2]].position) / 3.0f;
+
+    mesh.centroids[0][i] = centroid.x;
+    mesh.centroids[1][i] = centroid.y;
+    mesh.centroids[2][i] = centroid.z;
+  }
+}
+
+void sorted_mesh_sort(SortedMesh& mesh, const glm::mat4& model_view) {
+  nikol::f64 start = nikol::niclock_get_time();
+
+  nikol::u32 triangles_count = (nikol::u32)mesh.centroids[0].size();
+  mesh.stats.triangles_count = triangles_count;
+
+  // The view space depth is the third row of the model view (negated, since the view looks down -Z)
+  glm::vec4 axis = -glm::vec4(model_view[0][2], model_view[1][2], model_view[2][2], model_view[3][2]);
+
+  mesh.stats.is_skipped = axis == mesh.last_axis;
+  if(mesh.stats.is_skipped) {
+    mesh.stats.sort_time = 0.0;
+    return;
+  }
+
+  mesh.last_axis = axis;
+
+  // Plain SoA loops, so the compiler is free to vectorize them
+  mesh.depths.resize(triangles_count);
+
+  const nikol::f32* xs = mesh.centroids[0].data();
+  const nikol::f32* ys = mesh.centroids[1].data();
+  const nikol::f32* zs = mesh.centroids[2].data();
+  nikol::f32* depths   = mesh.depths.data();
+
+  for(nikol::u32 i = 0; i < triangles_count; i++) {
+    depths[i] = axis.x * xs[i] + axis.y * ys[i] + axis.z * zs[i] + axis.w;
+  }
+
+  // The furthest first
+  radix_sort_floats(mesh.sort, depths, triangles_count, true);
+
+  const nikol::u32* order = mesh.sort.order.data();
+  for(nikol::u32 i = 0; i < triangles_count; i++) {
+    const nikol::u32* triangle = &mesh.indices[order[i] * 3];
+
+    mesh.sorted_indices[i * 3 + 0] = triangle[0];
+    mesh.sorted_indices[i * 3 + 1] = triangle[1];
+    mesh.sorted_indices[i * 3 + 2] = triangle[2];
+  }
+
+  mesh.stats.sort_time = (nikol::niclock_get_time() - start) * 1000.0;
+}
+
+void sorted_mesh_upload(nikol::GfxContext* gfx, SortedMesh& mesh, const std::vector<Vertex>& vertices) {
+  if(mesh.mesh) {
+    mesh_destroy(mesh.mesh);
+  }
+
+  mesh.mesh = mesh_create_dynamic(gfx, vertices, mesh.indices);
+}
+
+void sorted_mesh_destroy(SortedMesh& mesh) {
+  mesh_destroy(mesh.mesh);
+  mesh.mesh = nullptr;
+}
+// SortedMesh functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "mesh.h"
+#include "vertex.h"
+#include "radix_sort.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// SortedMeshStats
+// Per sort (see `sorted_mesh_sort`)
+struct SortedMeshStats {
+  nikol::u32 triangles_count = 0;
+  bool is_skipped            = false; // The view did not change since the last sort
+
+  nikol::f64 sort_time = 0.0; // In milliseconds, the depths and the gathering included
+};
+// SortedMeshStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SortedMesh
+// A translucent mesh whose triangles get sorted back to front for every view, so it blends right over
+// itself as well, not just over the rest of the scene. The triangles are sorted by the view space depth
+// of their centroids, so intersecting (or long and overlapping) triangles can still come out wrong.
+//
+// Every sort writes the triangles into `sorted_indices`, which gets streamed into the index buffer
+// (see `render_sorted_mesh`). Only worth it for big meshes that can actually overlap themselves.
+struct SortedMesh {
+  std::vector<nikol::u32> indices; // As given
+
+  // The centroid of every triangle in object space, as SoA arrays (x, y and z)
+  std::vector<nikol::f32> centroids[3];
+
+  // Per sort
+  std::vector<nikol::f32> depths;
+  std::vector<nikol::u32> sorted_indices;
+  RadixSort sort;
+  SortedMeshStats stats;
+
+  // The view axis of the last sort, in object space (see `sorted_mesh_sort`)
+  glm::vec4 last_axis = glm::vec4(0.0f);
+
+  Mesh* mesh = nullptr;
+};
+// SortedMesh
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SortedMesh functions
+
+// Find the centroids of the triangles of `indices`. Anything built before is replaced.
+void sorted_mesh_build(SortedMesh& mesh, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices);
+
+// Sort the triangles back to front for `model_view` into `sorted_indices`. Nothing gets done if
+// the model view's depth axis is the same as the last time (a still camera and mesh).
+void sorted_mesh_sort(SortedMesh& mesh, const glm::mat4& model_view);
+
+// Create the mesh from `vertices` (the ones given to `sorted_mesh_build`) with a dynamic index buffer
+void sorted_mesh_upload(nikol::GfxContext* gfx, SortedMesh& mesh, const std::vector<Vertex>& vertices);
+
+// Destroys the mesh
+void sorted_mesh_destroy(SortedMesh& mesh);
+// SortedMesh functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,227 @@
+#include "static_batch.h"
+#include "mesh.h"
+#include "material.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// The slots are unique and do not depend on where the materials were allocated, so the chunks come out
+// in the same order every run. The default material (`nullptr`) goes last.
+static nikol::u32 get_material_key(const Material* material) {
+  return material ? material->slot : MATERIAL_SLOT_INVALID;
+}
+
+static nikol::u32 longest_axis(const glm::vec3& extent) {
+  if(extent.x >= extent.y && extent.x >= extent.z) {
+    return 0;
+  }
+
+  return (extent.y >= extent.z) ? 1 : 2;
+}
+
+// Split `[first, last)` of `objects` in two along the longest axis of their centers until every piece is small enough
+static void split_objects(StaticBatch& batch, 
+                          std::vector<StaticBatchObject*>& objects, 
+                          const nikol::u32 first, 
+                          const nikol::u32 last, 
+                          std::vector<nikol::u32>& chunk_firsts) {
+  glm::vec3 bounds_min = objects[first]->bounds_min, bounds_max = objects[first]->bounds_max;
+  glm::vec3 center_min = (bounds_min + bounds_max) * 0.5f, center_max = center_min;
+  nikol::u32 vertices_count = 0;
+
+  for(nikol::u32 i = first; i < last; i++) {
+    const StaticBatchObject* obj = objects[i];
+    glm::vec3 center             = (obj->bounds_min + obj->bounds_max) * 0.5f;
+
+    bounds_min      = glm::min(bounds_min, obj->bounds_min);
+    bounds_max      = glm::max(bounds_max, obj->bounds_max);
+    center_min      = glm::min(center_min, center);
+    center_max      = glm::max(center_max, center);
+    vertices_count += (nikol::u32)obj->vertices->size();
+  }
+
+  glm::vec3 extent = bounds_max - bounds_min;
+  bool is_small    = vertices_count <= STATIC_BATCH_MAX_VERTICES && glm::max(extent.x, glm::max(extent.y, extent.z)) <= STATIC_BATCH_MAX_EXTENT;
+  bool can_split   = (last - first) > 1;
+
+  if(is_small || !can_split) {
+    StaticBatchChunk chunk;
+    chunk.material      = objects[first]->material;
+    chunk.bounds_min    = bounds_min;
+    chunk.bounds_max    = bounds_max;
+    chunk.objects_count = last - first;
+
+    batch.chunks.push_back(chunk);
+    chunk_firsts.push_back(first);
+    return;
+  }
+
+  // Median split, so both halves get the same number of objects no matter how they are spread out
+  nikol::u32 axis   = longest_axis(center_max - center_min);
+  nikol::u32 middle = first + (last - first) / 2;
+
+  std::nth_element(objects.begin() + first, objects.begin() + middle, objects.begin() + last, [axis](const StaticBatchObject* a, const StaticBatchObject* b) {
+    return (a->bounds_min[axis] + a->bounds_max[axis]) < (b->bounds_min[axis] + b->bounds_max[axis]);
+  });
+
+  split_objects(batch, objects, first, middle, chunk_firsts);
+  split_objects(batch, objects, middle, last, chunk_firsts);
+}
+
+static void fill_chunk(StaticBatchChunk& chunk, StaticBatchObject* const* objects, const nikol::u32 count) {
+  nikol::u32 vertices_count = 0, indices_count = 0;
+  for(nikol::u32 i = 0; i < count; i++) {
+    vertices_count += (nikol::u32)objects[i]->vertices->size();
+    indices_count  += (nikol::u32)objects[i]->indices->size();
+  }
+
+  chunk.vertices.resize(vertices_count);
+  chunk.indices.resize(indices_count);
+
+  // The boxes were only approximations so far
+  chunk.bounds_min = glm::vec3( 1e30f);
+  chunk.bounds_max = glm::vec3(-1e30f);
+
+  Vertex* out_vert    = chunk.vertices.data();
+  nikol::u32* out_idx = chunk.indices.data();
+  nikol::u32 base     = 0;
+
+  for(nikol::u32 i = 0; i < count; i++) {
+    const StaticBatchObject* obj = objects[i];
+    glm::mat3 normal_matrix      = glm::transpose(glm::inverse(glm::mat3(obj->model)));
+
+    for(auto& vert : *obj->vertices) {
+      out_vert->position       = glm::vec3(obj->model * glm::vec4(vert.position, 1.0f));
+      out_vert->normal         = glm::normalize(normal_matrix * vert.normal);
+      out_vert->texture_coords = vert.texture_coords;
+
+      chunk.bounds_min = glm::min(chunk.bounds_min, out_vert->position);
+      chunk.bounds_max = glm::max(chunk.bounds_max, out_vert->position);
+      out_vert++;
+    }
+
+    for(auto index : *obj->indices) {
+      *out_idx++ = base + index;
+    }
+
+    base += (nikol::u32)obj->vertices->size();
+  }
+}
+
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StaticBatch functions
+void static_batch_add(StaticBatch& batch, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, Material* material, const glm::mat4& model) {
+  if(vertices.empty() || indices.empty()) {
+    return;
+  }
+
+  glm::vec3 local_min = vertices[0].position, local_max = local_min;
+  for(auto& vert : vertices) {
+    local_min = glm::min(local_min, vert.position);
+    local_max = glm::max(local_max, vert.position);
+  }
+
+  // The 8 corners of the local box, into world space
+  glm::vec3 world_min = glm::vec3( 1e30f);
+  glm::vec3 world_max = glm::vec3(-1e30f);
+
+  for(int i = 0; i < 8; i++) {
+    glm::vec3 corner = glm::vec3((i & 1) ? local_max.x : local_min.x,
+                                 (i & 2) ? local_max.y : local_min.y,
+                                 (i & 4) ? local_max.z : local_min.z);
+    glm::vec3 world  = glm::vec3(model * glm::vec4(corner, 1.0f));
+
+    world_min = glm::min(world_min, world);
+    world_max = glm::max(world_max, world);
+  }
+
+  batch.objects.push_back(StaticBatchObject{&vertices, &indices, material, model, world_min, world_max});
+}
+
+void static_batch_build(StaticBatch& batch) {
+  if(batch.objects.empty()) {
+    return;
+  }
+
+  // Grouping by material slot first (stable, so the objects keep the order they were added in within a material)
+  std::vector<StaticBatchObject*> objects(batch.objects.size());
+  for(nikol::sizei i = 0; i < objects.size(); i++) {
+    objects[i] = &batch.objects[i];
+  }
+
+  std::stable_sort(objects.begin(), objects.end(), [](const StaticBatchObject* a, const StaticBatchObject* b) {
+    return get_material_key(a->material) < get_material_key(b->material);
+  });
+
+  // Where the objects of every new chunk start in `objects`
+  std::vector<nikol::u32> chunk_firsts;
+
+  nikol::u32 first_chunk = (nikol::u32)batch.chunks.size();
+  nikol::u32 group_start = 0;
+
+  for(nikol::u32 i = 1; i <= objects.size(); i++) {
+    if(i < objects.size() && objects[i]->material == objects[group_start]->material) {
+      continue;
+    }
+
+    split_objects(batch, objects, group_start, i, chunk_firsts);
+
+    batch.stats.materials_count++;
+    group_start = i;
+  }
+
+  // Every chunk is independent from here on
+  job_system_parallel_for((nikol::u32)chunk_firsts.size(), 1, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      StaticBatchChunk& chunk = batch.chunks[first_chunk + i];
+      fill_chunk(chunk, &objects[chunk_firsts[i]], chunk.objects_count);
+    }
+  });
+
+  for(nikol::u32 i = first_chunk; i < batch.chunks.size(); i++) {
+    batch.stats.vertices_count  += (nikol::u32)batch.chunks[i].vertices.size();
+    batch.stats.triangles_count += (nikol::u32)batch.chunks[i].indices.size() / 3;
+  }
+
+  batch.stats.objects_count += (nikol::u32)batch.objects.size();
+  batch.stats.chunks_count   = (nikol::u32)batch.chunks.size();
+  batch.objects.clear();
+}
+
+void static_batch_upload(nikol::GfxContext* gfx, StaticBatch& batch) {
+  for(auto& chunk : batch.chunks) {
+    if(chunk.mesh) {
+      continue;
+    }
+
+    chunk.mesh = mesh_create(gfx, chunk.vertices, chunk.indices);
+
+    chunk.vertices = std::vector<Vertex>();
+    chunk.indices  = std::vector<nikol::u32>();
+  }
+}
+
+void static_batch_destroy(StaticBatch& batch) {
+  for(auto& chunk : batch.chunks) {
+    if(chunk.mesh) {
+      mesh_destroy(chunk.mesh);
+    }
+  }
+
+  batch.chunks.clear();
+  batch.objects.clear();
+  batch.stats = {};
+}
+
+// StaticBatch functions
+// ----------------------------------------------------------------------------
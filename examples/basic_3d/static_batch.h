@@ -0,0 +1,103 @@
+#pragma once
+
+#include "vertex.h"
+#include "mesh.h"
+#include "material.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// A chunk gets split in two as long as it has more vertices than this (so most chunks
+// still fit 16-bit indices) or covers more than `STATIC_BATCH_MAX_EXTENT` on any axis.
+const nikol::u32 STATIC_BATCH_MAX_VERTICES = 1 << 16;
+const nikol::f32 STATIC_BATCH_MAX_EXTENT   = 32.0f;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StaticBatchObject
+// A static piece of the scene waiting for `static_batch_build`. The geometry is not copied.
+struct StaticBatchObject {
+  const std::vector<Vertex>* vertices;
+  const std::vector<nikol::u32>* indices;
+
+  Material* material;
+  glm::mat4 model;
+
+  // World space box around the object (its local box transformed)
+  glm::vec3 bounds_min, bounds_max;
+};
+// StaticBatchObject
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StaticBatchChunk
+// One draw: every object of a material in one region of space, already in world space
+struct StaticBatchChunk {
+  Material* material;
+
+  // Released once uploaded
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+
+  glm::vec3 bounds_min, bounds_max;
+  nikol::u32 objects_count;
+
+  Mesh* mesh = nullptr;
+};
+// StaticBatchChunk
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StaticBatchStats
+struct StaticBatchStats {
+  nikol::u32 objects_count   = 0; // How many draws it would have been without batching
+  nikol::u32 materials_count = 0;
+  nikol::u32 chunks_count    = 0;
+
+  nikol::u32 vertices_count  = 0;
+  nikol::u32 triangles_count = 0;
+
+  // Per frame (see `render_static_batch`)
+  nikol::u32 chunks_visible = 0;
+};
+// StaticBatchStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StaticBatch
+// Static geometry merged at load time. Every object gets pre-transformed into world space and
+// concatenated with the others using the same material, so the whole scene is drawn with a handful
+// of `render_mesh` calls. Each material's objects are split in two along their longest axis until
+// every chunk is small enough to be culled on its own.
+struct StaticBatch {
+  std::vector<StaticBatchObject> objects;
+  std::vector<StaticBatchChunk> chunks;
+
+  StaticBatchStats stats;
+};
+// StaticBatch
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StaticBatch functions
+
+// `vertices` and `indices` have to stay alive until `static_batch_build`. A `nullptr` material is the renderer's default one.
+void static_batch_add(StaticBatch& batch, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices, Material* material, const glm::mat4& model);
+
+// Group, split and pre-transform every object added so far into `chunks` (using the job system).
+// Forgets the objects afterwards. No GPU work is done here, so it can run on any thread.
+void static_batch_build(StaticBatch& batch);
+
+// Create a mesh for every chunk and release the CPU copies of the vertices
+void static_batch_upload(nikol::GfxContext* gfx, StaticBatch& batch);
+
+// Destroys the meshes of every chunk
+void static_batch_destroy(StaticBatch& batch);
+// StaticBatch functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,408 @@
+#include "terrain.h"
+#include "mesh.h"
+#include "vertex.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <stb/stb_image.h>
+
+#include <vector>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// How many rows of leaves a job gets when building the quadtree
+const nikol::u32 BUILD_BATCH_SIZE = 4;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// FrustumResult
+enum FrustumResult {
+  FRUSTUM_OUTSIDE = 0,
+  FRUSTUM_INTERSECTS,
+  FRUSTUM_INSIDE,
+};
+// FrustumResult
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// SelectContext
+struct SelectContext {
+  glm::vec4 planes[6];
+  glm::vec3 eye;
+};
+// SelectContext
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static FrustumResult test_box(const glm::vec4* planes, const glm::vec3& min, const glm::vec3& max) {
+  FrustumResult result = FRUSTUM_INSIDE;
+
+  for(int i = 0; i < 6; i++) {
+    const glm::vec4& plane = planes[i];
+
+    // The corners furthest along the plane's normal and against it
+    glm::vec3 front = glm::vec3(plane.x >= 0.0f ? max.x : min.x,
+                                plane.y >= 0.0f ? max.y : min.y,
+                                plane.z >= 0.0f ? max.z : min.z);
+    glm::vec3 back  = glm::vec3(plane.x >= 0.0f ? min.x : max.x,
+                                plane.y >= 0.0f ? min.y : max.y,
+                                plane.z >= 0.0f ? min.z : max.z);
+
+    if(glm::dot(glm::vec3(plane), front) + plane.w < 0.0f) {
+      return FRUSTUM_OUTSIDE;
+    }
+
+    if(glm::dot(glm::vec3(plane), back) + plane.w < 0.0f) {
+      result = FRUSTUM_INTERSECTS;
+    }
+  }
+
+  return result;
+}
+
+static bool is_box_in_range(const glm::vec3& min, const glm::vec3& max, const glm::vec3& eye, const nikol::f32 range) {
+  glm::vec3 closest = glm::clamp(eye, min, max);
+  glm::vec3 diff    = closest - eye;
+
+  return glm::dot(diff, diff) <= range * range;
+}
+
+static void get_node_bounds(const Terrain& terrain, const nikol::u32 level, const nikol::u32 x, const nikol::u32 z, glm::vec3& min, glm::vec3& max) {
+  const TerrainLevel& lvl = terrain.levels[level];
+  nikol::u32 index        = lvl.first_node + z * lvl.nodes_x + x;
+  nikol::f32 height_scale = terrain.desc.height / 65535.0f;
+
+  min = terrain.desc.origin + glm::vec3(x * lvl.node_size, terrain.nodes_min[index] * height_scale, z * lvl.node_size);
+  max = terrain.desc.origin + glm::vec3((x + 1) * lvl.node_size, terrain.nodes_max[index] * height_scale, (z + 1) * lvl.node_size);
+}
+
+// The lowest and highest sample under every leaf. A leaf shares its last row and column of samples with its neighbours.
+static void build_leaves(Terrain& terrain) {
+  const TerrainLevel& leaves = terrain.levels[0];
+  nikol::u32 patch_size      = terrain.desc.patch_size;
+
+  job_system_parallel_for(leaves.nodes_z, BUILD_BATCH_SIZE, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 z = start; z < end; z++) {
+      nikol::u32 z0 = glm::min(z * patch_size, terrain.depth - 1);
+      nikol::u32 z1 = glm::min(z0 + patch_size, terrain.depth - 1);
+
+      for(nikol::u32 x = 0; x < leaves.nodes_x; x++) {
+        nikol::u32 x0 = glm::min(x * patch_size, terrain.width - 1);
+        nikol::u32 x1 = glm::min(x0 + patch_size, terrain.width - 1);
+
+        nikol::u16 low = 0xffff, high = 0;
+        for(nikol::u32 row = z0; row <= z1; row++) {
+          const nikol::u16* samples = &terrain.heights[row * terrain.width];
+
+          for(nikol::u32 col = x0; col <= x1; col++) {
+            low  = std::min(low, samples[col]);
+            high = std::max(high, samples[col]);
+          }
+        }
+
+        terrain.nodes_min[leaves.first_node + z * leaves.nodes_x + x] = low;
+        terrain.nodes_max[leaves.first_node + z * leaves.nodes_x + x] = high;
+      }
+    }
+  });
+}
+
+// Every other level out of the one below it
+static void build_parents(Terrain& terrain) {
+  for(nikol::u32 level = 1; level < terrain.levels_count; level++) {
+    const TerrainLevel& lvl   = terrain.levels[level];
+    const TerrainLevel& child = terrain.levels[level - 1];
+
+    for(nikol::u32 z = 0; z < lvl.nodes_z; z++) {
+      for(nikol::u32 x = 0; x < lvl.nodes_x; x++) {
+        nikol::u16 low = 0xffff, high = 0;
+
+        for(nikol::u32 i = 0; i < 4; i++) {
+          nikol::u32 cx = x * 2 + (i & 1);
+          nikol::u32 cz = z * 2 + (i >> 1);
+
+          if(cx >= child.nodes_x || cz >= child.nodes_z) {
+            continue;
+          }
+
+          nikol::u32 index = child.first_node + cz * child.nodes_x + cx;
+          low              = std::min(low, terrain.nodes_min[index]);
+          high             = std::max(high, terrain.nodes_max[index]);
+        }
+
+        terrain.nodes_min[lvl.first_node + z * lvl.nodes_x + x] = low;
+        terrain.nodes_max[lvl.first_node + z * lvl.nodes_x + x] = high;
+      }
+    }
+  }
+}
+
+static void add_node(Terrain& terrain, 
+                     const nikol::u32 level, 
+                     const nikol::u32 x, 
+                     const nikol::u32 z, 
+                     const TerrainPart part, 
+                     const glm::vec3& min, 
+                     const glm::vec3& max) {
+  const TerrainLevel& lvl = terrain.levels[level];
+
+  TerrainNode node;
+  node.node       = glm::vec4(x * lvl.node_size, z * lvl.node_size, lvl.node_size / terrain.desc.patch_size, 1.0f / terrain.desc.spacing);
+  node.morph      = glm::vec4(lvl.morph_start, 1.0f / (lvl.range - lvl.morph_start), terrain.desc.height, 0.0f);
+  node.bounds_min = min;
+  node.bounds_max = max;
+  node.level      = level;
+  node.part       = part;
+
+  nikol::u32 cells = (part == TERRAIN_PART_WHOLE) ? terrain.desc.patch_size : terrain.desc.patch_size / 2;
+
+  terrain.selection.push_back(node);
+  terrain.stats.nodes_per_level[level]++;
+  terrain.stats.triangles_count += cells * cells * 2;
+}
+
+// Returns false if the node is out of its level's range, leaving it to its parent to draw
+static bool select_node(Terrain& terrain, const SelectContext& ctx, const nikol::u32 level, const nikol::u32 x, const nikol::u32 z, bool is_inside) {
+  const TerrainLevel& lvl = terrain.levels[level];
+  terrain.stats.nodes_visited++;
+
+  glm::vec3 min, max;
+  get_node_bounds(terrain, level, x, z, min, max);
+
+  // Everything under a node fully inside the frustum is inside as well
+  if(!is_inside) {
+    FrustumResult result = test_box(ctx.planes, min, max);
+
+    if(result == FRUSTUM_OUTSIDE) {
+      terrain.stats.nodes_culled++;
+      return true;
+    }
+
+    is_inside = (result == FRUSTUM_INSIDE);
+  }
+
+  if(!is_box_in_range(min, max, ctx.eye, lvl.range)) {
+    return false;
+  }
+
+  if(level == 0 || !is_box_in_range(min, max, ctx.eye, terrain.levels[level - 1].range)) {
+    add_node(terrain, level, x, z, TERRAIN_PART_WHOLE, min, max);
+    return true;
+  }
+
+  // The children out of their own range are drawn by this node instead, as quarters of its own patch. 
+  // Drawing them with their own grid would look the same up close, but would not follow this level's morph.
+  const TerrainLevel& child = terrain.levels[level - 1];
+
+  for(nikol::u32 i = 0; i < 4; i++) {
+    nikol::u32 cx = x * 2 + (i & 1);
+    nikol::u32 cz = z * 2 + (i >> 1);
+
+    // Nothing but the edge's heights over there
+    if(cx >= child.nodes_x || cz >= child.nodes_z) {
+      continue;
+    }
+
+    if(!select_node(terrain, ctx, level - 1, cx, cz, is_inside)) {
+      glm::vec3 child_min, child_max;
+      get_node_bounds(terrain, level - 1, cx, cz, child_min, child_max);
+
+      add_node(terrain, level, x, z, (TerrainPart)(TERRAIN_PART_QUARTER_00 + i), child_min, child_max);
+    }
+  }
+
+  return true;
+}
+// `cells` x `cells` quads of the patch's grid, starting at (`first_x`, `first_z`). The vertices only 
+// hold their grid coordinates, as the shader places and lifts them.
+static Mesh* create_patch(nikol::GfxContext* gfx, const nikol::u32 first_x, const nikol::u32 first_z, const nikol::u32 cells, const nikol::u32 patch_size) {
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+  vertices.reserve((cells + 1) * (cells + 1));
+  indices.reserve(cells * cells * 6);
+
+  for(nikol::u32 z = first_z; z <= first_z + cells; z++) {
+    for(nikol::u32 x = first_x; x <= first_x + cells; x++) {
+      vertices.push_back(Vertex{glm::vec3(x, 0.0f, z), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(x, z) / (nikol::f32)patch_size});
+    }
+  }
+
+  // Every quad is split along the same diagonal as the next level's, so the morphed triangles line up with it
+  for(nikol::u32 z = 0; z < cells; z++) {
+    for(nikol::u32 x = 0; x < cells; x++) {
+      nikol::u32 top    = z * (cells + 1) + x;
+      nikol::u32 bottom = top + cells + 1;
+
+      indices.insert(indices.end(), {top, bottom, top + 1});
+      indices.insert(indices.end(), {top + 1, bottom, bottom + 1});
+    }
+  }
+
+  // The grid is already as small as it gets and the nodes are the LODs, so it goes up as is (no welding, no LOD chain)
+  glm::vec3 bounds_min = glm::vec3(first_x, 0.0f, first_z);
+  glm::vec3 bounds_max = glm::vec3(first_x + cells, 0.0f, first_z + cells);
+
+  return mesh_create(gfx, vertices.data(), (nikol::u32)vertices.size(), VERTEX_FORMAT_FULL, indices, bounds_min, bounds_max);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Terrain functions
+void terrain_build(Terrain& terrain, const nikol::u16* heights, const nikol::u32 width, const nikol::u32 depth, const TerrainDesc& desc) {
+  NIKOL_ASSERT(width > 1 && depth > 1, "A terrain needs at least 2x2 samples");
+  NIKOL_ASSERT(desc.patch_size >= 2 && (desc.patch_size % 2) == 0, "The terrain's patch size has to be even");
+
+  terrain.desc         = desc;
+  terrain.width        = width;
+  terrain.depth        = depth;
+  terrain.levels_count = std::clamp(desc.levels_count, 1u, TERRAIN_LEVELS_MAX);
+  terrain.stats        = {};
+
+  terrain.heights.assign(heights, heights + (nikol::sizei)width * depth);
+
+  // Each level halves the nodes of the one below it, until only the roots are left
+  nikol::f32 leaf_size   = desc.patch_size * desc.spacing;
+  nikol::f32 morph_ratio = glm::clamp(desc.morph_ratio, 0.01f, 0.9f);
+  nikol::f32 range       = glm::max(desc.lod_distance, leaf_size * 2.0f / (1.0f - morph_ratio));
+  nikol::u32 nodes       = 0;
+
+  for(nikol::u32 i = 0; i < terrain.levels_count; i++) {
+    TerrainLevel& lvl = terrain.levels[i];
+    nikol::u32 cells  = desc.patch_size << i;
+
+    lvl.nodes_x    = (width - 2 + cells) / cells;
+    lvl.nodes_z    = (depth - 2 + cells) / cells;
+    lvl.first_node = nodes;
+    lvl.node_size  = leaf_size * (1 << i);
+
+    // The morph is over right at the end of the range, where the next level takes over
+    nikol::f32 previous = (i == 0) ? 0.0f : terrain.levels[i - 1].range;
+    lvl.range           = range;
+    lvl.morph_start     = glm::mix(previous, range, 1.0f - morph_ratio);
+
+    nodes += lvl.nodes_x * lvl.nodes_z;
+    range *= 2.0f;
+  }
+
+  terrain.nodes_min.resize(nodes);
+  terrain.nodes_max.resize(nodes);
+
+  build_leaves(terrain);
+  build_parents(terrain);
+
+  terrain.stats.nodes_count    = nodes;
+  terrain.stats.triangles_full = (width - 1) * (depth - 1) * 2;
+}
+
+bool terrain_load(Terrain& terrain, const char* path, const TerrainDesc& desc) {
+  int width, depth, channels;
+
+  stbi_set_flip_vertically_on_load(false);
+  nikol::u16* pixels = stbi_load_16(path, &width, &depth, &channels, 1);
+  if(!pixels) {
+    return false;
+  }
+
+  terrain_build(terrain, pixels, (nikol::u32)width, (nikol::u32)depth, desc);
+  stbi_image_free(pixels);
+
+  return true;
+}
+
+void terrain_upload(nikol::GfxContext* gfx, Terrain& terrain) {
+  nikol::u32 size = terrain.desc.patch_size;
+  nikol::u32 half = size / 2;
+
+  terrain.patches[TERRAIN_PART_WHOLE] = create_patch(gfx, 0, 0, size, size);
+  for(nikol::u32 i = 0; i < 4; i++) {
+    terrain.patches[TERRAIN_PART_QUARTER_00 + i] = create_patch(gfx, (i & 1) * half, (i >> 1) * half, half, size);
+  }
+
+  // The formats are 8-bit only, so the 16 bits are split over two channels (and filtered by the shader)
+  std::vector<nikol::u8> pixels(terrain.heights.size() * 4);
+  for(nikol::sizei i = 0; i < terrain.heights.size(); i++) {
+    nikol::u16 height = terrain.heights[i];
+
+    pixels[i * 4 + 0] = (nikol::u8)(height >> 8);
+    pixels[i * 4 + 1] = (nikol::u8)(height & 0xff);
+    pixels[i * 4 + 2] = 0;
+    pixels[i * 4 + 3] = 0xff;
+  }
+
+  nikol::GfxTextureDesc tex_desc = {
+    .width     = terrain.width,
+    .height    = terrain.depth,
+    .depth     = 0,
+    .format    = nikol::GFX_TEXTURE_FORMAT_RGBA8,
+    .filter    = nikol::GFX_TEXTURE_FILTER_MIN_MAG_NEAREST,
+    .wrap_mode = nikol::GFX_TEXTURE_WRAP_REPEAT,
+    .data      = pixels.data(),
+  };
+  terrain.heightmap = nikol::gfx_texture_create(gfx, tex_desc);
+}
+
+void terrain_select(Terrain& terrain, const glm::mat4& view_projection, const glm::vec3& camera_position) {
+  nikol::f64 start = nikol::niclock_get_time();
+
+  // The frustum planes, straight out of the rows of the view projection (Gribb/Hartmann)
+  const glm::mat4& vp = view_projection;
+  glm::vec4 row0      = glm::vec4(vp[0][0], vp[1][0], vp[2][0], vp[3][0]);
+  glm::vec4 row1      = glm::vec4(vp[0][1], vp[1][1], vp[2][1], vp[3][1]);
+  glm::vec4 row2      = glm::vec4(vp[0][2], vp[1][2], vp[2][2], vp[3][2]);
+  glm::vec4 row3      = glm::vec4(vp[0][3], vp[1][3], vp[2][3], vp[3][3]);
+
+  SelectContext ctx = {
+    .planes = {
+      row3 + row0, row3 - row0,
+      row3 + row1, row3 - row1,
+      row3 + row2, row3 - row2,
+    },
+    .eye = camera_position,
+  };
+
+  nikol::u32 nodes_count    = terrain.stats.nodes_count;
+  nikol::u32 triangles_full = terrain.stats.triangles_full;
+
+  terrain.stats                = {};
+  terrain.stats.nodes_count    = nodes_count;
+  terrain.stats.triangles_full = triangles_full;
+  terrain.selection.clear();
+
+  nikol::u32 top          = terrain.levels_count - 1;
+  const TerrainLevel& lvl = terrain.levels[top];
+
+  // The roots out of even the last level's range are too far to be drawn at all
+  for(nikol::u32 z = 0; z < lvl.nodes_z; z++) {
+    for(nikol::u32 x = 0; x < lvl.nodes_x; x++) {
+      select_node(terrain, ctx, top, x, z, false);
+    }
+  }
+
+  terrain.stats.nodes_selected = (nikol::u32)terrain.selection.size();
+  terrain.stats.selection_time = (nikol::niclock_get_time() - start) * 1000.0;
+}
+
+void terrain_destroy(Terrain& terrain) {
+  for(auto& patch : terrain.patches) {
+    if(patch) {
+      mesh_destroy(patch);
+    }
+
+    patch = nullptr;
+  }
+
+  if(terrain.heightmap) {
+    nikol::gfx_texture_destroy(terrain.heightmap);
+  }
+
+  terrain.heightmap = nullptr;
+  terrain.selection.clear();
+}
+// Terrain functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+const nikol::u32 TERRAIN_LEVELS_MAX = 12;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// TerrainPart
+// What part of a node's patch gets drawn. A node whose children are only partly in range draws the
+// rest of them as quarters of its own patch (so with its own grid and morph).
+enum TerrainPart {
+  TERRAIN_PART_WHOLE = 0,
+  TERRAIN_PART_QUARTER_00, // The quarter at the node's corner
+  TERRAIN_PART_QUARTER_10, // Along +X
+  TERRAIN_PART_QUARTER_01, // Along +Z
+  TERRAIN_PART_QUARTER_11,
+
+  TERRAIN_PARTS_COUNT,
+};
+// TerrainPart
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// TerrainDesc
+struct TerrainDesc {
+  glm::vec3 origin   = glm::vec3(0.0f); // Where the first heightmap sample sits (the terrain spreads along +X and +Z)
+  nikol::f32 spacing = 1.0f;            // World units between two neighbouring samples
+  nikol::f32 height  = 64.0f;           // World height of the largest sample (65535)
+
+  // Grid cells along each side of the shared patch (even, so every odd vertex can morph onto an even one)
+  nikol::u32 patch_size = 32;
+
+  // Levels of the quadtree, the leaves included. A leaf covers `patch_size` samples, every level above twice as many.
+  nikol::u32 levels_count = 6;
+
+  // How far the most detailed level reaches. Every level after reaches twice as far. Clamped to at least
+  // `2 * leaf size / (1 - morph_ratio)`, so no level starts morphing before the far side of the nodes
+  // next to it (which would open cracks against them).
+  nikol::f32 lod_distance = 128.0f;
+
+  // The last part of every level's range, spent morphing into the next level's grid (at most 0.9)
+  nikol::f32 morph_ratio = 0.35f;
+};
+// TerrainDesc
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// TerrainLevel
+struct TerrainLevel {
+  nikol::u32 nodes_x, nodes_z;
+  nikol::u32 first_node; // Into `Terrain::nodes_min` and `Terrain::nodes_max`
+
+  nikol::f32 node_size;   // In world units
+  nikol::f32 range;       // How far from the camera the level is used
+  nikol::f32 morph_start; // Where its vertices start sliding into the next level's grid
+};
+// TerrainLevel
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// TerrainNode
+// A node picked by `terrain_select`, drawn as one instance of the shared patch (or of one of its quarters).
+// `node` and `morph` go as they are into `DrawData::terrain_node` and `DrawData::terrain_morph`.
+struct TerrainNode {
+  glm::vec4 node;  // Corner (x, z) relative to the origin, the size of a grid cell and 1 / the sample spacing
+  glm::vec4 morph; // Morph start, 1 / the morph's length and the height of the largest sample
+
+  glm::vec3 bounds_min, bounds_max; // World space, of the part only
+  nikol::u32 level;
+  TerrainPart part;
+};
+// TerrainNode
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// TerrainStats
+struct TerrainStats {
+  nikol::u32 nodes_count     = 0; // In the whole quadtree
+  nikol::u32 triangles_full  = 0; // One triangle pair per heightmap cell
+
+  // Per frame (see `terrain_select`)
+  nikol::u32 nodes_visited   = 0;
+  nikol::u32 nodes_culled    = 0; // Outside the frustum (their children never visited)
+  nikol::u32 nodes_selected  = 0;
+  nikol::u32 triangles_count = 0;
+
+  nikol::u32 nodes_per_level[TERRAIN_LEVELS_MAX] = {};
+
+  nikol::f64 selection_time = 0.0; // In milliseconds
+};
+// TerrainStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Terrain
+// A heightfield drawn with continuous distance-dependent LOD (CDLOD). The heightmap is covered by a
+// quadtree of square nodes, only keeping the lowest and highest sample under every node. Each frame
+// the quadtree is walked from the roots: a node outside the frustum is dropped, a node out of reach
+// of the next level's range is drawn as is, and anything else is split into its children.
+//
+// Every node is drawn with the same `patch_size` grid (or a quarter of it), scaled to the node's
+// size. The heights come out of the heightmap texture in the vertex shader (`MATERIAL_FEATURE_TERRAIN`),
+// where the odd vertices also slide onto their even neighbours across the end of each level's range.
+// The grid has turned into the next level's by the time the next level takes over, so there are no
+// cracks or pops between levels.
+struct Terrain {
+  TerrainDesc desc;
+
+  // The samples, row by row along +X
+  std::vector<nikol::u16> heights;
+  nikol::u32 width = 0, depth = 0;
+
+  // Leaves first, and the whole level row by row
+  TerrainLevel levels[TERRAIN_LEVELS_MAX];
+  nikol::u32 levels_count = 0;
+
+  std::vector<nikol::u16> nodes_min, nodes_max;
+
+  // Per frame
+  std::vector<TerrainNode> selection;
+  TerrainStats stats;
+
+  // The shared patch (and its quarters, in the same grid coordinates), indexed by `TerrainPart`
+  Mesh* patches[TERRAIN_PARTS_COUNT] = {};
+
+  // The heights packed into a texture (the high byte in red, the low one in green)
+  nikol::GfxTexture* heightmap = nullptr;
+};
+// Terrain
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Terrain functions
+
+// Copy the samples and build the quadtree (using the job system). A heightmap of `(patch_size << (levels_count - 1)) + 1`
+// samples along a side is covered exactly. The nodes hanging over the edge of any other size get the edge's heights.
+void terrain_build(Terrain& terrain, const nikol::u16* heights, const nikol::u32 width, const nikol::u32 depth, const TerrainDesc& desc);
+
+// Same as above, with the heights of a grayscale PNG (16-bit ones keep their precision, 8-bit ones get stretched).
+// Returns false if the file could not be loaded.
+bool terrain_load(Terrain& terrain, const char* path, const TerrainDesc& desc);
+
+// Create the shared patches and the heightmap texture. The texture is the one to create the terrain's material with.
+void terrain_upload(nikol::GfxContext* gfx, Terrain& terrain);
+
+// Pick the nodes to draw from `camera_position` into `selection`, dropping the ones outside the frustum of `view_projection`
+void terrain_select(Terrain& terrain, const glm::mat4& view_projection, const glm::vec3& camera_position);
+
+// Destroys the patches and the texture
+void terrain_destroy(Terrain& terrain);
+// Terrain functions
+// ----------------------------------------------------------------------------
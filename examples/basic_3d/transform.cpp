@@ -1,17 +1,207 @@
 #include "trasform.h"
 
-#include <glm/ext/matrix_transform.hpp>
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+
+// The SIMD kernels only run if the quaternion is stored the way they read it (see `TRANSFORM_QUAT_XYZW`)
+#if defined(__AVX__)
+  #include <immintrin.h>
+  #define TRANSFORM_SIMD_AVX
+  #define TRANSFORM_SIMD_SSE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <xmmintrin.h>
+  #define TRANSFORM_SIMD_SSE
+#endif
+
+// Every SIMD load reads 16 bytes, so the last field still needs 4 bytes of room after it
+static_assert(offsetof(Transform, position) == 0, "Unexpected Transform layout");
+static_assert(offsetof(Transform, rotation) == 12, "Unexpected Transform layout");
+static_assert(offsetof(Transform, scale) == 28, "Unexpected Transform layout");
+static_assert(sizeof(Transform) >= offsetof(Transform, scale) + 16, "Unexpected Transform layout");
 
 // ----------------------------------------------------------------------------
 // Private functions
+static void compose_scalar(const Transform& trans, glm::mat4& model) {
+  const glm::quat& q = trans.rotation;
+
+  float x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
+  
+  float xx = q.x * x2, yy = q.y * y2, zz = q.z * z2;
+  float xy = q.x * y2, xz = q.x * z2, yz = q.y * z2;
+  float wx = q.w * x2, wy = q.w * y2, wz = q.w * z2;
+
+  model[0] = glm::vec4((1.0f - (yy + zz)) * trans.scale.x, (xy + wz) * trans.scale.x, (xz - wy) * trans.scale.x, 0.0f);
+  model[1] = glm::vec4((xy - wz) * trans.scale.y, (1.0f - (xx + zz)) * trans.scale.y, (yz + wx) * trans.scale.y, 0.0f);
+  model[2] = glm::vec4((xz + wy) * trans.scale.z, (yz - wx) * trans.scale.z, (1.0f - (xx + yy)) * trans.scale.z, 0.0f);
+  model[3] = glm::vec4(trans.position, 1.0f);
+}
+
+#if defined(TRANSFORM_SIMD_SSE)
+
+// Thin wrappers so the same composition code works on both register widths
+struct Lane4 { __m128 v; };
+
+static inline Lane4 simd_add(Lane4 a, Lane4 b) { return {_mm_add_ps(a.v, b.v)}; }
+static inline Lane4 simd_sub(Lane4 a, Lane4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+static inline Lane4 simd_mul(Lane4 a, Lane4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+static inline Lane4 simd_one(Lane4)            { return {_mm_set1_ps(1.0f)}; }
+
+#if defined(TRANSFORM_SIMD_AVX)
+struct Lane8 { __m256 v; };
+
+static inline Lane8 simd_add(Lane8 a, Lane8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+static inline Lane8 simd_sub(Lane8 a, Lane8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+static inline Lane8 simd_mul(Lane8 a, Lane8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+static inline Lane8 simd_one(Lane8)            { return {_mm256_set1_ps(1.0f)}; }
+#endif
+
+// Structure-of-arrays view of a few transforms (4 for SSE, 8 for AVX)
+template<typename Lane>
+struct TRSLanes {
+  Lane px, py, pz; 
+  Lane qx, qy, qz, qw;
+  Lane sx, sy, sz;
+};
+
+// The upper 3x3 of the model matrix. `m[column * 3 + row]`.
+template<typename Lane>
+struct BasisLanes {
+  Lane m[9];
+};
+
+static inline void load_lanes4(const Transform* trans, TRSLanes<Lane4>& lanes) {
+  __m128 a, b, c, d;
+
+  // Positions (the 4th lane is garbage and gets thrown away)
+  a = _mm_loadu_ps(&trans[0].position.x);
+  b = _mm_loadu_ps(&trans[1].position.x);
+  c = _mm_loadu_ps(&trans[2].position.x);
+  d = _mm_loadu_ps(&trans[3].position.x);
+  _MM_TRANSPOSE4_PS(a, b, c, d);
+  lanes.px = {a}; lanes.py = {b}; lanes.pz = {c};
+
+  // Rotations
+  a = _mm_loadu_ps(&trans[0].rotation.x);
+  b = _mm_loadu_ps(&trans[1].rotation.x);
+  c = _mm_loadu_ps(&trans[2].rotation.x);
+  d = _mm_loadu_ps(&trans[3].rotation.x);
+  _MM_TRANSPOSE4_PS(a, b, c, d);
+  lanes.qx = {a}; lanes.qy = {b}; lanes.qz = {c}; lanes.qw = {d};
+
+  // Scales
+  a = _mm_loadu_ps(&trans[0].scale.x);
+  b = _mm_loadu_ps(&trans[1].scale.x);
+  c = _mm_loadu_ps(&trans[2].scale.x);
+  d = _mm_loadu_ps(&trans[3].scale.x);
+  _MM_TRANSPOSE4_PS(a, b, c, d);
+  lanes.sx = {a}; lanes.sy = {b}; lanes.sz = {c};
+}
+
+template<typename Lane>
+static inline void compose_lanes(const TRSLanes<Lane>& in, BasisLanes<Lane>& out) {
+  Lane one = simd_one(in.qx);
+
+  Lane x2 = simd_add(in.qx, in.qx), y2 = simd_add(in.qy, in.qy), z2 = simd_add(in.qz, in.qz);
+  
+  Lane xx = simd_mul(in.qx, x2), yy = simd_mul(in.qy, y2), zz = simd_mul(in.qz, z2);
+  Lane xy = simd_mul(in.qx, y2), xz = simd_mul(in.qx, z2), yz = simd_mul(in.qy, z2);
+  Lane wx = simd_mul(in.qw, x2), wy = simd_mul(in.qw, y2), wz = simd_mul(in.qw, z2);
+
+  out.m[0] = simd_mul(simd_sub(one, simd_add(yy, zz)), in.sx);
+  out.m[1] = simd_mul(simd_add(xy, wz), in.sx);
+  out.m[2] = simd_mul(simd_sub(xz, wy), in.sx);
+  
+  out.m[3] = simd_mul(simd_sub(xy, wz), in.sy);
+  out.m[4] = simd_mul(simd_sub(one, simd_add(xx, zz)), in.sy);
+  out.m[5] = simd_mul(simd_add(yz, wx), in.sy);
+  
+  out.m[6] = simd_mul(simd_add(xz, wy), in.sz);
+  out.m[7] = simd_mul(simd_sub(yz, wx), in.sz);
+  out.m[8] = simd_mul(simd_sub(one, simd_add(xx, yy)), in.sz);
+}
+
+static inline void store_lanes4(const BasisLanes<Lane4>& basis, const TRSLanes<Lane4>& lanes, glm::mat4* models) {
+  __m128 zero = _mm_setzero_ps();
+  __m128 one  = _mm_set1_ps(1.0f);
+
+  // Turn every column back into one register per matrix
+  __m128 cols[4][4] = {
+    {basis.m[0].v, basis.m[1].v, basis.m[2].v, zero}, 
+    {basis.m[3].v, basis.m[4].v, basis.m[5].v, zero}, 
+    {basis.m[6].v, basis.m[7].v, basis.m[8].v, zero}, 
+    {lanes.px.v,   lanes.py.v,   lanes.pz.v,   one},
+  };
+
+  for(int col = 0; col < 4; col++) {
+    _MM_TRANSPOSE4_PS(cols[col][0], cols[col][1], cols[col][2], cols[col][3]);
+  }
+
+  for(int i = 0; i < 4; i++) {
+    float* out = &models[i][0].x;
 
-static void update_transform(Transform& trans) {
-  trans.model = glm::translate(glm::mat4(1.0f), trans.position) * 
-                glm::rotate(glm::mat4(1.0f), 90.0f, trans.rotation) *
-                glm::scale(glm::mat4(1.0f), trans.scale);
+    _mm_storeu_ps(out + 0,  cols[0][i]);
+    _mm_storeu_ps(out + 4,  cols[1][i]);
+    _mm_storeu_ps(out + 8,  cols[2][i]);
+    _mm_storeu_ps(out + 12, cols[3][i]);
+  }
 }
 
+#if defined(TRANSFORM_SIMD_AVX)
+static inline Lane8 combine_lanes(Lane4 low, Lane4 high) {
+  return {_mm256_insertf128_ps(_mm256_castps128_ps256(low.v), high.v, 1)};
+}
+
+static size_t compose_batch8(const Transform* transforms, glm::mat4* models, const size_t count) {
+  size_t i = 0;
+
+  for(; i + 8 <= count; i += 8) {
+    TRSLanes<Lane4> low, high;
+    load_lanes4(&transforms[i], low);
+    load_lanes4(&transforms[i + 4], high);
+
+    TRSLanes<Lane8> lanes = {
+      combine_lanes(low.px, high.px), combine_lanes(low.py, high.py), combine_lanes(low.pz, high.pz),
+      combine_lanes(low.qx, high.qx), combine_lanes(low.qy, high.qy), combine_lanes(low.qz, high.qz), combine_lanes(low.qw, high.qw), 
+      combine_lanes(low.sx, high.sx), combine_lanes(low.sy, high.sy), combine_lanes(low.sz, high.sz),
+    };
+
+    BasisLanes<Lane8> basis; 
+    compose_lanes(lanes, basis);
+
+    // Split back into two groups of 4 for the stores
+    BasisLanes<Lane4> basis_low, basis_high;
+    for(int m = 0; m < 9; m++) {
+      basis_low.m[m]  = {_mm256_castps256_ps128(basis.m[m].v)};
+      basis_high.m[m] = {_mm256_extractf128_ps(basis.m[m].v, 1)};
+    }
+
+    store_lanes4(basis_low, low, &models[i]);
+    store_lanes4(basis_high, high, &models[i + 4]);
+  }
+
+  return i;
+}
+#endif
+
+static size_t compose_batch4(const Transform* transforms, glm::mat4* models, const size_t count) {
+  size_t i = 0;
+
+  for(; i + 4 <= count; i += 4) {
+    TRSLanes<Lane4> lanes; 
+    load_lanes4(&transforms[i], lanes);
+
+    BasisLanes<Lane4> basis; 
+    compose_lanes(lanes, basis);
+
+    store_lanes4(basis, lanes, &models[i]);
+  }
+
+  return i;
+}
+
+#endif // TRANSFORM_SIMD_SSE
 // Private functions
 // ----------------------------------------------------------------------------
 
@@ -20,25 +210,72 @@ static void update_transform(Transform& trans) {
 Transform transform_create(const glm::vec3& pos, const glm::vec3& scale, const glm::vec3& rotation) {
   return Transform {
     .position = pos, 
-    .rotation = rotation, 
+    .rotation = glm::quat(glm::radians(rotation)), 
     .scale    = scale, 
-    .model    = glm::mat4(1.0f),
+    .is_dirty = true,
   };
 }
 
 void transform_translate(Transform& trans, const glm::vec3& pos) {
   trans.position = pos;
-  update_transform(trans);  
+  trans.is_dirty = true;
 }
 
 void transform_rotate(Transform& trans, const float angle, const glm::vec3& axis) {
-  trans.rotation = axis;
-  update_transform(trans);  
+  trans.rotation = glm::angleAxis(glm::radians(angle), glm::normalize(axis));
+  trans.is_dirty = true;
 }
 
 void transform_scale(Transform& trans, const glm::vec3& scale) {
-  trans.scale = scale;
-  update_transform(trans);  
+  trans.scale    = scale;
+  trans.is_dirty = true;
+}
+
+glm::mat4 transform_get_model(const Transform& trans) {
+  glm::mat4 model; 
+  compose_scalar(trans, model);
+
+  return model;
+}
+
+void transform_compose_batch(const Transform* transforms, glm::mat4* models, const size_t count) {
+  size_t done = 0;
+
+#if defined(TRANSFORM_SIMD_SSE)
+  if constexpr(TRANSFORM_QUAT_XYZW) {
+  #if defined(TRANSFORM_SIMD_AVX)
+    done += compose_batch8(transforms, models, count);
+  #endif
+    done += compose_batch4(transforms + done, models + done, count - done);
+  }
+#endif
+
+  // Whatever is left over (or everything, without SIMD)
+  for(size_t i = done; i < count; i++) {
+    compose_scalar(transforms[i], models[i]);
+  }
+}
+
+void transform_update_models(Transform* transforms, glm::mat4* models, const size_t count) {
+  size_t i = 0; 
+  
+  while(i < count) {
+    // Skip over the clean ones...
+    while(i < count && !transforms[i].is_dirty) {
+      i++;
+    }
+
+    // ...and compose every consecutive dirty one in one go
+    size_t start = i;
+    while(i < count && transforms[i].is_dirty) {
+      transforms[i].is_dirty = false;
+      i++;
+    }
+
+    if(i > start) {
+      transform_compose_batch(&transforms[start], &models[start], i - start);
+    }
+  }
 }
 // Transform functions
 // ----------------------------------------------------------------------------
@@ -1,15 +1,32 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The SIMD kernels (here and in animation_clip.cpp) read `glm::quat` as 4 floats in (x, y, z, w) order. 
+// GLM can be set up to store it differently, in which case they fall back to their scalar paths.
+constexpr bool TRANSFORM_QUAT_XYZW = offsetof(glm::quat, x) == 0 && 
+                                     offsetof(glm::quat, w) == 12 && 
+                                     sizeof(glm::quat) == 16;
+// Consts
+// ----------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------
 // Transform
+// Only the TRS (40 bytes, 44 with the flag) lives here. The model matrix is composed on demand, 
+// preferably many at a time through `transform_update_models`.
 struct Transform {
   glm::vec3 position; 
-  glm::vec3 rotation; 
+  glm::quat rotation; 
   glm::vec3 scale; 
 
-  glm::mat4 model;
+  // Set on every mutation and cleared once the model matrix is rebuilt
+  bool is_dirty;
 };
 // Transform
 // ----------------------------------------------------------------------------
@@ -20,5 +37,13 @@ Transform transform_create(const glm::vec3& pos, const glm::vec3& scale, const g
 void transform_translate(Transform& trans, const glm::vec3& pos);
 void transform_rotate(Transform& trans, const float angle, const glm::vec3& axis);
 void transform_scale(Transform& trans, const glm::vec3& scale);
+
+glm::mat4 transform_get_model(const Transform& trans);
+
+// Compose the model matrices of `count` transforms into `models` with SIMD (SSE or AVX when available).
+void transform_compose_batch(const Transform* transforms, glm::mat4* models, const size_t count);
+
+// Same as above, but only touches the dirty transforms and clears their flags afterwards
+void transform_update_models(Transform* transforms, glm::mat4* models, const size_t count);
 // Transform functions
 // ----------------------------------------------------------------------------
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <nikol/nikol_core.hpp>
 #include <glm/glm.hpp>
 
 struct Vertex {
@@ -7,3 +8,45 @@ struct Vertex {
   glm::vec3 normal;
   glm::vec2 texture_coords;
 };
+
+// A `Vertex` with its tangent frame (see `mesh_compute_tangents`), as mesh files with a tangent stream store it
+struct TangentVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 texture_coords;
+
+  glm::vec4 tangent;
+};
+
+// A `Vertex` bound to up to 4 joints of a skeleton (see skinning.h). 
+// Unused influences have a weight of 0 and the weights add up to 1.
+struct SkinnedVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 texture_coords;
+
+  nikol::u8 joints[4];
+  glm::vec4 weights;
+};
+
+// A `SkinnedVertex` as uploaded for the vertex shader to skin (see `VERTEX_FORMAT_SKINNED`). The layouts
+// only know about floats, so the joint indices go up as (exact) float values instead of bytes.
+struct SkinnedGpuVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 texture_coords;
+
+  glm::vec4 joints;
+  glm::vec4 weights;
+};
+
+// How a mesh's vertices are laid out once uploaded (see vertex_quantize.h)
+enum VertexFormat {
+  VERTEX_FORMAT_FULL = 0,          // `Vertex` as is (32 bytes)
+  VERTEX_FORMAT_QUANTIZED,         // 16-bit positions, 2x snorm16 octahedral normals and half UVs (16 bytes)
+  VERTEX_FORMAT_QUANTIZED_COMPACT, // 15-bit positions, 2x snorm8 octahedral normals and half UVs (12 bytes)
+  VERTEX_FORMAT_VOXEL,             // Block corner, face and block type in a single word (4 bytes, see voxel.h)
+  VERTEX_FORMAT_SKINNED,           // `SkinnedGpuVertex`, skinned with the joint palette in the vertex shader (64 bytes, see skinning.h)
+
+  VERTEX_FORMATS_MAX,
+};
@@ -0,0 +1,327 @@
+#include "vertex_quantize.h"
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <vector>
+#include <cstring>
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// PackedLayout
+// The sizes of the fields, in the order they get streamed in: the position, the normal, then the UVs (2x half)
+struct PackedLayout {
+  nikol::u32 position_bits; // Per axis
+  nikol::u32 normal_bits;   // Per octahedral component
+  nikol::u32 words_count;
+};
+// PackedLayout
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static PackedLayout get_packed_layout(const VertexFormat format) {
+  if(format == VERTEX_FORMAT_QUANTIZED_COMPACT) {
+    return PackedLayout{15, 8, 3};
+  }
+
+  return PackedLayout{16, 16, 4};
+}
+
+static void write_bits(nikol::u32* words, nikol::u32& offset, const nikol::u32 value, const nikol::u32 count) {
+  nikol::u32 index = offset / PACKED_WORD_BITS;
+  nikol::u32 shift = offset % PACKED_WORD_BITS;
+  nikol::u32 bits  = value & ((1u << count) - 1);
+
+  // Whatever lands past the word's 31 bits gets dropped by `packed_word_encode`
+  words[index] |= bits << shift;
+  if(shift + count > PACKED_WORD_BITS) {
+    words[index + 1] |= bits >> (PACKED_WORD_BITS - shift);
+  }
+
+  offset += count;
+}
+
+static nikol::u32 read_bits(const nikol::u32* words, nikol::u32& offset, const nikol::u32 count) {
+  nikol::u32 index = offset / PACKED_WORD_BITS;
+  nikol::u32 shift = offset % PACKED_WORD_BITS;
+  nikol::u32 bits  = words[index] >> shift;
+
+  if(shift + count > PACKED_WORD_BITS) {
+    bits |= words[index + 1] << (PACKED_WORD_BITS - shift);
+  }
+
+  offset += count;
+  return bits & ((1u << count) - 1);
+}
+
+static nikol::i32 sign_extend(const nikol::u32 value, const nikol::u32 bits) {
+  return (nikol::i32)(value << (32 - bits)) >> (32 - bits);
+}
+
+static nikol::f32 sign_not_zero(const nikol::f32 value) {
+  return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+static nikol::u32 quantize_unorm(const nikol::f32 value, const nikol::u32 max) {
+  return (nikol::u32)std::lround(glm::clamp(value, 0.0f, 1.0f) * (nikol::f32)max);
+}
+
+static nikol::i32 quantize_snorm(const nikol::f32 value, const nikol::i32 max) {
+  return (nikol::i32)std::lround(glm::clamp(value, -1.0f, 1.0f) * (nikol::f32)max);
+}
+
+static nikol::f32 dequantize_snorm(const nikol::i32 value, const nikol::i32 max) {
+  return glm::max((nikol::f32)value / (nikol::f32)max, -1.0f);
+}
+
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Vertex quantize functions
+nikol::u32 packed_word_encode(const nikol::u32 bits) {
+  nikol::u32 exponent = ((bits >> 23) & 0x7f) + 1;
+  return (bits & 0x7fffff) | (exponent << 23) | (((bits >> 30) & 1) << 31);
+}
+
+nikol::u32 packed_word_decode(const nikol::u32 word) {
+  nikol::u32 exponent = ((word >> 23) & 0xff) - 1;
+  return (word & 0x7fffff) | ((exponent & 0x7f) << 23) | ((word >> 31) << 30);
+}
+
+nikol::u32 vertex_format_get_stride(const VertexFormat format) {
+  switch(format) {
+    case VERTEX_FORMAT_QUANTIZED:
+      return 16;
+    case VERTEX_FORMAT_QUANTIZED_COMPACT:
+      return 12;
+    case VERTEX_FORMAT_VOXEL:
+      return 4;
+    case VERTEX_FORMAT_SKINNED:
+      return sizeof(SkinnedGpuVertex);
+    default:
+      return sizeof(Vertex);
+  }
+}
+
+glm::vec2 octahedral_encode(const glm::vec3& normal) {
+  glm::vec3 n = normal / (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+
+  // The lower hemisphere gets folded over the diagonals
+  if(n.z < 0.0f) {
+    return glm::vec2((1.0f - glm::abs(n.y)) * sign_not_zero(n.x),
+                     (1.0f - glm::abs(n.x)) * sign_not_zero(n.y));
+  }
+
+  return glm::vec2(n.x, n.y);
+}
+
+glm::vec3 octahedral_decode(const glm::vec2& oct) {
+  glm::vec3 n = glm::vec3(oct.x, oct.y, 1.0f - glm::abs(oct.x) - glm::abs(oct.y));
+  nikol::f32 t = glm::max(-n.z, 0.0f);
+
+  n.x += (n.x >= 0.0f) ? -t : t;
+  n.y += (n.y >= 0.0f) ? -t : t;
+
+  return glm::normalize(n);
+}
+
+nikol::u16 half_from_float(const nikol::f32 value) {
+  nikol::u32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  nikol::u32 sign     = (bits >> 16) & 0x8000;
+  nikol::u32 raw_exp  = (bits >> 23) & 0xff;
+  nikol::u32 mantissa = bits & 0x7fffff;
+  nikol::i32 exponent = (nikol::i32)raw_exp - 127 + 15;
+
+  // Infinity and NaN (keeping NaNs quiet)
+  if(raw_exp == 0xff) {
+    return (nikol::u16)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+
+  // Too big
+  if(exponent >= 31) {
+    return (nikol::u16)(sign | 0x7c00);
+  }
+
+  // Too small for a normal half, but maybe not for a subnormal one
+  if(exponent <= 0) {
+    if(exponent < -10) {
+      return (nikol::u16)sign;
+    }
+
+    mantissa |= 0x800000;
+
+    nikol::u32 shift     = (nikol::u32)(14 - exponent);
+    nikol::u32 result    = mantissa >> shift;
+    nikol::u32 remainder = mantissa & ((1u << shift) - 1);
+    nikol::u32 halfway   = 1u << (shift - 1);
+
+    result += (remainder > halfway) || (remainder == halfway && (result & 1));
+    return (nikol::u16)(sign | result);
+  }
+
+  nikol::u32 result    = sign | ((nikol::u32)exponent << 10) | (mantissa >> 13);
+  nikol::u32 remainder = mantissa & 0x1fff;
+
+  // A carry out of the mantissa correctly bumps the exponent
+  result += (remainder > 0x1000) || (remainder == 0x1000 && (result & 1));
+  return (nikol::u16)result;
+}
+
+nikol::f32 half_to_float(const nikol::u16 value) {
+  nikol::u32 sign     = (nikol::u32)(value & 0x8000) << 16;
+  nikol::u32 exponent = (value >> 10) & 0x1f;
+  nikol::u32 mantissa = value & 0x3ff;
+  nikol::u32 bits     = 0;
+
+  if(exponent == 0) {
+    if(mantissa == 0) {
+      bits = sign;
+    }
+    else {
+      // Subnormal. Shift it up until it's a normal float.
+      nikol::i32 exp = 1;
+      while(!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        exp--;
+      }
+
+      bits = sign | ((nikol::u32)(exp + 112) << 23) | ((mantissa & 0x3ff) << 13);
+    }
+  }
+  else if(exponent == 31) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  }
+  else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+
+  nikol::f32 result;
+  std::memcpy(&result, &bits, sizeof(result));
+
+  return result;
+}
+
+QuantizeStats vertex_quantize(std::vector<nikol::u8>& out, const std::vector<Vertex>& vertices, const VertexFormat format, glm::mat4& dequantize) {
+  NIKOL_ASSERT(format != VERTEX_FORMAT_VOXEL, "Voxel vertices only come out of the voxel mesher");
+  NIKOL_ASSERT(format != VERTEX_FORMAT_SKINNED, "Skinned vertices only come out of `skinned_mesh_create`");
+
+  QuantizeStats stats;
+  dequantize = glm::mat4(1.0f);
+
+  if(format == VERTEX_FORMAT_FULL) {
+    out.resize(vertices.size() * sizeof(Vertex));
+    std::memcpy(out.data(), vertices.data(), out.size());
+
+    return stats;
+  }
+
+  nikol::u32 stride       = vertex_format_get_stride(format);
+  stats.vertex_size_after = stride;
+  out.resize(vertices.size() * stride);
+
+  // The bounding box every position gets quantized in
+  glm::vec3 min = vertices.empty() ? glm::vec3(0.0f) : vertices[0].position;
+  glm::vec3 max = min;
+  for(auto& vert : vertices) {
+    min = glm::min(min, vert.position);
+    max = glm::max(max, vert.position);
+  }
+
+  // A flat axis still needs a non-zero scale
+  glm::vec3 extent = max - min;
+  for(nikol::u32 i = 0; i < 3; i++) {
+    extent[i] = (extent[i] > 0.0f) ? extent[i] : 1.0f;
+  }
+
+  PackedLayout layout     = get_packed_layout(format);
+  nikol::u32 position_max = (1u << layout.position_bits) - 1;
+  nikol::i32 snorm_max    = (1 << (layout.normal_bits - 1)) - 1;
+
+  glm::vec3 step = extent / (nikol::f32)position_max;
+  dequantize     = glm::scale(glm::translate(glm::mat4(1.0f), min), step);
+
+  for(nikol::sizei i = 0; i < vertices.size(); i++) {
+    const Vertex& vert = vertices[i];
+    nikol::u8* dest    = &out[i * stride];
+
+    // Position
+    glm::vec3 local = (vert.position - min) / extent;
+    nikol::u32 px   = quantize_unorm(local.x, position_max);
+    nikol::u32 py   = quantize_unorm(local.y, position_max);
+    nikol::u32 pz   = quantize_unorm(local.z, position_max);
+
+    // Normal
+    glm::vec2 oct = octahedral_encode(vert.normal);
+    nikol::i32 nx = quantize_snorm(oct.x, snorm_max);
+    nikol::i32 ny = quantize_snorm(oct.y, snorm_max);
+
+    // Texture coords
+    nikol::u16 u = half_from_float(vert.texture_coords.x);
+    nikol::u16 v = half_from_float(vert.texture_coords.y);
+
+    nikol::u32 words[4] = {0, 0, 0, 0};
+    nikol::u32 offset   = 0;
+
+    write_bits(words, offset, px, layout.position_bits);
+    write_bits(words, offset, py, layout.position_bits);
+    write_bits(words, offset, pz, layout.position_bits);
+    write_bits(words, offset, (nikol::u32)nx, layout.normal_bits);
+    write_bits(words, offset, (nikol::u32)ny, layout.normal_bits);
+    write_bits(words, offset, u, 16);
+    write_bits(words, offset, v, 16);
+
+    for(nikol::u32 w = 0; w < layout.words_count; w++) {
+      nikol::u32 word = packed_word_encode(words[w]);
+      std::memcpy(dest + w * sizeof(nikol::u32), &word, sizeof(nikol::u32));
+    }
+
+    // Measuring the damage, decoded like the shaders would
+    Vertex decoded = vertex_unpack(dest, format, dequantize);
+    stats.max_position_error = glm::max(stats.max_position_error, glm::length(decoded.position - vert.position));
+
+    nikol::f32 cos = glm::clamp(glm::dot(decoded.normal, glm::normalize(vert.normal)), -1.0f, 1.0f);
+    stats.max_normal_error = glm::max(stats.max_normal_error, glm::degrees(std::acos(cos)));
+
+    glm::vec2 uv_error = glm::abs(decoded.texture_coords - vert.texture_coords);
+    stats.max_uv_error = glm::max(stats.max_uv_error, glm::max(uv_error.x, uv_error.y));
+  }
+
+  return stats;
+}
+
+Vertex vertex_unpack(const nikol::u8* vertex, const VertexFormat format, const glm::mat4& dequantize) {
+  NIKOL_ASSERT(format == VERTEX_FORMAT_QUANTIZED || format == VERTEX_FORMAT_QUANTIZED_COMPACT, "Only the quantized formats get unpacked");
+
+  PackedLayout layout  = get_packed_layout(format);
+  nikol::i32 snorm_max = (1 << (layout.normal_bits - 1)) - 1;
+
+  nikol::u32 words[4] = {0, 0, 0, 0};
+  for(nikol::u32 w = 0; w < layout.words_count; w++) {
+    std::memcpy(&words[w], vertex + w * sizeof(nikol::u32), sizeof(nikol::u32));
+    words[w] = packed_word_decode(words[w]);
+  }
+
+  nikol::u32 offset = 0;
+  nikol::u32 px     = read_bits(words, offset, layout.position_bits);
+  nikol::u32 py     = read_bits(words, offset, layout.position_bits);
+  nikol::u32 pz     = read_bits(words, offset, layout.position_bits);
+  nikol::i32 nx     = sign_extend(read_bits(words, offset, layout.normal_bits), layout.normal_bits);
+  nikol::i32 ny     = sign_extend(read_bits(words, offset, layout.normal_bits), layout.normal_bits);
+  nikol::u16 u      = (nikol::u16)read_bits(words, offset, 16);
+  nikol::u16 v      = (nikol::u16)read_bits(words, offset, 16);
+
+  Vertex result;
+  result.position       = glm::vec3(dequantize * glm::vec4((nikol::f32)px, (nikol::f32)py, (nikol::f32)pz, 1.0f));
+  result.normal         = octahedral_decode(glm::vec2(dequantize_snorm(nx, snorm_max), dequantize_snorm(ny, snorm_max)));
+  result.texture_coords = glm::vec2(half_to_float(u), half_to_float(v));
+
+  return result;
+}
+// Vertex quantize functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vertex.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The layouts only know about floats, and GPUs are free to flush denormal floats to zero and to
+// canonicalize NaNs on the way in. So a packed word only carries 31 bits: the top 7 go into the
+// exponent plus one, which keeps it within [1, 128] and the word a normal float whatever the bits.
+const nikol::u32 PACKED_WORD_BITS = 31;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// QuantizeStats
+struct QuantizeStats {
+  nikol::u32 vertex_size_before = sizeof(Vertex);
+  nikol::u32 vertex_size_after  = sizeof(Vertex);
+
+  nikol::f32 max_position_error = 0.0f; // In object space units
+  nikol::f32 max_normal_error   = 0.0f; // In degrees
+  nikol::f32 max_uv_error       = 0.0f;
+};
+// QuantizeStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Vertex quantize functions
+
+// The size of one vertex in `format`
+nikol::u32 vertex_format_get_stride(const VertexFormat format);
+
+// Map a unit vector onto the [-1, 1] square (and back)
+glm::vec2 octahedral_encode(const glm::vec3& normal);
+glm::vec3 octahedral_decode(const glm::vec2& oct);
+
+// IEEE 754 half floats (round to nearest even)
+nikol::u16 half_from_float(const nikol::f32 value);
+nikol::f32 half_to_float(const nikol::u16 value);
+
+// Turn the low `PACKED_WORD_BITS` bits of `bits` into a word that is always a normal float (and back)
+nikol::u32 packed_word_encode(const nikol::u32 bits);
+nikol::u32 packed_word_decode(const nikol::u32 word);
+
+// Pack `vertices` into `format`. Every vertex is a stream of bits, from the lowest bit of the first word
+// up, spread over `PACKED_WORD_BITS` per word (so some fields straddle two words):
+//  - VERTEX_FORMAT_QUANTIZED:         pos (3x 16 bits), normal (2x snorm16), uv (2x half) in 4 words
+//  - VERTEX_FORMAT_QUANTIZED_COMPACT: pos (3x 15 bits), normal (2x snorm8), uv (2x half) in 3 words
+//
+// The positions are integers within the mesh's bounding box. `dequantize` takes them back to object
+// space, so it just gets folded into the model matrix. The error is measured with `vertex_unpack`.
+QuantizeStats vertex_quantize(std::vector<nikol::u8>& out, const std::vector<Vertex>& vertices, const VertexFormat format, glm::mat4& dequantize);
+
+// Decode one packed vertex of a quantized `format` the same way the shaders do
+Vertex vertex_unpack(const nikol::u8* vertex, const VertexFormat format, const glm::mat4& dequantize);
+// Vertex quantize functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,397 @@
+#include "voxel.h"
+#include "mesh.h"
+#include "vertex.h"
+#include "vertex_quantize.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// The chunk with a layer of its neighbours' blocks all around
+const nikol::u32 PADDED_SIZE   = VOXEL_CHUNK_SIZE + 2;
+const nikol::u32 PADDED_BLOCKS = PADDED_SIZE * PADDED_SIZE * PADDED_SIZE;
+
+// The scratch of a thread is the padded chunk followed by the faces of one slice
+const nikol::u32 SCRATCH_SIZE = PADDED_BLOCKS + VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Globals
+
+// The axes along the rows of a slice and down its rows, per axis of the slice's faces. 
+// X goes along the rows whenever it can, as it is the one with the blocks next to each other in memory.
+static const nikol::u32 s_slice_axes[3][2] = {
+  {2, 1}, // X faces: along Z, down Y
+  {0, 2}, // Y faces: along X, down Z
+  {0, 1}, // Z faces: along X, down Y
+};
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u32 get_block_index(const nikol::u32 x, const nikol::u32 y, const nikol::u32 z) {
+  return (y * VOXEL_CHUNK_SIZE + z) * VOXEL_CHUNK_SIZE + x;
+}
+
+static nikol::u32 get_padded_index(const nikol::u32 x, const nikol::u32 y, const nikol::u32 z) {
+  return (y * PADDED_SIZE + z) * PADDED_SIZE + x;
+}
+
+static void mark_dirty(VoxelWorld& world, const glm::ivec3& coords) {
+  glm::ivec3 count = glm::ivec3(world.chunks_count);
+  if(coords.x < 0 || coords.y < 0 || coords.z < 0 || coords.x >= count.x || coords.y >= count.y || coords.z >= count.z) {
+    return;
+  }
+
+  nikol::u32 index  = (coords.y * count.z + coords.z) * count.x + coords.x;
+  VoxelChunk& chunk = world.chunks[index];
+
+  if(!chunk.is_dirty) {
+    chunk.is_dirty = true;
+    world.dirty_chunks.push_back(index);
+  }
+}
+
+// Copy the chunk into the middle of `padded` and the layer of blocks touching each of its sides around it.
+// The edges and corners of the padding never get read, so they are left as air (as is anything outside the world).
+static void fill_padded(const VoxelWorld& world, const VoxelChunk& chunk, nikol::u8* padded) {
+  std::memset(padded, VOXEL_BLOCK_AIR, PADDED_BLOCKS);
+
+  for(nikol::u32 y = 0; y < VOXEL_CHUNK_SIZE; y++) {
+    for(nikol::u32 z = 0; z < VOXEL_CHUNK_SIZE; z++) {
+      std::memcpy(&padded[get_padded_index(1, y + 1, z + 1)], &chunk.blocks[get_block_index(0, y, z)], VOXEL_CHUNK_SIZE);
+    }
+  }
+
+  for(nikol::u32 side = 0; side < VOXEL_FACES_COUNT; side++) {
+    nikol::u32 axis = side / 2;
+    bool is_below   = (side & 1) != 0;
+
+    glm::ivec3 coords = glm::ivec3(chunk.coords);
+    coords[axis]     += is_below ? -1 : 1;
+
+    if(coords[axis] < 0 || coords[axis] >= (nikol::i32)world.chunks_count[axis]) {
+      continue;
+    }
+
+    const VoxelChunk& neighbour = world.chunks[(coords.y * world.chunks_count.z + coords.z) * world.chunks_count.x + coords.x];
+    if(neighbour.solid_count == 0) {
+      continue;
+    }
+
+    // The neighbour's layer right across the side, into the padding on that side
+    glm::uvec3 src, dst;
+    src[axis] = is_below ? VOXEL_CHUNK_SIZE - 1 : 0;
+    dst[axis] = is_below ? 0 : PADDED_SIZE - 1;
+
+    nikol::u32 a = (axis + 1) % 3;
+    nikol::u32 b = (axis + 2) % 3;
+
+    for(src[a] = 0; src[a] < VOXEL_CHUNK_SIZE; src[a]++) {
+      for(src[b] = 0; src[b] < VOXEL_CHUNK_SIZE; src[b]++) {
+        dst[a] = src[a] + 1;
+        dst[b] = src[b] + 1;
+
+        padded[get_padded_index(dst.x, dst.y, dst.z)] = neighbour.blocks[get_block_index(src.x, src.y, src.z)];
+      }
+    }
+  }
+}
+
+static void push_quad(VoxelChunk& chunk, const nikol::u32 face, const glm::uvec3* corners, const nikol::u8 type) {
+  nikol::u32 first = (nikol::u32)chunk.vertices.size();
+
+  for(nikol::u32 i = 0; i < 4; i++) {
+    const glm::uvec3& corner = corners[i];
+    chunk.vertices.push_back(packed_word_encode(corner.x | (corner.y << 6) | (corner.z << 12) | (face << 18) | ((nikol::u32)type << 21)));
+  }
+
+  chunk.indices.insert(chunk.indices.end(), {first, first + 1, first + 2, first + 2, first + 3, first});
+  chunk.quads_count++;
+}
+
+// Merge the faces of one slice into quads, growing each one along the row first and then down the
+// rows for as long as every face in the next one is of the same type. The faces get used up along the way.
+static void merge_faces(VoxelChunk& chunk, nikol::u8* faces, const nikol::u32 face, const nikol::u32 plane) {
+  nikol::u32 axis = face / 2;
+  nikol::u32 u    = s_slice_axes[axis][0];
+  nikol::u32 v    = s_slice_axes[axis][1];
+
+  // Along `u` then `v` only goes counter-clockwise around the axis if `v` comes right after `u`.
+  // The faces pointing down the axis need it the other way around.
+  bool is_flipped = (((u + 1) % 3) != v) != ((face & 1) != 0);
+
+  for(nikol::u32 row = 0; row < VOXEL_CHUNK_SIZE; row++) {
+    for(nikol::u32 col = 0; col < VOXEL_CHUNK_SIZE;) {
+      nikol::u8 type = faces[row * VOXEL_CHUNK_SIZE + col];
+      if(type == VOXEL_BLOCK_AIR) {
+        col++;
+        continue;
+      }
+
+      nikol::u32 width = 1;
+      while(col + width < VOXEL_CHUNK_SIZE && faces[row * VOXEL_CHUNK_SIZE + col + width] == type) {
+        width++;
+      }
+
+      nikol::u32 height = 1;
+      for(; row + height < VOXEL_CHUNK_SIZE; height++) {
+        const nikol::u8* next = &faces[(row + height) * VOXEL_CHUNK_SIZE + col];
+
+        nikol::u32 i = 0;
+        while(i < width && next[i] == type) {
+          i++;
+        }
+
+        if(i < width) {
+          break;
+        }
+      }
+
+      for(nikol::u32 r = row; r < row + height; r++) {
+        std::memset(&faces[r * VOXEL_CHUNK_SIZE + col], VOXEL_BLOCK_AIR, width);
+      }
+
+      // The corners in (`u`, `v`), counter-clockwise
+      nikol::u32 quad[4][2] = {{col, row}, {col + width, row}, {col + width, row + height}, {col, row + height}};
+
+      glm::uvec3 corners[4];
+      for(nikol::u32 i = 0; i < 4; i++) {
+        nikol::u32 src = is_flipped ? (3 - i) : i;
+
+        corners[i][axis] = plane;
+        corners[i][u]    = quad[src][0];
+        corners[i][v]    = quad[src][1];
+      }
+
+      push_quad(chunk, face, corners, type);
+      col += width;
+    }
+  }
+}
+
+// The faces along one row of a slice. The rows along X (so `stride == 1`) get vectorized, 
+// which is why they go through a local row first (it cannot overlap the blocks).
+static nikol::u32 find_faces(const nikol::u8* blocks, const nikol::u8* ahead, const nikol::u32 stride, nikol::u8* out) {
+  nikol::u8 row[VOXEL_CHUNK_SIZE];
+  nikol::u32 count = 0;
+
+  for(nikol::u32 col = 0; col < VOXEL_CHUNK_SIZE; col++) {
+    nikol::u8 type = blocks[col * stride];
+    nikol::u8 next = ahead[col * stride];
+
+    row[col] = (next == VOXEL_BLOCK_AIR) ? type : VOXEL_BLOCK_AIR;
+    count   += (row[col] != VOXEL_BLOCK_AIR);
+  }
+
+  std::memcpy(out, row, VOXEL_CHUNK_SIZE);
+  return count;
+}
+
+static void mesh_chunk(const VoxelWorld& world, VoxelChunk& chunk, nikol::u8* scratch) {
+  chunk.vertices.clear();
+  chunk.indices.clear();
+  chunk.faces_count = 0;
+  chunk.quads_count = 0;
+
+  if(chunk.solid_count == 0) {
+    return;
+  }
+
+  nikol::u8* padded = scratch;
+  nikol::u8* faces  = scratch + PADDED_BLOCKS;
+  fill_padded(world, chunk, padded);
+
+  // How far apart neighbouring blocks are along X, Y and Z
+  const nikol::i32 strides[3] = {1, PADDED_SIZE * PADDED_SIZE, PADDED_SIZE};
+
+  for(nikol::u32 face = 0; face < VOXEL_FACES_COUNT; face++) {
+    nikol::u32 axis = face / 2;
+    nikol::i32 u    = strides[s_slice_axes[axis][0]];
+    nikol::i32 v    = strides[s_slice_axes[axis][1]];
+
+    // The block the face looks at
+    nikol::i32 ahead = (face & 1) ? -strides[axis] : strides[axis];
+
+    for(nikol::u32 slice = 0; slice < VOXEL_CHUNK_SIZE; slice++) {
+      nikol::i32 base      = (slice + 1) * strides[axis] + u + v;
+      nikol::u32 has_faces = 0;
+
+      for(nikol::u32 row = 0; row < VOXEL_CHUNK_SIZE; row++) {
+        const nikol::u8* blocks = &padded[base + row * v];
+        nikol::u8* out          = &faces[row * VOXEL_CHUNK_SIZE];
+
+        has_faces += (u == 1) ? find_faces(blocks, blocks + ahead, 1, out) : find_faces(blocks, blocks + ahead, u, out);
+      }
+
+      if(has_faces == 0) {
+        continue;
+      }
+
+      chunk.faces_count += has_faces;
+
+      // The faces pointing up the axis sit on the far side of their blocks
+      merge_faces(chunk, faces, face, (face & 1) ? slice : slice + 1);
+    }
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Voxel world functions
+void voxel_world_create(VoxelWorld& world, const glm::uvec3& chunks_count, const glm::vec3& origin, const nikol::f32 block_size) {
+  world.origin       = origin;
+  world.block_size   = block_size;
+  world.chunks_count = chunks_count;
+
+  world.chunks.resize(chunks_count.x * chunks_count.y * chunks_count.z);
+  world.dirty_chunks.clear();
+  world.stats = VoxelStats{};
+
+  nikol::u32 index = 0;
+  for(nikol::u32 y = 0; y < chunks_count.y; y++) {
+    for(nikol::u32 z = 0; z < chunks_count.z; z++) {
+      for(nikol::u32 x = 0; x < chunks_count.x; x++, index++) {
+        VoxelChunk& chunk = world.chunks[index];
+
+        chunk.coords = glm::uvec3(x, y, z);
+        chunk.blocks.assign(VOXEL_CHUNK_BLOCKS, VOXEL_BLOCK_AIR);
+      }
+    }
+  }
+}
+
+void voxel_world_destroy(VoxelWorld& world) {
+  for(auto& chunk : world.chunks) {
+    mesh_destroy(chunk.mesh);
+  }
+
+  world.chunks.clear();
+  world.dirty_chunks.clear();
+  world.scratch.clear();
+}
+
+nikol::u8 voxel_world_get_block(const VoxelWorld& world, const glm::ivec3& block) {
+  glm::ivec3 size = glm::ivec3(world.chunks_count * VOXEL_CHUNK_SIZE);
+  if(block.x < 0 || block.y < 0 || block.z < 0 || block.x >= size.x || block.y >= size.y || block.z >= size.z) {
+    return VOXEL_BLOCK_AIR;
+  }
+
+  glm::uvec3 coords = glm::uvec3(block) / VOXEL_CHUNK_SIZE;
+  glm::uvec3 local  = glm::uvec3(block) % VOXEL_CHUNK_SIZE;
+
+  const VoxelChunk& chunk = world.chunks[(coords.y * world.chunks_count.z + coords.z) * world.chunks_count.x + coords.x];
+  return chunk.blocks[get_block_index(local.x, local.y, local.z)];
+}
+
+void voxel_world_set_block(VoxelWorld& world, const glm::ivec3& block, const nikol::u8 type) {
+  glm::ivec3 size = glm::ivec3(world.chunks_count * VOXEL_CHUNK_SIZE);
+  if(block.x < 0 || block.y < 0 || block.z < 0 || block.x >= size.x || block.y >= size.y || block.z >= size.z) {
+    return;
+  }
+
+  glm::ivec3 coords = block / (nikol::i32)VOXEL_CHUNK_SIZE;
+  glm::ivec3 local  = block % (nikol::i32)VOXEL_CHUNK_SIZE;
+
+  VoxelChunk& chunk = world.chunks[(coords.y * world.chunks_count.z + coords.z) * world.chunks_count.x + coords.x];
+  nikol::u8& old    = chunk.blocks[get_block_index(local.x, local.y, local.z)];
+
+  if(old == type) {
+    return;
+  }
+
+  chunk.solid_count += (type != VOXEL_BLOCK_AIR) - (old != VOXEL_BLOCK_AIR);
+  old                = type;
+
+  mark_dirty(world, coords);
+
+  // The faces of the neighbour's blocks right across depend on this block too
+  for(nikol::u32 axis = 0; axis < 3; axis++) {
+    glm::ivec3 step = glm::ivec3(0);
+    step[axis]      = 1;
+
+    if(local[axis] == 0) {
+      mark_dirty(world, coords - step);
+    }
+    else if(local[axis] == (nikol::i32)VOXEL_CHUNK_SIZE - 1) {
+      mark_dirty(world, coords + step);
+    }
+  }
+}
+
+nikol::u32 voxel_world_mesh(VoxelWorld& world) {
+  nikol::f64 start = nikol::niclock_get_time();
+  world.stats      = VoxelStats{};
+
+  nikol::u32 count = (nikol::u32)world.dirty_chunks.size();
+  if(count == 0) {
+    return 0;
+  }
+
+  // The job system might have been started after the world was created
+  nikol::u32 threads_count = job_system_get_threads_count();
+  if(world.scratch.size() < threads_count) {
+    world.scratch.resize(threads_count, std::vector<nikol::u8>(SCRATCH_SIZE));
+  }
+
+  // A chunk per job, as a single one is already plenty of work
+  job_system_parallel_for(count, 1, [&](const nikol::u32 first, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = first; i < end; i++) {
+      VoxelChunk& chunk = world.chunks[world.dirty_chunks[i]];
+      mesh_chunk(world, chunk, world.scratch[thread_index].data());
+
+      chunk.is_dirty     = false;
+      chunk.needs_upload = true;
+    }
+  });
+
+  for(auto index : world.dirty_chunks) {
+    world.stats.faces_count += world.chunks[index].faces_count;
+    world.stats.quads_count += world.chunks[index].quads_count;
+  }
+
+  world.stats.chunks_meshed = count;
+  world.stats.meshing_time  = (nikol::niclock_get_time() - start) * 1000.0;
+  world.dirty_chunks.clear();
+
+  return count;
+}
+
+void voxel_world_upload(nikol::GfxContext* gfx, VoxelWorld& world) {
+  for(auto& chunk : world.chunks) {
+    if(!chunk.needs_upload) {
+      continue;
+    }
+
+    // The sizes change with every meshing, so the mesh gets replaced as a whole
+    mesh_destroy(chunk.mesh);
+    chunk.mesh         = nullptr;
+    chunk.needs_upload = false;
+
+    if(chunk.indices.empty()) {
+      continue;
+    }
+
+    chunk.mesh = mesh_create(gfx,
+                             chunk.vertices.data(), (nikol::u32)chunk.vertices.size(), VERTEX_FORMAT_VOXEL,
+                             chunk.indices,
+                             glm::vec3(0.0f), glm::vec3((nikol::f32)VOXEL_CHUNK_SIZE));
+  }
+}
+
+glm::mat4 voxel_chunk_get_model(const VoxelWorld& world, const VoxelChunk& chunk) {
+  glm::vec3 corner = world.origin + glm::vec3(chunk.coords * VOXEL_CHUNK_SIZE) * world.block_size;
+  return glm::scale(glm::translate(glm::mat4(1.0f), corner), glm::vec3(world.block_size));
+}
+// Voxel world functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "mesh.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// ----------------------------------------------------------------------------
+// Consts
+
+// Blocks along each side of a chunk. The packed corners only get 6 bits each, so at most 63.
+const nikol::u32 VOXEL_CHUNK_SIZE   = 32;
+const nikol::u32 VOXEL_CHUNK_BLOCKS = VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE * VOXEL_CHUNK_SIZE;
+
+// The block type of empty space. Every other type is solid.
+const nikol::u8 VOXEL_BLOCK_AIR = 0;
+// Consts
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// VoxelFace
+// Which way a face points. The axis is `face / 2` and the odd ones point down the axis.
+enum VoxelFace {
+  VOXEL_FACE_POS_X = 0,
+  VOXEL_FACE_NEG_X,
+  VOXEL_FACE_POS_Y,
+  VOXEL_FACE_NEG_Y,
+  VOXEL_FACE_POS_Z,
+  VOXEL_FACE_NEG_Z,
+
+  VOXEL_FACES_COUNT,
+};
+// VoxelFace
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// VoxelChunk
+struct VoxelChunk {
+  glm::uvec3 coords; // In chunks
+
+  // Row by row along +X, then slice by slice along +Z, then +Y
+  std::vector<nikol::u8> blocks;
+  nikol::u32 solid_count = 0;
+
+  // The last meshing, packed as `VERTEX_FORMAT_VOXEL`: the corner (6 bits per axis, from the
+  // chunk's corner), then the `VoxelFace` (3 bits) and the block type (8 bits). Four vertices per quad.
+  // Each word goes through `packed_word_encode`, so it never turns into a denormal float on the GPU.
+  std::vector<nikol::u32> vertices;
+  std::vector<nikol::u32> indices;
+
+  nikol::u32 faces_count = 0; // Visible block faces, before they got merged into quads
+  nikol::u32 quads_count = 0;
+
+  bool is_dirty     = false; // A block in or right next to the chunk changed since the last meshing
+  bool needs_upload = false; // Meshed since the last upload
+
+  Mesh* mesh = nullptr; // Null while there is nothing to draw
+};
+// VoxelChunk
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// VoxelStats
+// Of the last `voxel_world_mesh`
+struct VoxelStats {
+  nikol::u32 chunks_meshed = 0;
+  nikol::u32 faces_count   = 0; // One quad per visible block face without the merging
+  nikol::u32 quads_count   = 0;
+
+  nikol::f64 meshing_time = 0.0; // In milliseconds
+};
+// VoxelStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// VoxelWorld
+// A box of chunks, where only the block faces between a solid block and air get meshed. The coplanar
+// faces of the same block type are merged greedily into as few quads as possible, so a flat floor
+// of a chunk comes out as a single quad instead of a thousand cubes.
+//
+// Changing a block only flags its chunk (and the neighbour it touches, if any) as dirty. The dirty chunks
+// get meshed all at once by `voxel_world_mesh` on the job system, then uploaded by `voxel_world_upload`.
+struct VoxelWorld {
+  glm::vec3 origin      = glm::vec3(0.0f); // The corner of the first block
+  nikol::f32 block_size = 1.0f;
+
+  glm::uvec3 chunks_count = glm::uvec3(0);
+  std::vector<VoxelChunk> chunks; // Along +X, then +Z, then +Y
+
+  std::vector<nikol::u32> dirty_chunks;
+
+  // A padded copy of the chunk being meshed and the faces of a slice, per thread
+  std::vector<std::vector<nikol::u8>> scratch;
+
+  VoxelStats stats;
+};
+// VoxelWorld
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Voxel world functions
+
+// A world of `chunks_count` chunks full of air
+void voxel_world_create(VoxelWorld& world, const glm::uvec3& chunks_count, const glm::vec3& origin, const nikol::f32 block_size = 1.0f);
+
+// Destroys every chunk's mesh
+void voxel_world_destroy(VoxelWorld& world);
+
+// The block at `block` (in blocks from the origin), or air outside the world
+nikol::u8 voxel_world_get_block(const VoxelWorld& world, const glm::ivec3& block);
+
+// Blocks outside the world are ignored. Setting a block to the type it already has does not dirty anything.
+void voxel_world_set_block(VoxelWorld& world, const glm::ivec3& block, const nikol::u8 type);
+
+// Mesh every dirty chunk in parallel (using the job system) and return how many there were.
+// The blocks have to be left alone until it returns.
+nikol::u32 voxel_world_mesh(VoxelWorld& world);
+
+// (Re)create the meshes of the chunks meshed since the last upload
+void voxel_world_upload(nikol::GfxContext* gfx, VoxelWorld& world);
+
+// Places the packed corners of `chunk` in the world
+glm::mat4 voxel_chunk_get_model(const VoxelWorld& world, const VoxelChunk& chunk);
+// Voxel world functions
+// ----------------------------------------------------------------------------
@@ -1,6 +1,7 @@
 #include "renderer.h"
 #include "nikol/nikol_core.hpp"
 #include "shaders.h"
+#include "state_cache.h"
 
 #include <vector>
 
@@ -41,6 +42,7 @@ struct BatchDrawCall {
 struct Renderer {
   nikol::GfxContextDesc gfx_desc;
   nikol::GfxContext* gfx = nullptr;
+  StateCache state_cache;
 
   nikol::GfxPipelineDesc pipe_desc;
   nikol::GfxPipeline* pipe = nullptr;
@@ -66,6 +68,8 @@ static void init_context(nikol::Window* window) {
 
   s_renderer.gfx = nikol::gfx_context_init(s_renderer.gfx_desc);
   NIKOL_ASSERT(s_renderer.gfx, "Could not initialize a graphics context");
+
+  state_cache_init(s_renderer.state_cache, s_renderer.gfx);
 }
 
 static const char* compile_shaders() {
@@ -144,8 +148,8 @@ static void flush_batch(BatchDrawCall& draw_call) {
                            sizeof(Vertex) * draw_call.vertices.size(), 
                            draw_call.vertices.data());
 
-  // Apply the pipeline 
-  nikol::gfx_context_apply_pipeline(s_renderer.gfx, s_renderer.pipe, s_renderer.pipe_desc);
+  // Apply the pipeline (only if something actually changed)
+  state_cache_apply(s_renderer.state_cache, s_renderer.pipe, s_renderer.pipe_desc);
 
   // Draw the pipeline
   nikol::gfx_pipeline_draw_index(s_renderer.gfx, s_renderer.pipe);
@@ -223,6 +227,8 @@ void renderer_begin() {
   nikol::window_get_size(s_renderer.gfx_desc.window, &width, &height);
 
   s_renderer.ortho_cam = glm::ortho(0.0f, (float)width, (float)height, 0.0f);
+
+  state_cache_reset_stats(s_renderer.state_cache);
 }
 
 void renderer_end() {
@@ -356,5 +362,9 @@ nikol::GfxTexture* renderer_load_texture(const char* path) {
   return texture;
 }
 
+const StateCacheStats& renderer_get_state_stats() {
+  return s_renderer.state_cache.stats;
+}
+
 /// Public functions
 /// --------------------------------------------------------------------------------------
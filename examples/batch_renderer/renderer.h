@@ -1,6 +1,7 @@
 #pragma once
 
 #include <nikol/nikol_core.hpp>
+#include "state_cache.h"
 
 #include <glm/glm.hpp>
 
@@ -15,3 +16,5 @@ void render_texture(nikol::GfxTexture* texture, const glm::vec2& pos, const glm:
 void render_quad(const glm::vec2& pos, const glm::vec2& size, const glm::vec4& color);
 
 nikol::GfxTexture* renderer_load_texture(const char* path);
+
+const StateCacheStats& renderer_get_state_stats();
@@ -0,0 +1,102 @@
+#include "benchmarks.h"
+
+#include "animation_clip.h"
+#include "trasform.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 JOINTS_COUNT     = 64;
+const nikol::u32 CLIP_FRAMES      = 300;
+const nikol::f32 CLIP_SAMPLE_RATE = 30.0f;
+const nikol::u32 SAMPLES_COUNT    = 100000;
+const nikol::u32 BLENDS_COUNT     = 100000;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static std::vector<Transform> make_keys() {
+  std::vector<Transform> keys(CLIP_FRAMES * JOINTS_COUNT);
+
+  // A 10 second walk-like cycle: every joint swings on its own axis, only the root moves
+  for(nikol::u32 frame = 0; frame < CLIP_FRAMES; frame++) {
+    nikol::f32 time = frame / CLIP_SAMPLE_RATE;
+
+    for(nikol::u32 joint = 0; joint < JOINTS_COUNT; joint++) {
+      Transform& key = keys[frame * JOINTS_COUNT + joint];
+
+      glm::vec3 axis = glm::normalize(glm::vec3(glm::sin(joint * 1.3f), glm::cos(joint * 0.7f), 0.5f));
+      nikol::f32 angle = glm::sin(time * 2.0f + joint * 0.25f) * 1.2f;
+
+      key.position = (joint == 0) ? glm::vec3(time * 1.5f, glm::abs(glm::sin(time * 4.0f)) * 0.1f, 0.0f) : glm::vec3(0.0f, 0.5f, 0.0f);
+      key.rotation = glm::angleAxis(angle, axis);
+      key.scale    = glm::vec3(1.0f);
+      key.is_dirty = true;
+    }
+  }
+
+  return keys;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_animation_clip() {
+  std::vector<Transform> keys = make_keys();
+
+  AnimationClip clip;
+  animation_clip_compress(clip, keys.data(), JOINTS_COUNT, CLIP_FRAMES, CLIP_SAMPLE_RATE);
+
+  const AnimationClipStats& stats = clip.stats;
+  bench_report("compression ratio", (double)stats.raw_bytes / stats.compressed_bytes, "x", (double)stats.compressed_bytes);
+  bench_report("max rotation error", glm::degrees(stats.max_rotation_error), "degrees", stats.constant_tracks);
+  bench_report("max translation error", stats.max_translation_error * 1e6f, "micrometers", stats.constant_tracks);
+  bench_report("max scale error", stats.max_scale_error, "units", stats.constant_tracks);
+
+  // Random access sampling, as a crowd of characters at unrelated times would do
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<nikol::f32> time(0.0f, clip.duration);
+
+  std::vector<nikol::f32> times(SAMPLES_COUNT);
+  for(auto& t : times) {
+    t = time(rng);
+  }
+
+  std::vector<Transform> pose(JOINTS_COUNT);
+  double checksum = 0.0;
+
+  double start = bench_now();
+  for(auto t : times) {
+    animation_clip_sample(clip, t, pose.data());
+    checksum += pose[JOINTS_COUNT - 1].rotation.w;
+  }
+  double sample_time = bench_now() - start;
+
+  bench_report("sample (64 joints)", SAMPLES_COUNT / sample_time, "poses/s", checksum);
+  bench_report("sample joints", (SAMPLES_COUNT * (double)JOINTS_COUNT) / sample_time, "joints/s", checksum);
+
+  // Blending two sampled poses (a walk into a run, say)
+  std::vector<Transform> pose_a(JOINTS_COUNT), pose_b(JOINTS_COUNT), blended(JOINTS_COUNT);
+  animation_clip_sample(clip, 1.0f, pose_a.data());
+  animation_clip_sample(clip, 6.5f, pose_b.data());
+
+  checksum = 0.0;
+  start    = bench_now();
+  for(nikol::u32 i = 0; i < BLENDS_COUNT; i++) {
+    animation_blend_poses(pose_a.data(), pose_b.data(), (i & 255) / 255.0f, blended.data(), JOINTS_COUNT);
+    checksum += blended[i % JOINTS_COUNT].position.x;
+  }
+  double blend_time = bench_now() - start;
+
+  bench_report("blend poses (64 joints)", (BLENDS_COUNT * (double)JOINTS_COUNT) / blend_time, "joints/s", checksum);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
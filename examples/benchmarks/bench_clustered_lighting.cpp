@@ -0,0 +1,109 @@
+#include "benchmarks.h"
+
+#include "clustered_lighting.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 LIGHT_COUNTS[] = {1000, 2000, 5000, 10000};
+const int FRAMES_COUNT          = 20;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static std::vector<PointLight> generate_lights(const nikol::u32 count) {
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<nikol::f32> pos(-50.0f, 50.0f);
+  std::uniform_real_distribution<nikol::f32> radius(1.0f, 6.0f);
+
+  std::vector<PointLight> lights(count);
+  for(auto& light : lights) {
+    light.position  = glm::vec3(pos(rng), pos(rng) * 0.2f, pos(rng));
+    light.radius    = radius(rng);
+    light.color     = glm::vec3(1.0f);
+    light.intensity = 1.0f;
+  }
+
+  return lights;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_clustered_lighting() {
+  job_system_init();
+
+  // CPU side only, so no context is needed
+  ClusteredLighting cl;
+  clustered_lighting_init(cl, nullptr);
+
+  glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1366.0f / 768.0f, 0.1f, 100.0f);
+  glm::mat4 view       = glm::lookAt(glm::vec3(0.0f, 5.0f, 45.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+  double start = bench_now();
+  clustered_lighting_update_grid(cl, projection, 1366, 768);
+  bench_report("build the grid", (bench_now() - start) * 1e6, "us", cl.max_z[CLUSTERS_COUNT - 1]);
+
+  for(auto count : LIGHT_COUNTS) {
+    std::vector<PointLight> lights = generate_lights(count);
+
+    // Warming up
+    clustered_lighting_bin(cl, lights.data(), count, view);
+
+    start = bench_now();
+    for(int i = 0; i < FRAMES_COUNT; i++) {
+      clustered_lighting_bin(cl, lights.data(), count, view);
+    }
+    double frame_time = (bench_now() - start) / FRAMES_COUNT;
+
+    char name[64];
+    snprintf(name, sizeof(name), "bin %u lights (%u threads)", count, job_system_get_threads_count());
+    bench_report(name, frame_time * 1e3, "ms/frame", cl.stats.light_indices);
+
+    snprintf(name, sizeof(name), "visible of %u lights", count);
+    bench_report(name, cl.stats.lights_visible, "lights", cl.stats.clusters_lit);
+
+    snprintf(name, sizeof(name), "indices per lit cluster (%u lights)", count);
+    bench_report(name, (double)cl.stats.light_indices / glm::max(cl.stats.clusters_lit, 1u), "lights", cl.stats.max_per_cluster);
+
+    // What the shader goes without, with every block at 16 KiB
+    snprintf(name, sizeof(name), "lights dropped (%u lights)", count);
+    bench_report(name, cl.stats.lights_dropped, "lights", cl.stats.lights_visible);
+
+    snprintf(name, sizeof(name), "indices dropped (%u lights)", count);
+    bench_report(name, cl.stats.indices_dropped, "indices", cl.stats.cluster_lights_cap);
+
+    // The lights left out have to be the furthest ones, and every cluster touched by a light has to keep some
+    nikol::u32 kept         = (nikol::u32)cl.view_lights.size();
+    nikol::f32 furthest     = kept > 0 ? cl.visible_distances[cl.light_sort.order[kept - 1]] : 0.0f;
+    nikol::u32 out_of_order = 0;
+    for(nikol::u32 i = kept; i < cl.visible_distances.size(); i++) {
+      out_of_order += cl.visible_distances[cl.light_sort.order[i]] < furthest;
+    }
+
+    nikol::u32 clusters_emptied = 0;
+    for(nikol::u32 c = 0; c < CLUSTERS_COUNT; c++) {
+      clusters_emptied += cl.cluster_counts[c] > 0 && cl.cluster_ranges[c].y == 0;
+    }
+
+    snprintf(name, sizeof(name), "nearer lights dropped (%u lights)", count);
+    bench_report(name, out_of_order, "lights", furthest);
+
+    snprintf(name, sizeof(name), "lit clusters emptied (%u lights)", count);
+    bench_report(name, clusters_emptied, "clusters", cl.stats.clusters_lit);
+  }
+
+  clustered_lighting_shutdown(cl);
+  job_system_shutdown();
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,107 @@
+#include "benchmarks.h"
+
+#include "command_buffer.h"
+#include "linear_allocator.h"
+#include "job_system.h"
+#include "material.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 DRAWS_COUNT     = 100000;
+const nikol::u32 BATCH_SIZE      = 128;
+const int FRAMES_COUNT           = 20;
+const nikol::u32 THREAD_COUNTS[] = {1, 2, 4, 8};
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void record_frame(std::vector<CommandBuffer>& buffers, std::vector<LinearAllocator>& memory, const std::vector<glm::mat4>& transforms) {
+  for(auto& alloc : memory) {
+    linear_allocator_reset(alloc);
+  }
+
+  // Fake handles, as nothing gets executed here
+  nikol::GfxPipelineDesc desc = {};
+  nikol::GfxPipeline* pipe    = (nikol::GfxPipeline*)&desc;
+  nikol::GfxBuffer* buffer    = (nikol::GfxBuffer*)&desc;
+
+  nikol::u32 buffers_count = (DRAWS_COUNT + BATCH_SIZE - 1) / BATCH_SIZE;
+  buffers.resize(buffers_count);
+
+  job_system_parallel_for(buffers_count, 1, [&](const nikol::u32 start, const nikol::u32 end, const nikol::u32 thread_index) {
+    for(nikol::u32 i = start; i < end; i++) {
+      CommandBuffer& cmd = buffers[i];
+      command_buffer_begin(cmd, memory[thread_index], i);
+
+      nikol::u32 first = i * BATCH_SIZE;
+      nikol::u32 last  = glm::min(first + BATCH_SIZE, DRAWS_COUNT);
+      for(nikol::u32 j = first; j < last; j++) {
+        DrawData data        = {};
+        data.view_projection = transforms[j];
+        data.material_index  = j & 511;
+
+        command_buffer_update_buffer(cmd, buffer, 0, sizeof(DrawData), &data);
+        command_buffer_apply_pipeline(cmd, pipe, &desc, nullptr, nullptr, buffer, 36);
+        command_buffer_draw_index(cmd, pipe);
+      }
+    }
+  });
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_command_buffer() {
+  std::vector<glm::mat4> transforms(DRAWS_COUNT);
+  for(nikol::u32 i = 0; i < DRAWS_COUNT; i++) {
+    transforms[i] = glm::mat4((nikol::f32)i);
+  }
+
+  for(auto threads : THREAD_COUNTS) {
+    job_system_init(threads);
+
+    std::vector<LinearAllocator> memory(job_system_get_threads_count());
+    for(auto& alloc : memory) {
+      linear_allocator_init(alloc);
+    }
+
+    std::vector<CommandBuffer> buffers;
+
+    // Warming the allocators up, so the blocks are already there
+    record_frame(buffers, memory, transforms);
+
+    double start = bench_now();
+    for(int i = 0; i < FRAMES_COUNT; i++) {
+      record_frame(buffers, memory, transforms);
+    }
+    double frame_time = (bench_now() - start) / FRAMES_COUNT;
+
+    double bytes    = 0.0;
+    double commands = 0.0;
+    for(auto& cmd : buffers) {
+      bytes    += (double)cmd.bytes;
+      commands += cmd.commands_count;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "record %u draws (%u threads)", DRAWS_COUNT, threads);
+    bench_report(name, (DRAWS_COUNT / frame_time) * 1e-6, "M draws/s", commands);
+
+    snprintf(name, sizeof(name), "command memory (%u threads)", threads);
+    bench_report(name, bytes / DRAWS_COUNT, "bytes/draw", bytes);
+
+    for(auto& alloc : memory) {
+      linear_allocator_shutdown(alloc);
+    }
+    job_system_shutdown();
+  }
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
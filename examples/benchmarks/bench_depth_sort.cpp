@@ -0,0 +1,165 @@
+#include "benchmarks.h"
+
+#include "radix_sort.h"
+#include "sorted_mesh.h"
+#include "mesh_generator.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 ITEM_COUNTS[] = {1000, 10000, 100000, 1000000};
+const int SORT_RUNS            = 20;
+const int VIEWS_COUNT          = 64;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// View space depths of a scene's translucent draws. With `levels`, the depths are rounded so many of them tie.
+static std::vector<nikol::f32> make_depths(const nikol::u32 count, const nikol::u32 levels = 0) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<nikol::f32> depth(0.1f, 1000.0f);
+
+  std::vector<nikol::f32> depths(count);
+  for(auto& value : depths) {
+    value = depth(rng);
+
+    if(levels > 0) {
+      value = (nikol::f32)(int)(value * levels / 1000.0f);
+    }
+  }
+
+  return depths;
+}
+
+// What the radix sort has to match: a comparison sort keeping the ties in order
+static void reference_sort(std::vector<nikol::u32>& order, const std::vector<nikol::f32>& keys) {
+  order.resize(keys.size());
+  for(nikol::u32 i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+
+  std::stable_sort(order.begin(), order.end(), [&](const nikol::u32 a, const nikol::u32 b) {
+    return keys[a] > keys[b];
+  });
+}
+
+static nikol::u32 count_mismatches(const std::vector<nikol::u32>& a, const std::vector<nikol::u32>& b) {
+  nikol::u32 mismatches = 0;
+  for(nikol::sizei i = 0; i < a.size(); i++) {
+    mismatches += a[i] != b[i];
+  }
+
+  return mismatches;
+}
+
+// Triangles that come before one further away than themselves
+static nikol::u32 count_misordered(const SortedMesh& mesh, const std::vector<Vertex>& vertices, const glm::mat4& model_view) {
+  nikol::u32 misordered = 0;
+  nikol::f32 last_depth = 1e30f;
+
+  for(nikol::sizei i = 0; i < mesh.sorted_indices.size(); i += 3) {
+    glm::vec3 centroid = (vertices[mesh.sorted_indices[i + 0]].position +
+                          vertices[mesh.sorted_indices[i + 1]].position +
+                          vertices[mesh.sorted_indices[i + 2]].position) / 3.0f;
+    nikol::f32 depth   = -(model_view * glm::vec4(centroid, 1.0f)).z;
+
+    misordered += depth > last_depth + 1e-3f;
+    last_depth  = depth;
+  }
+
+  return misordered;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_depth_sort() {
+  char name[64];
+
+  // Back to front, against a stable comparison sort
+  for(auto count : ITEM_COUNTS) {
+    std::vector<nikol::f32> depths = make_depths(count);
+    RadixSort sort;
+    std::vector<nikol::u32> reference;
+
+    double start = bench_now();
+    for(int run = 0; run < SORT_RUNS; run++) {
+      radix_sort_floats(sort, depths.data(), count, true);
+    }
+    double radix_time = (bench_now() - start) / SORT_RUNS;
+
+    start = bench_now();
+    for(int run = 0; run < SORT_RUNS; run++) {
+      reference_sort(reference, depths);
+    }
+    double reference_time = (bench_now() - start) / SORT_RUNS;
+
+    snprintf(name, sizeof(name), "radix sort %u items", count);
+    bench_report(name, radix_time * 1e3, "ms", sort.passes);
+
+    snprintf(name, sizeof(name), "std::stable_sort %u items", count);
+    bench_report(name, reference_time * 1e3, "ms", count_mismatches(sort.order, reference));
+
+    snprintf(name, sizeof(name), "speedup at %u items", count);
+    bench_report(name, reference_time / radix_time, "x", sort.order[0]);
+  }
+
+  // Lots of ties, which have to stay in submission order, and keys on both sides of zero
+  std::vector<nikol::f32> ties = make_depths(100000, 64);
+  for(nikol::u32 i = 0; i < ties.size(); i += 2) {
+    ties[i] = -ties[i];
+  }
+
+  RadixSort sort;
+  std::vector<nikol::u32> reference;
+  radix_sort_floats(sort, ties.data(), (nikol::u32)ties.size(), true);
+  reference_sort(reference, ties);
+
+  bench_report("stability (100000 items, 128 depths)", count_mismatches(sort.order, reference), "mismatches", sort.passes);
+
+  // Every triangle of a big torus, sorted again for a camera going around it
+  ShapeDesc torus_desc = {.type = SHAPE_TORUS, .segments = 256, .rings = 200, .radius = 3.0f, .tube_radius = 1.0f};
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+  shape_generate(torus_desc, vertices, indices);
+
+  SortedMesh mesh;
+  sorted_mesh_build(mesh, vertices, indices);
+
+  double sort_time      = 0.0;
+  nikol::u32 misordered = 0;
+  glm::mat4 model_view  = glm::mat4(1.0f);
+
+  for(int view = 0; view < VIEWS_COUNT; view++) {
+    nikol::f32 angle = view * (6.2831853f / VIEWS_COUNT);
+    glm::vec3 eye    = glm::vec3(std::cos(angle) * 12.0f, 4.0f + std::sin(angle * 3.0f) * 4.0f, std::sin(angle) * 12.0f);
+    model_view       = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    double start = bench_now();
+    sorted_mesh_sort(mesh, model_view);
+    sort_time += bench_now() - start;
+
+    misordered += count_misordered(mesh, vertices, model_view);
+  }
+
+  snprintf(name, sizeof(name), "sort %u triangles per view", mesh.stats.triangles_count);
+  bench_report(name, sort_time * 1e3 / VIEWS_COUNT, "ms", misordered);
+
+  // A still camera leaves the last order alone
+  double start = bench_now();
+  sorted_mesh_sort(mesh, model_view);
+  bench_report("sort again from the same view", (bench_now() - start) * 1e3, "ms", mesh.stats.is_skipped);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,122 @@
+#include "benchmarks.h"
+
+#include "frame_graph.h"
+
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const int FRAMES_COUNT = 10000;
+const nikol::u32 WIDTH  = 1920;
+const nikol::u32 HEIGHT = 1080;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void count_pass(void* user_data) {
+  (*(nikol::u32*)user_data)++;
+}
+
+// A deferred-ish frame: shadows, a depth prepass, SSAO, the lighting, a bloom chain and
+// the post process. The debug overlay goes nowhere, so it should get culled.
+static void declare_frame(FrameGraph& graph, nikol::u32* executed) {
+  RenderTargetDesc full  = {.width = WIDTH, .height = HEIGHT, .format = RENDER_TARGET_FORMAT_RGBA16F};
+  RenderTargetDesc half  = {.width = WIDTH / 2, .height = HEIGHT / 2, .format = RENDER_TARGET_FORMAT_RGBA16F};
+  RenderTargetDesc quart = {.width = WIDTH / 4, .height = HEIGHT / 4, .format = RENDER_TARGET_FORMAT_RGBA16F};
+
+  frame_graph_reset(graph);
+
+  FrameGraphResource backbuffer = frame_graph_import_target(graph, "backbuffer", {.width = WIDTH, .height = HEIGHT});
+  FrameGraphResource shadow_map = frame_graph_create_target(graph, "shadow_map", {.width = 2048, .height = 2048, .format = RENDER_TARGET_FORMAT_DEPTH32F});
+  FrameGraphResource depth      = frame_graph_create_target(graph, "depth", {.width = WIDTH, .height = HEIGHT, .format = RENDER_TARGET_FORMAT_DEPTH24_STENCIL8});
+  FrameGraphResource ssao       = frame_graph_create_target(graph, "ssao", {.width = WIDTH, .height = HEIGHT, .format = RENDER_TARGET_FORMAT_R32F});
+  FrameGraphResource hdr        = frame_graph_create_target(graph, "hdr", full);
+  FrameGraphResource bright     = frame_graph_create_target(graph, "bloom_bright", full);
+  FrameGraphResource down_half  = frame_graph_create_target(graph, "bloom_half", half);
+  FrameGraphResource down_quart = frame_graph_create_target(graph, "bloom_quarter", quart);
+  FrameGraphResource bloom      = frame_graph_create_target(graph, "bloom", full);
+  FrameGraphResource overlay    = frame_graph_create_target(graph, "debug_overlay", full);
+
+  // Added out of order on purpose
+  FrameGraphPass post = frame_graph_add_pass(graph, "post", count_pass, executed);
+  frame_graph_read(graph, post, hdr);
+  frame_graph_read(graph, post, bloom);
+  frame_graph_write(graph, post, backbuffer);
+
+  FrameGraphPass shadows = frame_graph_add_pass(graph, "shadows", count_pass, executed);
+  frame_graph_write(graph, shadows, shadow_map);
+
+  FrameGraphPass prepass = frame_graph_add_pass(graph, "depth_prepass", count_pass, executed);
+  frame_graph_write(graph, prepass, depth);
+
+  FrameGraphPass ao = frame_graph_add_pass(graph, "ssao", count_pass, executed);
+  frame_graph_read(graph, ao, depth);
+  frame_graph_write(graph, ao, ssao);
+
+  FrameGraphPass lighting = frame_graph_add_pass(graph, "lighting", count_pass, executed);
+  frame_graph_read(graph, lighting, shadow_map);
+  frame_graph_read(graph, lighting, depth);
+  frame_graph_read(graph, lighting, ssao);
+  frame_graph_write(graph, lighting, hdr);
+
+  FrameGraphPass debug = frame_graph_add_pass(graph, "debug", count_pass, executed);
+  frame_graph_read(graph, debug, depth);
+  frame_graph_write(graph, debug, overlay);
+
+  FrameGraphPass extract = frame_graph_add_pass(graph, "bloom_extract", count_pass, executed);
+  frame_graph_read(graph, extract, hdr);
+  frame_graph_write(graph, extract, bright);
+
+  FrameGraphPass down0 = frame_graph_add_pass(graph, "bloom_down_half", count_pass, executed);
+  frame_graph_read(graph, down0, bright);
+  frame_graph_write(graph, down0, down_half);
+
+  FrameGraphPass down1 = frame_graph_add_pass(graph, "bloom_down_quarter", count_pass, executed);
+  frame_graph_read(graph, down1, down_half);
+  frame_graph_write(graph, down1, down_quart);
+
+  FrameGraphPass up = frame_graph_add_pass(graph, "bloom_up", count_pass, executed);
+  frame_graph_read(graph, up, down_quart);
+  frame_graph_write(graph, up, bloom);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_frame_graph() {
+  FrameGraph graph;
+  nikol::u32 executed = 0;
+
+  // Every frame compiled from scratch...
+  double start = bench_now();
+  for(int i = 0; i < FRAMES_COUNT; i++) {
+    declare_frame(graph, &executed);
+    graph.is_compiled = false;
+    frame_graph_compile(graph);
+    frame_graph_execute(graph);
+  }
+  double full_time = (bench_now() - start) / FRAMES_COUNT;
+
+  // ...and with the schedule cached
+  start = bench_now();
+  for(int i = 0; i < FRAMES_COUNT; i++) {
+    declare_frame(graph, &executed);
+    frame_graph_compile(graph);
+    frame_graph_execute(graph);
+  }
+  double cached_time = (bench_now() - start) / FRAMES_COUNT;
+
+  const FrameGraphStats& stats = graph.stats;
+
+  bench_report("declare + compile + execute", full_time * 1e6, "us/frame", (double)executed);
+  bench_report("declare + cached + execute", cached_time * 1e6, "us/frame", (double)stats.cache_hits);
+  bench_report("passes culled", (double)stats.passes_culled, "passes", (double)stats.passes_total);
+  bench_report("transient memory (unaliased)", stats.memory_unaliased / (1024.0 * 1024.0), "MiB", 0.0);
+  bench_report("transient memory (aliased)", stats.memory_aliased / (1024.0 * 1024.0), "MiB", (double)stats.physical_resources);
+
+  frame_graph_dump(graph, stdout);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,76 @@
+#include "benchmarks.h"
+
+#include "geometry_pool.h"
+
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 POOL_CAPACITY  = 1 << 22;
+const nikol::u32 LIVE_RANGES    = 4096;
+const nikol::u32 CHURN_OPS      = 1 << 20;
+const nikol::u32 MAX_RANGE_SIZE = 1024;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Range
+struct Range {
+  nikol::u32 offset, count;
+};
+// Range
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u32 random_size() {
+  // Mostly small meshes with the occasional big one
+  nikol::u32 size = 16 + (std::rand() % 256);
+  if((std::rand() % 16) == 0) {
+    size += std::rand() % MAX_RANGE_SIZE;
+  }
+
+  return size;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_geometry_pool() {
+  RangeAllocator alloc;
+  range_allocator_init(alloc, POOL_CAPACITY);
+
+  std::vector<Range> ranges(LIVE_RANGES);
+  for(auto& range : ranges) {
+    range.count  = random_size();
+    range.offset = range_allocator_alloc(alloc, range.count);
+  }
+
+  // Streaming meshes in and out in random order
+  double checksum = 0.0;
+  nikol::u32 failed = 0;
+
+  double start = bench_now();
+  for(nikol::u32 i = 0; i < CHURN_OPS; i++) {
+    Range& range = ranges[std::rand() % LIVE_RANGES];
+    range_allocator_free(alloc, range.offset, range.count);
+
+    range.count  = random_size();
+    range.offset = range_allocator_alloc(alloc, range.count);
+
+    failed   += (range.offset == RANGE_INVALID);
+    checksum += range.offset;
+  }
+  double churn_time = (bench_now() - start) / CHURN_OPS;
+
+  bench_report("free + alloc", churn_time * 1e9, "ns/op", checksum);
+  bench_report("occupancy", (100.0 * alloc.used) / alloc.capacity, "%", 0.0);
+  bench_report("free blocks", (double)alloc.free_by_offset.size(), "blocks", 0.0);
+  bench_report("fragmentation", 100.0 * range_allocator_fragmentation(alloc), "%", 0.0);
+  bench_report("failed allocations", (double)failed, "allocs", 0.0);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
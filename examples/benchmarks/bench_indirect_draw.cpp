@@ -0,0 +1,143 @@
+#include "benchmarks.h"
+
+#include "indirect_draw.h"
+#include "job_system.h"
+
+#include <vector>
+#include <random>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 DRAW_COUNTS[]   = {1000, 10000, 100000};
+const nikol::u32 STATES_COUNT    = 64; // Pipelines times materials in a typical scene
+const nikol::u32 POOLED_MESHES   = 1000;
+const nikol::u32 POOLED_DRAWS    = 10000;
+const int FRAMES_COUNT           = 20;
+
+// Fake index buffers of the pooled meshes
+static nikol::u8 s_mesh_index_buffers[POOLED_MESHES];
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static std::vector<IndirectDraw> make_draws(const nikol::u32 count) {
+  // Fake handles, as nothing gets executed here
+  static nikol::u8 handles[STATES_COUNT];
+
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<nikol::u32> state(0, STATES_COUNT - 1);
+  std::uniform_int_distribution<nikol::u32> indices(36, 3000);
+
+  std::vector<IndirectDraw> draws(count);
+  for(auto& draw : draws) {
+    // A handful of pipelines, each drawn with a few shaders and textures
+    nikol::u32 index = state(rng);
+
+    draw.state.pipe          = (nikol::GfxPipeline*)&handles[index / 8];
+    draw.state.desc          = (const nikol::GfxPipelineDesc*)&handles[index / 8];
+    draw.state.shader        = (nikol::GfxShader*)&handles[index % 4];
+    draw.state.texture       = (nikol::GfxTexture*)&handles[index];
+    draw.state.index_buffer  = (nikol::GfxBuffer*)&handles[index / 8];
+    draw.state.index_source  = nullptr;
+    draw.state.index_buffers = nullptr;
+
+    draw.args = DrawIndirectArgs{indices(rng), 1, 0, 0, 0};
+  }
+
+  return draws;
+}
+
+// Draws of meshes out of one geometry pool, all with the same material. Each mesh has its own copy of the pool's 
+// desc and its own index buffer. With `is_pooled`, they get keyed the way the renderer does it (see `prepare_draw`).
+static std::vector<IndirectDraw> make_pooled_draws(std::vector<nikol::GfxBuffer*>& index_buffers, const bool is_pooled) {
+  // Fake handles, as nothing gets executed here
+  static nikol::GfxPipelineDesc mesh_descs[POOLED_MESHES];
+  static nikol::u8 pool_handles[4];
+
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<nikol::u32> mesh(0, POOLED_MESHES - 1);
+
+  std::vector<IndirectDraw> draws(POOLED_DRAWS);
+  index_buffers.resize(POOLED_DRAWS);
+
+  for(nikol::u32 i = 0; i < POOLED_DRAWS; i++) {
+    IndirectDraw& draw = draws[i];
+    nikol::u32 index   = mesh(rng);
+
+    draw.state.pipe          = (nikol::GfxPipeline*)&pool_handles[0];
+    draw.state.desc          = &mesh_descs[index];
+    draw.state.shader        = (nikol::GfxShader*)&pool_handles[1];
+    draw.state.texture       = (nikol::GfxTexture*)&pool_handles[2];
+    draw.state.index_buffer  = (nikol::GfxBuffer*)&s_mesh_index_buffers[index];
+    draw.state.index_source  = nullptr;
+    draw.state.index_buffers = nullptr;
+
+    index_buffers[i] = draw.state.index_buffer;
+
+    if(is_pooled) {
+      draw.state.desc          = (const nikol::GfxPipelineDesc*)&pool_handles[3];
+      draw.state.index_buffer  = nullptr;
+      draw.state.index_buffers = index_buffers.data();
+    }
+
+    // The indices count tells which mesh it was
+    draw.args = DrawIndirectArgs{36 + index, 1, 0, 0, 0};
+  }
+
+  return draws;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_indirect_draw() {
+  job_system_init();
+
+  for(auto count : DRAW_COUNTS) {
+    std::vector<IndirectDraw> draws = make_draws(count);
+    IndirectDrawList list;
+
+    double start = bench_now();
+    for(int frame = 0; frame < FRAMES_COUNT; frame++) {
+      indirect_draw_list_build(list, draws.data(), count);
+    }
+    double build_time = (bench_now() - start) / FRAMES_COUNT;
+
+    char name[64];
+    snprintf(name, sizeof(name), "build %u draws (%u threads)", count, job_system_get_threads_count());
+    bench_report(name, build_time * 1e3, "ms", list.args[count - 1].base_instance);
+
+    snprintf(name, sizeof(name), "submissions for %u draws", count);
+    bench_report(name, list.stats.batches, "batches", list.stats.largest_batch);
+  }
+
+  // Pooled meshes only differ by their index buffer, so they should collapse into a single batch
+  std::vector<nikol::GfxBuffer*> index_buffers;
+  IndirectDrawList list;
+
+  std::vector<IndirectDraw> draws = make_pooled_draws(index_buffers, false);
+  indirect_draw_list_build(list, draws.data(), POOLED_DRAWS);
+
+  char name[64];
+  snprintf(name, sizeof(name), "%u pooled draws keyed per mesh", POOLED_DRAWS);
+  bench_report(name, list.stats.batches, "batches", list.stats.largest_batch);
+
+  draws = make_pooled_draws(index_buffers, true);
+  indirect_draw_list_build(list, draws.data(), POOLED_DRAWS);
+
+  // Every argument still has to find its own mesh's index buffer through its draw ID
+  nikol::u32 mismatches = 0;
+  for(auto& args : list.args) {
+    mismatches += index_buffers[args.base_instance] != (nikol::GfxBuffer*)&s_mesh_index_buffers[args.indices_count - 36];
+  }
+
+  snprintf(name, sizeof(name), "%u pooled draws keyed per pool", POOLED_DRAWS);
+  bench_report(name, list.stats.batches, "batches", mismatches);
+
+  job_system_shutdown();
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+#include "benchmarks.h"
+
+#include "mesh_generator.h"
+#include "mesh_prepare.h"
+#include "mesh_lod.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+// ----------------------------------------------------------------------------
+// Globals
+const int ITERATIONS      = 5;
+const int INSTANCES_COUNT = 1024;
+const int FRAMES_COUNT    = 64;
+const float MIN_DISTANCE  = 1.5f;
+const float MAX_DISTANCE  = 200.0f;
+const float PROJ_SCALE    = 2.4142f; // 1 / tan(45 / 2), the example camera's default
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static float random_float() {
+  return ((float)std::rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_lod() {
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+  shape_generate(ShapeDesc{.type = SHAPE_TORUS, .segments = 256, .rings = 128}, vertices, indices);
+  mesh_prepare(vertices, indices);
+
+  // Generating the chain
+  MeshLod lods[MESH_LODS_MAX];
+  nikol::u32 lods_count = 0;
+
+  double checksum = 0.0;
+  double start    = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    std::vector<nikol::u32> chain = indices;
+    lods_count = mesh_generate_lods(chain, vertices, lods);
+
+    checksum += chain.size();
+  }
+  double gen_time = (bench_now() - start) / ITERATIONS;
+  bench_report("mesh_generate_lods", gen_time * 1000.0, "ms/mesh", checksum);
+
+  for(nikol::u32 i = 0; i < lods_count; i++) {
+    printf("  LOD %u: %u triangles, error %.4f, used above %.3f\n",
+           i, lods[i].indices_count / 3, lods[i].error, lods[i].min_screen_size);
+  }
+
+  // Instances spread out in front of the camera, with the distances spaced exponentially 
+  // (as many close-ups as far-away ones)
+  std::vector<glm::vec3> centers(INSTANCES_COUNT);
+  for(auto& center : centers) {
+    float dist = MIN_DISTANCE * std::pow(MAX_DISTANCE / MIN_DISTANCE, (random_float() + 1.0f) * 0.5f);
+    center     = glm::vec3(random_float() * dist * 0.25f, 0.0f, -dist);
+  }
+
+  nikol::f32 radius = 0.0f;
+  for(auto& vert : vertices) {
+    radius = glm::max(radius, glm::length(vert.position));
+  }
+
+  // Picking the LODs every frame like `render_mesh` does
+  nikol::u64 triangles_full      = 0;
+  nikol::u64 triangles_submitted = 0;
+
+  start = bench_now();
+  for(int frame = 0; frame < FRAMES_COUNT; frame++) {
+    glm::vec3 eye = glm::vec3(0.0f, 0.0f, (float)frame * 0.01f);
+
+    for(auto& center : centers) {
+      nikol::f32 size = mesh_lod_screen_size(center, radius, eye, PROJ_SCALE);
+      nikol::u32 lod  = mesh_lod_select(lods, lods_count, size);
+
+      triangles_submitted += lods[lod].indices_count / 3;
+      triangles_full      += lods[0].indices_count / 3;
+    }
+  }
+  double select_time = (bench_now() - start) / ((double)FRAMES_COUNT * INSTANCES_COUNT);
+
+  bench_report("mesh_lod_select", select_time * 1e9, "ns/instance", (double)triangles_submitted);
+  bench_report("triangles/frame (LOD 0)", (double)triangles_full / FRAMES_COUNT, "tris", 0.0);
+  bench_report("triangles/frame (LOD)", (double)triangles_submitted / FRAMES_COUNT, "tris", 0.0);
+  bench_report("reduction", (double)triangles_full / (double)triangles_submitted, "x", 0.0);
+
+  // Whatever LOD gets picked, its error should never cover more than the pixels allowed
+  nikol::f32 max_pixels = 0.0f;
+  for(auto& center : centers) {
+    nikol::f32 size = mesh_lod_screen_size(center, radius, glm::vec3(0.0f), PROJ_SCALE);
+    nikol::u32 lod  = mesh_lod_select(lods, lods_count, size);
+
+    max_pixels = glm::max(max_pixels, (lods[lod].error / radius) * size * MESH_LOD_REFERENCE_HEIGHT * 0.5f);
+  }
+  bench_report("worst projected error", max_pixels, "pixels", MESH_LOD_ERROR_PIXELS);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,323 @@
+#include "benchmarks.h"
+
+#include "mesh_codec.h"
+#include "mesh_file.h"
+#include "mesh_generator.h"
+#include "mesh_optimizer.h"
+
+#include <stb/stb_image.h>
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+// ----------------------------------------------------------------------------
+// Globals
+const int RUNS_COUNT = 10;
+
+// The deflate stream the codec is compared against (see `zlib_compress`)
+const nikol::u32 DEFLATE_WINDOW     = 32768;
+const nikol::u32 DEFLATE_HASH_BITS  = 15;
+const nikol::u32 DEFLATE_CHAIN      = 16;
+const nikol::u32 DEFLATE_MIN_MATCH  = 3;
+const nikol::u32 DEFLATE_MAX_MATCH  = 258;
+
+const nikol::u16 LENGTH_BASES[29]   = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const nikol::u8 LENGTH_EXTRAS[29]   = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const nikol::u16 DISTANCE_BASES[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const nikol::u8 DISTANCE_EXTRAS[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// BitWriter
+// Deflate packs its bits from the lowest up
+struct BitWriter {
+  std::vector<nikol::u8>& out;
+
+  nikol::u64 bits  = 0;
+  nikol::u32 count = 0;
+};
+// BitWriter
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void bits_put(BitWriter& writer, const nikol::u32 value, const nikol::u32 count) {
+  writer.bits  |= (nikol::u64)value << writer.count;
+  writer.count += count;
+
+  while(writer.count >= 8) {
+    writer.out.push_back((nikol::u8)writer.bits);
+
+    writer.bits  >>= 8;
+    writer.count  -= 8;
+  }
+}
+
+// Huffman codes go in from their highest bit
+static void bits_put_code(BitWriter& writer, const nikol::u32 code, const nikol::u32 length) {
+  nikol::u32 reversed = 0;
+  for(nikol::u32 i = 0; i < length; i++) {
+    reversed |= ((code >> i) & 1) << (length - 1 - i);
+  }
+
+  bits_put(writer, reversed, length);
+}
+
+// A symbol of the fixed literal/length code
+static void put_literal(BitWriter& writer, const nikol::u32 symbol) {
+  if(symbol < 144) {
+    bits_put_code(writer, 0x30 + symbol, 8);
+  }
+  else if(symbol < 256) {
+    bits_put_code(writer, 0x190 + (symbol - 144), 9);
+  }
+  else if(symbol < 280) {
+    bits_put_code(writer, symbol - 256, 7);
+  }
+  else {
+    bits_put_code(writer, 0xc0 + (symbol - 280), 8);
+  }
+}
+
+static void put_match(BitWriter& writer, const nikol::u32 length, const nikol::u32 distance) {
+  nikol::u32 code = 28;
+  while(LENGTH_BASES[code] > length) {
+    code--;
+  }
+  put_literal(writer, 257 + code);
+  bits_put(writer, length - LENGTH_BASES[code], LENGTH_EXTRAS[code]);
+
+  code = 29;
+  while(DISTANCE_BASES[code] > distance) {
+    code--;
+  }
+  bits_put_code(writer, code, 5);
+  bits_put(writer, distance - DISTANCE_BASES[code], DISTANCE_EXTRAS[code]);
+}
+
+// A zlib stream with a single fixed Huffman block and greedy hash chain matching. A lot weaker
+// than zlib's own compressor, but any zlib decoder (`stbi_zlib_decode_malloc` here) decodes it at full speed.
+static void zlib_compress(std::vector<nikol::u8>& out, const nikol::u8* data, const nikol::u32 size) {
+  out = {0x78, 0x01};
+
+  BitWriter writer = {out};
+  bits_put(writer, 1, 1); // Last block
+  bits_put(writer, 1, 2); // Fixed Huffman codes
+
+  std::vector<nikol::i32> heads(1u << DEFLATE_HASH_BITS, -1);
+  std::vector<nikol::i32> chain(size, -1);
+
+  auto hash = [&](const nikol::u32 pos) {
+    nikol::u32 key = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16);
+    return (key * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+  };
+
+  auto insert = [&](const nikol::u32 pos) {
+    if(pos + DEFLATE_MIN_MATCH <= size) {
+      nikol::u32 key = hash(pos);
+      chain[pos]     = heads[key];
+      heads[key]     = (nikol::i32)pos;
+    }
+  };
+
+  nikol::u32 pos = 0;
+  while(pos < size) {
+    nikol::u32 best_length   = 0;
+    nikol::u32 best_distance = 0;
+
+    if(pos + DEFLATE_MIN_MATCH <= size) {
+      nikol::u32 max_length = std::min(DEFLATE_MAX_MATCH, size - pos);
+      nikol::i32 candidate  = heads[hash(pos)];
+
+      for(nikol::u32 depth = 0; depth < DEFLATE_CHAIN && candidate >= 0 && (pos - candidate) <= DEFLATE_WINDOW; depth++) {
+        nikol::u32 length = 0;
+        while(length < max_length && data[candidate + length] == data[pos + length]) {
+          length++;
+        }
+
+        if(length > best_length) {
+          best_length   = length;
+          best_distance = pos - candidate;
+        }
+
+        candidate = chain[candidate];
+      }
+    }
+
+    if(best_length >= DEFLATE_MIN_MATCH) {
+      put_match(writer, best_length, best_distance);
+
+      for(nikol::u32 i = 0; i < best_length; i++) {
+        insert(pos + i);
+      }
+      pos += best_length;
+    }
+    else {
+      put_literal(writer, data[pos]);
+
+      insert(pos);
+      pos++;
+    }
+  }
+
+  put_literal(writer, 256); // End of block
+  bits_put(writer, 0, 7);   // Flush to a byte
+
+  // Adler-32 of the raw data (big-endian)
+  nikol::u32 a = 1, b = 0;
+  for(nikol::u32 i = 0; i < size; i++) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+
+  nikol::u32 adler = (b << 16) | a;
+  for(int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back((nikol::u8)(adler >> shift));
+  }
+}
+
+// Decode `stream` `RUNS_COUNT` times and report the decoded GB/s
+static void report_zlib(const char* name, const std::vector<nikol::u8>& stream, const nikol::u8* raw, const nikol::u32 raw_size) {
+  double start = bench_now();
+  double mismatches = 0.0;
+
+  for(int run = 0; run < RUNS_COUNT; run++) {
+    int decoded_size = 0;
+    char* decoded    = stbi_zlib_decode_malloc((const char*)stream.data(), (int)stream.size(), &decoded_size);
+
+    mismatches += (decoded_size != (int)raw_size) || std::memcmp(decoded, raw, raw_size) != 0;
+    free(decoded);
+  }
+  double elapsed = (bench_now() - start) / RUNS_COUNT;
+
+  char label[64];
+  snprintf(label, sizeof(label), "%s zlib ratio", name);
+  bench_report(label, (double)raw_size / stream.size(), "x", stream.size());
+
+  snprintf(label, sizeof(label), "%s zlib decode", name);
+  bench_report(label, raw_size / elapsed / 1e9, "GB/s", mismatches);
+}
+
+// The codec may rotate triangles, but has to keep every one of them (with its winding) in place
+static nikol::u32 count_changed_triangles(const nikol::u32* a, const nikol::u32* b, const nikol::sizei count) {
+  nikol::u32 changed = 0;
+
+  for(nikol::sizei i = 0; i < count; i += 3) {
+    bool same = false;
+    for(nikol::u32 r = 0; r < 3; r++) {
+      same |= a[i] == b[i + r] && a[i + 1] == b[i + (r + 1) % 3] && a[i + 2] == b[i + (r + 2) % 3];
+    }
+
+    changed += !same;
+  }
+
+  return changed;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_mesh_codec() {
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+  shape_generate(ShapeDesc{.type = SHAPE_TORUS, .segments = 1024, .rings = 512}, vertices, indices);
+
+  // The order the converter writes with --optimize
+  mesh_optimize(vertices, indices);
+
+  nikol::u32 vertices_count = (nikol::u32)vertices.size();
+  nikol::u32 indices_count  = (nikol::u32)indices.size();
+  nikol::u32 vertex_bytes   = vertices_count * sizeof(Vertex);
+  nikol::u32 index_bytes    = indices_count * sizeof(nikol::u32);
+
+  printf("  %u vertices, %u indices (%.1f MiB raw)\n", vertices_count, indices_count, (vertex_bytes + index_bytes) / (1024.0 * 1024.0));
+
+  // Vertices
+  std::vector<nikol::u8> vertex_stream;
+
+  double start = bench_now();
+  mesh_codec_encode_vertices(vertex_stream, vertices.data(), vertices_count, sizeof(Vertex));
+  bench_report("vertex encode", (bench_now() - start) * 1e3, "ms", vertex_stream.size());
+  bench_report("vertex ratio", (double)vertex_bytes / vertex_stream.size(), "x", vertex_stream.size());
+
+  std::vector<Vertex> decoded_vertices(vertices_count);
+  double mismatches = 0.0;
+
+  start = bench_now();
+  for(int run = 0; run < RUNS_COUNT; run++) {
+    mismatches += !mesh_codec_decode_vertices(decoded_vertices.data(), vertices_count, sizeof(Vertex), vertex_stream.data(), vertex_stream.size());
+  }
+  double elapsed = (bench_now() - start) / RUNS_COUNT;
+
+  mismatches += std::memcmp(decoded_vertices.data(), vertices.data(), vertex_bytes) != 0;
+  bench_report("vertex decode", vertex_bytes / elapsed / 1e9, "GB/s", mismatches);
+
+  // Indices
+  std::vector<nikol::u8> index_stream;
+
+  start = bench_now();
+  mesh_codec_encode_indices(index_stream, indices.data(), indices_count);
+  bench_report("index encode", (bench_now() - start) * 1e3, "ms", index_stream.size());
+  bench_report("index ratio", (double)index_bytes / index_stream.size(), "x", index_stream.size());
+  bench_report("index bits per triangle", index_stream.size() * 8.0 / (indices_count / 3), "bits", index_stream.size());
+
+  std::vector<nikol::u32> decoded_indices(indices_count);
+  mismatches = 0.0;
+
+  start = bench_now();
+  for(int run = 0; run < RUNS_COUNT; run++) {
+    mismatches += !mesh_codec_decode_indices(decoded_indices.data(), indices_count, sizeof(nikol::u32), vertices_count, index_stream.data(), index_stream.size());
+  }
+  elapsed = (bench_now() - start) / RUNS_COUNT;
+
+  mismatches += count_changed_triangles(indices.data(), decoded_indices.data(), indices_count);
+  bench_report("index decode", index_bytes / elapsed / 1e9, "GB/s", mismatches);
+
+  // One vertex short, so the last vertex turns into an index out of range
+  bool is_rejected = !mesh_codec_decode_indices(decoded_indices.data(), indices_count, sizeof(nikol::u32), vertices_count - 1, index_stream.data(), index_stream.size());
+  bench_report("index out of range", is_rejected ? 1.0 : 0.0, "rejected", indices_count);
+
+  // The same blobs through a general purpose compressor
+  std::vector<nikol::u8> zlib_stream;
+
+  zlib_compress(zlib_stream, (const nikol::u8*)vertices.data(), vertex_bytes);
+  report_zlib("vertex", zlib_stream, (const nikol::u8*)vertices.data(), vertex_bytes);
+
+  zlib_compress(zlib_stream, (const nikol::u8*)indices.data(), index_bytes);
+  report_zlib("index", zlib_stream, (const nikol::u8*)indices.data(), index_bytes);
+
+  // A full round trip through a compressed mesh file
+  std::filesystem::path dir = std::filesystem::temp_directory_path();
+  std::string raw_path      = (dir / "nikol_bench_codec_raw.nmsh").string();
+  std::string packed_path   = (dir / "nikol_bench_codec_packed.nmsh").string();
+
+  mesh_file_write(raw_path.c_str(), vertices, indices, {});
+  mesh_file_write(packed_path.c_str(), vertices, indices, {}, 4, true);
+
+  MeshFile file;
+  mismatches = !mesh_file_open(file, packed_path.c_str());
+
+  if(mismatches == 0.0) {
+    mismatches += !mesh_file_decode(file, decoded_vertices.data(), decoded_indices.data(), sizeof(nikol::u32));
+    mismatches += std::memcmp(decoded_vertices.data(), vertices.data(), vertex_bytes) != 0;
+    mismatches += count_changed_triangles(indices.data(), decoded_indices.data(), indices_count);
+
+    mesh_file_close(file);
+  }
+
+  bench_report("mesh file ratio",
+               (double)std::filesystem::file_size(raw_path) / std::filesystem::file_size(packed_path),
+               "x",
+               mismatches);
+
+  std::filesystem::remove(raw_path);
+  std::filesystem::remove(packed_path);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,179 @@
+#include "benchmarks.h"
+
+#include "mesh_generator.h"
+#include "mesh_file.h"
+#include "obj_importer.h"
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <filesystem>
+
+// ----------------------------------------------------------------------------
+// Globals
+const int ITERATIONS = 5;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static void write_obj(const char* path, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  FILE* file = fopen(path, "wb");
+
+  for(auto& vert : vertices) {
+    fprintf(file, "v %f %f %f\n", vert.position.x, vert.position.y, vert.position.z);
+  }
+  for(auto& vert : vertices) {
+    fprintf(file, "vt %f %f\n", vert.texture_coords.x, vert.texture_coords.y);
+  }
+  for(auto& vert : vertices) {
+    fprintf(file, "vn %f %f %f\n", vert.normal.x, vert.normal.y, vert.normal.z);
+  }
+
+  for(nikol::sizei i = 0; i < indices.size(); i += 3) {
+    nikol::u32 a = indices[i] + 1, b = indices[i + 1] + 1, c = indices[i + 2] + 1;
+    fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+  }
+
+  fclose(file);
+}
+
+// Copy the file at `path` into `out_path` with its attribute table (or header) tampered with in one of three 
+// ways a layout cannot follow: an unknown name, attributes out of order and padding between two attributes
+static void write_tampered(const char* path, const char* out_path, const int tamper) {
+  std::vector<nikol::u8> bytes(std::filesystem::file_size(path));
+
+  FILE* file = fopen(path, "rb");
+  fread(bytes.data(), 1, bytes.size(), file);
+  fclose(file);
+
+  MeshFileHeader* header        = (MeshFileHeader*)bytes.data();
+  MeshFileAttribute* attributes = (MeshFileAttribute*)(bytes.data() + header->attributes_offset);
+
+  switch(tamper) {
+    case 0:
+      std::strcpy(attributes[1].name, "BINORMAL");
+      break;
+    case 1:
+      std::swap(attributes[0].offset, attributes[1].offset);
+      break;
+    case 2:
+      attributes[2].offset += 4;
+      break;
+  }
+
+  file = fopen(out_path, "wb");
+  fwrite(bytes.data(), 1, bytes.size(), file);
+  fclose(file);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_mesh_file() {
+  std::vector<Vertex> vertices; 
+  std::vector<nikol::u32> indices;
+  shape_generate(ShapeDesc{.type = SHAPE_TORUS, .segments = 1024, .rings = 512}, vertices, indices);
+
+  std::filesystem::path dir = std::filesystem::temp_directory_path();
+  std::string obj_path      = (dir / "nikol_bench_mesh.obj").string();
+  std::string mesh_path     = (dir / "nikol_bench_mesh.nmsh").string();
+
+  write_obj(obj_path.c_str(), vertices, indices);
+  mesh_file_write(mesh_path.c_str(), vertices, indices, {});
+  
+  printf("  %zu vertices, %zu indices (OBJ: %.1f MiB, NMSH: %.1f MiB)\n", 
+         vertices.size(), indices.size(),
+         std::filesystem::file_size(obj_path) / (1024.0 * 1024.0), 
+         std::filesystem::file_size(mesh_path) / (1024.0 * 1024.0));
+
+  // Parsing the text
+  double checksum = 0.0;
+  double start    = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    ObjMesh mesh; 
+    obj_import(obj_path.c_str(), mesh);
+
+    checksum += mesh.vertices.size() + mesh.indices.back();
+  }
+  double obj_time = (bench_now() - start) / ITERATIONS;
+  bench_report("obj_import", obj_time * 1000.0, "ms/load", checksum);
+
+  // The importer's tangents have to come back out of the file as they went in, raw and encoded
+  ObjMesh imported;
+  obj_import(obj_path.c_str(), imported);
+
+  std::string tangent_path = (dir / "nikol_bench_tangents.nmsh").string();
+  nikol::u32 mismatches    = 0;
+
+  for(int compress = 0; compress < 2; compress++) {
+    mesh_file_write(tangent_path.c_str(), imported.vertices, imported.indices, imported.submeshes, 4, compress == 1, imported.tangents);
+
+    MeshFile file;
+    mesh_file_open(file, tangent_path.c_str());
+
+    std::vector<TangentVertex> stored(file.header->vertices_count);
+    std::vector<nikol::u32> stored_indices(file.header->indices_count);
+
+    if(mesh_file_is_compressed(file)) {
+      mesh_file_decode(file, stored.data(), stored_indices.data(), sizeof(nikol::u32));
+    }
+    else {
+      std::memcpy(stored.data(), file.vertices, stored.size() * sizeof(TangentVertex));
+    }
+
+    mismatches += file.header->vertex_stride != sizeof(TangentVertex) || file.header->attributes_count != 4;
+    for(nikol::sizei i = 0; i < stored.size(); i++) {
+      mismatches += std::memcmp(&stored[i].tangent, &imported.tangents[i], sizeof(glm::vec4)) != 0;
+    }
+
+    mesh_file_close(file);
+  }
+  bench_report("tangent stream round trip", mismatches, "mismatches", (double)imported.tangents.size());
+
+  // Mapping the binary and touching every page, so the data really is resident
+  checksum = 0.0;
+  start    = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    MeshFile file; 
+    mesh_file_open(file, mesh_path.c_str());
+
+    const nikol::u8* bytes = (const nikol::u8*)file.base;
+    for(nikol::sizei i = 0; i < file.size; i += 4096) {
+      checksum += bytes[i];
+    }
+    checksum += file.header->vertices_count;
+
+    mesh_file_close(file);
+  }
+  double mesh_time = (bench_now() - start) / ITERATIONS;
+  bench_report("mesh_file_open", mesh_time * 1000.0, "ms/load", checksum);
+  bench_report("speedup", obj_time / mesh_time, "x", 0.0);
+
+  // Files a layout cannot describe get turned away when opened, not when uploaded
+  std::string tampered_path = (dir / "nikol_bench_tampered.nmsh").string();
+  nikol::u32 rejected       = 0;
+
+  for(int tamper = 0; tamper < 3; tamper++) {
+    write_tampered(mesh_path.c_str(), tampered_path.c_str(), tamper);
+
+    MeshFile file;
+    if(!mesh_file_open(file, tampered_path.c_str())) {
+      rejected++;
+      continue;
+    }
+
+    mesh_file_close(file);
+  }
+  bench_report("tampered layouts", rejected, "rejected", 3);
+
+  std::filesystem::remove(tampered_path);
+  std::filesystem::remove(obj_path);
+  std::filesystem::remove(mesh_path);
+  std::filesystem::remove(tangent_path);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,173 @@
+#include "benchmarks.h"
+
+#include "mesh_normals.h"
+#include "mesh_generator.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 GRID_SIZES[] = {1024, 2048}; // 2M and 8M triangles
+const nikol::f32 GRID_EXTENT  = 100.0f;
+const int RUNS_COUNT          = 3;
+
+const nikol::u32 THREAD_COUNTS[] = {1, 2, 4, 8};
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::f32 height_at(const nikol::f32 x, const nikol::f32 z) {
+  return std::sin(x * 0.3f) * std::cos(z * 0.2f) * 2.0f;
+}
+
+static nikol::f32 slope_x(const nikol::f32 x, const nikol::f32 z) {
+  return std::cos(x * 0.3f) * 0.3f * std::cos(z * 0.2f) * 2.0f;
+}
+
+static nikol::f32 slope_z(const nikol::f32 x, const nikol::f32 z) {
+  return std::sin(x * 0.3f) * -std::sin(z * 0.2f) * 0.2f * 2.0f;
+}
+
+static glm::vec3 analytic_normal(const nikol::f32 x, const nikol::f32 z) {
+  return glm::normalize(glm::vec3(-slope_x(x, z), 1.0f, -slope_z(x, z)));
+}
+
+// A rolling terrain with its normals wiped, as an importer would hand it over
+static void make_terrain(const nikol::u32 size, std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices) {
+  ShapeDesc desc = {.type = SHAPE_PLANE, .segments = size, .rings = size, .size = GRID_EXTENT};
+  shape_generate(desc, vertices, indices);
+
+  for(auto& vert : vertices) {
+    vert.position.y = height_at(vert.position.x, vert.position.z);
+    vert.normal     = glm::vec3(0.0f);
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_mesh_normals() {
+  const NormalWeighting weightings[] = {NORMAL_WEIGHT_AREA, NORMAL_WEIGHT_ANGLE};
+  const char* weighting_names[]      = {"area", "angle"};
+
+  for(auto size : GRID_SIZES) {
+    std::vector<Vertex> vertices;
+    std::vector<nikol::u32> indices;
+    make_terrain(size, vertices, indices);
+
+    nikol::u32 triangles = (nikol::u32)(indices.size() / 3);
+    char name[64];
+
+    std::vector<glm::vec4> tangents;
+
+    for(auto threads : THREAD_COUNTS) {
+      job_system_init(threads);
+
+      // The angle weighting goes last, so those are the normals the tangents and the error below get
+      for(int w = 0; w < 2; w++) {
+        double start = bench_now();
+        for(int run = 0; run < RUNS_COUNT; run++) {
+          mesh_compute_normals(vertices, indices, weightings[w]);
+        }
+        double elapsed = (bench_now() - start) / RUNS_COUNT;
+
+        snprintf(name, sizeof(name), "normals %s %.1fM tris (%u threads)", weighting_names[w], triangles / 1e6, job_system_get_threads_count());
+        bench_report(name, elapsed * 1e3, "ms", vertices[vertices.size() / 2].normal.x);
+      }
+
+      double start = bench_now();
+      for(int run = 0; run < RUNS_COUNT; run++) {
+        mesh_compute_tangents(vertices, indices, tangents);
+      }
+      double elapsed = (bench_now() - start) / RUNS_COUNT;
+
+      snprintf(name, sizeof(name), "tangents %.1fM tris (%u threads)", triangles / 1e6, job_system_get_threads_count());
+      bench_report(name, elapsed * 1e3, "ms", tangents[tangents.size() / 2].x);
+
+      // Only the per-thread ranges grow with the threads
+      snprintf(name, sizeof(name), "scratch %.1fM tris (%u threads)", triangles / 1e6, job_system_get_threads_count());
+      bench_report(name, mesh_tangents_scratch_size((nikol::u32)vertices.size()) / (1024.0 * 1024.0), "MiB", vertices.size());
+
+      job_system_shutdown();
+    }
+
+    // How far the (angle weighted) normals are from the real surface
+    nikol::f32 max_error = 0.0f;
+    for(auto& vert : vertices) {
+      nikol::f32 cos_angle = glm::clamp(glm::dot(vert.normal, analytic_normal(vert.position.x, vert.position.z)), -1.0f, 1.0f);
+      max_error            = glm::max(max_error, std::acos(cos_angle));
+    }
+
+    snprintf(name, sizeof(name), "normal error %.1fM tris", triangles / 1e6);
+    bench_report(name, glm::degrees(max_error), "degrees", triangles);
+
+    // U runs along +X on the plane, so every tangent should follow the surface along X, with a positive sign
+    nikol::f32 max_tangent_error = 0.0f;
+    nikol::u32 flipped           = 0;
+    for(nikol::sizei i = 0; i < vertices.size(); i++) {
+      glm::vec3 normal   = vertices[i].normal;
+      glm::vec3 along_u  = glm::vec3(1.0f, slope_x(vertices[i].position.x, vertices[i].position.z), 0.0f);
+      glm::vec3 expected = glm::normalize(along_u - normal * glm::dot(normal, along_u));
+
+      nikol::f32 cos_angle = glm::clamp(glm::dot(glm::vec3(tangents[i]), expected), -1.0f, 1.0f);
+      max_tangent_error    = glm::max(max_tangent_error, std::acos(cos_angle));
+      flipped             += tangents[i].w < 0.0f;
+    }
+
+    snprintf(name, sizeof(name), "tangent error %.1fM tris", triangles / 1e6);
+    bench_report(name, glm::degrees(max_tangent_error), "degrees", flipped);
+  }
+
+  // Triangles in no particular order span too many vertices per batch for the ranges,
+  // so they go through the shared sums. Both ways should agree.
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+  make_terrain(GRID_SIZES[0], vertices, indices);
+
+  std::vector<nikol::u32> order(indices.size() / 3);
+  for(nikol::u32 i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+  std::vector<nikol::u32> shuffled(indices.size());
+  for(nikol::sizei i = 0; i < order.size(); i++) {
+    shuffled[i * 3 + 0] = indices[order[i] * 3 + 0];
+    shuffled[i * 3 + 1] = indices[order[i] * 3 + 1];
+    shuffled[i * 3 + 2] = indices[order[i] * 3 + 2];
+  }
+
+  job_system_init();
+
+  std::vector<Vertex> shuffled_vertices = vertices;
+  mesh_compute_normals(vertices, indices, NORMAL_WEIGHT_ANGLE);
+
+  double start = bench_now();
+  for(int run = 0; run < RUNS_COUNT; run++) {
+    mesh_compute_normals(shuffled_vertices, shuffled, NORMAL_WEIGHT_ANGLE);
+  }
+  double elapsed = (bench_now() - start) / RUNS_COUNT;
+
+  nikol::f32 max_difference = 0.0f;
+  for(nikol::sizei i = 0; i < vertices.size(); i++) {
+    nikol::f32 cos_angle = glm::clamp(glm::dot(vertices[i].normal, shuffled_vertices[i].normal), -1.0f, 1.0f);
+    max_difference       = glm::max(max_difference, std::acos(cos_angle));
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "normals shuffled %.1fM tris (%u threads)", order.size() / 1e6, job_system_get_threads_count());
+  bench_report(name, elapsed * 1e3, "ms", glm::degrees(max_difference));
+
+  job_system_shutdown();
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+#include "benchmarks.h"
+
+#include "mesh_generator.h"
+#include "mesh_optimizer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const int ITERATIONS    = 5;
+const int TORUS_COUNT   = 8;
+const float TANGLE_SIZE = 1.5f;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// Tori thrown into each other at random, so every view looks through several layers
+static void generate_tangle(std::mt19937& rng, std::vector<Vertex>& vertices, std::vector<nikol::u32>& indices) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+  std::vector<Vertex> torus_vertices;
+  std::vector<nikol::u32> torus_indices;
+  shape_generate(ShapeDesc{.type = SHAPE_TORUS, .segments = 96, .rings = 48}, torus_vertices, torus_indices);
+
+  for(int i = 0; i < TORUS_COUNT; i++) {
+    glm::vec3 axis   = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+    glm::quat rot    = glm::angleAxis(dist(rng) * 3.1415f, axis);
+    glm::vec3 offset = glm::vec3(dist(rng), dist(rng), dist(rng)) * TANGLE_SIZE * 0.5f;
+
+    nikol::u32 base = (nikol::u32)vertices.size();
+    for(auto vert : torus_vertices) {
+      vert.position = rot * vert.position + offset;
+      vert.normal   = rot * vert.normal;
+      vertices.push_back(vert);
+    }
+
+    for(auto index : torus_indices) {
+      indices.push_back(base + index);
+    }
+  }
+
+  // Triangles in no particular order, like a mesh straight out of a bad exporter
+  nikol::sizei triangles_count = indices.size() / 3;
+  for(nikol::sizei i = triangles_count - 1; i > 0; i--) {
+    nikol::sizei j = std::uniform_int_distribution<nikol::sizei>(0, i)(rng);
+    std::swap_ranges(indices.begin() + i * 3, indices.begin() + i * 3 + 3, indices.begin() + j * 3);
+  }
+}
+
+static void report_mesh(const char* when, const std::vector<Vertex>& vertices, const std::vector<nikol::u32>& indices) {
+  VertexCacheStats cache = mesh_analyze_vertex_cache(indices.data(), indices.size(), vertices.size());
+  OverdrawStats overdraw = mesh_analyze_overdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+
+  char name[64];
+  snprintf(name, sizeof(name), "ACMR %s", when);
+  bench_report(name, cache.acmr, "vertices/triangle", cache.vertices_transformed);
+
+  snprintf(name, sizeof(name), "ATVR %s", when);
+  bench_report(name, cache.atvr, "transforms/vertex", cache.vertices_transformed);
+
+  snprintf(name, sizeof(name), "overdraw %s", when);
+  bench_report(name, overdraw.overdraw, "shaded/covered", overdraw.pixels_shaded);
+}
+
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_mesh_optimizer() {
+  std::mt19937 rng(1234);
+
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+  generate_tangle(rng, vertices, indices);
+  printf("  %zu vertices, %zu triangles\n", vertices.size(), indices.size() / 3);
+
+  report_mesh("before", vertices, indices);
+
+  // The whole pipeline, as `mesh_converter --optimize` runs it
+  std::vector<Vertex> optimized_vertices;
+  std::vector<nikol::u32> optimized_indices;
+  MeshOptimizeStats stats;
+
+  double checksum = 0.0;
+  double start    = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    optimized_vertices = vertices;
+    optimized_indices  = indices;
+    stats              = mesh_optimize(optimized_vertices, optimized_indices);
+
+    checksum += stats.clusters_count;
+  }
+  double time = (bench_now() - start) / ITERATIONS;
+  bench_report("mesh_optimize", time * 1000.0, "ms/mesh", checksum);
+
+  report_mesh("after", optimized_vertices, optimized_indices);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,143 @@
+#include "benchmarks.h"
+
+#include "meshlet.h"
+#include "mesh_generator.h"
+#include "mesh_optimizer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 VIEWS_COUNT = 16;
+const int CULLS_PER_VIEW     = 50;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// Half the views circle the whole torus, the other half are close ups along the tube
+static glm::mat4 view_at(const nikol::u32 index, glm::vec3& eye) {
+  nikol::f32 angle = (index / 2) * (glm::two_pi<nikol::f32>() / (VIEWS_COUNT / 2));
+  glm::vec3 around = glm::vec3(std::cos(angle), 0.0f, std::sin(angle));
+
+  if((index % 2) == 0) {
+    eye = around * 30.0f + glm::vec3(0.0f, 12.0f, 0.0f);
+    return glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+  }
+
+  glm::vec3 tangent = glm::vec3(-around.z, 0.0f, around.x);
+  eye               = around * 16.0f + glm::vec3(0.0f, 3.0f, 0.0f);
+
+  return glm::lookAt(eye, eye + tangent, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+static bool is_inside_clip(const glm::mat4& view_projection, const glm::vec3& position) {
+  glm::vec4 clip = view_projection * glm::vec4(position, 1.0f);
+
+  return std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && std::abs(clip.z) <= clip.w;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_meshlet() {
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+  shape_generate(ShapeDesc{.type = SHAPE_TORUS, .segments = 1024, .rings = 512, .radius = 10.0f, .tube_radius = 4.0f}, vertices, indices);
+  mesh_optimize(vertices, indices);
+
+  nikol::u32 triangles_count = (nikol::u32)(indices.size() / 3);
+
+  // Building
+  MeshletMesh mesh;
+
+  double start = bench_now();
+  meshlet_mesh_build(mesh, vertices, indices);
+  double elapsed = bench_now() - start;
+
+  char name[64];
+  snprintf(name, sizeof(name), "build %.1fM tris", triangles_count / 1e6);
+  bench_report(name, elapsed * 1e3, "ms", mesh.meshlets.size());
+
+  nikol::u32 cone_cullable = 0;
+  for(auto& bounds : mesh.bounds) {
+    cone_cullable += bounds.cone_cutoff < 1.0f;
+  }
+
+  bench_report("meshlets", mesh.meshlets.size(), "meshlets", cone_cullable);
+  bench_report("vertices per meshlet", (double)mesh.meshlet_vertices.size() / mesh.meshlets.size(), "avg", MESHLET_MAX_VERTICES);
+  bench_report("triangles per meshlet", (double)triangles_count / mesh.meshlets.size(), "avg", MESHLET_MAX_TRIANGLES);
+  bench_report("meshlets with a usable cone", 100.0 * cone_cullable / mesh.meshlets.size(), "%", cone_cullable);
+
+  // Culling from every view, checking the culled triangles really were invisible
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1366.0f / 768.0f, 0.1f, 200.0f);
+
+  double cull_time           = 0.0;
+  double culled_sum          = 0.0, ideal_sum = 0.0;
+  double frustum_sum         = 0.0, cone_sum  = 0.0;
+  nikol::u32 wrongly_culled  = 0;
+  nikol::u32 ranges_sum      = 0;
+
+  for(nikol::u32 v = 0; v < VIEWS_COUNT; v++) {
+    glm::vec3 eye;
+    glm::mat4 view_projection = projection * view_at(v, eye);
+
+    start = bench_now();
+    for(int i = 0; i < CULLS_PER_VIEW; i++) {
+      meshlet_mesh_cull(mesh, view_projection, eye);
+    }
+    cull_time += (bench_now() - start) / CULLS_PER_VIEW;
+
+    culled_sum  += (double)mesh.stats.triangles_culled / triangles_count;
+    frustum_sum += (double)mesh.stats.culled_frustum / mesh.meshlets.size();
+    cone_sum    += (double)mesh.stats.culled_cone / mesh.meshlets.size();
+    ranges_sum  += (nikol::u32)mesh.ranges.size();
+
+    // What culling every triangle on its own would drop (facing away or outside the frustum)
+    nikol::u32 ideal = 0;
+    for(nikol::u32 t = 0; t < triangles_count; t++) {
+      glm::vec3 p0 = vertices[indices[t * 3 + 0]].position;
+      glm::vec3 p1 = vertices[indices[t * 3 + 1]].position;
+      glm::vec3 p2 = vertices[indices[t * 3 + 2]].position;
+
+      bool is_away    = glm::dot(glm::cross(p1 - p0, p2 - p0), p0 - eye) >= 0.0f;
+      bool is_outside = !is_inside_clip(view_projection, p0) && !is_inside_clip(view_projection, p1) && !is_inside_clip(view_projection, p2);
+      ideal          += is_away || is_outside;
+    }
+    ideal_sum += (double)ideal / triangles_count;
+
+    // Culled meshlets must not have a single front facing triangle with a corner on screen
+    for(nikol::sizei m = 0; m < mesh.meshlets.size(); m++) {
+      if(mesh.visible[m]) {
+        continue;
+      }
+
+      const Meshlet& meshlet = mesh.meshlets[m];
+      for(nikol::u32 t = 0; t < meshlet.triangles_count; t++) {
+        const nikol::u32* tri = &mesh.indices[(meshlet.triangle_offset + t) * 3];
+        glm::vec3 p0          = vertices[tri[0]].position;
+        glm::vec3 p1          = vertices[tri[1]].position;
+        glm::vec3 p2          = vertices[tri[2]].position;
+
+        bool is_facing    = glm::dot(glm::cross(p1 - p0, p2 - p0), p0 - eye) < 0.0f;
+        bool is_on_screen = is_inside_clip(view_projection, p0) || is_inside_clip(view_projection, p1) || is_inside_clip(view_projection, p2);
+        wrongly_culled   += is_facing && is_on_screen;
+      }
+    }
+  }
+
+  bench_report("cull (test + compaction)", cull_time / VIEWS_COUNT * 1e3, "ms/frame", ranges_sum);
+  bench_report("meshlets culled by the frustum", 100.0 * frustum_sum / VIEWS_COUNT, "%", 0.0);
+  bench_report("meshlets culled by the cone", 100.0 * cone_sum / VIEWS_COUNT, "%", 0.0);
+  bench_report("triangles culled", 100.0 * culled_sum / VIEWS_COUNT, "%", wrongly_culled);
+  bench_report("triangles culled (per triangle)", 100.0 * ideal_sum / VIEWS_COUNT, "%", 0.0);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
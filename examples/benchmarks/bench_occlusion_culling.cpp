@@ -0,0 +1,194 @@
+#include "benchmarks.h"
+
+#include "occlusion_culling.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 BUILDINGS_X     = 8;
+const nikol::u32 BUILDINGS_Z     = 8;
+const nikol::u32 CANDIDATES      = 10000;
+const int FRAMES_COUNT           = 50;
+const nikol::u32 THREAD_COUNTS[] = {1, 4};
+
+// Samples per pixel on each axis for the reference depth
+const nikol::u32 REFERENCE_SAMPLES = 4;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static OccluderMesh make_box() {
+  OccluderMesh box;
+
+  for(nikol::u32 i = 0; i < 8; i++) {
+    box.positions.push_back(glm::vec3((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+  }
+
+  // Two triangles per face (the winding does not matter to the rasterizer)
+  const nikol::u32 faces[6][4] = {
+    {0, 1, 3, 2}, {4, 5, 7, 6}, // -Z, +Z
+    {0, 1, 5, 4}, {2, 3, 7, 6}, // -Y, +Y
+    {0, 2, 6, 4}, {1, 3, 7, 5}, // -X, +X
+  };
+
+  for(auto& face : faces) {
+    box.indices.insert(box.indices.end(), {face[0], face[1], face[2], face[0], face[2], face[3]});
+  }
+
+  return box;
+}
+
+// The farthest of the nearest occluder depths sampled all over every pixel (1 where any sample misses every 
+// occluder). The occlusion buffer can never be nearer than this without hiding something it should not.
+static std::vector<nikol::f32> reference_depth(const OccluderMesh& occluder, const std::vector<glm::mat4>& models, const glm::mat4& view_projection) {
+  const nikol::u32 width  = OCCLUSION_WIDTH * REFERENCE_SAMPLES;
+  const nikol::u32 height = OCCLUSION_HEIGHT * REFERENCE_SAMPLES;
+
+  std::vector<nikol::f32> samples(width * height, 1.0f);
+
+  for(auto& model : models) {
+    glm::mat4 mvp = view_projection * model;
+
+    for(nikol::sizei i = 0; i + 2 < occluder.indices.size(); i += 3) {
+      glm::vec3 p[3];
+      bool is_clipped = false;
+
+      for(nikol::u32 j = 0; j < 3; j++) {
+        glm::vec4 clip = mvp * glm::vec4(occluder.positions[occluder.indices[i + j]], 1.0f);
+        is_clipped     = is_clipped || clip.w <= 0.0f;
+
+        p[j] = glm::vec3((clip.x / clip.w * 0.5f + 0.5f) * width, (clip.y / clip.w * 0.5f + 0.5f) * height, clip.z / clip.w * 0.5f + 0.5f);
+      }
+
+      nikol::f32 area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+      if(is_clipped || area == 0.0f) {
+        continue;
+      }
+
+      nikol::i32 x0 = glm::max((nikol::i32)glm::min(p[0].x, glm::min(p[1].x, p[2].x)), 0);
+      nikol::i32 y0 = glm::max((nikol::i32)glm::min(p[0].y, glm::min(p[1].y, p[2].y)), 0);
+      nikol::i32 x1 = glm::min((nikol::i32)glm::max(p[0].x, glm::max(p[1].x, p[2].x)), (nikol::i32)width - 1);
+      nikol::i32 y1 = glm::min((nikol::i32)glm::max(p[0].y, glm::max(p[1].y, p[2].y)), (nikol::i32)height - 1);
+
+      for(nikol::i32 y = y0; y <= y1; y++) {
+        for(nikol::i32 x = x0; x <= x1; x++) {
+          glm::vec2 s = glm::vec2(x + 0.5f, y + 0.5f);
+
+          // Barycentrics, which are all positive inside whatever the winding
+          nikol::f32 w0 = ((p[1].x - s.x) * (p[2].y - s.y) - (p[1].y - s.y) * (p[2].x - s.x)) / area;
+          nikol::f32 w1 = ((p[2].x - s.x) * (p[0].y - s.y) - (p[2].y - s.y) * (p[0].x - s.x)) / area;
+          nikol::f32 w2 = 1.0f - w0 - w1;
+
+          if(w0 >= 0.0f && w1 >= 0.0f && w2 >= 0.0f) {
+            nikol::f32& depth = samples[y * width + x];
+            depth             = glm::min(depth, w0 * p[0].z + w1 * p[1].z + w2 * p[2].z);
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<nikol::f32> reference(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 0.0f);
+  for(nikol::u32 y = 0; y < height; y++) {
+    for(nikol::u32 x = 0; x < width; x++) {
+      nikol::f32& depth = reference[(y / REFERENCE_SAMPLES) * OCCLUSION_WIDTH + (x / REFERENCE_SAMPLES)];
+      depth             = glm::max(depth, samples[y * width + x]);
+    }
+  }
+
+  return reference;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_occlusion_culling() {
+  // A city block: a grid of tall buildings with small props scattered in between and behind them
+  OccluderMesh box = make_box();
+
+  std::vector<glm::mat4> buildings;
+  for(nikol::u32 z = 0; z < BUILDINGS_Z; z++) {
+    for(nikol::u32 x = 0; x < BUILDINGS_X; x++) {
+      glm::vec3 pos = glm::vec3(((nikol::f32)x - BUILDINGS_X * 0.5f) * 12.0f, 10.0f, -15.0f - (nikol::f32)z * 12.0f);
+      buildings.push_back(glm::scale(glm::translate(glm::mat4(1.0f), pos), glm::vec3(10.0f, 20.0f, 10.0f)));
+    }
+  }
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<nikol::f32> pos_x(-50.0f, 50.0f);
+  std::uniform_real_distribution<nikol::f32> pos_z(-110.0f, -10.0f);
+
+  std::vector<glm::vec3> mins(CANDIDATES), maxs(CANDIDATES);
+  for(nikol::u32 i = 0; i < CANDIDATES; i++) {
+    glm::vec3 center = glm::vec3(pos_x(rng), 1.0f, pos_z(rng));
+
+    mins[i] = center - glm::vec3(0.5f);
+    maxs[i] = center + glm::vec3(0.5f);
+  }
+
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1366.0f / 768.0f, 0.1f, 200.0f);
+  glm::mat4 view       = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+  std::vector<nikol::u8> visible(CANDIDATES);
+  std::vector<nikol::f32> reference = reference_depth(box, buildings, projection * view);
+
+  for(auto threads : THREAD_COUNTS) {
+    job_system_init(threads);
+
+    OcclusionBuffer buffer;
+    occlusion_buffer_init(buffer);
+
+    double raster_time = 0.0;
+    double test_time   = 0.0;
+
+    for(int frame = 0; frame < FRAMES_COUNT; frame++) {
+      double start = bench_now();
+
+      occlusion_buffer_begin(buffer, projection * view);
+      for(auto& model : buildings) {
+        occlusion_buffer_add_occluder(buffer, box, model);
+      }
+      occlusion_buffer_rasterize(buffer);
+
+      double mid = bench_now();
+      occlusion_buffer_test_batch(buffer, mins.data(), maxs.data(), CANDIDATES, visible.data());
+
+      raster_time += mid - start;
+      test_time   += bench_now() - mid;
+    }
+
+    const OcclusionStats& stats = buffer.stats;
+
+    char name[64];
+    snprintf(name, sizeof(name), "rasterize %u occluders (%u threads)", stats.occluders, threads);
+    bench_report(name, (raster_time / FRAMES_COUNT) * 1e6, "us/frame", stats.triangles_setup);
+
+    snprintf(name, sizeof(name), "test %u boxes (%u threads)", CANDIDATES, threads);
+    bench_report(name, (test_time / FRAMES_COUNT) * 1e6, "us/frame", stats.tested);
+
+    snprintf(name, sizeof(name), "occluded (%u threads)", threads);
+    bench_report(name, (stats.occluded * 100.0) / stats.tested, "%", stats.occluded);
+
+    // Pixels nearer than every occluder sampled over them, which could hide something visible
+    nikol::u32 too_near = 0;
+    for(nikol::sizei i = 0; i < reference.size(); i++) {
+      too_near += buffer.depth[i] < reference[i] - 1e-5f;
+    }
+
+    snprintf(name, sizeof(name), "pixels nearer than the reference (%u threads)", threads);
+    bench_report(name, too_near, "pixels", reference.size());
+
+    job_system_shutdown();
+  }
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
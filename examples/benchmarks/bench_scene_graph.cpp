@@ -0,0 +1,153 @@
+#include "benchmarks.h"
+
+#include "scene_graph.h"
+#include "job_system.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 NODES_COUNT     = 1 << 17;
+const nikol::u32 ROOTS_COUNT     = 16;
+const nikol::u32 REPARENT_COUNT  = 1024;
+const nikol::u32 DIRTY_STRIDE    = 64;
+const int FRAMES_COUNT           = 20;
+const nikol::u32 THREAD_COUNTS[] = {1, 2, 4, 8};
+
+// Both sides multiply the same matrices, only grouped differently
+const float MAX_DIFFERENCE = 1e-4f;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static float random_float() {
+  return ((float)std::rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+}
+
+// The plain serial walk. Every parent handle is smaller than its children's, so one pass in handle order is enough.
+static void compute_reference(const SceneGraph& graph, std::vector<glm::mat4>& worlds) {
+  worlds.resize(graph.parent_handles.size());
+
+  for(SceneNode node = 0; node < graph.parent_handles.size(); node++) {
+    nikol::u32 index = graph.handle_to_index[node];
+    glm::mat4 local  = glm::translate(glm::mat4(1.0f), graph.positions[index]) *
+                       glm::mat4_cast(graph.rotations[index]) *
+                       glm::scale(glm::mat4(1.0f), graph.scales[index]);
+
+    SceneNode parent = graph.parent_handles[node];
+    worlds[node]     = parent != SCENE_NODE_INVALID ? worlds[parent] * local : local;
+  }
+}
+
+static float max_difference(const SceneGraph& graph, const std::vector<glm::mat4>& reference) {
+  float largest = 0.0f;
+  for(SceneNode node = 0; node < reference.size(); node++) {
+    const glm::mat4& world = scene_graph_get_world(graph, node);
+
+    for(int col = 0; col < 4; col++) {
+      glm::vec4 diff = glm::abs(world[col] - reference[node][col]);
+      largest        = glm::max(largest, glm::max(glm::max(diff.x, diff.y), glm::max(diff.z, diff.w)));
+    }
+  }
+
+  return largest;
+}
+
+static void report_difference(const char* name, const SceneGraph& graph) {
+  std::vector<glm::mat4> reference;
+  compute_reference(graph, reference);
+
+  float difference = max_difference(graph, reference);
+  bench_report(name, difference * 1e6, "1e-6 max diff", MAX_DIFFERENCE);
+  NIKOL_ASSERT(difference <= MAX_DIFFERENCE, "scene_graph_update does not match a serial update");
+}
+
+static void build_graph(SceneGraph& graph) {
+  scene_graph_clear(graph);
+
+  std::srand(1234);
+  for(nikol::u32 i = 0; i < NODES_COUNT; i++) {
+    SceneNode parent = i < ROOTS_COUNT ? SCENE_NODE_INVALID : (SceneNode)(std::rand() % i);
+    glm::vec3 pos    = glm::vec3(random_float(), random_float(), random_float());
+
+    SceneNode node = scene_graph_create_node(graph, parent, pos);
+    scene_graph_rotate(graph, node, random_float() * 180.0f, glm::vec3(random_float(), random_float(), random_float()) + glm::vec3(0.0f, 1.1f, 0.0f));
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_scene_graph() {
+  SceneGraph graph;
+
+  for(auto threads : THREAD_COUNTS) {
+    job_system_init(threads);
+    char name[64];
+
+    // The first update sorts the nodes and builds the tasks
+    build_graph(graph);
+
+    double start = bench_now();
+    scene_graph_update(graph);
+    double sort_time = bench_now() - start;
+
+    snprintf(name, sizeof(name), "sort %u nodes (%u threads)", NODES_COUNT, threads);
+    bench_report(name, sort_time * 1000.0, "ms", (double)graph.tasks.size());
+
+    // Every node dirty
+    start = bench_now();
+    for(int frame = 0; frame < FRAMES_COUNT; frame++) {
+      std::fill(graph.dirty.begin(), graph.dirty.end(), 1);
+      scene_graph_update(graph);
+    }
+    double full_time = (bench_now() - start) / FRAMES_COUNT;
+
+    snprintf(name, sizeof(name), "full update (%u threads)", threads);
+    bench_report(name, (NODES_COUNT / full_time) * 1e-6, "M nodes/s", graph.worlds[NODES_COUNT - 1][3][0]);
+
+    snprintf(name, sizeof(name), "full update vs serial (%u threads)", threads);
+    report_difference(name, graph);
+
+    // A few nodes moved every frame, dragging their subtrees along
+    start = bench_now();
+    for(int frame = 0; frame < FRAMES_COUNT; frame++) {
+      for(SceneNode node = frame % DIRTY_STRIDE; node < NODES_COUNT; node += DIRTY_STRIDE) {
+        scene_graph_translate(graph, node, glm::vec3(random_float(), random_float(), random_float()));
+      }
+      scene_graph_update(graph);
+    }
+    double partial_time = (bench_now() - start) / FRAMES_COUNT;
+
+    snprintf(name, sizeof(name), "1/%u moved (%u threads)", DIRTY_STRIDE, threads);
+    bench_report(name, (NODES_COUNT / partial_time) * 1e-6, "M nodes/s", graph.worlds[NODES_COUNT - 1][3][0]);
+
+    snprintf(name, sizeof(name), "partial update vs serial (%u threads)", threads);
+    report_difference(name, graph);
+
+    // Moving whole subtrees around re-sorts everything and rebuilds the tasks.
+    // The new parents still come before their children, so no cycles.
+    for(nikol::u32 i = 0; i < REPARENT_COUNT; i++) {
+      SceneNode node = ROOTS_COUNT + (SceneNode)(std::rand() % (NODES_COUNT - ROOTS_COUNT));
+      scene_graph_set_parent(graph, node, (SceneNode)(std::rand() % node));
+    }
+    scene_graph_update(graph);
+
+    snprintf(name, sizeof(name), "re-parented vs serial (%u threads)", threads);
+    report_difference(name, graph);
+
+    job_system_shutdown();
+  }
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,150 @@
+#include "benchmarks.h"
+
+#include "skinning.h"
+#include "trasform.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 JOINT_COUNTS[]     = {64, 128};
+const nikol::u32 CHARACTERS         = 1000;
+const nikol::u32 SKINNED_VERTICES   = 4096;
+const nikol::u32 SKINNED_CHARACTERS = 100;
+const int FRAMES_COUNT              = 20;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static Skeleton make_skeleton(const nikol::u32 joints_count) {
+  Skeleton skeleton;
+
+  // A binary tree of bones, each one a unit up from its parent
+  for(nikol::u32 i = 0; i < joints_count; i++) {
+    nikol::u32 parent = (i == 0) ? JOINT_INVALID : (i - 1) / 2;
+    skeleton_add_joint(skeleton, parent, transform_create(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f)));
+  }
+
+  skeleton_finalize(skeleton);
+  return skeleton;
+}
+
+static std::vector<SkinnedVertex> make_vertices(const nikol::u32 joints_count) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<nikol::f32> pos(-1.0f, 1.0f);
+  std::uniform_int_distribution<nikol::u32> joint(0, joints_count - 1);
+
+  std::vector<SkinnedVertex> vertices(SKINNED_VERTICES);
+  for(auto& vert : vertices) {
+    vert.position       = glm::vec3(pos(rng), pos(rng), pos(rng));
+    vert.normal         = glm::normalize(vert.position);
+    vert.texture_coords = glm::vec2(0.0f);
+
+    for(auto& index : vert.joints) {
+      index = (nikol::u8)joint(rng);
+    }
+    vert.weights = glm::vec4(0.4f, 0.3f, 0.2f, 0.1f);
+  }
+
+  return vertices;
+}
+
+static void animate(std::vector<SkeletonPose>& poses, const nikol::f32 time) {
+  for(nikol::u32 i = 0; i < poses.size(); i++) {
+    for(nikol::u32 j = 0; j < poses[i].locals.size(); j++) {
+      poses[i].locals[j].rotation = glm::angleAxis(glm::sin(time + i * 0.1f + j) * 0.3f, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_skinning() {
+  job_system_init();
+
+  for(auto joints_count : JOINT_COUNTS) {
+    Skeleton skeleton = make_skeleton(joints_count);
+
+    std::vector<SkeletonPose> poses(CHARACTERS);
+    for(auto& pose : poses) {
+      skeleton_pose_init(pose, skeleton);
+    }
+
+    // Palettes only (the animation itself is not timed)
+    double palette_time = 0.0;
+    for(int frame = 0; frame < FRAMES_COUNT; frame++) {
+      animate(poses, frame * 0.016f);
+
+      double start = bench_now();
+      skeleton_update_palettes(poses.data(), CHARACTERS);
+      palette_time += bench_now() - start;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "palettes (%u joints, %u threads)", joints_count, job_system_get_threads_count());
+    bench_report(name, (CHARACTERS * FRAMES_COUNT) / (palette_time * 1e3), "characters/ms", poses[0].palette[joints_count - 1][3].y);
+
+    // CPU skinning of a few characters, one job per character
+    std::vector<SkinnedVertex> vertices = make_vertices(joints_count);
+    std::vector<std::vector<Vertex>> outputs(SKINNED_CHARACTERS, std::vector<Vertex>(SKINNED_VERTICES));
+
+    double start = bench_now();
+    for(int frame = 0; frame < FRAMES_COUNT; frame++) {
+      job_system_parallel_for(SKINNED_CHARACTERS, 1, [&](const nikol::u32 first, const nikol::u32 last, const nikol::u32 thread_index) {
+        for(nikol::u32 i = first; i < last; i++) {
+          skinning_apply(vertices.data(), outputs[i].data(), SKINNED_VERTICES, poses[i].palette.data());
+        }
+      });
+    }
+    double skin_time = bench_now() - start;
+
+    snprintf(name, sizeof(name), "cpu skinning %u verts (%u joints)", SKINNED_VERTICES, joints_count);
+    bench_report(name, (SKINNED_CHARACTERS * FRAMES_COUNT) / (skin_time * 1e3), "characters/ms", outputs[0][0].position.x);
+
+    // The bounds of every posed character, against the vertices skinned above. The bind pose
+    // bounds are what a mesh would keep otherwise.
+    std::vector<glm::vec4> joint_spheres;
+    skinning_compute_joint_spheres(vertices, joint_spheres);
+
+    std::vector<glm::vec3> centers(SKINNED_CHARACTERS);
+    std::vector<nikol::f32> radii(SKINNED_CHARACTERS);
+
+    start = bench_now();
+    for(nikol::u32 i = 0; i < SKINNED_CHARACTERS; i++) {
+      skinning_compute_bounds(joint_spheres, poses[i].palette.data(), centers[i], radii[i]);
+    }
+    double bounds_time = bench_now() - start;
+
+    std::vector<glm::mat4> bind_palette(joints_count, glm::mat4(1.0f));
+    glm::vec3 bind_center;
+    nikol::f32 bind_radius;
+    skinning_compute_bounds(joint_spheres, bind_palette.data(), bind_center, bind_radius);
+
+    nikol::u32 outside = 0, outside_bind = 0;
+    for(nikol::u32 i = 0; i < SKINNED_CHARACTERS; i++) {
+      for(auto& vert : outputs[i]) {
+        outside      += glm::length(vert.position - centers[i]) > radii[i] * 1.0001f;
+        outside_bind += glm::length(vert.position - bind_center) > bind_radius;
+      }
+    }
+
+    snprintf(name, sizeof(name), "posed bounds (%u joints)", joints_count);
+    bench_report(name, bounds_time * 1e6 / SKINNED_CHARACTERS, "us/character", outside);
+
+    snprintf(name, sizeof(name), "outside bind pose bounds (%u joints)", joints_count);
+    bench_report(name, outside_bind, "vertices", radii[0]);
+  }
+
+  job_system_shutdown();
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,123 @@
+#include "benchmarks.h"
+
+#include "static_batch.h"
+#include "mesh_generator.h"
+#include "material.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 ROOMS_PER_SIDE   = 16;
+const nikol::f32 ROOM_SIZE        = 12.0f;
+const nikol::u32 PROPS_PER_ROOM   = 40;
+const nikol::u32 MATERIALS_COUNT  = 8;
+const int BUILDS_COUNT            = 5;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+struct PropShape {
+  std::vector<Vertex> vertices;
+  std::vector<nikol::u32> indices;
+};
+
+static std::vector<PropShape> make_shapes() {
+  ShapeDesc descs[] = {
+    {.type = SHAPE_PLANE, .segments = 1, .rings = 1, .size = ROOM_SIZE},     // Floors
+    {.type = SHAPE_CYLINDER, .segments = 12, .rings = 1, .height = 3.0f},    // Pillars
+    {.type = SHAPE_UV_SPHERE, .segments = 12, .rings = 8},                   // Props
+    {.type = SHAPE_CONE, .segments = 12, .rings = 1},
+  };
+
+  std::vector<PropShape> shapes(sizeof(descs) / sizeof(descs[0]));
+  for(nikol::sizei i = 0; i < shapes.size(); i++) {
+    shape_generate(descs[i], shapes[i].vertices, shapes[i].indices);
+  }
+
+  return shapes;
+}
+
+// A grid of rooms, each with a floor, 4 pillars and a bunch of small props
+static void add_scene(StaticBatch& batch, const std::vector<PropShape>& shapes, Material* materials) {
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<nikol::f32> offset(-ROOM_SIZE * 0.45f, ROOM_SIZE * 0.45f);
+  std::uniform_int_distribution<nikol::u32> prop(2, 3);
+  std::uniform_int_distribution<nikol::u32> material(2, MATERIALS_COUNT - 1);
+
+  for(nikol::u32 x = 0; x < ROOMS_PER_SIDE; x++) {
+    for(nikol::u32 z = 0; z < ROOMS_PER_SIDE; z++) {
+      glm::vec3 room = glm::vec3(x * ROOM_SIZE, 0.0f, z * ROOM_SIZE);
+
+      static_batch_add(batch, shapes[0].vertices, shapes[0].indices, &materials[0], glm::translate(glm::mat4(1.0f), room));
+
+      for(int corner = 0; corner < 4; corner++) {
+        glm::vec3 pos = room + glm::vec3((corner & 1) ? 5.5f : -5.5f, 1.5f, (corner & 2) ? 5.5f : -5.5f);
+        static_batch_add(batch, shapes[1].vertices, shapes[1].indices, &materials[1], glm::translate(glm::mat4(1.0f), pos));
+      }
+
+      for(nikol::u32 i = 0; i < PROPS_PER_ROOM; i++) {
+        glm::vec3 pos   = room + glm::vec3(offset(rng), 0.5f, offset(rng));
+        glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), pos), offset(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        const PropShape& shape = shapes[prop(rng)];
+        static_batch_add(batch, shape.vertices, shape.indices, &materials[material(rng)], model);
+      }
+    }
+  }
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_static_batch() {
+  job_system_init();
+
+  std::vector<PropShape> shapes = make_shapes();
+  // Only their slots matter here, handed out backwards so the order cannot come from the addresses
+  Material materials[MATERIALS_COUNT];
+  for(nikol::u32 i = 0; i < MATERIALS_COUNT; i++) {
+    materials[i].slot = MATERIALS_COUNT - i - 1;
+  }
+
+  StaticBatch batch;
+  double build_time = 0.0;
+
+  for(int i = 0; i < BUILDS_COUNT; i++) {
+    static_batch_destroy(batch);
+    add_scene(batch, shapes, materials);
+
+    double start = bench_now();
+    static_batch_build(batch);
+    build_time += bench_now() - start;
+  }
+
+  const StaticBatchStats& stats = batch.stats;
+  bench_report("draws without batching", stats.objects_count, "draws", stats.triangles_count);
+  bench_report("draws with batching", stats.chunks_count, "draws", stats.vertices_count);
+  bench_report("draw reduction", (double)stats.objects_count / stats.chunks_count, "x", stats.materials_count);
+
+  char name[64];
+  snprintf(name, sizeof(name), "build (%u threads)", job_system_get_threads_count());
+  bench_report(name, (build_time * 1e3) / BUILDS_COUNT, "ms", batch.chunks[0].bounds_max.x);
+
+  // The chunks have to come out by slot, the same way every run
+  nikol::u32 out_of_order = 0;
+  for(nikol::sizei i = 1; i < batch.chunks.size(); i++) {
+    out_of_order += batch.chunks[i].material->slot < batch.chunks[i - 1].material->slot;
+  }
+  bench_report("chunks out of slot order", out_of_order, "chunks", batch.chunks[0].material->slot);
+
+  static_batch_destroy(batch);
+  job_system_shutdown();
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,295 @@
+#include "benchmarks.h"
+
+#include "terrain.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const nikol::u32 HEIGHTMAP_SIZE  = 4097;
+const nikol::u32 VIEWS_COUNT     = 16;
+const int SELECTIONS_PER_VIEW    = 50;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// A few octaves of sines, enough to get the nodes' bounds spread out
+static void generate_heights(std::vector<nikol::u16>& heights) {
+  heights.resize(HEIGHTMAP_SIZE * HEIGHTMAP_SIZE);
+
+  for(nikol::u32 z = 0; z < HEIGHTMAP_SIZE; z++) {
+    for(nikol::u32 x = 0; x < HEIGHTMAP_SIZE; x++) {
+      nikol::f32 h = 0.0f, amplitude = 0.5f, frequency = 0.002f;
+
+      for(int octave = 0; octave < 5; octave++) {
+        h         += amplitude * std::sin(x * frequency + octave * 1.7f) * std::cos(z * frequency * 1.3f - octave * 0.9f);
+        amplitude *= 0.5f;
+        frequency *= 2.1f;
+      }
+
+      heights[z * HEIGHTMAP_SIZE + x] = (nikol::u16)(glm::clamp(h * 0.5f + 0.5f, 0.0f, 1.0f) * 65535.0f);
+    }
+  }
+}
+
+// The views fly low over the terrain, looking ahead and slightly down
+static glm::mat4 view_at(const Terrain& terrain, const nikol::u32 index, glm::vec3& eye) {
+  nikol::f32 angle = index * (glm::two_pi<nikol::f32>() / VIEWS_COUNT);
+  nikol::f32 size  = (HEIGHTMAP_SIZE - 1) * terrain.desc.spacing;
+
+  eye   = terrain.desc.origin + glm::vec3(size * (0.5f + 0.3f * std::cos(angle)), 0.0f, size * (0.5f + 0.3f * std::sin(angle)));
+  eye.y = terrain.desc.origin.y + terrain.desc.height + 20.0f;
+
+  glm::vec3 forward = glm::vec3(-std::sin(angle), -0.25f, std::cos(angle));
+  return glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+static nikol::f32 sample_height(const Terrain& terrain, const glm::vec2& xz) {
+  glm::vec2 texel = xz / terrain.desc.spacing;
+  int x0          = (int)std::floor(texel.x), z0 = (int)std::floor(texel.y);
+  glm::vec2 t     = texel - glm::vec2(x0, z0);
+
+  auto at = [&](int x, int z) {
+    x = glm::clamp(x, 0, (int)terrain.width - 1);
+    z = glm::clamp(z, 0, (int)terrain.depth - 1);
+    return (nikol::f32)terrain.heights[z * terrain.width + x] / 65535.0f;
+  };
+
+  nikol::f32 h0 = glm::mix(at(x0, z0), at(x0 + 1, z0), t.x);
+  nikol::f32 h1 = glm::mix(at(x0, z0 + 1), at(x0 + 1, z0 + 1), t.x);
+  return glm::mix(h0, h1, t.y) * terrain.desc.height;
+}
+
+// What the vertex shader does to the patch's vertex at `grid` (terrain space, without the height)
+static glm::vec2 morph_vertex(const Terrain& terrain, const TerrainNode& node, const glm::vec2& grid, const glm::vec3& eye) {
+  glm::vec2 corner = glm::vec2(node.node.x, node.node.y);
+  glm::vec2 xz     = corner + grid * node.node.z;
+
+  glm::vec3 world  = terrain.desc.origin + glm::vec3(xz.x, sample_height(terrain, xz), xz.y);
+  nikol::f32 morph = glm::clamp((glm::length(world - eye) - node.morph.x) * node.morph.y, 0.0f, 1.0f);
+
+  glm::vec2 odd = glm::vec2(std::fmod(grid.x, 2.0f), std::fmod(grid.y, 2.0f));
+  return corner + (grid - odd * morph) * node.node.z;
+}
+
+// The grid coordinates the part of the patch drawn by `node` starts at, and how many cells it spans
+static void get_part_grid(const Terrain& terrain, const TerrainNode& node, glm::vec2& first, nikol::f32& cells) {
+  nikol::u32 half = terrain.desc.patch_size / 2;
+
+  if(node.part == TERRAIN_PART_WHOLE) {
+    first = glm::vec2(0.0f);
+    cells = (nikol::f32)terrain.desc.patch_size;
+    return;
+  }
+
+  nikol::u32 quarter = node.part - TERRAIN_PART_QUARTER_00;
+  first              = glm::vec2((quarter & 1) * half, (quarter >> 1) * half);
+  cells              = (nikol::f32)half;
+}
+
+static bool is_box_outside(const glm::mat4& vp, const glm::vec3& min, const glm::vec3& max) {
+  glm::vec4 row0 = glm::vec4(vp[0][0], vp[1][0], vp[2][0], vp[3][0]);
+  glm::vec4 row1 = glm::vec4(vp[0][1], vp[1][1], vp[2][1], vp[3][1]);
+  glm::vec4 row2 = glm::vec4(vp[0][2], vp[1][2], vp[2][2], vp[3][2]);
+  glm::vec4 row3 = glm::vec4(vp[0][3], vp[1][3], vp[2][3], vp[3][3]);
+
+  glm::vec4 planes[6] = {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2};
+
+  for(auto& plane : planes) {
+    glm::vec3 corner = glm::vec3(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+    if(glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// The leaves in view (and in range) that no node covers, and the ones covered more than once
+static void check_coverage(const Terrain& terrain, const glm::mat4& vp, const glm::vec3& eye, std::vector<int>& owners, nikol::u32& holes, nikol::u32& overlaps) {
+  const TerrainLevel& leaves = terrain.levels[0];
+  owners.assign(leaves.nodes_x * leaves.nodes_z, -1);
+
+  for(nikol::sizei i = 0; i < terrain.selection.size(); i++) {
+    const TerrainNode& node = terrain.selection[i];
+
+    glm::vec2 first;
+    nikol::f32 cells;
+    get_part_grid(terrain, node, first, cells);
+
+    glm::vec2 corner = glm::vec2(node.node.x, node.node.y) + first * node.node.z;
+    nikol::u32 span  = (nikol::u32)(cells * node.node.z / leaves.node_size + 0.5f);
+    nikol::u32 x0    = (nikol::u32)(corner.x / leaves.node_size + 0.5f);
+    nikol::u32 z0    = (nikol::u32)(corner.y / leaves.node_size + 0.5f);
+
+    for(nikol::u32 z = z0; z < glm::min(z0 + span, leaves.nodes_z); z++) {
+      for(nikol::u32 x = x0; x < glm::min(x0 + span, leaves.nodes_x); x++) {
+        int& owner = owners[z * leaves.nodes_x + x];
+        overlaps  += (owner != -1);
+        owner      = (int)i;
+      }
+    }
+  }
+
+  nikol::f32 height_scale = terrain.desc.height / 65535.0f;
+  nikol::f32 last_range   = terrain.levels[terrain.levels_count - 1].range;
+
+  for(nikol::u32 z = 0; z < leaves.nodes_z; z++) {
+    for(nikol::u32 x = 0; x < leaves.nodes_x; x++) {
+      nikol::u32 index = z * leaves.nodes_x + x;
+      if(owners[index] != -1) {
+        continue;
+      }
+
+      glm::vec3 min = terrain.desc.origin + glm::vec3(x * leaves.node_size, terrain.nodes_min[index] * height_scale, z * leaves.node_size);
+      glm::vec3 max = terrain.desc.origin + glm::vec3((x + 1) * leaves.node_size, terrain.nodes_max[index] * height_scale, (z + 1) * leaves.node_size);
+
+      glm::vec3 closest = glm::clamp(eye, min, max);
+      holes            += !is_box_outside(vp, min, max) && glm::length(closest - eye) < last_range;
+    }
+  }
+}
+
+// Every morphed vertex along the border of a node has to be a morphed vertex of the node across the border as well,
+// or the two edges do not line up (a T-junction, so a crack once the heights differ)
+static nikol::u32 count_cracks(const Terrain& terrain, const glm::vec3& eye, const std::vector<int>& owners) {
+  const TerrainLevel& leaves = terrain.levels[0];
+  nikol::u32 cracks          = 0;
+
+  auto owner_at = [&](const glm::vec2& xz) {
+    int x = (int)std::floor(xz.x / leaves.node_size);
+    int z = (int)std::floor(xz.y / leaves.node_size);
+
+    if(x < 0 || z < 0 || x >= (int)leaves.nodes_x || z >= (int)leaves.nodes_z) {
+      return -1;
+    }
+    return owners[z * leaves.nodes_x + x];
+  };
+
+  auto has_vertex = [&](const TerrainNode& node, const glm::vec2& point) {
+    glm::vec2 first;
+    nikol::f32 cells;
+    get_part_grid(terrain, node, first, cells);
+
+    for(nikol::f32 i = 0.0f; i <= cells; i++) {
+      glm::vec2 grids[4] = {first + glm::vec2(i, 0.0f), first + glm::vec2(i, cells), first + glm::vec2(0.0f, i), first + glm::vec2(cells, i)};
+
+      for(auto& grid : grids) {
+        if(glm::length(morph_vertex(terrain, node, grid, eye) - point) < 1e-3f) {
+          return true;
+        }
+      }
+    }
+    return false;
+  };
+
+  // A point that slid to within the probe's reach of a corner can land on a node that does not even touch it
+  auto is_on_edge = [&](const TerrainNode& node, const glm::vec2& point) {
+    glm::vec2 first;
+    nikol::f32 cells;
+    get_part_grid(terrain, node, first, cells);
+
+    glm::vec2 min = glm::vec2(node.node.x, node.node.y) + first * node.node.z;
+    glm::vec2 max = min + cells * node.node.z;
+    return point.x > min.x - 1e-3f && point.x < max.x + 1e-3f && point.y > min.y - 1e-3f && point.y < max.y + 1e-3f;
+  };
+
+  for(auto& node : terrain.selection) {
+    nikol::f32 nudge = node.node.z * 0.25f;
+
+    glm::vec2 first;
+    nikol::f32 cells;
+    get_part_grid(terrain, node, first, cells);
+
+    for(nikol::f32 i = 0.0f; i <= cells; i++) {
+      // The borders along Z (left and right) and along X (bottom and top), with the way out of the node
+      glm::vec2 grids[4]   = {first + glm::vec2(0.0f, i), first + glm::vec2(cells, i), first + glm::vec2(i, 0.0f), first + glm::vec2(i, cells)};
+      glm::vec2 outward[4] = {glm::vec2(-1.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, -1.0f), glm::vec2(0.0f, 1.0f)};
+
+      for(int side = 0; side < 4; side++) {
+        glm::vec2 point = morph_vertex(terrain, node, grids[side], eye);
+        glm::vec2 along = glm::vec2(outward[side].y, outward[side].x);
+
+        // The node on either side of the point, in case it sits right where two neighbours meet
+        for(nikol::f32 dir : {-1.0f, 1.0f}) {
+          int owner = owner_at(point + outward[side] * nudge + along * dir * 1e-2f);
+          if(owner == -1 || !is_on_edge(terrain.selection[owner], point)) {
+            continue;
+          }
+
+          cracks += !has_vertex(terrain.selection[owner], point);
+        }
+      }
+    }
+  }
+
+  return cracks;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_terrain() {
+  std::vector<nikol::u16> heights;
+  generate_heights(heights);
+
+  TerrainDesc desc = {
+    .origin       = glm::vec3(-2048.0f, 0.0f, -2048.0f),
+    .spacing      = 1.0f,
+    .height       = 300.0f,
+    .patch_size   = 32,
+    .levels_count = 8,
+    .lod_distance = 64.0f,
+  };
+
+  Terrain terrain;
+
+  double start = bench_now();
+  terrain_build(terrain, heights.data(), HEIGHTMAP_SIZE, HEIGHTMAP_SIZE, desc);
+  double elapsed = bench_now() - start;
+
+  char name[64];
+  snprintf(name, sizeof(name), "build %ux%u", HEIGHTMAP_SIZE, HEIGHTMAP_SIZE);
+  bench_report(name, elapsed * 1e3, "ms", terrain.stats.nodes_count);
+
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1366.0f / 768.0f, 0.5f, 8000.0f);
+
+  double select_time = 0.0;
+  double nodes_sum = 0.0, triangles_sum = 0.0, visited_sum = 0.0;
+  nikol::u32 holes = 0, overlaps = 0, cracks = 0;
+  std::vector<int> owners;
+
+  for(nikol::u32 v = 0; v < VIEWS_COUNT; v++) {
+    glm::vec3 eye;
+    glm::mat4 view_projection = projection * view_at(terrain, v, eye);
+
+    start = bench_now();
+    for(int i = 0; i < SELECTIONS_PER_VIEW; i++) {
+      terrain_select(terrain, view_projection, eye);
+    }
+    select_time += (bench_now() - start) / SELECTIONS_PER_VIEW;
+
+    nodes_sum     += terrain.stats.nodes_selected;
+    visited_sum   += terrain.stats.nodes_visited;
+    triangles_sum += terrain.stats.triangles_count;
+
+    check_coverage(terrain, view_projection, eye, owners, holes, overlaps);
+    cracks += count_cracks(terrain, eye, owners);
+  }
+
+  bench_report("select", select_time / VIEWS_COUNT * 1e3, "ms/frame", visited_sum / VIEWS_COUNT);
+  bench_report("nodes selected", nodes_sum / VIEWS_COUNT, "nodes/frame", overlaps);
+  bench_report("triangles", triangles_sum / VIEWS_COUNT / 1e6, "M/frame", holes);
+  bench_report("triangles (full heightmap)", terrain.stats.triangles_full / 1e6, "M", 0.0);
+  bench_report("cracks between nodes", cracks, "vertices", 0.0);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,107 @@
+#include "benchmarks.h"
+
+#include "trasform.h"
+
+#include <nikol/nikol_core.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include <vector>
+#include <cstdlib>
+
+// ----------------------------------------------------------------------------
+// Globals
+const size_t TRANSFORMS_COUNT = 1 << 20;
+const int ITERATIONS          = 20;
+
+// The kernels reorder a few multiplications, but nothing more
+const float MAX_DIFFERENCE = 1e-4f;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+static float random_float() {
+  return ((float)std::rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+}
+
+static double checksum(const std::vector<glm::mat4>& models) {
+  double sum = 0.0;
+  for(size_t i = 0; i < models.size(); i += 997) {
+    sum += models[i][0][0] + models[i][3][2];
+  }
+
+  return sum;
+}
+
+static float max_difference(const std::vector<glm::mat4>& models, const std::vector<glm::mat4>& reference) {
+  float largest = 0.0f;
+  for(size_t i = 0; i < models.size(); i++) {
+    for(int col = 0; col < 4; col++) {
+      glm::vec4 diff = glm::abs(models[i][col] - reference[i][col]);
+      largest        = glm::max(largest, glm::max(glm::max(diff.x, diff.y), glm::max(diff.z, diff.w)));
+    }
+  }
+
+  return largest;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_transform() {
+  std::vector<Transform> transforms(TRANSFORMS_COUNT);
+  std::vector<glm::mat4> models(TRANSFORMS_COUNT);
+
+  std::srand(1234);
+  for(auto& trans : transforms) {
+    trans = transform_create(glm::vec3(random_float(), random_float(), random_float()) * 100.0f, glm::vec3(1.0f));
+    transform_rotate(trans, random_float() * 180.0f, glm::vec3(random_float(), random_float(), random_float()) + glm::vec3(0.0f, 1.1f, 0.0f));
+  }
+
+  // The old way: three full matrices multiplied together per transform
+  double start = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    for(size_t i = 0; i < TRANSFORMS_COUNT; i++) {
+      models[i] = glm::translate(glm::mat4(1.0f), transforms[i].position) * 
+                  glm::mat4_cast(transforms[i].rotation) *
+                  glm::scale(glm::mat4(1.0f), transforms[i].scale);
+    }
+  }
+  double elapsed = bench_now() - start;
+  bench_report("glm translate * rotate * scale", (TRANSFORMS_COUNT * ITERATIONS) / elapsed / 1e6, "M transforms/s", checksum(models));
+
+  std::vector<glm::mat4> reference = models;
+
+  // The batched SIMD kernel
+  start = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    transform_compose_batch(transforms.data(), models.data(), TRANSFORMS_COUNT);
+  }
+  elapsed = bench_now() - start;
+  bench_report("transform_compose_batch", (TRANSFORMS_COUNT * ITERATIONS) / elapsed / 1e6, "M transforms/s", checksum(models));
+
+  float batch_difference = max_difference(models, reference);
+  bench_report("compose_batch vs glm", batch_difference * 1e6, "1e-6 max diff", MAX_DIFFERENCE);
+  NIKOL_ASSERT(batch_difference <= MAX_DIFFERENCE, "transform_compose_batch does not match glm");
+
+  // Lazy updates where only 1 in 8 transforms changed since the last frame
+  start = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    for(size_t i = it % 8; i < TRANSFORMS_COUNT; i += 8) {
+      transforms[i].is_dirty = true;
+    }
+    transform_update_models(transforms.data(), models.data(), TRANSFORMS_COUNT);
+  }
+  elapsed = bench_now() - start;
+  bench_report("transform_update_models (1/8 dirty)", (TRANSFORMS_COUNT * ITERATIONS) / elapsed / 1e6, "M transforms/s", checksum(models));
+
+  // Every transform got dirty at some point, so all of them should be up to date
+  float update_difference = max_difference(models, reference);
+  bench_report("update_models vs glm", update_difference * 1e6, "1e-6 max diff", MAX_DIFFERENCE);
+  NIKOL_ASSERT(update_difference <= MAX_DIFFERENCE, "transform_update_models does not match glm");
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,131 @@
+#include "benchmarks.h"
+
+#include "mesh_generator.h"
+#include "vertex_quantize.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstring>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const int ITERATIONS = 10;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// What a GPU may do to a float attribute on the way in: denormals flushed to zero and NaNs made canonical
+static nikol::u32 flush_word(const nikol::u32 word) {
+  nikol::u32 exponent = (word >> 23) & 0xff;
+
+  if(exponent == 0) {
+    return word & 0x80000000;
+  }
+  else if(exponent == 0xff && (word & 0x7fffff)) {
+    return 0x7fc00000;
+  }
+
+  return word;
+}
+
+// The corners of the box (where the positions hit 0 and the largest value), the axes and diagonals
+// as normals, and UVs at zero, negative, tiny and huge
+static std::vector<Vertex> make_boundary_vertices() {
+  const glm::vec3 normals[] = {
+    glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1),
+    glm::normalize(glm::vec3(-1, -1, -1)), glm::normalize(glm::vec3(1, -1, 1)), glm::normalize(glm::vec3(-1, 1, -1)),
+  };
+  const glm::vec2 uvs[] = {
+    glm::vec2(0.0f, 0.0f), glm::vec2(-0.0f, 1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(-65504.0f, 65504.0f), glm::vec2(6e-8f, -6e-5f),
+  };
+
+  std::vector<Vertex> vertices;
+  for(int corner = 0; corner < 8; corner++) {
+    glm::vec3 position = glm::vec3((corner & 1) ? 5.0f : -3.0f, (corner & 2) ? 2.0f : -7.0f, (corner & 4) ? 1.0f : 0.0f);
+
+    for(auto& normal : normals) {
+      for(auto& uv : uvs) {
+        vertices.push_back(Vertex{position, normal, uv});
+      }
+    }
+  }
+
+  return vertices;
+}
+
+// Every word has to be a normal float, and decoding has to give the same vertex after the GPU had its way with them
+static void run_round_trip(const char* name, const VertexFormat format) {
+  std::vector<Vertex> vertices = make_boundary_vertices();
+  std::vector<nikol::u8> packed;
+  glm::mat4 dequantize;
+
+  QuantizeStats stats = vertex_quantize(packed, vertices, format, dequantize);
+  nikol::u32 stride   = vertex_format_get_stride(format);
+
+  nikol::u32 unsafe_words = 0;
+  nikol::u32 mismatches   = 0;
+
+  for(nikol::sizei i = 0; i < vertices.size(); i++) {
+    nikol::u8* vertex = &packed[i * stride];
+    Vertex before     = vertex_unpack(vertex, format, dequantize);
+
+    for(nikol::u32 offset = 0; offset < stride; offset += sizeof(nikol::u32)) {
+      nikol::u32 word;
+      std::memcpy(&word, vertex + offset, sizeof(word));
+
+      nikol::u32 exponent = (word >> 23) & 0xff;
+      unsafe_words       += (exponent == 0 || exponent == 0xff);
+
+      word = flush_word(word);
+      std::memcpy(vertex + offset, &word, sizeof(word));
+    }
+
+    Vertex after = vertex_unpack(vertex, format, dequantize);
+    mismatches  += std::memcmp(&before, &after, sizeof(Vertex)) != 0;
+  }
+
+  bench_report(name, mismatches, "mismatches", unsafe_words);
+  printf("  %zu boundary vertices, max errors: position %g, normal %.3f deg, uv %g\n",
+         vertices.size(), stats.max_position_error, stats.max_normal_error, stats.max_uv_error);
+}
+
+static void run_format(const char* name, const std::vector<Vertex>& vertices, const VertexFormat format) {
+  std::vector<nikol::u8> packed;
+  glm::mat4 dequantize;
+  QuantizeStats stats;
+
+  double checksum = 0.0;
+  double start    = bench_now();
+  for(int it = 0; it < ITERATIONS; it++) {
+    stats     = vertex_quantize(packed, vertices, format, dequantize);
+    checksum += packed[packed.size() / 2];
+  }
+  double time = (bench_now() - start) / ITERATIONS;
+
+  bench_report(name, time * 1e9 / vertices.size(), "ns/vertex", checksum);
+  printf("  %u -> %u bytes/vertex, max errors: position %g, normal %.3f deg, uv %g\n",
+         stats.vertex_size_before, stats.vertex_size_after, 
+         stats.max_position_error, stats.max_normal_error, stats.max_uv_error);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_vertex_quantize() {
+  std::vector<Vertex> vertices; 
+  std::vector<nikol::u32> indices;
+  shape_generate(ShapeDesc{.type = SHAPE_TORUS, .segments = 1024, .rings = 512}, vertices, indices);
+
+  run_format("quantize (snorm16 normals)", vertices, VERTEX_FORMAT_QUANTIZED);
+  run_format("quantize (snorm8 normals)", vertices, VERTEX_FORMAT_QUANTIZED_COMPACT);
+
+  run_round_trip("round trip (snorm16 normals)", VERTEX_FORMAT_QUANTIZED);
+  run_round_trip("round trip (snorm8 normals)", VERTEX_FORMAT_QUANTIZED_COMPACT);
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
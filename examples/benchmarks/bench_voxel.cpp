@@ -0,0 +1,223 @@
+#include "benchmarks.h"
+
+#include "voxel.h"
+#include "vertex_quantize.h"
+#include "job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Globals
+const glm::uvec3 CHUNKS_COUNT = glm::uvec3(16, 4, 16);
+const int MESHING_RUNS        = 5;
+const int EDITS_COUNT         = 2000;
+// Globals
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Private functions
+
+// Rolling hills of stone, dirt and grass, with caves running through them
+static void generate_blocks(VoxelWorld& world) {
+  glm::ivec3 size = glm::ivec3(world.chunks_count * VOXEL_CHUNK_SIZE);
+
+  for(int z = 0; z < size.z; z++) {
+    for(int x = 0; x < size.x; x++) {
+      nikol::f32 h = 0.45f + 0.2f * std::sin(x * 0.021f) * std::cos(z * 0.017f) + 0.08f * std::sin((x + z) * 0.053f) + 0.03f * std::cos(x * 0.19f - z * 0.11f);
+      int height   = (int)(h * size.y);
+
+      for(int y = 0; y < height; y++) {
+        nikol::f32 cave = std::sin(x * 0.09f + y * 0.05f) * std::sin(z * 0.08f - y * 0.07f) * std::cos((x - z) * 0.04f + y * 0.11f);
+        if(cave > 0.3f) {
+          continue;
+        }
+
+        nikol::u8 type = (y == height - 1) ? 3 : (y >= height - 4) ? 2 : 1;
+        voxel_world_set_block(world, glm::ivec3(x, y, z), type);
+      }
+    }
+  }
+}
+
+static void dirty_everything(VoxelWorld& world) {
+  for(nikol::u32 i = 0; i < world.chunks.size(); i++) {
+    world.chunks[i].is_dirty = true;
+    world.dirty_chunks.push_back(i);
+  }
+}
+
+// One face per side of a solid block touching air, straight out of the blocks
+static nikol::u64 count_visible_faces(const VoxelWorld& world) {
+  glm::ivec3 size     = glm::ivec3(world.chunks_count * VOXEL_CHUNK_SIZE);
+  glm::ivec3 sides[6] = {glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1)};
+  nikol::u64 faces    = 0;
+
+  for(int y = 0; y < size.y; y++) {
+    for(int z = 0; z < size.z; z++) {
+      for(int x = 0; x < size.x; x++) {
+        glm::ivec3 block = glm::ivec3(x, y, z);
+        if(voxel_world_get_block(world, block) == VOXEL_BLOCK_AIR) {
+          continue;
+        }
+
+        for(auto& side : sides) {
+          faces += voxel_world_get_block(world, block + side) == VOXEL_BLOCK_AIR;
+        }
+      }
+    }
+  }
+
+  return faces;
+}
+
+// The quads have to cover exactly the visible faces, so their areas add up to the faces' count
+static nikol::u64 sum_quad_areas(const VoxelWorld& world) {
+  nikol::u64 area = 0;
+
+  for(auto& chunk : world.chunks) {
+    for(nikol::sizei i = 0; i < chunk.vertices.size(); i += 4) {
+      glm::ivec3 corners[2];
+
+      for(int c = 0; c < 2; c++) {
+        nikol::u32 word = packed_word_decode(chunk.vertices[i + c * 2]);
+        corners[c]      = glm::ivec3(word & 63, (word >> 6) & 63, (word >> 12) & 63);
+      }
+
+      glm::ivec3 extent = glm::abs(corners[1] - corners[0]);
+      nikol::u32 axis   = ((packed_word_decode(chunk.vertices[i]) >> 18) & 7) / 2;
+      extent[axis]      = 1;
+
+      area += (nikol::u64)extent.x * extent.y * extent.z;
+    }
+  }
+
+  return area;
+}
+
+// Words the GPU could flush to zero or mangle as floats (denormals, infinities and NaNs)
+static nikol::u64 count_unsafe_words(const VoxelWorld& world) {
+  nikol::u64 unsafe = 0;
+  for(auto& chunk : world.chunks) {
+    for(auto word : chunk.vertices) {
+      nikol::u32 exponent = (word >> 23) & 0xff;
+      unsafe             += (exponent == 0 || exponent == 0xff);
+    }
+  }
+
+  return unsafe;
+}
+
+static nikol::u64 count_solid_blocks(const VoxelWorld& world) {
+  nikol::u64 solid = 0;
+  for(auto& chunk : world.chunks) {
+    solid += chunk.solid_count;
+  }
+
+  return solid;
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmark functions
+void bench_voxel() {
+  job_system_init();
+
+  VoxelWorld world;
+  voxel_world_create(world, CHUNKS_COUNT, glm::vec3(0.0f));
+
+  double start = bench_now();
+  generate_blocks(world);
+  double elapsed = bench_now() - start;
+
+  nikol::u32 chunks_count = (nikol::u32)world.chunks.size();
+  nikol::u64 solid_count  = count_solid_blocks(world);
+
+  char name[64];
+  snprintf(name, sizeof(name), "fill %u chunks of %u^3", chunks_count, VOXEL_CHUNK_SIZE);
+  bench_report(name, elapsed * 1e3, "ms", (double)solid_count);
+
+  // Meshing everything from scratch, a few times over
+  double best = 1e9;
+  for(int run = 0; run < MESHING_RUNS; run++) {
+    if(run > 0) {
+      dirty_everything(world);
+    }
+
+    start = bench_now();
+    voxel_world_mesh(world);
+    best = std::min(best, bench_now() - start);
+  }
+
+  snprintf(name, sizeof(name), "mesh all chunks (%u threads)", job_system_get_threads_count());
+  bench_report(name, best * 1e3, "ms", world.stats.quads_count);
+  bench_report("chunks meshed", chunks_count / best, "chunks/s", world.stats.chunks_meshed);
+
+  // Checking the merged quads against the blocks themselves
+  nikol::u64 faces_count = count_visible_faces(world);
+  nikol::u64 quads_area  = sum_quad_areas(world);
+
+  bench_report("visible faces", faces_count / 1e6, "M", (double)world.stats.faces_count - faces_count);
+  bench_report("greedy quads", world.stats.quads_count / 1e6, "M", (double)quads_area - faces_count);
+  bench_report("quads saved by merging", 100.0 * (1.0 - (double)world.stats.quads_count / faces_count), "%", quads_area);
+  bench_report("denormal or NaN vertex words", count_unsafe_words(world), "words", world.stats.quads_count * 4);
+
+  // A cube per solid block (24 full vertices, 36 indices) against the packed quads (4 words, 6 indices)
+  double cubes_size  = solid_count * (24.0 * sizeof(Vertex) + 36.0 * sizeof(nikol::u32));
+  double greedy_size = world.stats.quads_count * (4.0 * vertex_format_get_stride(VERTEX_FORMAT_VOXEL) + 6.0 * sizeof(nikol::u32));
+
+  bench_report("triangles (cube per block)", solid_count * 12 / 1e6, "M", (double)solid_count);
+  bench_report("triangles (greedy)", world.stats.quads_count * 2 / 1e6, "M", world.stats.quads_count);
+  bench_report("geometry (cube per block)", cubes_size / (1024.0 * 1024.0), "MiB", cubes_size);
+  bench_report("geometry (greedy)", greedy_size / (1024.0 * 1024.0), "MiB", greedy_size);
+
+  // Digging and placing blocks one at a time, remeshing after each like a frame would
+  glm::ivec3 size     = glm::ivec3(world.chunks_count * VOXEL_CHUNK_SIZE);
+  nikol::u32 seed     = 1234;
+  nikol::u32 remeshed = 0;
+  double edits_time   = 0.0;
+
+  auto next_random = [&](const nikol::u32 range) {
+    seed = seed * 1664525u + 1013904223u;
+    return (int)((seed >> 8) % range);
+  };
+
+  for(int i = 0; i < EDITS_COUNT; i++) {
+    glm::ivec3 block = glm::ivec3(next_random(size.x), next_random(size.y), next_random(size.z));
+    nikol::u8 type   = voxel_world_get_block(world, block) == VOXEL_BLOCK_AIR ? 2 : VOXEL_BLOCK_AIR;
+
+    start = bench_now();
+    voxel_world_set_block(world, block, type);
+    remeshed   += voxel_world_mesh(world);
+    edits_time += bench_now() - start;
+  }
+
+  bench_report("edit + remesh", edits_time * 1e6 / EDITS_COUNT, "us/edit", remeshed);
+  bench_report("chunks remeshed per edit", (double)remeshed / EDITS_COUNT, "chunks", remeshed);
+
+  // The incremental meshes have to match meshing the edited blocks from scratch
+  std::vector<std::vector<nikol::u32>> incremental(chunks_count);
+  for(nikol::u32 i = 0; i < chunks_count; i++) {
+    incremental[i] = world.chunks[i].vertices;
+  }
+
+  dirty_everything(world);
+  voxel_world_mesh(world);
+
+  nikol::u32 mismatches = 0;
+  for(nikol::u32 i = 0; i < chunks_count; i++) {
+    mismatches += incremental[i] != world.chunks[i].vertices;
+  }
+
+  bench_report("stale chunks after the edits", mismatches, "chunks", (double)sum_quad_areas(world) - count_visible_faces(world));
+
+  voxel_world_destroy(world);
+  job_system_shutdown();
+}
+// Benchmark functions
+// ----------------------------------------------------------------------------
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+// Benchmark helpers
+inline double bench_now() {
+  using Clock = std::chrono::high_resolution_clock;
+  return std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+}
+
+// Printed next to every result so the optimizer can't throw the work away
+inline void bench_report(const char* name, const double value, const char* unit, const double checksum) {
+  printf("  %-40s %14.2f %-16s (checksum %g)\n", name, value, unit, checksum);
+}
+// Benchmark helpers
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Benchmarks
+void bench_transform();
+void bench_mesh_file();
+void bench_lod();
+void bench_geometry_pool();
+void bench_vertex_quantize();
+void bench_frame_graph();
+void bench_command_buffer();
+void bench_clustered_lighting();
+void bench_occlusion_culling();
+void bench_skinning();
+void bench_animation_clip();
+void bench_static_batch();
+void bench_indirect_draw();
+void bench_mesh_normals();
+void bench_mesh_codec();
+void bench_meshlet();
+void bench_terrain();
+void bench_voxel();
+void bench_depth_sort();
+void bench_mesh_optimizer();
+void bench_scene_graph();
+// Benchmarks
+// ----------------------------------------------------------------------------
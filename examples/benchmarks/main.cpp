@@ -0,0 +1,59 @@
+#include "benchmarks.h"
+
+#include <cstdio>
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+// Benchmark 
+struct Benchmark {
+  const char* name; 
+  void (*func)();
+};
+// Benchmark 
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Globals
+static const Benchmark s_benchmarks[] = {
+  {"transform", bench_transform},
+  {"mesh_file", bench_mesh_file},
+  {"lod", bench_lod},
+  {"geometry_pool", bench_geometry_pool},
+  {"vertex_quantize", bench_vertex_quantize},
+  {"frame_graph", bench_frame_graph},
+  {"command_buffer", bench_command_buffer},
+  {"clustered_lighting", bench_clustered_lighting},
+  {"occlusion_culling", bench_occlusion_culling},
+  {"skinning", bench_skinning},
+  {"animation_clip", bench_animation_clip},
+  {"static_batch", bench_static_batch},
+  {"indirect_draw", bench_indirect_draw},
+  {"mesh_normals", bench_mesh_normals},
+  {"mesh_codec", bench_mesh_codec},
+  {"meshlet", bench_meshlet},
+  {"terrain", bench_terrain},
+  {"voxel", bench_voxel},
+  {"depth_sort", bench_depth_sort},
+  {"mesh_optimizer", bench_mesh_optimizer},
+  {"scene_graph", bench_scene_graph},
+};
+// Globals
+// ----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  // Run everything unless specific benchmarks are requested by name
+  for(auto& bench : s_benchmarks) {
+    bool should_run = (argc <= 1);
+
+    for(int i = 1; i < argc; i++) {
+      should_run |= (std::strcmp(argv[i], bench.name) == 0);
+    }
+
+    if(!should_run) {
+      continue;
+    }
+
+    printf("[%s]\n", bench.name);
+    bench.func();
+  }
+}
@@ -0,0 +1,97 @@
+#include "state_cache.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <cstring>
+
+// ----------------------------------------------------------------------------
+// Private functions
+static nikol::u32 count_changed_binds(const StateCache& cache, nikol::GfxPipeline* pipe, const nikol::GfxPipelineDesc& desc) {
+  const nikol::GfxPipelineDesc& last = cache.last_desc;
+
+  // Shader + vertex buffer + index buffer + layout + every texture slot
+  nikol::u32 total_binds = 4 + desc.textures_count;
+
+  // Nothing is known about the backend state. Everything has to be bound.
+  if(!cache.is_valid || cache.last_pipe != pipe) {
+    return total_binds;
+  }
+
+  nikol::u32 changed = 0;
+
+  changed += (last.shader != desc.shader);
+  changed += (last.vertex_buffer != desc.vertex_buffer);
+  changed += (last.index_buffer != desc.index_buffer);
+  
+  // The layout descs are plain POD, so a byte compare is enough here
+  bool layout_changed = (last.layout_count != desc.layout_count) || 
+                        (std::memcmp(last.layout, desc.layout, sizeof(desc.layout[0]) * desc.layout_count) != 0);
+  changed += layout_changed;
+
+  for(nikol::sizei i = 0; i < desc.textures_count; i++) {
+    changed += (i >= last.textures_count) || (last.textures[i] != desc.textures[i]);
+  }
+
+  return changed;
+}
+
+static bool draw_params_changed(const StateCache& cache, const nikol::GfxPipelineDesc& desc) {
+  const nikol::GfxPipelineDesc& last = cache.last_desc;
+
+  // These are not bindings, but the backend only learns about them through 
+  // an apply, so any change here has to go through as well.
+  return (last.vertices_count != desc.vertices_count) || 
+         (last.indices_count != desc.indices_count)   || 
+         (last.draw_mode != desc.draw_mode)           || 
+         (last.textures_count != desc.textures_count);
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StateCache functions
+void state_cache_init(StateCache& cache, nikol::GfxContext* gfx) {
+  cache.gfx       = gfx;
+  cache.last_pipe = nullptr;
+  cache.last_desc = {};
+  cache.is_valid  = false;
+  cache.stats     = {};
+}
+
+bool state_cache_apply(StateCache& cache, nikol::GfxPipeline* pipe, const nikol::GfxPipelineDesc& desc) {
+  nikol::u32 total_binds = 4 + desc.textures_count;
+  nikol::u32 changed     = count_changed_binds(cache, pipe, desc);
+
+  // Nothing changed since the last draw. No need to bother the backend.
+  if(changed == 0 && !draw_params_changed(cache, desc)) {
+    cache.stats.binds_skipped   += total_binds;
+    cache.stats.applies_skipped += 1;
+
+    return false;
+  }
+
+  // The backend only exposes a full apply, so even a single change will 
+  // re-apply the whole pipeline. The counters still reflect what really changed.
+  nikol::gfx_context_apply_pipeline(cache.gfx, pipe, desc);
+
+  cache.stats.binds_issued   += changed;
+  cache.stats.binds_skipped  += total_binds - changed;
+  cache.stats.applies_issued += 1;
+
+  cache.last_pipe = pipe;
+  cache.last_desc = desc;
+  cache.is_valid  = true;
+
+  return true;
+}
+
+void state_cache_invalidate(StateCache& cache) {
+  cache.last_pipe = nullptr;
+  cache.is_valid  = false;
+}
+
+void state_cache_reset_stats(StateCache& cache) {
+  cache.stats = {};
+}
+// StateCache functions
+// ----------------------------------------------------------------------------
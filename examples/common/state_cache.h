@@ -0,0 +1,46 @@
+#pragma once
+
+#include <nikol/nikol_core.hpp>
+
+// ----------------------------------------------------------------------------
+// StateCacheStats
+struct StateCacheStats {
+  nikol::u32 binds_issued  = 0; 
+  nikol::u32 binds_skipped = 0;
+
+  nikol::u32 applies_issued  = 0; 
+  nikol::u32 applies_skipped = 0;
+};
+// StateCacheStats
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StateCache
+struct StateCache {
+  nikol::GfxContext* gfx = nullptr;
+
+  // The last pipeline (and its description) that actually reached the backend 
+  nikol::GfxPipeline* last_pipe = nullptr; 
+  nikol::GfxPipelineDesc last_desc;
+  bool is_valid = false;
+
+  StateCacheStats stats;
+};
+// StateCache
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// StateCache functions
+void state_cache_init(StateCache& cache, nikol::GfxContext* gfx);
+
+// Apply `pipe` with `desc` only if it differs from the last applied state. 
+// Returns `true` if the pipeline was applied and `false` if it was filtered out.
+bool state_cache_apply(StateCache& cache, nikol::GfxPipeline* pipe, const nikol::GfxPipelineDesc& desc);
+
+// Forget the last applied state. Call this whenever something binds behind the cache's back.
+void state_cache_invalidate(StateCache& cache);
+
+// Reset the per-frame counters. Usually called at the beginning of each frame.
+void state_cache_reset_stats(StateCache& cache);
+// StateCache functions
+// ----------------------------------------------------------------------------
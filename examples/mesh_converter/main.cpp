@@ -0,0 +1,118 @@
+#include "obj_importer.h"
+#include "mesh_file.h"
+#include "mesh_optimizer.h"
+#include "mesh_prepare.h"
+#include "mesh_normals.h"
+
+#include <nikol/nikol_core.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+// ----------------------------------------------------------------------------
+// Private functions
+static bool has_extension(const char* path, const char* ext) {
+  nikol::sizei path_len = std::strlen(path);
+  nikol::sizei ext_len  = std::strlen(ext);
+
+  return path_len >= ext_len && std::strcmp(path + path_len - ext_len, ext) == 0;
+}
+
+static void print_usage() {
+  printf("Usage: NikolMeshConverter <input.obj> <output.nmsh> [--index32] [--weld-epsilon <e>] [--optimize] [--compress]\n");
+  printf("  --index32            Always store 32-bit indices (16-bit ones are picked when they fit)\n");
+  printf("  --weld-epsilon <e>   Merge vertices that are closer than <e> on every attribute (default: exact matches only)\n");
+  printf("  --optimize           Reorder the triangles and vertices for the vertex cache and overdraw\n");
+  printf("  --compress           Encode the vertices and indices with the mesh codec (best paired with --optimize)\n");
+}
+// Private functions
+// ----------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+  if(argc < 3) {
+    print_usage();
+    return -1;
+  }
+
+  const char* input_path  = argv[1];
+  const char* output_path = argv[2];
+
+  bool force_index32      = false;
+  bool should_optimize    = false;
+  bool should_compress    = false;
+  nikol::f32 weld_epsilon = 0.0f;
+  
+  for(int i = 3; i < argc; i++) {
+    if(std::strcmp(argv[i], "--index32") == 0) {
+      force_index32 = true;
+    }
+    else if(std::strcmp(argv[i], "--weld-epsilon") == 0 && (i + 1) < argc) {
+      weld_epsilon = (nikol::f32)std::atof(argv[++i]);
+    }
+    else if(std::strcmp(argv[i], "--optimize") == 0) {
+      should_optimize = true;
+    }
+    else if(std::strcmp(argv[i], "--compress") == 0) {
+      should_compress = true;
+    }
+  }
+
+  if(has_extension(input_path, ".gltf") || has_extension(input_path, ".glb")) {
+    printf("glTF input is not supported yet. Export the asset as OBJ first.\n");
+    return -1;
+  }
+
+  ObjMesh mesh;
+  if(!obj_import(input_path, mesh)) {
+    printf("Could not import '%s'\n", input_path);
+    return -1;
+  }
+
+  // Welding only remaps the indices, so the submesh ranges stay valid
+  MeshPrepareStats prepare = mesh_prepare(mesh.vertices, mesh.indices, weld_epsilon);
+  printf("Vertices: %u -> %u, index bytes: %zu -> %zu\n", 
+         prepare.vertices_before, prepare.vertices_after, 
+         prepare.index_bytes_before, force_index32 ? prepare.index_bytes_before : prepare.index_bytes_after);
+
+  // Submeshes are optimized one by one, so their index ranges stay intact. 
+  // The vertices are reordered once everything is in its final place.
+  if(should_optimize) {
+    VertexCacheStats before = mesh_analyze_vertex_cache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    std::vector<nikol::u32> scratch(mesh.indices.size());
+
+    for(auto& submesh : mesh.submeshes) {
+      nikol::u32* indices = &mesh.indices[submesh.index_offset];
+      nikol::u32* temp    = &scratch[submesh.index_offset];
+
+      mesh_optimize_vertex_cache(temp, indices, submesh.indices_count, mesh.vertices.size());
+      mesh_optimize_overdraw(indices, temp, submesh.indices_count, mesh.vertices.data(), mesh.vertices.size());
+    }
+
+    std::vector<Vertex> vertices(mesh.vertices.size());
+    nikol::sizei used = mesh_optimize_vertex_fetch(vertices.data(), mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size());
+    
+    vertices.resize(used);
+    mesh.vertices.swap(vertices);
+
+    VertexCacheStats after = mesh_analyze_vertex_cache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    printf("ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+  }
+
+  // Welding and the vertex fetch pass moved the vertices around, so the tangents get built again on the final ones
+  if(!mesh.tangents.empty()) {
+    mesh_compute_tangents(mesh.vertices, mesh.indices, mesh.tangents);
+  }
+
+  // The vertex fetch pass can only drop vertices, so the size picked before still fits
+  nikol::u32 index_size = force_index32 ? 4 : prepare.index_size;
+
+  if(!mesh_file_write(output_path, mesh.vertices, mesh.indices, mesh.submeshes, index_size, should_compress, mesh.tangents)) {
+    printf("Could not write '%s'\n", output_path);
+    return -1;
+  }
+
+  printf("'%s' -> '%s': %zu vertices%s, %zu indices (%u-bit), %zu submeshes\n", 
+         input_path, output_path, 
+         mesh.vertices.size(), mesh.tangents.empty() ? "" : " (with tangents)", mesh.indices.size(), index_size * 8, mesh.submeshes.size());
+}